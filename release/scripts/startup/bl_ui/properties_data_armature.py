@@ -63,6 +63,7 @@ class DATA_PT_skeleton(ArmatureButtonsPanel, Panel):
         arm = context.armature
 
         layout.row().prop(arm, "pose_position", expand=True)
+        layout.prop(arm, "use_pose_batch")
 
         col = layout.column()
         col.label(text="Layers:")
@@ -27,6 +27,7 @@
 extern "C" {
 #endif
 
+struct ArmatureDeformCache;
 struct BMEditMesh;
 struct Bone;
 struct Depsgraph;
@@ -398,6 +399,12 @@ void BKE_pose_eval_bbone_segments(struct Depsgraph *depsgraph,
                                   struct Object *object,
                                   int pchan_index);
 
+void BKE_pose_eval_batch(struct Depsgraph *depsgraph,
+                         struct Scene *scene,
+                         struct Object *object,
+                         const int *pchan_order,
+                         int pchan_order_len);
+
 void BKE_pose_iktree_evaluate(struct Depsgraph *depsgraph,
                               struct Scene *scene,
                               struct Object *object,
@@ -429,6 +436,8 @@ void BKE_pose_eval_proxy_copy_bone(struct Depsgraph *depsgraph,
 /* Note that we could have a 'BKE_armature_deform_coords' that doesn't take object data
  * currently there are no callers for this though. */
 
+void BKE_armature_deform_cache_free(struct ArmatureDeformCache *cache);
+
 void BKE_armature_deform_coords_with_gpencil_stroke(const struct Object *ob_arm,
                                                     const struct Object *ob_target,
                                                     float (*vert_coords)[3],
@@ -447,7 +456,9 @@ void BKE_armature_deform_coords_with_mesh(const struct Object *ob_arm,
                                           int deformflag,
                                           float (*vert_coords_prev)[3],
                                           const char *defgrp_name,
-                                          const struct Mesh *me_target);
+                                          const struct Mesh *me_target,
+                                          const struct Depsgraph *depsgraph,
+                                          struct ArmatureDeformCache **cache);
 
 void BKE_armature_deform_coords_with_editmesh(const struct Object *ob_arm,
                                               const struct Object *ob_target,
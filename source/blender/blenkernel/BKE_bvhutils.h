@@ -259,6 +259,19 @@ bool bvhcache_has_tree(const struct BVHCache *bvh_cache, const BVHTree *tree);
 struct BVHCache *bvhcache_init(void);
 void bvhcache_free(struct BVHCache *bvh_cache);
 
+struct BVHCache *bvhcache_release_for_reuse(struct Mesh *mesh);
+void bvhcache_reuse(struct Mesh *mesh, struct BVHCache *bvh_cache);
+
+typedef struct BVHCacheStats {
+  /** Trees of a previous evaluation refitted to the new vertex positions. */
+  uint64_t refits;
+  /** Trees built from scratch. */
+  uint64_t builds;
+} BVHCacheStats;
+
+void bvhcache_stats_get(BVHCacheStats *r_stats);
+void bvhcache_stats_reset(void);
+
 #ifdef __cplusplus
 }
 #endif
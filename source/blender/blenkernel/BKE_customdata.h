@@ -70,7 +70,10 @@ typedef enum eCDAllocType {
   CD_CALLOC = 1,
   /** Allocate and set to default. */
   CD_DEFAULT = 2,
-  /** Use data pointers, set layer flag NOFREE. */
+  /**
+   * Use data pointers, set layer flag NOFREE. Data owned by the source layers is shared
+   * instead, it stays valid until the last layer using it is freed.
+   */
   CD_REFERENCE = 3,
   /** Do a full copy of all layers, only allowed if source has same number of elements. */
   CD_DUPLICATE = 4,
@@ -123,6 +126,13 @@ void CustomData_data_mix_value(
  * enum (e.g. CD_MLOOPUV). the layer type's equal function is used to compare
  * the data, if it exists, otherwise memcmp is used.*/
 bool CustomData_data_equals(int type, const void *data1, const void *data2);
+/* Exact comparison of all layers of the types in mask, including their names and active
+ * layers. Layers which elements own memory are only compared for #CD_MDEFORMVERT, other
+ * ones are never considered equal unless they share the same data. */
+bool CustomData_layers_data_equal(const struct CustomData *data1,
+                                  const struct CustomData *data2,
+                                  CustomDataMask mask,
+                                  const int totelem);
 void CustomData_data_initminmax(int type, void *min, void *max);
 void CustomData_data_dominmax(int type, const void *data, void *min, void *max);
 void CustomData_data_multiply(int type, void *data, float fac);
@@ -218,7 +228,8 @@ bool CustomData_has_layer(const struct CustomData *data, int type);
 int CustomData_number_of_layers(const struct CustomData *data, int type);
 int CustomData_number_of_layers_typemask(const struct CustomData *data, CustomDataMask mask);
 
-/* duplicate data of a layer with flag NOFREE, and remove that flag.
+/* ensure the layer data can be modified: duplicate data of a layer with flag NOFREE and remove
+ * that flag, or duplicate data shared with other layers (see #CD_REFERENCE).
  * returns the layer data */
 void *CustomData_duplicate_referenced_layer(struct CustomData *data,
                                             const int type,
@@ -231,6 +242,8 @@ void *CustomData_duplicate_referenced_layer_named(struct CustomData *data,
                                                   const int type,
                                                   const char *name,
                                                   const int totelem);
+/* The layer does not own its data (flag NOFREE). Layers sharing data all own it, and are made
+ * mutable by #CustomData_duplicate_referenced_layer as well. */
 bool CustomData_is_referenced_layer(struct CustomData *data, int type);
 
 /* set the CD_FLAG_NOCOPY flag in custom data layers where the mask is
@@ -373,7 +386,8 @@ void CustomData_bmesh_set_n(
  */
 void CustomData_bmesh_set_layer_n(struct CustomData *data, void *block, int n, const void *source);
 
-/* set the pointer of to the first layer of type. the old data is not freed.
+/* set the pointer of to the first layer of type. the old data is not freed, data shared with
+ * other layers stays with them.
  * returns the value of ptr if the layer is found, NULL otherwise
  */
 void *CustomData_set_layer(const struct CustomData *data, int type, void *ptr);
@@ -289,8 +289,44 @@ void BKE_fcurve_correct_bezpart(const float v1[2], float v2[2], float v3[2], con
 
 /* -------- Evaluation --------  */
 
+/**
+ * Keyframe segment which was last evaluated, for evaluating the same F-Curve many times at
+ * nearby times (playback, drawing, sampling). Evaluation then skips the binary search for the
+ * segment and re-uses the corrected Bezier coefficients of the segment.
+ *
+ * The cursor notices re-allocated keyframes, but must be re-initialized with
+ * #BKE_fcurve_segment_cursor_init when keyframes are modified in place.
+ */
+typedef struct FCurveSegmentCursor {
+  /** Keyframes the cursor was used with. */
+  const struct BezTriple *bezt;
+  int totvert;
+  /** Keyframe times are ascending, otherwise segments are always searched. */
+  bool is_sorted;
+  /** Cubic coefficients of #segment are valid. */
+  bool has_coefficients;
+  /** Index of the keyframe which ends the cached segment, 0 when unset. */
+  int segment;
+  /** Cubic coefficients of the Bezier segment, with handles corrected to not form a loop. */
+  float x_coefficients[4];
+  float y_coefficients[4];
+  /** All keyframe and handle values of the Bezier segment are the same. */
+  bool is_flat;
+} FCurveSegmentCursor;
+
+/** Initializer for cursors declared where the F-Curve is sampled. */
+#define FCURVE_SEGMENT_CURSOR_INIT \
+  { \
+    NULL \
+  }
+
+void BKE_fcurve_segment_cursor_init(FCurveSegmentCursor *cursor);
+
 /* evaluate fcurve */
 float evaluate_fcurve(struct FCurve *fcu, float evaltime);
+float evaluate_fcurve_cursor(struct FCurve *fcu,
+                             float evaltime,
+                             struct FCurveSegmentCursor *cursor);
 float evaluate_fcurve_only_curve(struct FCurve *fcu, float evaltime);
 float evaluate_fcurve_driver(struct PathResolvedRNA *anim_rna,
                              struct FCurve *fcu,
@@ -301,6 +337,10 @@ bool BKE_fcurve_is_empty(struct FCurve *fcu);
 float calculate_fcurve(struct PathResolvedRNA *anim_rna,
                        struct FCurve *fcu,
                        const struct AnimationEvalContext *anim_eval_context);
+float calculate_fcurve_ex(struct PathResolvedRNA *anim_rna,
+                          struct FCurve *fcu,
+                          const struct AnimationEvalContext *anim_eval_context,
+                          struct FCurveSegmentCursor *cursor);
 
 /* ************* F-Curve Samples API ******************** */
 
@@ -314,7 +354,8 @@ typedef float (*FcuSampleFunc)(struct FCurve *fcu, void *data, float evaltime);
 
 /* ----- Sampling Callbacks ------  */
 
-/* Basic sampling callback which acts as a wrapper for evaluate_fcurve() */
+/* Basic sampling callback which acts as a wrapper for evaluate_fcurve(),
+ * 'data' is an optional #FCurveSegmentCursor. */
 float fcurve_samplingcb_evalcurve(struct FCurve *fcu, void *data, float evaltime);
 
 /* -------- Main Methods --------  */
@@ -156,6 +156,10 @@ enum {
   G_DEBUG_XR_TIME = (1 << 22),               /* XR/OpenXR timing messages */
 
   G_DEBUG_GHOST = (1 << 23), /* Debug GHOST module. */
+
+  G_DEBUG_DEPSGRAPH_PRIORITY = (1 << 24), /* schedule depsgraph operations by critical path */
+  /* compare incremental depsgraph relations updates against a full build */
+  G_DEBUG_DEPSGRAPH_VALIDATE_INCREMENTAL = (1 << 25),
 };
 
 #define G_DEBUG_ALL \
@@ -30,6 +30,7 @@ extern "C" {
 #endif
 
 struct Mesh;
+struct OpenSubdiv_PatchCoord;
 struct Subdiv;
 
 /* Returns true if evaluator is ready for use. */
@@ -102,6 +103,33 @@ void BKE_subdiv_eval_displacement(struct Subdiv *subdiv,
 void BKE_subdiv_eval_final_point(
     struct Subdiv *subdiv, const int ptex_face_index, const float u, const float v, float r_P[3]);
 
+/* Batched queries.
+ *
+ * Evaluate points at arrays of (ptex face, u, v) coordinates, passing many points to the
+ * evaluator at once. Big batches are evaluated in parallel. Output arrays have one element per
+ * coordinate. */
+
+void BKE_subdiv_eval_limit_points(struct Subdiv *subdiv,
+                                  const struct OpenSubdiv_PatchCoord *patch_coords,
+                                  const int num_patch_coords,
+                                  float (*r_P)[3]);
+void BKE_subdiv_eval_limit_points_and_derivatives(struct Subdiv *subdiv,
+                                                  const struct OpenSubdiv_PatchCoord *patch_coords,
+                                                  const int num_patch_coords,
+                                                  float (*r_P)[3],
+                                                  float (*r_dPdu)[3],
+                                                  float (*r_dPdv)[3]);
+void BKE_subdiv_eval_limit_points_and_normals(struct Subdiv *subdiv,
+                                              const struct OpenSubdiv_PatchCoord *patch_coords,
+                                              const int num_patch_coords,
+                                              float (*r_P)[3],
+                                              float (*r_N)[3]);
+/* Same as BKE_subdiv_eval_final_point(), with displacement applied to the points. */
+void BKE_subdiv_eval_final_points(struct Subdiv *subdiv,
+                                  const struct OpenSubdiv_PatchCoord *patch_coords,
+                                  const int num_patch_coords,
+                                  float (*r_P)[3]);
+
 /* Patch queries at given resolution.
  *
  * Will evaluate patch at uniformly distributed (u, v) coordinates on a grid
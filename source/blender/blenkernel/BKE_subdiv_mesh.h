@@ -49,6 +49,22 @@ struct Mesh *BKE_subdiv_to_mesh(struct Subdiv *subdiv,
                                 const SubdivToMeshSettings *settings,
                                 const struct Mesh *coarse_mesh);
 
+/* Re-evaluate vertex positions and normals of a mesh created by BKE_subdiv_to_mesh(), keeping its
+ * edges, loops, polygons and custom data. Evaluator stencils of the subdivision surface are
+ * re-used, so the coarse mesh is supposed to only differ in vertex positions from the one the
+ * mesh was created from, see BKE_subdiv_mesh_coarse_positions_only_differ().
+ * Returns false if the mesh could not be updated. */
+bool BKE_subdiv_mesh_update_positions(struct Subdiv *subdiv,
+                                      const SubdivToMeshSettings *settings,
+                                      const struct Mesh *coarse_mesh,
+                                      struct Mesh *subdiv_mesh);
+
+/* Check whether the subdivided mesh of coarse_mesh_prev can be updated to coarse_mesh with
+ * BKE_subdiv_mesh_update_positions(): topology and all data other than vertex positions and
+ * normals are to be equal. */
+bool BKE_subdiv_mesh_coarse_positions_only_differ(const struct Mesh *coarse_mesh,
+                                                  const struct Mesh *coarse_mesh_prev);
+
 #ifdef __cplusplus
 }
 #endif
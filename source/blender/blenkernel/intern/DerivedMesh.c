@@ -782,6 +782,7 @@ static void add_orco_mesh(Object *ob, BMEditMesh *em, Mesh *mesh, Mesh *mesh_orc
 static void mesh_calc_modifier_final_normals(const Mesh *mesh_input,
                                              const CustomData_MeshMasks *final_datamask,
                                              const bool sculpt_dyntopo,
+                                             MeshLoopSplitCache **loop_split_cache_p,
                                              Mesh *mesh_final)
 {
   /* Compute normals. */
@@ -812,8 +813,9 @@ static void mesh_calc_modifier_final_normals(const Mesh *mesh_input,
   }
 
   if (do_loop_normals) {
-    /* Compute loop normals (note: will compute poly and vert normals as well, if needed!) */
-    BKE_mesh_calc_normals_split(mesh_final);
+    /* Compute loop normals (note: will compute poly and vert normals as well, if needed!)
+     * The smooth fans are kept for the next evaluation when a cache is given. */
+    BKE_mesh_calc_normals_split_cached(mesh_final, loop_split_cache_p);
     BKE_mesh_tessface_clear(mesh_final);
   }
 
@@ -1330,8 +1332,10 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
   }
 
   /* Compute normals. */
+  MeshLoopSplitCache **loop_split_cache_p = use_cache ? &ob->runtime.loop_split_cache : NULL;
   if (is_own_mesh) {
-    mesh_calc_modifier_final_normals(mesh_input, &final_datamask, sculpt_dyntopo, mesh_final);
+    mesh_calc_modifier_final_normals(
+        mesh_input, &final_datamask, sculpt_dyntopo, loop_split_cache_p, mesh_final);
   }
   else {
     Mesh_Runtime *runtime = &mesh_input->runtime;
@@ -1340,8 +1344,11 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
       BLI_mutex_lock(runtime->eval_mutex);
       if (runtime->mesh_eval == NULL) {
         mesh_final = BKE_mesh_copy_for_eval(mesh_input, true);
-        mesh_calc_modifier_final_normals(mesh_input, &final_datamask, sculpt_dyntopo, mesh_final);
+        mesh_calc_modifier_final_normals(
+            mesh_input, &final_datamask, sculpt_dyntopo, loop_split_cache_p, mesh_final);
         mesh_calc_finalize(mesh_input, mesh_final);
+        bvhcache_reuse(mesh_final, runtime->bvh_cache_reuse);
+        runtime->bvh_cache_reuse = NULL;
         runtime->mesh_eval = mesh_final;
       }
       BLI_mutex_unlock(runtime->eval_mutex);
@@ -1575,7 +1582,7 @@ static void editbmesh_calc_modifiers(struct Depsgraph *depsgraph,
       /* apply vertex coordinates or build a DerivedMesh as necessary */
       if (mesh_final) {
         if (deformed_verts) {
-          Mesh *mesh_tmp = BKE_mesh_copy_for_eval(mesh_final, false);
+          Mesh *mesh_tmp = BKE_mesh_copy_for_eval(mesh_final, true);
           if (mesh_final != mesh_cage) {
             BKE_id_free(NULL, mesh_final);
           }
@@ -1656,7 +1663,7 @@ static void editbmesh_calc_modifiers(struct Depsgraph *depsgraph,
 
     if (r_cage && i == cageIndex) {
       if (mesh_final && deformed_verts) {
-        mesh_cage = BKE_mesh_copy_for_eval(mesh_final, false);
+        mesh_cage = BKE_mesh_copy_for_eval(mesh_final, true);
         BKE_mesh_vert_coords_apply(mesh_cage, deformed_verts);
       }
       else if (mesh_final) {
@@ -1688,7 +1695,7 @@ static void editbmesh_calc_modifiers(struct Depsgraph *depsgraph,
    * then we need to build one. */
   if (mesh_final) {
     if (deformed_verts) {
-      Mesh *mesh_tmp = BKE_mesh_copy_for_eval(mesh_final, false);
+      Mesh *mesh_tmp = BKE_mesh_copy_for_eval(mesh_final, true);
       if (mesh_final != mesh_cage) {
         BKE_id_free(NULL, mesh_final);
       }
@@ -1807,6 +1814,17 @@ static void mesh_build_data(struct Depsgraph *depsgraph,
   const bool is_mesh_eval_owned = (mesh_eval != mesh->runtime.mesh_eval);
   BKE_object_eval_assign_data(ob, &mesh_eval->id, is_mesh_eval_owned);
 
+  /* Hand over the trees of the previous evaluated mesh, see #BKE_object_free_derived_caches. */
+  if (ob->runtime.bvh_cache_reuse != NULL) {
+    if (is_mesh_eval_owned) {
+      bvhcache_reuse(mesh_eval, ob->runtime.bvh_cache_reuse);
+    }
+    else {
+      bvhcache_free(ob->runtime.bvh_cache_reuse);
+    }
+    ob->runtime.bvh_cache_reuse = NULL;
+  }
+
   ob->runtime.mesh_deform_eval = mesh_deform_eval;
   ob->runtime.last_data_mask = *dataMask;
   ob->runtime.last_need_mapping = need_mapping;
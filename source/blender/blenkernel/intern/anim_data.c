@@ -257,6 +257,9 @@ void BKE_animdata_free(ID *id, const bool do_id_user)
       /* free driver array cache */
       MEM_SAFE_FREE(adt->driver_array);
 
+      /* free cached bindings of the active action */
+      BKE_animsys_free_binding_cache(adt);
+
       /* free overrides */
       /* TODO... */
 
@@ -356,6 +359,7 @@ AnimData *BKE_animdata_copy(Main *bmain, AnimData *adt, const int flag)
   /* duplicate drivers (F-Curves) */
   BKE_fcurves_copy(&dadt->drivers, &adt->drivers);
   dadt->driver_array = NULL;
+  dadt->binding_cache = NULL;
 
   /* don't copy overrides */
   BLI_listbase_clear(&dadt->overrides);
@@ -1577,6 +1581,7 @@ void BKE_animdata_blend_read_data(BlendDataReader *reader, AnimData *adt)
   BLO_read_list(reader, &adt->drivers);
   BKE_fcurve_blend_read_data(reader, &adt->drivers);
   adt->driver_array = NULL;
+  adt->binding_cache = NULL;
 
   /* link overrides */
   /* TODO... */
@@ -582,6 +582,24 @@ static void animsys_write_orig_anim_rna(PointerRNA *ptr,
   }
 }
 
+/* Standard checks for whether an F-Curve of an action is to be evaluated. */
+static bool animsys_fcurve_is_evaluated(FCurve *fcu)
+{
+  /* Check if this F-Curve doesn't belong to a muted group. */
+  if ((fcu->grp != NULL) && (fcu->grp->flag & AGRP_MUTED)) {
+    return false;
+  }
+  /* Check if this curve should be skipped. */
+  if ((fcu->flag & (FCURVE_MUTED | FCURVE_DISABLED))) {
+    return false;
+  }
+  /* Skip empty curves, as if muted. */
+  if (BKE_fcurve_is_empty(fcu)) {
+    return false;
+  }
+  return true;
+}
+
 /**
  * Evaluate all the F-Curves in the given list
  * This performs a set of standard checks. If extra checks are required,
@@ -594,16 +612,7 @@ static void animsys_evaluate_fcurves(PointerRNA *ptr,
 {
   /* Calculate then execute each curve. */
   LISTBASE_FOREACH (FCurve *, fcu, list) {
-    /* Check if this F-Curve doesn't belong to a muted group. */
-    if ((fcu->grp != NULL) && (fcu->grp->flag & AGRP_MUTED)) {
-      continue;
-    }
-    /* Check if this curve should be skipped. */
-    if ((fcu->flag & (FCURVE_MUTED | FCURVE_DISABLED))) {
-      continue;
-    }
-    /* Skip empty curves, as if muted. */
-    if (BKE_fcurve_is_empty(fcu)) {
+    if (!animsys_fcurve_is_evaluated(fcu)) {
       continue;
     }
     PathResolvedRNA anim_rna;
@@ -773,6 +782,155 @@ void animsys_evaluate_action(PointerRNA *ptr,
   animsys_evaluate_action_ex(ptr, act, anim_eval_context, flush_to_original);
 }
 
+/* ***************************************** */
+/* Active Action Bindings */
+
+/* How the RNA path of an F-Curve is bound to a property. */
+typedef enum eAnimBindingType {
+  /* Path does not resolve to an animatable property, the F-Curve is not written anywhere. */
+  ANIM_BINDING_INVALID = 0,
+  /* The resolved property is stored in the binding. */
+  ANIM_BINDING_RESOLVED = 1,
+  /* Path leads to an ID property, which can be re-allocated without any dependency graph
+   * update, or into another datablock. Resolved again on every evaluation. */
+  ANIM_BINDING_DYNAMIC = 2,
+} eAnimBindingType;
+
+typedef struct AnimBinding {
+  FCurve *fcu;
+  /* Property of the evaluated datablock. */
+  PathResolvedRNA anim_rna;
+  /* Property of the original datablock, only bound when flushing to original. */
+  PathResolvedRNA orig_anim_rna;
+  /* eAnimBindingType. */
+  char type;
+  char orig_type;
+  /* Keyframe segment of the previous frame. */
+  FCurveSegmentCursor cursor;
+} AnimBinding;
+
+/**
+ * Resolved RNA paths of all F-Curves of the active action, stored in the animation data of
+ * evaluated datablocks, so that playback does not resolve the same paths on every frame.
+ *
+ * Properties are only bound inside the owner datablock, so the pointers stay valid until the
+ * dependency graph re-copies the owner, which frees its animation data together with the cache.
+ * The F-Curves belong to the evaluated action, which is checked by its copy-on-write generation.
+ */
+typedef struct AnimBindingCache {
+  bAction *action;
+  struct Depsgraph *depsgraph;
+  uint64_t action_generation;
+  bool flush_to_original;
+  int bindings_num;
+  AnimBinding *bindings;
+} AnimBindingCache;
+
+static char animsys_binding_resolve(PointerRNA *ptr, FCurve *fcu, PathResolvedRNA *r_anim_rna)
+{
+  if (!BKE_animsys_store_rna_setting(ptr, fcu->rna_path, fcu->array_index, r_anim_rna)) {
+    return ANIM_BINDING_INVALID;
+  }
+  if (RNA_property_is_idprop(r_anim_rna->prop) || r_anim_rna->ptr.owner_id != ptr->owner_id) {
+    return ANIM_BINDING_DYNAMIC;
+  }
+  return ANIM_BINDING_RESOLVED;
+}
+
+static AnimBindingCache *animsys_binding_cache_ensure(PointerRNA *ptr,
+                                                      AnimData *adt,
+                                                      bAction *act,
+                                                      struct Depsgraph *depsgraph,
+                                                      const bool flush_to_original)
+{
+  const uint64_t action_generation = DEG_get_copy_on_write_generation(depsgraph, &act->id);
+  AnimBindingCache *cache = adt->binding_cache;
+  if (cache != NULL && cache->action == act && cache->depsgraph == depsgraph &&
+      cache->action_generation == action_generation &&
+      cache->flush_to_original == flush_to_original) {
+    return cache;
+  }
+
+  BKE_animsys_free_binding_cache(adt);
+
+  cache = MEM_callocN(sizeof(*cache), __func__);
+  cache->action = act;
+  cache->depsgraph = depsgraph;
+  cache->action_generation = action_generation;
+  cache->flush_to_original = flush_to_original;
+  cache->bindings_num = BLI_listbase_count(&act->curves);
+  cache->bindings = MEM_calloc_arrayN(cache->bindings_num, sizeof(AnimBinding), __func__);
+
+  PointerRNA ptr_orig;
+  const bool bind_orig = flush_to_original && animsys_construct_orig_pointer_rna(ptr, &ptr_orig);
+
+  AnimBinding *binding = cache->bindings;
+  LISTBASE_FOREACH (FCurve *, fcu, &act->curves) {
+    binding->fcu = fcu;
+    binding->type = animsys_binding_resolve(ptr, fcu, &binding->anim_rna);
+    if (bind_orig && binding->type != ANIM_BINDING_INVALID) {
+      binding->orig_type = animsys_binding_resolve(&ptr_orig, fcu, &binding->orig_anim_rna);
+    }
+    binding++;
+  }
+
+  adt->binding_cache = cache;
+  return cache;
+}
+
+/* Same as #animsys_evaluate_action_ex, but writing into the cached bindings of the active
+ * action of an evaluated datablock. */
+static void animsys_evaluate_action_bindings(PointerRNA *ptr,
+                                             AnimData *adt,
+                                             bAction *act,
+                                             const AnimationEvalContext *anim_eval_context,
+                                             const bool flush_to_original)
+{
+  action_idcode_patch_check(ptr->owner_id, act);
+
+  AnimBindingCache *cache = animsys_binding_cache_ensure(
+      ptr, adt, act, anim_eval_context->depsgraph, flush_to_original);
+
+  for (int i = 0; i < cache->bindings_num; i++) {
+    AnimBinding *binding = &cache->bindings[i];
+    FCurve *fcu = binding->fcu;
+    if (binding->type == ANIM_BINDING_INVALID || !animsys_fcurve_is_evaluated(fcu)) {
+      continue;
+    }
+
+    PathResolvedRNA anim_rna_dynamic;
+    PathResolvedRNA *anim_rna = &binding->anim_rna;
+    if (binding->type == ANIM_BINDING_DYNAMIC) {
+      if (!BKE_animsys_store_rna_setting(
+              ptr, fcu->rna_path, fcu->array_index, &anim_rna_dynamic)) {
+        continue;
+      }
+      anim_rna = &anim_rna_dynamic;
+    }
+
+    const float curval = calculate_fcurve_ex(anim_rna, fcu, anim_eval_context, &binding->cursor);
+    BKE_animsys_write_rna_setting(anim_rna, curval);
+
+    if (binding->orig_type == ANIM_BINDING_RESOLVED) {
+      BKE_animsys_write_rna_setting(&binding->orig_anim_rna, curval);
+    }
+    else if (binding->orig_type == ANIM_BINDING_DYNAMIC) {
+      animsys_write_orig_anim_rna(ptr, fcu->rna_path, fcu->array_index, curval);
+    }
+  }
+}
+
+void BKE_animsys_free_binding_cache(AnimData *adt)
+{
+  AnimBindingCache *cache = adt->binding_cache;
+  if (cache == NULL) {
+    return;
+  }
+  MEM_SAFE_FREE(cache->bindings);
+  MEM_freeN(cache);
+  adt->binding_cache = NULL;
+}
+
 /* ***************************************** */
 /* NLA System - Evaluation */
 
@@ -2637,7 +2795,11 @@ void BKE_animsys_evaluate_animdata(ID *id,
        */
       animsys_calculate_nla(&id_ptr, adt, anim_eval_context, flush_to_original);
     }
-    /* evaluate Active Action only */
+    /* evaluate Active Action only, with cached bindings for evaluated datablocks */
+    else if (adt->action && anim_eval_context->depsgraph != NULL && DEG_is_evaluated_id(id)) {
+      animsys_evaluate_action_bindings(
+          &id_ptr, adt, adt->action, anim_eval_context, flush_to_original);
+    }
     else if (adt->action) {
       animsys_evaluate_action_ex(&id_ptr, adt->action, anim_eval_context, flush_to_original);
     }
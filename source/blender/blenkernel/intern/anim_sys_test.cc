@@ -0,0 +1,230 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "tests/depsgraph_base_test.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_action.h"
+#include "BKE_anim_data.h"
+#include "BKE_animsys.h"
+#include "BKE_collection.h"
+#include "BKE_constraint.h"
+#include "BKE_fcurve.h"
+#include "BKE_layer.h"
+#include "BKE_object.h"
+
+#include "BLI_listbase.h"
+#include "BLI_string.h"
+#include "BLI_vector.hh"
+
+#include "DNA_anim_types.h"
+#include "DNA_constraint_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+#include "DEG_depsgraph_query.h"
+
+#include "ED_keyframing.h"
+
+#include "PIL_time.h"
+
+namespace blender::bke::tests {
+
+class AnimSysTest : public deg::tests::DepsgraphBaseTest {
+ public:
+  /* Empty object with an action, which animates `location` from 0 at frame 1 to `i + 1` at
+   * frame 11. */
+  Object *animated_object_add(const char *name)
+  {
+    Object *object = BKE_object_add_only_object(bmain, OB_EMPTY, name);
+    bAction *action = BKE_action_add(bmain, name);
+    AnimData *adt = BKE_animdata_add_id(&object->id);
+    adt->action = action;
+    for (int i = 0; i < 3; i++) {
+      FCurve *fcu = BKE_fcurve_create();
+      fcu->rna_path = BLI_strdup("location");
+      fcu->array_index = i;
+      fcu->flag = FCURVE_VISIBLE | FCURVE_SELECTED;
+      insert_vert_fcurve(fcu, 1.0f, 0.0f, BEZT_KEYTYPE_KEYFRAME, INSERTKEY_NO_USERPREF);
+      insert_vert_fcurve(fcu, 11.0f, i + 1.0f, BEZT_KEYTYPE_KEYFRAME, INSERTKEY_NO_USERPREF);
+      BLI_addtail(&action->curves, fcu);
+    }
+    BKE_collection_object_add(bmain, scene->master_collection, object);
+    BKE_main_collection_sync(bmain);
+    return object;
+  }
+
+  void graph_build_and_evaluate()
+  {
+    DEG_graph_build_from_view_layer(graph);
+    DEG_evaluate_on_refresh(graph);
+    DEG_ids_clear_recalc(bmain, graph);
+  }
+
+  void graph_evaluate_frame(const float ctime)
+  {
+    DEG_evaluate_on_framechange(graph, ctime);
+    DEG_ids_clear_recalc(bmain, graph);
+  }
+};
+
+TEST_F(AnimSysTest, active_action_bindings)
+{
+  Object *object = animated_object_add("Object");
+  graph_build_and_evaluate();
+
+  Object *object_eval = DEG_get_evaluated_object(graph, object);
+  ASSERT_NE(object_eval, object);
+
+  graph_evaluate_frame(11.0f);
+  EXPECT_NE(object_eval->adt->binding_cache, nullptr);
+  EXPECT_EQ(object->adt->binding_cache, nullptr);
+  EXPECT_FLOAT_EQ(object_eval->loc[0], 1.0f);
+  EXPECT_FLOAT_EQ(object_eval->loc[1], 2.0f);
+  EXPECT_FLOAT_EQ(object_eval->loc[2], 3.0f);
+  /* Inactive dependency graph does not write to the original. */
+  EXPECT_FLOAT_EQ(object->loc[0], 0.0f);
+
+  graph_evaluate_frame(1.0f);
+  EXPECT_FLOAT_EQ(object_eval->loc[2], 0.0f);
+}
+
+TEST_F(AnimSysTest, active_action_bindings_flush_to_original)
+{
+  Object *object = animated_object_add("Object");
+  DEG_make_active(graph);
+  graph_build_and_evaluate();
+
+  graph_evaluate_frame(11.0f);
+  EXPECT_FLOAT_EQ(object->loc[0], 1.0f);
+  EXPECT_FLOAT_EQ(object->loc[1], 2.0f);
+  EXPECT_FLOAT_EQ(object->loc[2], 3.0f);
+}
+
+TEST_F(AnimSysTest, active_action_bindings_update)
+{
+  Object *object = animated_object_add("Object");
+  graph_build_and_evaluate();
+  graph_evaluate_frame(11.0f);
+
+  /* Re-target the second curve, the cached bindings must follow. */
+  FCurve *fcu = (FCurve *)BLI_findlink(&object->adt->action->curves, 1);
+  MEM_freeN(fcu->rna_path);
+  fcu->rna_path = BLI_strdup("scale");
+  DEG_id_tag_update_ex(bmain, &object->adt->action->id, ID_RECALC_ANIMATION);
+  DEG_evaluate_on_refresh(graph);
+  DEG_ids_clear_recalc(bmain, graph);
+
+  /* Refresh evaluates at the scene frame. */
+  Object *object_eval = DEG_get_evaluated_object(graph, object);
+  EXPECT_FLOAT_EQ(object_eval->scale[1], 0.0f);
+
+  graph_evaluate_frame(11.0f);
+  EXPECT_FLOAT_EQ(object_eval->scale[1], 2.0f);
+  EXPECT_FLOAT_EQ(object_eval->loc[2], 3.0f);
+
+  /* Updates of other datablocks keep the bindings. */
+  Object *other = animated_object_add("Other");
+  DEG_relations_tag_update(bmain);
+  graph_build_and_evaluate();
+  AnimBindingCache *binding_cache = object_eval->adt->binding_cache;
+  ASSERT_NE(binding_cache, nullptr);
+  const uint64_t action_generation = DEG_get_copy_on_write_generation(
+      graph, &object->adt->action->id);
+  DEG_id_tag_update_ex(bmain, &other->id, ID_RECALC_COPY_ON_WRITE);
+  DEG_id_tag_update_ex(bmain, &other->adt->action->id, ID_RECALC_ANIMATION);
+  graph_evaluate_frame(11.0f);
+  EXPECT_EQ(DEG_get_copy_on_write_generation(graph, &object->adt->action->id), action_generation);
+  EXPECT_EQ(object_eval->adt->binding_cache, binding_cache);
+
+  /* Assigning another action re-copies the datablock, which re-binds as well. */
+  bAction *action = BKE_action_add(bmain, "Rotation");
+  FCurve *fcu_rot = BKE_fcurve_create();
+  fcu_rot->rna_path = BLI_strdup("rotation_euler");
+  fcu_rot->array_index = 0;
+  insert_vert_fcurve(fcu_rot, 1.0f, 4.0f, BEZT_KEYTYPE_KEYFRAME, INSERTKEY_NO_USERPREF);
+  BLI_addtail(&action->curves, fcu_rot);
+  object->adt->action = action;
+  DEG_id_tag_update_ex(bmain, &object->id, ID_RECALC_ANIMATION);
+  DEG_relations_tag_update(bmain);
+  graph_build_and_evaluate();
+  EXPECT_FLOAT_EQ(object_eval->rot[0], 4.0f);
+}
+
+/* Compare evaluation of original datablocks, which resolves RNA paths on every frame, with
+ * evaluated datablocks using cached bindings. */
+TEST_F(AnimSysTest, performance_active_action_1000)
+{
+  const int objects_num = 1000;
+  const int frames_num = 100;
+  Vector<Object *> objects;
+  for (int i = 0; i < objects_num; i++) {
+    Object *object = animated_object_add("Object");
+    /* Paths into collections are the common case for rigs. */
+    BKE_constraint_add_for_object(object, "Limit", CONSTRAINT_TYPE_LOCLIMIT);
+    FCurve *fcu = BKE_fcurve_create();
+    fcu->rna_path = BLI_strdup("constraints[\"Limit\"].influence");
+    insert_vert_fcurve(fcu, 1.0f, 0.0f, BEZT_KEYTYPE_KEYFRAME, INSERTKEY_NO_USERPREF);
+    insert_vert_fcurve(fcu, 11.0f, 1.0f, BEZT_KEYTYPE_KEYFRAME, INSERTKEY_NO_USERPREF);
+    BLI_addtail(&object->adt->action->curves, fcu);
+    objects.append(object);
+  }
+  graph_build_and_evaluate();
+
+  Vector<Object *> objects_eval;
+  for (Object *object : objects) {
+    objects_eval.append(DEG_get_evaluated_object(graph, object));
+  }
+
+  double time_start = PIL_check_seconds_timer();
+  for (int frame = 0; frame < frames_num; frame++) {
+    const AnimationEvalContext anim_eval_context = BKE_animsys_eval_context_construct(
+        graph, (float)frame);
+    for (Object *object : objects) {
+      BKE_animsys_evaluate_animdata(
+          &object->id, object->adt, &anim_eval_context, ADT_RECALC_ANIM, false);
+    }
+  }
+  const double time_resolve = PIL_check_seconds_timer() - time_start;
+
+  time_start = PIL_check_seconds_timer();
+  for (int frame = 0; frame < frames_num; frame++) {
+    const AnimationEvalContext anim_eval_context = BKE_animsys_eval_context_construct(
+        graph, (float)frame);
+    for (Object *object_eval : objects_eval) {
+      BKE_animsys_evaluate_animdata(
+          &object_eval->id, object_eval->adt, &anim_eval_context, ADT_RECALC_ANIM, false);
+    }
+  }
+  const double time_bindings = PIL_check_seconds_timer() - time_start;
+
+  for (int i = 0; i < objects_num; i++) {
+    EXPECT_FLOAT_EQ(objects_eval[i]->loc[2], objects[i]->loc[2]);
+    EXPECT_FLOAT_EQ(((bConstraint *)objects_eval[i]->constraints.first)->enforce,
+                    ((bConstraint *)objects[i]->constraints.first)->enforce);
+  }
+  printf("Active action of %d objects for %d frames, resolved: %.3f ms, bindings: %.3f ms\n",
+         objects_num,
+         frames_num,
+         time_resolve * 1000.0,
+         time_bindings * 1000.0);
+}
+
+}  // namespace blender::bke::tests
@@ -25,11 +25,16 @@
 
 #include <ctype.h>
 #include <float.h>
+#include <limits.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "MEM_guardedalloc.h"
 
 #include "BLI_listbase.h"
@@ -37,6 +42,7 @@
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
 
+#include "DNA_ID.h"
 #include "DNA_armature_types.h"
 #include "DNA_gpencil_types.h"
 #include "DNA_lattice_types.h"
@@ -52,6 +58,7 @@
 #include "BKE_lattice.h"
 
 #include "DEG_depsgraph_build.h"
+#include "DEG_depsgraph_query.h"
 
 #include "CLG_log.h"
 
@@ -231,6 +238,161 @@ static void pchan_bone_deform(bPoseChannel *pchan,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Packed Vertex Group Weights
+ *
+ * Mesh vertex group weights copied into fixed size arrays, which are built once and reused while
+ * the vertex groups of the mesh don't change. Deforming with these avoids following the
+ * #MDeformWeight array of every vertex, and accumulates bone transforms with SIMD instructions.
+ * \{ */
+
+/* Maximum number of vertex groups of a vertex in the packed weights. */
+#define PACKED_GROUPS_MAX 4
+/* Vertices with more groups are deformed by the generic code. */
+#define PACKED_GROUPS_GENERIC UCHAR_MAX
+
+typedef struct ArmatureDeformCache {
+  /* Data the packed weights were built from. */
+  const MDeformVert *dverts;
+  int verts_num;
+  int defbase_len;
+  int armature_def_nr;
+  /* Copy-on-write generation of the mesh, which changes when the original weights are edited. */
+  uint64_t mesh_generation;
+
+  /* Number of vertex groups of each vertex, or #PACKED_GROUPS_GENERIC. */
+  unsigned char *groups_num;
+  /* Vertex group indices and weights, in the order of #MDeformVert.dw.
+   * All influences of a vertex are read together, so they are stored next to each other: one
+   * vertex takes 16 bytes of each array. Splitting them into an array per influence would touch
+   * four cache lines per array for every vertex, and the kernels vectorize over the components
+   * of a transform, not over vertices. */
+  int (*groups)[PACKED_GROUPS_MAX];
+  float (*weights)[PACKED_GROUPS_MAX];
+  /* Weights in the armature vertex group, NULL when there is none. */
+  float *armature_weights;
+} ArmatureDeformCache;
+
+/* How vertex groups influence the packed deformation, evaluated for the current pose. */
+enum {
+  /* No deforming bone for the vertex group. */
+  PACKED_GROUP_UNUSED = 0,
+  /* Bone with a single transform. */
+  PACKED_GROUP_BONE = 1,
+  /* B-Bone segments or envelope multiplication, vertices need the generic code. */
+  PACKED_GROUP_GENERIC = 2,
+};
+
+static void armature_deform_cache_clear(ArmatureDeformCache *cache)
+{
+  MEM_SAFE_FREE(cache->groups_num);
+  MEM_SAFE_FREE(cache->groups);
+  MEM_SAFE_FREE(cache->weights);
+  MEM_SAFE_FREE(cache->armature_weights);
+  cache->dverts = NULL;
+}
+
+void BKE_armature_deform_cache_free(ArmatureDeformCache *cache)
+{
+  if (cache == NULL) {
+    return;
+  }
+  armature_deform_cache_clear(cache);
+  MEM_freeN(cache);
+}
+
+static void armature_deform_cache_build(ArmatureDeformCache *cache,
+                                        const MDeformVert *dverts,
+                                        const int verts_num,
+                                        const int defbase_len,
+                                        const int armature_def_nr,
+                                        const uint64_t mesh_generation)
+{
+  armature_deform_cache_clear(cache);
+
+  cache->dverts = dverts;
+  cache->verts_num = verts_num;
+  cache->defbase_len = defbase_len;
+  cache->armature_def_nr = armature_def_nr;
+  cache->mesh_generation = mesh_generation;
+
+  cache->groups_num = MEM_malloc_arrayN(verts_num, sizeof(*cache->groups_num), __func__);
+  cache->groups = MEM_malloc_arrayN(verts_num, sizeof(*cache->groups), __func__);
+  cache->weights = MEM_malloc_arrayN(verts_num, sizeof(*cache->weights), __func__);
+  if (armature_def_nr != -1) {
+    cache->armature_weights = MEM_malloc_arrayN(
+        verts_num, sizeof(*cache->armature_weights), __func__);
+  }
+
+  for (int i = 0; i < verts_num; i++) {
+    const MDeformVert *dvert = &dverts[i];
+    int groups_num = 0;
+
+    /* Groups without bones are kept, they are skipped at evaluation like in the generic code. */
+    for (int j = 0; j < dvert->totweight; j++) {
+      const MDeformWeight *dw = &dvert->dw[j];
+      if (dw->def_nr >= defbase_len) {
+        continue;
+      }
+      if (groups_num == PACKED_GROUPS_MAX) {
+        groups_num = PACKED_GROUPS_GENERIC;
+        break;
+      }
+      cache->groups[i][groups_num] = (int)dw->def_nr;
+      cache->weights[i][groups_num] = dw->weight;
+      groups_num++;
+    }
+    cache->groups_num[i] = (unsigned char)groups_num;
+
+    if (cache->armature_weights) {
+      cache->armature_weights[i] = BKE_defvert_find_weight(dvert, armature_def_nr);
+    }
+  }
+}
+
+/**
+ * Get packed weights of the mesh, re-using the cached ones when possible.
+ * Only weights of the mesh before modifiers are cached, modifiers before this one may change
+ * them on every evaluation.
+ */
+static const ArmatureDeformCache *armature_deform_cache_ensure(ArmatureDeformCache **cache_p,
+                                                               const Depsgraph *depsgraph,
+                                                               const Object *ob_target,
+                                                               const Mesh *me_target,
+                                                               const int defbase_len,
+                                                               const int armature_def_nr)
+{
+  const Mesh *me_base = (ob_target->runtime.data_orig != NULL) ?
+                            (const Mesh *)ob_target->runtime.data_orig :
+                            (const Mesh *)ob_target->data;
+  if (me_target->dvert != me_base->dvert || me_target->totvert != me_base->totvert) {
+    return NULL;
+  }
+
+  if (*cache_p == NULL) {
+    *cache_p = MEM_callocN(sizeof(ArmatureDeformCache), __func__);
+  }
+  ArmatureDeformCache *cache = *cache_p;
+
+  /* Weights are edited in place on the original mesh, which then gets copied to the evaluated
+   * one. Geometry updates from shape keys or drivers don't copy the mesh and keep the cache. */
+  const uint64_t mesh_generation = DEG_get_copy_on_write_generation(depsgraph,
+                                                                    (ID *)&me_base->id);
+  if (cache->dverts != me_target->dvert || cache->verts_num != me_target->totvert ||
+      cache->defbase_len != defbase_len || cache->armature_def_nr != armature_def_nr ||
+      cache->mesh_generation != mesh_generation) {
+    armature_deform_cache_build(cache,
+                                me_target->dvert,
+                                me_target->totvert,
+                                defbase_len,
+                                armature_def_nr,
+                                mesh_generation);
+  }
+  return cache;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Armature Deform #BKE_armature_deform_coords API
  *
@@ -258,6 +420,10 @@ typedef struct ArmatureUserdata {
   bPoseChannel **pchan_from_defbase;
   int defbase_len;
 
+  /* Packed weights, and the #PACKED_GROUP_UNUSED like type of each vertex group. */
+  const ArmatureDeformCache *packed;
+  const char *packed_group_type;
+
   float premat[4][4];
   float postmat[4][4];
 
@@ -414,12 +580,213 @@ static void armature_vert_task_with_dvert(const ArmatureUserdata *data,
   }
 }
 
+/* Linear blend skinning, the same operations as #pchan_deform_accumulate with 3 lanes. */
+static float armature_packed_accumulate_vec(const ArmatureUserdata *data,
+                                            const int groups_num,
+                                            const int *groups,
+                                            const float *weights,
+                                            const float co[3],
+                                            float r_vec[3])
+{
+  float contrib = 0.0f;
+
+#ifdef __SSE2__
+  const __m128 x = _mm_set1_ps(co[0]);
+  const __m128 y = _mm_set1_ps(co[1]);
+  const __m128 z = _mm_set1_ps(co[2]);
+  const __m128 co_in = _mm_set_ps(0.0f, co[2], co[1], co[0]);
+  __m128 vec = _mm_setzero_ps();
+
+  for (int j = 0; j < groups_num; j++) {
+    const bPoseChannel *pchan = data->pchan_from_defbase[groups[j]];
+    const float weight = weights[j];
+    if (pchan == NULL || weight == 0.0f) {
+      continue;
+    }
+    const float(*mat)[4] = pchan->chan_mat;
+    __m128 tmp = _mm_mul_ps(x, _mm_loadu_ps(mat[0]));
+    tmp = _mm_add_ps(tmp, _mm_mul_ps(y, _mm_loadu_ps(mat[1])));
+    tmp = _mm_add_ps(tmp, _mm_mul_ps(_mm_loadu_ps(mat[2]), z));
+    tmp = _mm_sub_ps(_mm_add_ps(tmp, _mm_loadu_ps(mat[3])), co_in);
+    vec = _mm_add_ps(vec, _mm_mul_ps(tmp, _mm_set1_ps(weight)));
+    contrib += weight;
+  }
+
+  float vec_store[4];
+  _mm_storeu_ps(vec_store, vec);
+  copy_v3_v3(r_vec, vec_store);
+#else
+  zero_v3(r_vec);
+  for (int j = 0; j < groups_num; j++) {
+    const bPoseChannel *pchan = data->pchan_from_defbase[groups[j]];
+    const float weight = weights[j];
+    if (pchan == NULL || weight == 0.0f) {
+      continue;
+    }
+    pchan_deform_accumulate(NULL, pchan->chan_mat, co, weight, r_vec, NULL, NULL);
+    contrib += weight;
+  }
+#endif
+
+  return contrib;
+}
+
+/* Dual quaternion skinning, the same operations as #add_weighted_dq_dq with 4 lanes. */
+static float armature_packed_accumulate_dq(const ArmatureUserdata *data,
+                                           const int groups_num,
+                                           const int *groups,
+                                           const float *weights,
+                                           DualQuat *r_dq)
+{
+  float contrib = 0.0f;
+
+  memset(r_dq, 0, sizeof(*r_dq));
+
+#ifdef __SSE2__
+  __m128 quat = _mm_setzero_ps();
+  __m128 trans = _mm_setzero_ps();
+  __m128 scale[4] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+
+  for (int j = 0; j < groups_num; j++) {
+    const bPoseChannel *pchan = data->pchan_from_defbase[groups[j]];
+    float weight = weights[j];
+    if (pchan == NULL || weight == 0.0f) {
+      continue;
+    }
+    contrib += weight;
+
+    const DualQuat *dq = &pchan->runtime.deform_dual_quat;
+
+    /* Interpolate in the right direction, but never use negative weights for scaling. */
+    float quat_sum[4];
+    _mm_storeu_ps(quat_sum, quat);
+    const float weight_scale = weight;
+    if (dot_qtqt(dq->quat, quat_sum) < 0) {
+      weight = -weight;
+    }
+
+    const __m128 weight_v = _mm_set1_ps(weight);
+    quat = _mm_add_ps(quat, _mm_mul_ps(weight_v, _mm_loadu_ps(dq->quat)));
+    trans = _mm_add_ps(trans, _mm_mul_ps(weight_v, _mm_loadu_ps(dq->trans)));
+
+    if (dq->scale_weight) {
+      const __m128 weight_scale_v = _mm_set1_ps(weight_scale);
+      for (int k = 0; k < 4; k++) {
+        scale[k] = _mm_add_ps(scale[k], _mm_mul_ps(_mm_loadu_ps(dq->scale[k]), weight_scale_v));
+      }
+      r_dq->scale_weight += weight_scale;
+    }
+  }
+
+  _mm_storeu_ps(r_dq->quat, quat);
+  _mm_storeu_ps(r_dq->trans, trans);
+  for (int k = 0; k < 4; k++) {
+    _mm_storeu_ps(r_dq->scale[k], scale[k]);
+  }
+#else
+  for (int j = 0; j < groups_num; j++) {
+    const bPoseChannel *pchan = data->pchan_from_defbase[groups[j]];
+    const float weight = weights[j];
+    if (pchan == NULL || weight == 0.0f) {
+      continue;
+    }
+    add_weighted_dq_dq(r_dq, &pchan->runtime.deform_dual_quat, weight);
+    contrib += weight;
+  }
+#endif
+
+  return contrib;
+}
+
+/**
+ * Deform a vertex using the packed weights, with the same result as
+ * #armature_vert_task_with_dvert. Only used without deform matrices and previous coordinates.
+ */
+static void armature_vert_task_packed(const ArmatureUserdata *data,
+                                      const int i,
+                                      const MDeformVert *dvert)
+{
+  const ArmatureDeformCache *packed = data->packed;
+  const int groups_num = packed->groups_num[i];
+
+  if (groups_num == PACKED_GROUPS_GENERIC) {
+    armature_vert_task_with_dvert(data, i, dvert);
+    return;
+  }
+
+  const int *groups = packed->groups[i];
+  const float *weights = packed->weights[i];
+  bool deformed = false;
+  for (int j = 0; j < groups_num; j++) {
+    const char group_type = data->packed_group_type[groups[j]];
+    if (group_type == PACKED_GROUP_GENERIC) {
+      armature_vert_task_with_dvert(data, i, dvert);
+      return;
+    }
+    deformed |= (group_type == PACKED_GROUP_BONE);
+  }
+  /* Envelopes are used when no vertex group has a bone. */
+  if (!deformed && data->use_envelope) {
+    armature_vert_task_with_dvert(data, i, dvert);
+    return;
+  }
+
+  float armature_weight = 1.0f;
+  if (packed->armature_weights) {
+    armature_weight = packed->armature_weights[i];
+    if (data->invert_vgroup) {
+      armature_weight = 1.0f - armature_weight;
+    }
+  }
+  if (armature_weight == 0.0f) {
+    return;
+  }
+
+  float *co = data->vert_coords[i];
+  mul_m4_v3(data->premat, co);
+
+  if (data->use_quaternion) {
+    DualQuat dq;
+    const float contrib = armature_packed_accumulate_dq(data, groups_num, groups, weights, &dq);
+    if (contrib > 0.0001f) {
+      normalize_dq(&dq, contrib);
+
+      if (armature_weight != 1.0f) {
+        float dco[3];
+        copy_v3_v3(dco, co);
+        mul_v3m3_dq(dco, NULL, &dq);
+        sub_v3_v3(dco, co);
+        mul_v3_fl(dco, armature_weight);
+        add_v3_v3(co, dco);
+      }
+      else {
+        mul_v3m3_dq(co, NULL, &dq);
+      }
+    }
+  }
+  else {
+    float vec[3];
+    const float contrib = armature_packed_accumulate_vec(
+        data, groups_num, groups, weights, co, vec);
+    if (contrib > 0.0001f) {
+      mul_v3_fl(vec, armature_weight / contrib);
+      add_v3_v3v3(co, vec, co);
+    }
+  }
+
+  mul_m4_v3(data->postmat, co);
+}
+
 static void armature_vert_task(void *__restrict userdata,
                                const int i,
                                const TaskParallelTLS *__restrict UNUSED(tls))
 {
   const ArmatureUserdata *data = userdata;
   const MDeformVert *dvert;
+  if (data->packed) {
+    armature_vert_task_packed(data, i, data->me_target->dvert + i);
+    return;
+  }
   if (data->use_dverts || data->armature_def_nr != -1) {
     if (data->me_target) {
       BLI_assert(i < data->me_target->totvert);
@@ -469,7 +836,9 @@ static void armature_deform_coords_impl(const Object *ob_arm,
                                         const char *defgrp_name,
                                         const Mesh *me_target,
                                         BMEditMesh *em_target,
-                                        bGPDstroke *gps_target)
+                                        bGPDstroke *gps_target,
+                                        const Depsgraph *depsgraph,
+                                        ArmatureDeformCache **cache)
 {
   bArmature *arm = ob_arm->data;
   bPoseChannel **pchan_from_defbase = NULL;
@@ -483,6 +852,8 @@ static void armature_deform_coords_impl(const Object *ob_arm,
   bool use_dverts = false;
   int armature_def_nr;
   int cd_dvert_offset = -1;
+  const ArmatureDeformCache *packed = NULL;
+  char *packed_group_type = NULL;
 
   /* in editmode, or not an armature */
   if (arm->edbo || (ob_arm->pose == NULL)) {
@@ -560,6 +931,30 @@ static void armature_deform_coords_impl(const Object *ob_arm,
     }
   }
 
+  /* Use packed weights for the common case of deforming mesh coordinates by vertex groups. */
+  if (cache != NULL && depsgraph != NULL && use_dverts && me_target != NULL &&
+      vert_deform_mats == NULL && vert_coords_prev == NULL) {
+    packed = armature_deform_cache_ensure(
+        cache, depsgraph, ob_target, me_target, defbase_len, armature_def_nr);
+  }
+  if (packed) {
+    packed_group_type = MEM_malloc_arrayN(defbase_len, sizeof(*packed_group_type), __func__);
+    for (i = 0; i < defbase_len; i++) {
+      const bPoseChannel *pchan = pchan_from_defbase[i];
+      if (pchan == NULL) {
+        packed_group_type[i] = PACKED_GROUP_UNUSED;
+      }
+      else if ((pchan->bone->segments > 1 &&
+                pchan->runtime.bbone_segments == pchan->bone->segments) ||
+               (pchan->bone->flag & BONE_MULT_VG_ENV)) {
+        packed_group_type[i] = PACKED_GROUP_GENERIC;
+      }
+      else {
+        packed_group_type[i] = PACKED_GROUP_BONE;
+      }
+    }
+  }
+
   ArmatureUserdata data = {
       .ob_arm = ob_arm,
       .ob_target = ob_target,
@@ -576,6 +971,8 @@ static void armature_deform_coords_impl(const Object *ob_arm,
       .dverts_len = dverts_len,
       .pchan_from_defbase = pchan_from_defbase,
       .defbase_len = defbase_len,
+      .packed = packed,
+      .packed_group_type = packed_group_type,
       .bmesh =
           {
               .cd_dvert_offset = cd_dvert_offset,
@@ -611,6 +1008,9 @@ static void armature_deform_coords_impl(const Object *ob_arm,
   if (pchan_from_defbase) {
     MEM_freeN(pchan_from_defbase);
   }
+  if (packed_group_type) {
+    MEM_freeN(packed_group_type);
+  }
 }
 
 void BKE_armature_deform_coords_with_gpencil_stroke(const Object *ob_arm,
@@ -633,7 +1033,9 @@ void BKE_armature_deform_coords_with_gpencil_stroke(const Object *ob_arm,
                               defgrp_name,
                               NULL,
                               NULL,
-                              gps_target);
+                              gps_target,
+                              NULL,
+                              NULL);
 }
 
 void BKE_armature_deform_coords_with_mesh(const Object *ob_arm,
@@ -644,7 +1046,9 @@ void BKE_armature_deform_coords_with_mesh(const Object *ob_arm,
                                           int deformflag,
                                           float (*vert_coords_prev)[3],
                                           const char *defgrp_name,
-                                          const Mesh *me_target)
+                                          const Mesh *me_target,
+                                          const Depsgraph *depsgraph,
+                                          ArmatureDeformCache **cache)
 {
   armature_deform_coords_impl(ob_arm,
                               ob_target,
@@ -656,7 +1060,9 @@ void BKE_armature_deform_coords_with_mesh(const Object *ob_arm,
                               defgrp_name,
                               me_target,
                               NULL,
-                              NULL);
+                              NULL,
+                              depsgraph,
+                              cache);
 }
 
 void BKE_armature_deform_coords_with_editmesh(const Object *ob_arm,
@@ -679,6 +1085,8 @@ void BKE_armature_deform_coords_with_editmesh(const Object *ob_arm,
                               defgrp_name,
                               NULL,
                               em_target,
+                              NULL,
+                              NULL,
                               NULL);
 }
 
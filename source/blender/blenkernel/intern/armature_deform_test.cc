@@ -0,0 +1,310 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "tests/depsgraph_base_test.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_armature.h"
+#include "BKE_collection.h"
+#include "BKE_customdata.h"
+#include "BKE_deform.h"
+#include "BKE_key.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_object.h"
+
+#include "BLI_array.hh"
+#include "BLI_float3.hh"
+#include "BLI_listbase.h"
+#include "BLI_math.h"
+#include "BLI_rand.hh"
+#include "BLI_string.h"
+
+#include "DNA_action_types.h"
+#include "DNA_armature_types.h"
+#include "DNA_key_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+
+#include "PIL_time.h"
+
+namespace blender::bke::tests {
+
+class ArmatureDeformTest : public deg::tests::DepsgraphBaseTest {
+ public:
+  Object *ob_arm;
+  Object *ob_mesh;
+  Mesh *mesh;
+
+  /* Armature with bones along the X axis, posed with random rotation, scale and offset. */
+  void armature_add(const int bones_num, RandomNumberGenerator &rng)
+  {
+    bArmature *arm = BKE_armature_add(bmain, "Armature");
+    ob_arm = BKE_object_add_only_object(bmain, OB_ARMATURE, "Armature");
+    ob_arm->data = arm;
+    unit_m4(ob_arm->obmat);
+
+    for (int i = 0; i < bones_num; i++) {
+      Bone *bone = (Bone *)MEM_callocN(sizeof(Bone), __func__);
+      BLI_snprintf(bone->name, sizeof(bone->name), "Bone%d", i);
+      copy_v3_fl3(bone->arm_head, (float)i, 0.0f, 0.0f);
+      copy_v3_fl3(bone->arm_tail, (float)i + 1.0f, 0.0f, 0.0f);
+      unit_m4(bone->arm_mat);
+      copy_v3_v3(bone->arm_mat[3], bone->arm_head);
+      bone->length = 1.0f;
+      bone->segments = 1;
+      bone->rad_head = bone->rad_tail = 0.25f;
+      bone->dist = 0.5f;
+      bone->weight = 1.0f;
+      BLI_addtail(&arm->bonebase, bone);
+    }
+    BKE_pose_rebuild(bmain, ob_arm, arm, false);
+
+    LISTBASE_FOREACH (bPoseChannel *, pchan, &ob_arm->pose->chanbase) {
+      float eul[3] = {rng.get_float(), rng.get_float(), rng.get_float()};
+      float loc[3] = {rng.get_float(), rng.get_float(), rng.get_float()};
+      float size[3] = {1.0f, 1.0f, 1.0f};
+      /* Some bones with scale, which dual quaternions handle separately. */
+      if (rng.get_float() < 0.3f) {
+        copy_v3_fl3(size, 0.5f + rng.get_float(), 0.5f + rng.get_float(), 1.0f);
+      }
+      add_v3_v3(loc, pchan->bone->arm_head);
+      loc_eul_size_to_mat4(pchan->pose_mat, loc, eul, size);
+
+      float imat[4][4];
+      invert_m4_m4(imat, pchan->bone->arm_mat);
+      mul_m4_m4m4(pchan->chan_mat, pchan->pose_mat, imat);
+      mat4_to_dquat(&pchan->runtime.deform_dual_quat, pchan->bone->arm_mat, pchan->chan_mat);
+    }
+  }
+
+  /* Mesh with a vertex group for every bone, one without bone and an "Armature" group. */
+  void mesh_add(const int verts_num, const int groups_max, RandomNumberGenerator &rng)
+  {
+    mesh = BKE_mesh_add(bmain, "Mesh");
+    ob_mesh = BKE_object_add_only_object(bmain, OB_MESH, "Mesh");
+    ob_mesh->data = mesh;
+    unit_m4(ob_mesh->obmat);
+
+    LISTBASE_FOREACH (bPoseChannel *, pchan, &ob_arm->pose->chanbase) {
+      BKE_object_defgroup_new(ob_mesh, pchan->name);
+    }
+    BKE_object_defgroup_new(ob_mesh, "Other");
+    BKE_object_defgroup_new(ob_mesh, "Armature");
+    const int defbase_len = BLI_listbase_count(&ob_mesh->defbase);
+
+    mesh->totvert = verts_num;
+    mesh->mvert = (MVert *)CustomData_add_layer(
+        &mesh->vdata, CD_MVERT, CD_CALLOC, nullptr, verts_num);
+    mesh->dvert = (MDeformVert *)CustomData_add_layer(
+        &mesh->vdata, CD_MDEFORMVERT, CD_CALLOC, nullptr, verts_num);
+    for (int i = 0; i < verts_num; i++) {
+      const int groups_num = (int)(rng.get_uint32() % (groups_max + 1));
+      for (int j = 0; j < groups_num; j++) {
+        const int def_nr = (int)(rng.get_uint32() % (defbase_len - 1));
+        if (BKE_defvert_find_index(&mesh->dvert[i], def_nr) == nullptr) {
+          BKE_defvert_add_index_notest(&mesh->dvert[i], def_nr, rng.get_float());
+        }
+      }
+      if (i % 3) {
+        BKE_defvert_add_index_notest(&mesh->dvert[i], defbase_len - 1, rng.get_float());
+      }
+    }
+  }
+
+  Array<float3> coords_random(RandomNumberGenerator &rng)
+  {
+    Array<float3> coords(mesh->totvert);
+    for (float3 &co : coords) {
+      co = float3(rng.get_float() * 10.0f, rng.get_float() - 0.5f, rng.get_float() - 0.5f);
+    }
+    return coords;
+  }
+
+  void deform(Array<float3> &coords,
+              const int deformflag,
+              const char *defgrp_name,
+              ArmatureDeformCache **cache)
+  {
+    BKE_armature_deform_coords_with_mesh(ob_arm,
+                                         ob_mesh,
+                                         reinterpret_cast<float(*)[3]>(coords.data()),
+                                         nullptr,
+                                         (int)coords.size(),
+                                         deformflag,
+                                         nullptr,
+                                         defgrp_name,
+                                         mesh,
+                                         graph,
+                                         cache);
+  }
+
+  /* Compare deforming with the packed weights to the generic code. */
+  void expect_packed_matches(const Array<float3> &coords,
+                             const int deformflag,
+                             const char *defgrp_name,
+                             ArmatureDeformCache **cache)
+  {
+    Array<float3> coords_generic = coords;
+    deform(coords_generic, deformflag, defgrp_name, nullptr);
+    Array<float3> coords_packed = coords;
+    deform(coords_packed, deformflag, defgrp_name, cache);
+    ASSERT_NE(*cache, nullptr);
+
+    for (int i = 0; i < coords.size(); i++) {
+      EXPECT_FLOAT_EQ(coords_packed[i].x, coords_generic[i].x);
+      EXPECT_FLOAT_EQ(coords_packed[i].y, coords_generic[i].y);
+      EXPECT_FLOAT_EQ(coords_packed[i].z, coords_generic[i].z);
+    }
+  }
+};
+
+TEST_F(ArmatureDeformTest, packed_weights)
+{
+  RandomNumberGenerator rng;
+  armature_add(8, rng);
+  mesh_add(2000, 6, rng);
+  /* Vertices influenced by this bone use the generic code. */
+  ((bPoseChannel *)ob_arm->pose->chanbase.first)->bone->flag |= BONE_MULT_VG_ENV;
+  const Array<float3> coords = coords_random(rng);
+
+  const int deformflags[] = {
+      ARM_DEF_VGROUP,
+      ARM_DEF_VGROUP | ARM_DEF_QUATERNION,
+      ARM_DEF_VGROUP | ARM_DEF_ENVELOPE,
+      ARM_DEF_VGROUP | ARM_DEF_ENVELOPE | ARM_DEF_QUATERNION,
+      ARM_DEF_VGROUP | ARM_DEF_INVERT_VGROUP,
+  };
+  for (const int deformflag : deformflags) {
+    ArmatureDeformCache *cache = nullptr;
+    expect_packed_matches(coords, deformflag, "", &cache);
+    expect_packed_matches(coords, deformflag, "Armature", &cache);
+    BKE_armature_deform_cache_free(cache);
+  }
+}
+
+TEST_F(ArmatureDeformTest, packed_weights_update)
+{
+  RandomNumberGenerator rng;
+  armature_add(4, rng);
+  mesh_add(100, 3, rng);
+  const Array<float3> coords = coords_random(rng);
+
+  mesh->key = BKE_key_add(bmain, &mesh->id);
+  BKE_collection_object_add(bmain, scene->master_collection, ob_mesh);
+  DEG_graph_build_from_view_layer(graph);
+  DEG_evaluate_on_refresh(graph);
+
+  ArmatureDeformCache *cache = nullptr;
+  expect_packed_matches(coords, ARM_DEF_VGROUP, "", &cache);
+  Array<float3> coords_packed = coords;
+  deform(coords_packed, ARM_DEF_VGROUP, "", &cache);
+
+  /* Weights are edited in place, without telling the cache. */
+  for (int i = 0; i < mesh->totvert; i++) {
+    if (mesh->dvert[i].totweight) {
+      mesh->dvert[i].dw[0].weight *= 0.5f;
+    }
+  }
+
+  /* Geometry updates which don't copy the mesh, like shape keys driven by bones on every frame,
+   * keep the packed weights. */
+  DEG_id_tag_update_ex(bmain, &mesh->key->id, ID_RECALC_GEOMETRY);
+  DEG_evaluate_on_refresh(graph);
+  Array<float3> coords_kept = coords;
+  deform(coords_kept, ARM_DEF_VGROUP, "", &cache);
+  for (int i = 0; i < coords.size(); i++) {
+    EXPECT_EQ(coords_kept[i], coords_packed[i]);
+  }
+
+  /* Editing the mesh copies it to the evaluated one, which updates the weights. */
+  DEG_id_tag_update_ex(bmain, &mesh->id, ID_RECALC_GEOMETRY);
+  DEG_evaluate_on_refresh(graph);
+  expect_packed_matches(coords, ARM_DEF_VGROUP, "", &cache);
+
+  /* Vertex groups assigned by modifiers are not cached. */
+  Mesh *mesh_orig = mesh;
+  mesh = BKE_mesh_copy_for_eval(mesh_orig, false);
+  BKE_armature_deform_cache_free(cache);
+  cache = nullptr;
+  Array<float3> coords_deformed = coords;
+  deform(coords_deformed, ARM_DEF_VGROUP, "", &cache);
+  EXPECT_EQ(cache, nullptr);
+  BKE_id_free(nullptr, mesh);
+  mesh = mesh_orig;
+}
+
+/* Character sized mesh with up to 4 bones per vertex. */
+static void armature_deform_performance(ArmatureDeformTest &test, const int deformflag)
+{
+  const int verts_num = 1000000;
+  RandomNumberGenerator rng;
+  test.armature_add(100, rng);
+  test.mesh_add(verts_num, 4, rng);
+  const Array<float3> coords = test.coords_random(rng);
+
+  ArmatureDeformCache *cache = nullptr;
+  Array<float3> coords_packed = coords;
+  double time_start = PIL_check_seconds_timer();
+  test.deform(coords_packed, deformflag, "", &cache);
+  const double time_build = PIL_check_seconds_timer() - time_start;
+
+  /* Best of a few runs each, timings vary a lot between runs. */
+  const int runs_num = 5;
+  double time_generic = DBL_MAX, time_packed = DBL_MAX;
+  Array<float3> coords_generic = coords;
+  for (int run = 0; run < runs_num; run++) {
+    coords_generic = coords;
+    time_start = PIL_check_seconds_timer();
+    test.deform(coords_generic, deformflag, "", nullptr);
+    time_generic = min_dd(time_generic, PIL_check_seconds_timer() - time_start);
+
+    coords_packed = coords;
+    time_start = PIL_check_seconds_timer();
+    test.deform(coords_packed, deformflag, "", &cache);
+    time_packed = min_dd(time_packed, PIL_check_seconds_timer() - time_start);
+  }
+  BKE_armature_deform_cache_free(cache);
+
+  for (int i = 0; i < verts_num; i++) {
+    EXPECT_FLOAT_EQ(coords_packed[i].x, coords_generic[i].x);
+  }
+  printf("%s deform of %d vertices, generic: %.3f ms, packed: %.3f ms (first: %.3f ms)\n",
+         (deformflag & ARM_DEF_QUATERNION) ? "Dual quaternion" : "Linear blend",
+         verts_num,
+         time_generic * 1000.0,
+         time_packed * 1000.0,
+         time_build * 1000.0);
+}
+
+TEST_F(ArmatureDeformTest, performance_linear_blend_1000000)
+{
+  armature_deform_performance(*this, ARM_DEF_VGROUP);
+}
+
+TEST_F(ArmatureDeformTest, performance_dual_quaternion_1000000)
+{
+  armature_deform_performance(*this, ARM_DEF_VGROUP | ARM_DEF_QUATERNION);
+}
+
+}  // namespace blender::bke::tests
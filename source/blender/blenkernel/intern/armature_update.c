@@ -744,16 +744,11 @@ static void pose_channel_flush_to_orig_if_needed(struct Depsgraph *depsgraph,
   copy_v3_v3(pchan_orig->pose_tail, pchan->pose_tail);
 }
 
-void BKE_pose_bone_done(struct Depsgraph *depsgraph, struct Object *object, int pchan_index)
+static void pose_channel_done(struct Depsgraph *depsgraph,
+                              struct Object *object,
+                              bPoseChannel *pchan)
 {
-  const bArmature *armature = (bArmature *)object->data;
-  if (armature->edbo != NULL) {
-    return;
-  }
-  bPoseChannel *pchan = pose_pchan_get_indexed(object, pchan_index);
   float imat[4][4];
-  DEG_debug_print_eval_subdata(
-      depsgraph, __func__, object->id.name, object, "pchan", pchan->name, pchan);
   if (pchan->bone) {
     invert_m4_m4(imat, pchan->bone->arm_mat);
     mul_m4_m4m4(pchan->chan_mat, pchan->pose_mat, imat);
@@ -770,6 +765,28 @@ void BKE_pose_bone_done(struct Depsgraph *depsgraph, struct Object *object, int
   }
 }
 
+static void pose_channel_bbone_segments(struct Depsgraph *depsgraph, bPoseChannel *pchan)
+{
+  if (pchan->bone != NULL && pchan->bone->segments > 1) {
+    BKE_pchan_bbone_segments_cache_compute(pchan);
+    if (DEG_is_active(depsgraph)) {
+      BKE_pchan_bbone_segments_cache_copy(pchan->orig_pchan, pchan);
+    }
+  }
+}
+
+void BKE_pose_bone_done(struct Depsgraph *depsgraph, struct Object *object, int pchan_index)
+{
+  const bArmature *armature = (bArmature *)object->data;
+  if (armature->edbo != NULL) {
+    return;
+  }
+  bPoseChannel *pchan = pose_pchan_get_indexed(object, pchan_index);
+  DEG_debug_print_eval_subdata(
+      depsgraph, __func__, object->id.name, object, "pchan", pchan->name, pchan);
+  pose_channel_done(depsgraph, object, pchan);
+}
+
 void BKE_pose_eval_bbone_segments(struct Depsgraph *depsgraph,
                                   struct Object *object,
                                   int pchan_index)
@@ -781,11 +798,47 @@ void BKE_pose_eval_bbone_segments(struct Depsgraph *depsgraph,
   bPoseChannel *pchan = pose_pchan_get_indexed(object, pchan_index);
   DEG_debug_print_eval_subdata(
       depsgraph, __func__, object->id.name, object, "pchan", pchan->name, pchan);
-  if (pchan->bone != NULL && pchan->bone->segments > 1) {
-    BKE_pchan_bbone_segments_cache_compute(pchan);
-    if (DEG_is_active(depsgraph)) {
-      BKE_pchan_bbone_segments_cache_copy(pchan->orig_pchan, pchan);
+  pose_channel_bbone_segments(depsgraph, pchan);
+}
+
+/* Evaluate all bones of a pose which has no IK solvers and no dependencies on other data-blocks,
+ * replacing the per-bone operations. Channels are visited in `pchan_order`, which has parents and
+ * constraint targets before the channels using them.
+ *
+ * Each bone is computed by the same functions as in the per-bone operations, so this only saves
+ * the depsgraph scheduling overhead of those operations, not any of the bone math. */
+void BKE_pose_eval_batch(struct Depsgraph *depsgraph,
+                         Scene *scene,
+                         Object *object,
+                         const int *pchan_order,
+                         int pchan_order_len)
+{
+  const bArmature *armature = (bArmature *)object->data;
+  if (armature->edbo != NULL) {
+    return;
+  }
+  DEG_debug_print_eval(depsgraph, __func__, object->id.name, object);
+  BLI_assert(object->type == OB_ARMATURE);
+  const float ctime = BKE_scene_frame_get(scene); /* not accurate... */
+  for (int i = 0; i < pchan_order_len; i++) {
+    bPoseChannel *pchan = pose_pchan_get_indexed(object, pchan_order[i]);
+    BLI_assert((pchan->flag & (POSE_IKTREE | POSE_IKSPLINE)) == 0);
+    if (armature->flag & ARM_RESTPOS) {
+      Bone *bone = pchan->bone;
+      if (bone) {
+        copy_m4_m4(pchan->pose_mat, bone->arm_mat);
+        copy_v3_v3(pchan->pose_head, bone->arm_head);
+        copy_v3_v3(pchan->pose_tail, bone->arm_tail);
+      }
     }
+    else if ((pchan->flag & POSE_DONE) == 0) {
+      BKE_pose_where_is_bone(depsgraph, scene, object, pchan, ctime, 1);
+    }
+    pose_channel_done(depsgraph, object, pchan);
+  }
+  /* B-Bone shapes use the final transform of their handles. */
+  for (int i = 0; i < pchan_order_len; i++) {
+    pose_channel_bbone_segments(depsgraph, pose_pchan_get_indexed(object, pchan_order[i]));
   }
 }
 
@@ -0,0 +1,272 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "tests/depsgraph_base_test.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_action.h"
+#include "BKE_anim_data.h"
+#include "BKE_armature.h"
+#include "BKE_collection.h"
+#include "BKE_constraint.h"
+#include "BKE_fcurve.h"
+#include "BKE_layer.h"
+#include "BKE_object.h"
+
+#include "BLI_listbase.h"
+#include "BLI_math.h"
+#include "BLI_string.h"
+#include "BLI_vector.hh"
+
+#include "DNA_action_types.h"
+#include "DNA_anim_types.h"
+#include "DNA_armature_types.h"
+#include "DNA_constraint_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+#include "DEG_depsgraph_debug.h"
+#include "DEG_depsgraph_query.h"
+
+#include "ED_keyframing.h"
+
+#include "PIL_time.h"
+
+namespace blender::bke::tests {
+
+class ArmatureUpdateTest : public deg::tests::DepsgraphBaseTest {
+ public:
+  static Bone *bone_add(ListBase *bonebase, Bone *parent, const char *name, const float x)
+  {
+    Bone *bone = (Bone *)MEM_callocN(sizeof(Bone), __func__);
+    BLI_strncpy(bone->name, name, sizeof(bone->name));
+    /* Children start at the tail of their parent. */
+    copy_v3_fl3(bone->head, parent ? 0.0f : x, 0.0f, 0.0f);
+    copy_v3_fl3(bone->tail, parent ? 0.0f : x, 1.0f, 0.0f);
+    bone->parent = parent;
+    bone->weight = 1.0f;
+    BLI_addtail(parent ? &parent->childbase : bonebase, bone);
+    return bone;
+  }
+
+  /* Armature of chains with `chain_len` bones each, with a pose on every bone. */
+  Object *rig_add(const char *name, const int chains_num, const int chain_len)
+  {
+    bArmature *arm = BKE_armature_add(bmain, name);
+    Object *object = BKE_object_add_only_object(bmain, OB_ARMATURE, name);
+    object->data = arm;
+    for (int chain = 0; chain < chains_num; chain++) {
+      Bone *parent = nullptr;
+      for (int i = 0; i < chain_len; i++) {
+        char bone_name[64];
+        BLI_snprintf(bone_name, sizeof(bone_name), "Bone%d.%d", chain, i);
+        parent = bone_add(&arm->bonebase, parent, bone_name, (float)chain);
+      }
+    }
+    BKE_armature_where_is(arm);
+    BKE_pose_rebuild(bmain, object, arm, true);
+
+    int pchan_index = 0;
+    LISTBASE_FOREACH (bPoseChannel *, pchan, &object->pose->chanbase) {
+      pchan->rotmode = ROT_MODE_XYZ;
+      copy_v3_fl3(pchan->eul, 0.1f * pchan_index, 0.2f, -0.05f * pchan_index);
+      copy_v3_fl3(pchan->loc, 0.0f, 0.01f * pchan_index, 0.0f);
+      copy_v3_fl3(pchan->size, 1.0f, 1.0f + 0.01f * pchan_index, 1.0f);
+      pchan_index++;
+    }
+    BKE_collection_object_add(bmain, scene->master_collection, object);
+    BKE_main_collection_sync(bmain);
+    return object;
+  }
+
+  /* Animate the location of the first bone, re-evaluating the whole pose on frame changes. */
+  void rig_animate(Object *object)
+  {
+    bAction *action = BKE_action_add(bmain, object->id.name + 2);
+    AnimData *adt = BKE_animdata_add_id(&object->id);
+    adt->action = action;
+    FCurve *fcu = BKE_fcurve_create();
+    const bPoseChannel *pchan = (bPoseChannel *)object->pose->chanbase.first;
+    char rna_path[128];
+    BLI_snprintf(rna_path, sizeof(rna_path), "pose.bones[\"%s\"].location", pchan->name);
+    fcu->rna_path = BLI_strdup(rna_path);
+    fcu->flag = FCURVE_VISIBLE | FCURVE_SELECTED;
+    insert_vert_fcurve(fcu, 1.0f, 0.0f, BEZT_KEYTYPE_KEYFRAME, INSERTKEY_NO_USERPREF);
+    insert_vert_fcurve(fcu, 100.0f, 1.0f, BEZT_KEYTYPE_KEYFRAME, INSERTKEY_NO_USERPREF);
+    BLI_addtail(&action->curves, fcu);
+  }
+
+  /* Build a new dependency graph, returns the number of operations in it. */
+  size_t graph_build_and_evaluate()
+  {
+    if (graph != nullptr) {
+      DEG_graph_free(graph);
+    }
+    graph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_VIEWPORT);
+    DEG_graph_build_from_view_layer(graph);
+    DEG_evaluate_on_refresh(graph);
+    DEG_ids_clear_recalc(bmain, graph);
+    size_t outer, operations_num, relations_num;
+    DEG_stats_simple(graph, &outer, &operations_num, &relations_num);
+    return operations_num;
+  }
+
+  struct PoseResult {
+    float pose_mat[4][4];
+    float chan_mat[4][4];
+    DualQuat deform_dual_quat;
+    Vector<float> bbone_pose_mats;
+  };
+
+  Vector<PoseResult> pose_result_get(Object *object)
+  {
+    Object *object_eval = DEG_get_evaluated_object(graph, object);
+    Vector<PoseResult> result;
+    LISTBASE_FOREACH (bPoseChannel *, pchan, &object_eval->pose->chanbase) {
+      PoseResult pchan_result;
+      copy_m4_m4(pchan_result.pose_mat, pchan->pose_mat);
+      copy_m4_m4(pchan_result.chan_mat, pchan->chan_mat);
+      pchan_result.deform_dual_quat = pchan->runtime.deform_dual_quat;
+      if (pchan->runtime.bbone_pose_mats != nullptr) {
+        const float *mats = (const float *)pchan->runtime.bbone_pose_mats;
+        const int mats_len = (pchan->runtime.bbone_segments + 1) * sizeof(Mat4) / sizeof(float);
+        pchan_result.bbone_pose_mats.extend(Span<float>(mats, mats_len));
+      }
+      result.append(std::move(pchan_result));
+    }
+    return result;
+  }
+
+  static void expect_pose_result_eq(const Vector<PoseResult> &a, const Vector<PoseResult> &b)
+  {
+    ASSERT_EQ(a.size(), b.size());
+    for (int i = 0; i < a.size(); i++) {
+      EXPECT_M4_NEAR(a[i].pose_mat, b[i].pose_mat, 0.0f);
+      EXPECT_M4_NEAR(a[i].chan_mat, b[i].chan_mat, 0.0f);
+      EXPECT_V4_NEAR(a[i].deform_dual_quat.quat, b[i].deform_dual_quat.quat, 0.0f);
+      EXPECT_V4_NEAR(a[i].deform_dual_quat.trans, b[i].deform_dual_quat.trans, 0.0f);
+      EXPECT_EQ_ARRAY(a[i].bbone_pose_mats.data(),
+                      b[i].bbone_pose_mats.data(),
+                      std::min(a[i].bbone_pose_mats.size(), b[i].bbone_pose_mats.size()));
+      EXPECT_EQ(a[i].bbone_pose_mats.size(), b[i].bbone_pose_mats.size());
+    }
+  }
+};
+
+TEST_F(ArmatureUpdateTest, pose_batch)
+{
+  Object *object = rig_add("Rig", 2, 3);
+  bArmature *arm = (bArmature *)object->data;
+  /* Constraint targeting a bone which comes later in the list of channels. */
+  bPoseChannel *pchan_owner = BKE_pose_channel_find_name(object->pose, "Bone0.1");
+  bConstraint *con = BKE_constraint_add_for_pose(
+      object, pchan_owner, "Copy Rotation", CONSTRAINT_TYPE_ROTLIKE);
+  bRotateLikeConstraint *data = (bRotateLikeConstraint *)con->data;
+  data->tar = object;
+  STRNCPY(data->subtarget, "Bone1.2");
+  con->enforce = 0.5f;
+  /* B-Bone shape using the handles. */
+  BKE_pose_channel_find_name(object->pose, "Bone1.1")->bone->segments = 4;
+
+  const size_t operations_num = graph_build_and_evaluate();
+  const Vector<PoseResult> result = pose_result_get(object);
+
+  arm->flag |= ARM_POSE_BATCH;
+  const size_t operations_batch_num = graph_build_and_evaluate();
+  EXPECT_LT(operations_batch_num, operations_num);
+  expect_pose_result_eq(pose_result_get(object), result);
+
+  /* Rest position. */
+  arm->flag &= ~ARM_POSE_BATCH;
+  arm->flag |= ARM_RESTPOS;
+  graph_build_and_evaluate();
+  const Vector<PoseResult> result_rest = pose_result_get(object);
+  arm->flag |= ARM_POSE_BATCH;
+  graph_build_and_evaluate();
+  expect_pose_result_eq(pose_result_get(object), result_rest);
+}
+
+TEST_F(ArmatureUpdateTest, pose_batch_fallback)
+{
+  Object *object = rig_add("Rig", 1, 3);
+  bArmature *arm = (bArmature *)object->data;
+  Object *target = BKE_object_add_only_object(bmain, OB_EMPTY, "Target");
+  copy_v3_fl3(target->loc, 1.0f, 2.0f, 3.0f);
+  BKE_collection_object_add(bmain, scene->master_collection, target);
+  BKE_main_collection_sync(bmain);
+  bPoseChannel *pchan_owner = BKE_pose_channel_find_name(object->pose, "Bone0.1");
+  bConstraint *con = BKE_constraint_add_for_pose(
+      object, pchan_owner, "Copy Location", CONSTRAINT_TYPE_LOCLIKE);
+  ((bLocateLikeConstraint *)con->data)->tar = target;
+
+  const size_t operations_num = graph_build_and_evaluate();
+  const Vector<PoseResult> result = pose_result_get(object);
+  EXPECT_V3_NEAR(result[1].pose_mat[3], target->loc, 1e-6f);
+
+  /* Constraints using other objects keep the per-bone operations. */
+  arm->flag |= ARM_POSE_BATCH;
+  EXPECT_EQ(graph_build_and_evaluate(), operations_num);
+  expect_pose_result_eq(pose_result_get(object), result);
+
+  /* And so do cycles between bones of the same rig. */
+  ((bLocateLikeConstraint *)con->data)->tar = object;
+  STRNCPY(((bLocateLikeConstraint *)con->data)->subtarget, "Bone0.2");
+  arm->flag &= ~ARM_POSE_BATCH;
+  const size_t operations_cycle_num = graph_build_and_evaluate();
+  arm->flag |= ARM_POSE_BATCH;
+  EXPECT_EQ(graph_build_and_evaluate(), operations_cycle_num);
+}
+
+/* Crowd of animated rigs, compare frame changes with per-bone operations and batches. */
+TEST_F(ArmatureUpdateTest, performance_rigs_100)
+{
+  const int rigs_num = 100;
+  const int frames_num = 50;
+  Vector<Object *> objects;
+  for (int i = 0; i < rigs_num; i++) {
+    Object *object = rig_add("Rig", 10, 10);
+    rig_animate(object);
+    objects.append(object);
+  }
+
+  auto evaluate_frames = [&](const bool use_batch, double *r_time) {
+    for (Object *object : objects) {
+      SET_FLAG_FROM_TEST(((bArmature *)object->data)->flag, use_batch, ARM_POSE_BATCH);
+    }
+    graph_build_and_evaluate();
+    const double time_start = PIL_check_seconds_timer();
+    for (int frame = 1; frame <= frames_num; frame++) {
+      DEG_evaluate_on_framechange(graph, (float)frame);
+    }
+    *r_time = PIL_check_seconds_timer() - time_start;
+    return pose_result_get(objects.last());
+  };
+  double time_bones, time_batch;
+  const Vector<PoseResult> result_bones = evaluate_frames(false, &time_bones);
+  const Vector<PoseResult> result_batch = evaluate_frames(true, &time_batch);
+  expect_pose_result_eq(result_batch, result_bones);
+  printf("Pose of %d rigs for %d frames, per-bone: %.3f ms, batch: %.3f ms\n",
+         rigs_num,
+         frames_num,
+         time_bones * 1000.0,
+         time_batch * 1000.0);
+}
+
+}  // namespace blender::bke::tests
@@ -28,6 +28,7 @@
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
 
+#include "BLI_hash_mm2a.h"
 #include "BLI_linklist.h"
 #include "BLI_math.h"
 #include "BLI_threads.h"
@@ -40,12 +41,21 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 /* -------------------------------------------------------------------- */
 /** \name BVHCache
  * \{ */
 
 typedef struct BVHCacheItem {
   bool is_filled;
+  /**
+   * The tree was built for a previously evaluated mesh, see #bvhcache_release_for_reuse.
+   * It is only used once refitted to the current mesh.
+   */
+  bool is_outdated;
+  /** Topology of the mesh the tree was built for, only set for outdated trees. */
+  uint topology_hash;
   BVHTree *tree;
 } BVHCacheItem;
 
@@ -54,6 +64,10 @@ typedef struct BVHCache {
   ThreadMutex mutex;
 } BVHCache;
 
+static BVHCacheStats bvhcache_stats = {0};
+
+static uint bvhcache_topology_hash(const Mesh *mesh, BVHCacheType type);
+
 /**
  * Queries a bvhcache for the cache bvhtree of the request type
  *
@@ -86,7 +100,7 @@ static bool bvhcache_find(BVHCache **bvh_cache_p,
   }
   BVHCache *bvh_cache = *bvh_cache_p;
 
-  if (bvh_cache->items[type].is_filled) {
+  if (bvh_cache->items[type].is_filled && !bvh_cache->items[type].is_outdated) {
     *r_tree = bvh_cache->items[type].tree;
     return true;
   }
@@ -140,9 +154,15 @@ BVHCache *bvhcache_init(void)
 static void bvhcache_insert(BVHCache *bvh_cache, BVHTree *tree, BVHCacheType type)
 {
   BVHCacheItem *item = &bvh_cache->items[type];
-  BLI_assert(!item->is_filled);
+  if (item->is_filled) {
+    /* Only an outdated tree which wasn't refitted can be replaced. */
+    BLI_assert(item->is_outdated);
+    BLI_bvhtree_free(item->tree);
+  }
   item->tree = tree;
   item->is_filled = true;
+  item->is_outdated = false;
+  atomic_add_and_fetch_uint64(&bvhcache_stats.builds, 1);
 }
 
 /**
@@ -159,6 +179,80 @@ void bvhcache_free(BVHCache *bvh_cache)
   MEM_freeN(bvh_cache);
 }
 
+/**
+ * Detach the cache from \a mesh so its trees can be refitted for the next evaluated mesh,
+ * instead of being rebuilt from scratch, see #bvhcache_reuse.
+ *
+ * Trees of edit-mesh data are freed, they can't be checked against a #Mesh topology.
+ */
+BVHCache *bvhcache_release_for_reuse(Mesh *mesh)
+{
+  BVHCache *bvh_cache = mesh->runtime.bvh_cache;
+  if (bvh_cache == NULL) {
+    return NULL;
+  }
+  mesh->runtime.bvh_cache = NULL;
+
+  bool has_tree = false;
+  for (BVHCacheType type = 0; type < BVHTREE_MAX_ITEM; type++) {
+    BVHCacheItem *item = &bvh_cache->items[type];
+    if (!item->is_filled) {
+      continue;
+    }
+    if (item->tree == NULL || ELEM(type,
+                                   BVHTREE_FROM_EM_VERTS,
+                                   BVHTREE_FROM_EM_EDGES,
+                                   BVHTREE_FROM_EM_LOOPTRI)) {
+      BLI_bvhtree_free(item->tree);
+      memset(item, 0, sizeof(*item));
+      continue;
+    }
+    if (!item->is_outdated) {
+      item->topology_hash = bvhcache_topology_hash(mesh, type);
+      item->is_outdated = true;
+    }
+    has_tree = true;
+  }
+
+  if (!has_tree) {
+    bvhcache_free(bvh_cache);
+    return NULL;
+  }
+  return bvh_cache;
+}
+
+/**
+ * Give \a mesh the trees released from a previous evaluation of the same data.
+ * Outdated trees are refitted on first use when the topology still matches.
+ */
+void bvhcache_reuse(Mesh *mesh, BVHCache *bvh_cache)
+{
+  if (bvh_cache == NULL) {
+    return;
+  }
+  if (mesh->runtime.bvh_cache != NULL) {
+    bvhcache_free(bvh_cache);
+    return;
+  }
+  mesh->runtime.bvh_cache = bvh_cache;
+}
+
+/**
+ * Statistics of all caches since the last #bvhcache_stats_reset,
+ * to check how often trees are rebuilt. Lookups of cached trees aren't counted,
+ * only builds and refits which are expensive anyway.
+ */
+void bvhcache_stats_get(BVHCacheStats *r_stats)
+{
+  r_stats->refits = atomic_add_and_fetch_uint64(&bvhcache_stats.refits, 0);
+  r_stats->builds = atomic_add_and_fetch_uint64(&bvhcache_stats.builds, 0);
+}
+
+void bvhcache_stats_reset(void)
+{
+  memset(&bvhcache_stats, 0, sizeof(bvhcache_stats));
+}
+
 /** \} */
 /* -------------------------------------------------------------------- */
 /** \name Local Callbacks
@@ -1406,6 +1500,206 @@ static BLI_bitmap *looptri_no_hidden_map_get(const MPoly *mpoly,
   return looptri_mask;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Refit Outdated Trees
+ *
+ * A tree built for a previous evaluation of the mesh can be refitted when only the vertex
+ * positions changed: leafs keep their index, only their bounds are recalculated.
+ * Refitted trees get #BVH_TREE_REBUILD_ON_UPDATE, so they are rebuilt when the mesh deformed
+ * enough to make queries too slow. Trees of meshes which are not re-evaluated never pay for it.
+ * \{ */
+
+static uint bvhcache_topology_hash(const Mesh *mesh, BVHCacheType type)
+{
+  BLI_HashMurmur2A mm2;
+  BLI_hash_mm2a_init(&mm2, (uint)type);
+
+  switch (type) {
+    case BVHTREE_FROM_VERTS:
+    case BVHTREE_FROM_LOOSEVERTS:
+      BLI_hash_mm2a_add_int(&mm2, mesh->totvert);
+      if (type == BVHTREE_FROM_LOOSEVERTS) {
+        for (int i = 0; i < mesh->totedge; i++) {
+          BLI_hash_mm2a_add_int(&mm2, (int)mesh->medge[i].v1);
+          BLI_hash_mm2a_add_int(&mm2, (int)mesh->medge[i].v2);
+        }
+      }
+      break;
+    case BVHTREE_FROM_EDGES:
+    case BVHTREE_FROM_LOOSEEDGES:
+      BLI_hash_mm2a_add_int(&mm2, mesh->totedge);
+      for (int i = 0; i < mesh->totedge; i++) {
+        const MEdge *me = &mesh->medge[i];
+        BLI_hash_mm2a_add_int(&mm2, (int)me->v1);
+        BLI_hash_mm2a_add_int(&mm2, (int)me->v2);
+        if (type == BVHTREE_FROM_LOOSEEDGES) {
+          BLI_hash_mm2a_add_int(&mm2, (me->flag & ME_LOOSEEDGE) != 0);
+        }
+      }
+      break;
+    case BVHTREE_FROM_FACES:
+      BLI_hash_mm2a_add_int(&mm2, mesh->totface);
+      for (int i = 0; i < mesh->totface; i++) {
+        BLI_hash_mm2a_add(&mm2, (const uchar *)&mesh->mface[i].v1, sizeof(uint[4]));
+      }
+      break;
+    case BVHTREE_FROM_LOOPTRI:
+    case BVHTREE_FROM_LOOPTRI_NO_HIDDEN:
+      BLI_hash_mm2a_add_int(&mm2, mesh->totloop);
+      BLI_hash_mm2a_add_int(&mm2, mesh->totpoly);
+      for (int i = 0; i < mesh->totpoly; i++) {
+        const MPoly *mp = &mesh->mpoly[i];
+        BLI_hash_mm2a_add_int(&mm2, mp->loopstart);
+        BLI_hash_mm2a_add_int(&mm2, mp->totloop);
+        if (type == BVHTREE_FROM_LOOPTRI_NO_HIDDEN) {
+          BLI_hash_mm2a_add_int(&mm2, (mp->flag & ME_HIDE) != 0);
+        }
+      }
+      for (int i = 0; i < mesh->totloop; i++) {
+        BLI_hash_mm2a_add_int(&mm2, (int)mesh->mloop[i].v);
+      }
+      break;
+    case BVHTREE_FROM_EM_VERTS:
+    case BVHTREE_FROM_EM_EDGES:
+    case BVHTREE_FROM_EM_LOOPTRI:
+    case BVHTREE_MAX_ITEM:
+      BLI_assert(false);
+      break;
+  }
+
+  return BLI_hash_mm2a_end(&mm2);
+}
+
+static void bvhtree_refit_from_mesh(BVHTree *tree, Mesh *mesh, BVHCacheType type)
+{
+  const MVert *mvert = mesh->mvert;
+  int leaf_index = 0;
+
+  switch (type) {
+    case BVHTREE_FROM_VERTS:
+    case BVHTREE_FROM_LOOSEVERTS: {
+      BLI_bitmap *mask = NULL;
+      if (type == BVHTREE_FROM_LOOSEVERTS) {
+        int mask_len;
+        mask = loose_verts_map_get(mesh->medge, mesh->totedge, mvert, mesh->totvert, &mask_len);
+      }
+      for (int i = 0; i < mesh->totvert; i++) {
+        if (mask && !BLI_BITMAP_TEST_BOOL(mask, i)) {
+          continue;
+        }
+        BLI_bvhtree_update_node(tree, leaf_index++, mvert[i].co, NULL, 1);
+      }
+      MEM_SAFE_FREE(mask);
+      break;
+    }
+    case BVHTREE_FROM_EDGES:
+    case BVHTREE_FROM_LOOSEEDGES: {
+      BLI_bitmap *mask = NULL;
+      if (type == BVHTREE_FROM_LOOSEEDGES) {
+        int mask_len;
+        mask = loose_edges_map_get(mesh->medge, mesh->totedge, &mask_len);
+      }
+      for (int i = 0; i < mesh->totedge; i++) {
+        if (mask && !BLI_BITMAP_TEST_BOOL(mask, i)) {
+          continue;
+        }
+        float co[2][3];
+        copy_v3_v3(co[0], mvert[mesh->medge[i].v1].co);
+        copy_v3_v3(co[1], mvert[mesh->medge[i].v2].co);
+        BLI_bvhtree_update_node(tree, leaf_index++, co[0], NULL, 2);
+      }
+      MEM_SAFE_FREE(mask);
+      break;
+    }
+    case BVHTREE_FROM_FACES: {
+      for (int i = 0; i < mesh->totface; i++) {
+        const MFace *mf = &mesh->mface[i];
+        float co[4][3];
+        copy_v3_v3(co[0], mvert[mf->v1].co);
+        copy_v3_v3(co[1], mvert[mf->v2].co);
+        copy_v3_v3(co[2], mvert[mf->v3].co);
+        if (mf->v4) {
+          copy_v3_v3(co[3], mvert[mf->v4].co);
+        }
+        BLI_bvhtree_update_node(tree, leaf_index++, co[0], NULL, mf->v4 ? 4 : 3);
+      }
+      break;
+    }
+    case BVHTREE_FROM_LOOPTRI:
+    case BVHTREE_FROM_LOOPTRI_NO_HIDDEN: {
+      const MLoopTri *looptri = BKE_mesh_runtime_looptri_ensure(mesh);
+      const int looptri_len = BKE_mesh_runtime_looptri_len(mesh);
+      const MLoop *mloop = mesh->mloop;
+      BLI_bitmap *mask = NULL;
+      if (type == BVHTREE_FROM_LOOPTRI_NO_HIDDEN) {
+        int mask_len;
+        mask = looptri_no_hidden_map_get(mesh->mpoly, looptri_len, &mask_len);
+      }
+      for (int i = 0; i < looptri_len; i++) {
+        if (mask && !BLI_BITMAP_TEST_BOOL(mask, i)) {
+          continue;
+        }
+        float co[3][3];
+        copy_v3_v3(co[0], mvert[mloop[looptri[i].tri[0]].v].co);
+        copy_v3_v3(co[1], mvert[mloop[looptri[i].tri[1]].v].co);
+        copy_v3_v3(co[2], mvert[mloop[looptri[i].tri[2]].v].co);
+        BLI_bvhtree_update_node(tree, leaf_index++, co[0], NULL, 3);
+      }
+      MEM_SAFE_FREE(mask);
+      break;
+    }
+    case BVHTREE_FROM_EM_VERTS:
+    case BVHTREE_FROM_EM_EDGES:
+    case BVHTREE_FROM_EM_LOOPTRI:
+    case BVHTREE_MAX_ITEM:
+      BLI_assert(false);
+      break;
+  }
+
+  BLI_assert(leaf_index == BLI_bvhtree_get_len(tree));
+  BLI_bvhtree_update_tree(tree);
+}
+
+/**
+ * Refit the outdated tree of the given type when the topology of \a mesh didn't change
+ * since it was built, otherwise it's freed (and replaced in #bvhcache_insert).
+ *
+ * \return the refitted tree, NULL when it has to be built.
+ */
+static BVHTree *bvhcache_refit_outdated(Mesh *mesh, BVHCacheType type)
+{
+  BVHCache *bvh_cache = mesh->runtime.bvh_cache;
+  if (bvh_cache == NULL) {
+    return NULL;
+  }
+
+  BVHTree *tree = NULL;
+  BLI_mutex_lock(&bvh_cache->mutex);
+  BVHCacheItem *item = &bvh_cache->items[type];
+  if (item->is_filled && item->is_outdated) {
+    if (item->topology_hash == bvhcache_topology_hash(mesh, type)) {
+      BLI_bvhtree_rebuild_on_update_enable(item->tree);
+      bvhtree_refit_from_mesh(item->tree, mesh, type);
+      item->is_outdated = false;
+      tree = item->tree;
+      atomic_add_and_fetch_uint64(&bvhcache_stats.refits, 1);
+    }
+    else {
+      BLI_bvhtree_free(item->tree);
+      memset(item, 0, sizeof(*item));
+    }
+  }
+  else if (item->is_filled) {
+    /* Refitted or built by another thread in the meantime. */
+    tree = item->tree;
+  }
+  BLI_mutex_unlock(&bvh_cache->mutex);
+
+  return tree;
+}
+
+/** \} */
+
 /**
  * Builds or queries a bvhcache for the cache bvhtree of the request type.
  */
@@ -1419,6 +1713,10 @@ BVHTree *BKE_bvhtree_from_mesh_get(struct BVHTreeFromMesh *data,
   ThreadMutex *mesh_eval_mutex = (ThreadMutex *)mesh->runtime.eval_mutex;
 
   bool is_cached = bvhcache_find(bvh_cache_p, bvh_cache_type, &tree, NULL, NULL);
+  if (!is_cached) {
+    tree = bvhcache_refit_outdated(mesh, bvh_cache_type);
+    is_cached = (tree != NULL);
+  }
 
   if (is_cached && tree == NULL) {
     memset(data, 0, sizeof(*data));
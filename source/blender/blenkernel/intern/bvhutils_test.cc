@@ -0,0 +1,113 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "BKE_bvhutils.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BLI_math.h"
+
+namespace blender::bke::tests {
+
+class BVHCacheTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BKE_idtype_init();
+  }
+};
+
+/* A strip of quads along the X axis, at the given height. */
+static Mesh *bvhcache_test_mesh_new(const int quads_num, const float z)
+{
+  Mesh *mesh = BKE_mesh_new_nomain((quads_num + 1) * 2, 0, 0, quads_num * 4, quads_num);
+  for (int i = 0; i <= quads_num; i++) {
+    copy_v3_fl3(mesh->mvert[i * 2].co, (float)i, 0.0f, z);
+    copy_v3_fl3(mesh->mvert[i * 2 + 1].co, (float)i, 1.0f, z);
+  }
+  for (int i = 0; i < quads_num; i++) {
+    MLoop *ml = &mesh->mloop[i * 4];
+    ml[0].v = i * 2;
+    ml[1].v = i * 2 + 2;
+    ml[2].v = i * 2 + 3;
+    ml[3].v = i * 2 + 1;
+    mesh->mpoly[i].loopstart = i * 4;
+    mesh->mpoly[i].totloop = 4;
+  }
+  BKE_mesh_calc_edges(mesh, false, false);
+  return mesh;
+}
+
+static void bvhcache_test_nearest(Mesh *mesh, const float co[3], float r_co[3])
+{
+  BVHTreeFromMesh data;
+  BKE_bvhtree_from_mesh_get(&data, mesh, BVHTREE_FROM_LOOPTRI, 2);
+  ASSERT_NE(data.tree, nullptr);
+  BVHTreeNearest nearest;
+  nearest.index = -1;
+  nearest.dist_sq = FLT_MAX;
+  BLI_bvhtree_find_nearest(data.tree, co, &nearest, data.nearest_callback, &data);
+  EXPECT_NE(nearest.index, -1);
+  copy_v3_v3(r_co, nearest.co);
+  free_bvhtree_from_mesh(&data);
+}
+
+TEST_F(BVHCacheTest, RefitOnReuse)
+{
+  const float co[3] = {4.5f, 0.5f, 3.0f};
+  float co_nearest[3];
+  BVHCacheStats stats;
+  bvhcache_stats_reset();
+
+  Mesh *mesh = bvhcache_test_mesh_new(10, 0.0f);
+  bvhcache_test_nearest(mesh, co, co_nearest);
+  bvhcache_test_nearest(mesh, co, co_nearest);
+  EXPECT_FLOAT_EQ(co_nearest[2], 0.0f);
+  bvhcache_stats_get(&stats);
+  EXPECT_EQ(stats.builds, 1);
+  EXPECT_EQ(stats.refits, 0);
+
+  /* Same topology with moved vertices: the tree is refitted. */
+  Mesh *mesh_moved = bvhcache_test_mesh_new(10, 2.0f);
+  bvhcache_reuse(mesh_moved, bvhcache_release_for_reuse(mesh));
+  bvhcache_test_nearest(mesh_moved, co, co_nearest);
+  EXPECT_FLOAT_EQ(co_nearest[2], 2.0f);
+  bvhcache_stats_get(&stats);
+  EXPECT_EQ(stats.builds, 1);
+  EXPECT_EQ(stats.refits, 1);
+
+  /* Different topology: the tree is built again. */
+  Mesh *mesh_other = bvhcache_test_mesh_new(4, 2.0f);
+  bvhcache_reuse(mesh_other, bvhcache_release_for_reuse(mesh_moved));
+  bvhcache_test_nearest(mesh_other, co, co_nearest);
+  EXPECT_FLOAT_EQ(co_nearest[0], 4.0f);
+  bvhcache_stats_get(&stats);
+  EXPECT_EQ(stats.builds, 2);
+  EXPECT_EQ(stats.refits, 1);
+
+  BKE_id_free(nullptr, mesh);
+  BKE_id_free(nullptr, mesh_moved);
+  BKE_id_free(nullptr, mesh_other);
+}
+
+}  // namespace blender::bke::tests
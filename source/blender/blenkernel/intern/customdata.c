@@ -57,6 +57,8 @@
 
 #include "BLO_read_write.h"
 
+#include "atomic_ops.h"
+
 #include "bmesh.h"
 
 #include "CLG_log.h"
@@ -2073,6 +2075,68 @@ static bool customdata_typemap_is_valid(const CustomData *data)
 }
 #endif
 
+/* -------------------------------------------------------------------- */
+/* Implicit sharing of layer data.
+ *
+ * Copying a layer with #CD_REFERENCE from a layer that owns its data shares the data instead of
+ * only pointing to it: all layers using the data are counted, and the data is freed with the last
+ * one. Like referenced layers, shared layers have to be made mutable with
+ * #CustomData_duplicate_referenced_layer before writing to them, which only copies the data when
+ * it is still used by other layers. */
+
+typedef struct CustomDataLayerSharing {
+  /** Number of layers using the data. */
+  int users;
+} CustomDataLayerSharing;
+
+/* Add a user to the data of the layer, the layer owns its data but may be shared already.
+ * Layers of the same source can be copied from multiple threads. */
+static CustomDataLayerSharing *customData_layer_sharing_add_user(CustomDataLayer *layer)
+{
+  BLI_assert(!(layer->flag & CD_FLAG_NOFREE) && layer->data != NULL);
+  if (layer->sharing == NULL) {
+    CustomDataLayerSharing *sharing = MEM_mallocN(sizeof(*sharing), __func__);
+    sharing->users = 1;
+    if (atomic_cas_ptr((void **)&layer->sharing, NULL, sharing) != NULL) {
+      MEM_freeN(sharing);
+    }
+  }
+  atomic_add_and_fetch_int32(&layer->sharing->users, 1);
+  return layer->sharing;
+}
+
+/* Remove the layer from the users of its data. Returns true when the layer was the only user,
+ * in which case the caller takes over the data. */
+static bool customData_layer_sharing_remove_user(CustomDataLayer *layer)
+{
+  CustomDataLayerSharing *sharing = layer->sharing;
+  if (sharing == NULL) {
+    return true;
+  }
+  layer->sharing = NULL;
+  if (atomic_sub_and_fetch_int32(&sharing->users, 1) == 0) {
+    MEM_freeN(sharing);
+    return true;
+  }
+  return false;
+}
+
+/* The data of the layer is used by other layers, and can not be modified or freed. */
+static bool customData_layer_is_shared(const CustomDataLayer *layer)
+{
+  return layer->sharing != NULL && layer->sharing->users > 1;
+}
+
+static void *customData_duplicate_referenced_layer_index(CustomData *data,
+                                                         const int layer_index,
+                                                         const int totelem);
+
+/* The layer does not own its data, see #CustomData_is_referenced_layer. */
+static bool customData_layer_is_referenced(const CustomDataLayer *layer)
+{
+  return (layer->flag & CD_FLAG_NOFREE) || customData_layer_is_shared(layer);
+}
+
 bool CustomData_merge(const struct CustomData *source,
                       struct CustomData *dest,
                       CustomDataMask mask,
@@ -2135,8 +2199,19 @@ bool CustomData_merge(const struct CustomData *source,
       newlayer = customData_add_layer__internal(
           dest, type, CD_REFERENCE, data, totelem, layer->name);
     }
+    else if ((alloctype == CD_REFERENCE) && !(flag & CD_FLAG_NOFREE) && (data != NULL)) {
+      /* Share the data owned by the source layer. */
+      newlayer = customData_add_layer__internal(dest, type, CD_ASSIGN, data, totelem, layer->name);
+      if (newlayer) {
+        newlayer->sharing = customData_layer_sharing_add_user((CustomDataLayer *)layer);
+      }
+    }
     else {
       newlayer = customData_add_layer__internal(dest, type, alloctype, data, totelem, layer->name);
+      if (newlayer && (alloctype == CD_ASSIGN)) {
+        /* The source layer passes its user of the data on. */
+        newlayer->sharing = layer->sharing;
+      }
     }
 
     if (newlayer) {
@@ -2165,6 +2240,11 @@ void CustomData_realloc(CustomData *data, int totelem)
       continue;
     }
     typeInfo = layerType_getInfo(layer->type);
+    if (customData_layer_is_shared(layer)) {
+      /* Leave the shared data to the other users. */
+      const int totelem_old = (int)(MEM_allocN_len(layer->data) / typeInfo->size);
+      customData_duplicate_referenced_layer_index(data, i, totelem_old);
+    }
     layer->data = MEM_reallocN(layer->data, (size_t)totelem * typeInfo->size);
   }
 }
@@ -2189,6 +2269,10 @@ static void customData_free_layer__internal(CustomDataLayer *layer, int totelem)
   const LayerTypeInfo *typeInfo;
 
   if (!(layer->flag & CD_FLAG_NOFREE) && layer->data) {
+    if (!customData_layer_sharing_remove_user(layer)) {
+      /* Still used by other layers. */
+      return;
+    }
     typeInfo = layerType_getInfo(layer->type);
 
     if (typeInfo->free) {
@@ -2563,6 +2647,7 @@ static CustomDataLayer *customData_add_layer__internal(CustomData *data,
   data->layers[index].type = type;
   data->layers[index].flag = flag;
   data->layers[index].data = newlayerdata;
+  data->layers[index].sharing = NULL;
 
   /* Set default name if none exists. Note we only call DATA_()  once
    * we know there is a default name, to avoid overhead of locale lookups
@@ -2734,6 +2819,22 @@ int CustomData_number_of_layers_typemask(const CustomData *data, CustomDataMask
   return number;
 }
 
+static void *customData_duplicate_layer_data(const CustomDataLayer *layer, const int totelem)
+{
+  /* MEM_dupallocN won't work in case of complex layers, like e.g.
+   * CD_MDEFORMVERT, which has pointers to allocated data...
+   * So in case a custom copy function is defined, use it!
+   */
+  const LayerTypeInfo *typeInfo = layerType_getInfo(layer->type);
+
+  if (typeInfo->copy) {
+    void *dst_data = MEM_malloc_arrayN((size_t)totelem, typeInfo->size, "CD duplicate ref layer");
+    typeInfo->copy(layer->data, dst_data, totelem);
+    return dst_data;
+  }
+  return MEM_dupallocN(layer->data);
+}
+
 static void *customData_duplicate_referenced_layer_index(CustomData *data,
                                                          const int layer_index,
                                                          const int totelem)
@@ -2745,24 +2846,28 @@ static void *customData_duplicate_referenced_layer_index(CustomData *data,
   CustomDataLayer *layer = &data->layers[layer_index];
 
   if (layer->flag & CD_FLAG_NOFREE) {
-    /* MEM_dupallocN won't work in case of complex layers, like e.g.
-     * CD_MDEFORMVERT, which has pointers to allocated data...
-     * So in case a custom copy function is defined, use it!
-     */
-    const LayerTypeInfo *typeInfo = layerType_getInfo(layer->type);
-
-    if (typeInfo->copy) {
-      void *dst_data = MEM_malloc_arrayN(
-          (size_t)totelem, typeInfo->size, "CD duplicate ref layer");
-      typeInfo->copy(layer->data, dst_data, totelem);
-      layer->data = dst_data;
-    }
-    else {
-      layer->data = MEM_dupallocN(layer->data);
-    }
-
+    layer->data = customData_duplicate_layer_data(layer, totelem);
     layer->flag &= ~CD_FLAG_NOFREE;
   }
+  else if (customData_layer_is_shared(layer)) {
+    /* The other users keep the shared data. */
+    void *shared_data = layer->data;
+    layer->data = customData_duplicate_layer_data(layer, totelem);
+    if (customData_layer_sharing_remove_user(layer)) {
+      /* The other users were freed while copying, free the data in their place. */
+      const LayerTypeInfo *typeInfo = layerType_getInfo(layer->type);
+      if (typeInfo->free) {
+        typeInfo->free(shared_data, totelem, typeInfo->size);
+      }
+      MEM_freeN(shared_data);
+    }
+  }
+  else if (layer->sharing != NULL) {
+    /* The other users are gone, the layer owns the data now. */
+    const bool is_last_user = customData_layer_sharing_remove_user(layer);
+    BLI_assert(is_last_user);
+    UNUSED_VARS_NDEBUG(is_last_user);
+  }
 
   return layer->data;
 }
@@ -2807,6 +2912,7 @@ bool CustomData_is_referenced_layer(struct CustomData *data, int type)
 
   CustomDataLayer *layer = &data->layers[layer_index];
 
+  /* Shared data is owned by all its users. */
   return (layer->flag & CD_FLAG_NOFREE) != 0;
 }
 
@@ -2980,7 +3086,7 @@ void CustomData_copy_layer_type_data(const CustomData *source,
 void CustomData_free_elem(CustomData *data, int index, int count)
 {
   for (int i = 0; i < data->totlayer; i++) {
-    if (!(data->layers[i].flag & CD_FLAG_NOFREE)) {
+    if (!customData_layer_is_referenced(&data->layers[i])) {
       const LayerTypeInfo *typeInfo = layerType_getInfo(data->layers[i].type);
 
       if (typeInfo->free) {
@@ -3252,6 +3358,7 @@ void *CustomData_set_layer(const CustomData *data, int type, void *ptr)
     return NULL;
   }
 
+  customData_layer_sharing_remove_user(&data->layers[layer_index]);
   data->layers[layer_index].data = ptr;
 
   return ptr;
@@ -3265,6 +3372,7 @@ void *CustomData_set_layer_n(const struct CustomData *data, int type, int n, voi
     return NULL;
   }
 
+  customData_layer_sharing_remove_user(&data->layers[layer_index]);
   data->layers[layer_index].data = ptr;
 
   return ptr;
@@ -3859,7 +3967,7 @@ bool CustomData_has_interp(const struct CustomData *data)
 bool CustomData_has_referenced(const struct CustomData *data)
 {
   for (int i = 0; i < data->totlayer; i++) {
-    if (data->layers[i].flag & CD_FLAG_NOFREE) {
+    if (customData_layer_is_referenced(&data->layers[i])) {
       return true;
     }
   }
@@ -3915,6 +4023,75 @@ bool CustomData_data_equals(int type, const void *data1, const void *data2)
   return !memcmp(data1, data2, typeInfo->size);
 }
 
+static bool customData_mdeformvert_equal(const MDeformVert *dvert1,
+                                         const MDeformVert *dvert2,
+                                         const int count)
+{
+  for (int i = 0; i < count; i++) {
+    if (dvert1[i].totweight != dvert2[i].totweight || dvert1[i].flag != dvert2[i].flag) {
+      return false;
+    }
+    if (dvert1[i].totweight &&
+        memcmp(dvert1[i].dw, dvert2[i].dw, sizeof(MDeformWeight) * dvert1[i].totweight)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool customData_layer_data_equal(const CustomDataLayer *layer1,
+                                        const CustomDataLayer *layer2,
+                                        const int totelem)
+{
+  if (layer1->type != layer2->type || !STREQ(layer1->name, layer2->name) ||
+      layer1->active != layer2->active || layer1->active_rnd != layer2->active_rnd ||
+      layer1->active_clone != layer2->active_clone || layer1->active_mask != layer2->active_mask) {
+    return false;
+  }
+  if (layer1->data == layer2->data) {
+    return true;
+  }
+  if (layer1->data == NULL || layer2->data == NULL) {
+    return false;
+  }
+  if (layer1->type == CD_MDEFORMVERT) {
+    return customData_mdeformvert_equal(layer1->data, layer2->data, totelem);
+  }
+  const LayerTypeInfo *typeInfo = layerType_getInfo(layer1->type);
+  if (typeInfo->free) {
+    /* Elements own memory which is not compared here. */
+    return false;
+  }
+  return memcmp(layer1->data, layer2->data, (size_t)typeInfo->size * totelem) == 0;
+}
+
+bool CustomData_layers_data_equal(const CustomData *data1,
+                                  const CustomData *data2,
+                                  CustomDataMask mask,
+                                  const int totelem)
+{
+  int layer_index1 = 0, layer_index2 = 0;
+  while (true) {
+    while (layer_index1 < data1->totlayer &&
+           !(mask & CD_TYPE_AS_MASK(data1->layers[layer_index1].type))) {
+      layer_index1++;
+    }
+    while (layer_index2 < data2->totlayer &&
+           !(mask & CD_TYPE_AS_MASK(data2->layers[layer_index2].type))) {
+      layer_index2++;
+    }
+    if (layer_index1 == data1->totlayer || layer_index2 == data2->totlayer) {
+      return layer_index1 == data1->totlayer && layer_index2 == data2->totlayer;
+    }
+    if (!customData_layer_data_equal(
+            &data1->layers[layer_index1], &data2->layers[layer_index2], totelem)) {
+      return false;
+    }
+    layer_index1++;
+    layer_index2++;
+  }
+}
+
 void CustomData_data_initminmax(int type, void *min, void *max)
 {
   const LayerTypeInfo *typeInfo = layerType_getInfo(type);
@@ -5174,6 +5351,7 @@ void CustomData_blend_read(BlendDataReader *reader, CustomData *data, int count)
     }
 
     layer->flag &= ~CD_FLAG_NOFREE;
+    layer->sharing = NULL;
 
     if (CustomData_verify_versions(data, i)) {
       BLO_read_data_address(reader, &layer->data);
@@ -0,0 +1,198 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_customdata.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+#include "DNA_customdata_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+namespace blender::bke::tests {
+
+static const int elems_num = 4;
+
+static float *customdata_test_float_layer_add(CustomData *data)
+{
+  CustomData_reset(data);
+  float *values = (float *)CustomData_add_layer(
+      data, CD_PROP_FLOAT, CD_CALLOC, nullptr, elems_num);
+  for (int i = 0; i < elems_num; i++) {
+    values[i] = (float)i;
+  }
+  return values;
+}
+
+TEST(customdata, SharedLayerOutlivesSource)
+{
+  CustomData data_src, data_dst;
+  const float *values_src = customdata_test_float_layer_add(&data_src);
+  CustomData_copy(&data_src, &data_dst, CD_MASK_PROP_FLOAT, CD_REFERENCE, elems_num);
+
+  const float *values_dst = (const float *)CustomData_get_layer(&data_dst, CD_PROP_FLOAT);
+  EXPECT_EQ(values_dst, values_src);
+  /* Both layers own the shared data. */
+  EXPECT_FALSE(CustomData_is_referenced_layer(&data_src, CD_PROP_FLOAT));
+  EXPECT_FALSE(CustomData_is_referenced_layer(&data_dst, CD_PROP_FLOAT));
+  EXPECT_TRUE(CustomData_has_referenced(&data_src));
+
+  CustomData_free(&data_src, elems_num);
+  EXPECT_FALSE(CustomData_has_referenced(&data_dst));
+  EXPECT_EQ(values_dst[elems_num - 1], (float)(elems_num - 1));
+
+  /* The last user owns the data, making it mutable does not copy. */
+  EXPECT_EQ(CustomData_duplicate_referenced_layer(&data_dst, CD_PROP_FLOAT, elems_num),
+            values_dst);
+  CustomData_free(&data_dst, elems_num);
+}
+
+TEST(customdata, SharedLayerCopiedOnWrite)
+{
+  CustomData data_src, data_dst;
+  const float *values_src = customdata_test_float_layer_add(&data_src);
+  CustomData_copy(&data_src, &data_dst, CD_MASK_PROP_FLOAT, CD_REFERENCE, elems_num);
+
+  float *values_dst = (float *)CustomData_duplicate_referenced_layer(
+      &data_dst, CD_PROP_FLOAT, elems_num);
+  EXPECT_NE(values_dst, values_src);
+  values_dst[0] = -1.0f;
+  EXPECT_EQ(values_src[0], 0.0f);
+  EXPECT_FALSE(CustomData_is_referenced_layer(&data_src, CD_PROP_FLOAT));
+  EXPECT_FALSE(CustomData_is_referenced_layer(&data_dst, CD_PROP_FLOAT));
+
+  CustomData_free(&data_src, elems_num);
+  CustomData_free(&data_dst, elems_num);
+}
+
+TEST(customdata, SharedLayerReferencedCopy)
+{
+  /* Copies of a referenced layer don't own the data either. */
+  CustomData data_src, data_ref, data_dst;
+  const float *values_src = customdata_test_float_layer_add(&data_src);
+  CustomData_reset(&data_ref);
+  CustomData_add_layer(&data_ref, CD_PROP_FLOAT, CD_REFERENCE, (void *)values_src, elems_num);
+  CustomData_copy(&data_ref, &data_dst, CD_MASK_PROP_FLOAT, CD_REFERENCE, elems_num);
+
+  EXPECT_EQ(CustomData_get_layer(&data_dst, CD_PROP_FLOAT), values_src);
+  EXPECT_FALSE(CustomData_is_referenced_layer(&data_src, CD_PROP_FLOAT));
+  EXPECT_TRUE(CustomData_is_referenced_layer(&data_dst, CD_PROP_FLOAT));
+
+  CustomData_free(&data_dst, elems_num);
+  CustomData_free(&data_ref, elems_num);
+  CustomData_free(&data_src, elems_num);
+}
+
+TEST(customdata, SharedDeformVertLayer)
+{
+  CustomData data_src, data_dst;
+  CustomData_reset(&data_src);
+  MDeformVert *dverts = (MDeformVert *)CustomData_add_layer(
+      &data_src, CD_MDEFORMVERT, CD_CALLOC, nullptr, elems_num);
+  for (int i = 0; i < elems_num; i++) {
+    dverts[i].dw = (MDeformWeight *)MEM_callocN(sizeof(MDeformWeight), __func__);
+    dverts[i].dw->def_nr = i;
+    dverts[i].dw->weight = 0.5f;
+    dverts[i].totweight = 1;
+  }
+  CustomData_copy(&data_src, &data_dst, CD_MASK_MDEFORMVERT, CD_REFERENCE, elems_num);
+  CustomData_free(&data_src, elems_num);
+
+  const MDeformVert *dverts_dst = (const MDeformVert *)CustomData_get_layer(&data_dst,
+                                                                           CD_MDEFORMVERT);
+  EXPECT_EQ(dverts_dst, dverts);
+  EXPECT_EQ(dverts_dst[elems_num - 1].dw->def_nr, elems_num - 1);
+  CustomData_free(&data_dst, elems_num);
+}
+
+TEST(customdata, SharedLayerVertexNormals)
+{
+  BKE_idtype_init();
+  /* A single triangle, with vertices shared with a copy. */
+  Mesh *mesh = BKE_mesh_new_nomain(3, 0, 0, 3, 1);
+  mesh->mvert[1].co[0] = 1.0f;
+  mesh->mvert[2].co[1] = 1.0f;
+  for (int i = 0; i < 3; i++) {
+    mesh->mloop[i].v = i;
+  }
+  mesh->mpoly[0].totloop = 3;
+  Mesh *mesh_copy = BKE_mesh_copy_for_eval(mesh, true);
+  EXPECT_EQ(mesh_copy->mvert, mesh->mvert);
+  const MVert *mvert_shared = mesh->mvert;
+
+  /* Normals are written to the owning mesh too, after making its vertices mutable. */
+  BKE_mesh_calc_normals_mapping_simple(mesh);
+  EXPECT_NE(mesh->mvert, mvert_shared);
+  EXPECT_EQ(mesh->mvert[0].no[2], 32767);
+  EXPECT_EQ(mesh_copy->mvert[0].no[2], 0);
+
+  BKE_id_free(nullptr, mesh_copy);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST(customdata, LayersDataEqual)
+{
+  CustomData data_a, data_b;
+  customdata_test_float_layer_add(&data_a);
+  CustomData_copy(&data_a, &data_b, CD_MASK_PROP_FLOAT, CD_DUPLICATE, elems_num);
+  EXPECT_TRUE(CustomData_layers_data_equal(&data_a, &data_b, CD_MASK_ALL, elems_num));
+
+  float *values_b = (float *)CustomData_get_layer(&data_b, CD_PROP_FLOAT);
+  values_b[elems_num - 1] = -1.0f;
+  EXPECT_FALSE(CustomData_layers_data_equal(&data_a, &data_b, CD_MASK_ALL, elems_num));
+  EXPECT_TRUE(CustomData_layers_data_equal(
+      &data_a, &data_b, CD_MASK_ALL & ~CD_MASK_PROP_FLOAT, elems_num));
+
+  /* Layers which are not in the mask are ignored, others are to match. */
+  CustomData_add_layer(&data_b, CD_PROP_INT32, CD_CALLOC, nullptr, elems_num);
+  EXPECT_TRUE(CustomData_layers_data_equal(&data_a, &data_b, 0, elems_num));
+  EXPECT_FALSE(CustomData_layers_data_equal(
+      &data_a, &data_b, CD_MASK_ALL & ~CD_MASK_PROP_FLOAT, elems_num));
+
+  CustomData_free(&data_a, elems_num);
+  CustomData_free(&data_b, elems_num);
+}
+
+TEST(customdata, DeformVertLayersDataEqual)
+{
+  CustomData data_a, data_b;
+  CustomData_reset(&data_a);
+  MDeformVert *dverts = (MDeformVert *)CustomData_add_layer(
+      &data_a, CD_MDEFORMVERT, CD_CALLOC, nullptr, elems_num);
+  for (int i = 0; i < elems_num; i++) {
+    dverts[i].dw = (MDeformWeight *)MEM_callocN(sizeof(MDeformWeight), __func__);
+    dverts[i].dw->def_nr = i;
+    dverts[i].dw->weight = 0.5f;
+    dverts[i].totweight = 1;
+  }
+  CustomData_copy(&data_a, &data_b, CD_MASK_MDEFORMVERT, CD_DUPLICATE, elems_num);
+  EXPECT_TRUE(CustomData_layers_data_equal(&data_a, &data_b, CD_MASK_ALL, elems_num));
+
+  MDeformVert *dverts_b = (MDeformVert *)CustomData_get_layer(&data_b, CD_MDEFORMVERT);
+  dverts_b[0].dw->weight = 1.0f;
+  EXPECT_FALSE(CustomData_layers_data_equal(&data_a, &data_b, CD_MASK_ALL, elems_num));
+
+  CustomData_free(&data_a, elems_num);
+  CustomData_free(&data_b, elems_num);
+}
+
+}  // namespace blender::bke::tests
@@ -1014,12 +1014,12 @@ static void UNUSED_FUNCTION(bezt_add_to_cfra_elem)(ListBase *lb, BezTriple *bezt
  */
 
 /* Basic sampling callback which acts as a wrapper for evaluate_fcurve()
- * 'data' arg here is unneeded here...
+ * 'data' arg here is an optional #FCurveSegmentCursor, for sampling many frames in a row.
  */
-float fcurve_samplingcb_evalcurve(FCurve *fcu, void *UNUSED(data), float evaltime)
+float fcurve_samplingcb_evalcurve(FCurve *fcu, void *data, float evaltime)
 {
   /* Assume any interference from drivers on the curve is intended... */
-  return evaluate_fcurve(fcu, evaltime);
+  return evaluate_fcurve_cursor(fcu, evaltime, (FCurveSegmentCursor *)data);
 }
 
 /* Main API function for creating a set of sampled curve data, given some callback function
@@ -1590,30 +1590,41 @@ static int solve_cubic(double c0, double c1, double c2, double c3, float *o)
   return 0;
 }
 
+/* Cubic polynomial coefficients of a 1D Bezier curve. */
+static void bezier_coefficients(float q0, float q1, float q2, float q3, float r_c[4])
+{
+  r_c[0] = q0;
+  r_c[1] = 3.0f * (q1 - q0);
+  r_c[2] = 3.0f * (q0 - 2.0f * q1 + q2);
+  r_c[3] = q3 - q0 + 3.0f * (q1 - q2);
+}
+
+/* Find root(s) ('zero') of a Bezier curve given as polynomial coefficients. */
+static int findzero_coefficients(float x, const float c[4], float *o)
+{
+  return solve_cubic(c[0] - x, c[1], c[2], c[3], o);
+}
+
 /* Find root(s) ('zero') of a Bezier curve. */
 static int findzero(float x, float q0, float q1, float q2, float q3, float *o)
 {
-  const double c0 = q0 - x;
-  const double c1 = 3.0f * (q1 - q0);
-  const double c2 = 3.0f * (q0 - 2.0f * q1 + q2);
-  const double c3 = q3 - q0 + 3.0f * (q1 - q2);
+  float c[4];
+  bezier_coefficients(q0, q1, q2, q3, c);
+  return findzero_coefficients(x, c, o);
+}
 
-  return solve_cubic(c0, c1, c2, c3, o);
+static float berekeny_coefficients(const float c[4], float t)
+{
+  return c[0] + t * c[1] + t * t * c[2] + t * t * t * c[3];
 }
 
 static void berekeny(float f1, float f2, float f3, float f4, float *o, int b)
 {
-  float t, c0, c1, c2, c3;
-  int a;
+  float c[4];
+  bezier_coefficients(f1, f2, f3, f4, c);
 
-  c0 = f1;
-  c1 = 3.0f * (f2 - f1);
-  c2 = 3.0f * (f1 - 2.0f * f2 + f3);
-  c3 = f4 - f1 + 3.0f * (f2 - f3);
-
-  for (a = 0; a < b; a++) {
-    t = o[a];
-    o[a] = c0 + t * c1 + t * t * c2 + t * t * t * c3;
+  for (int a = 0; a < b; a++) {
+    o[a] = berekeny_coefficients(c, o[a]);
   }
 }
 
@@ -1739,7 +1750,74 @@ static float fcurve_eval_keyframes_extrapolate(
   return endpoint_bezt->vec[1][1] - (fac * dx);
 }
 
-static float fcurve_eval_keyframes_interpolate(FCurve *fcu, BezTriple *bezts, float evaltime)
+/**
+ * The threshold for finding keyframes at the evaluation time has the following constraints:
+ * - 0.001 is too coarse:
+ *   We get artifacts with 2cm driver movements at 1BU = 1m (see T40332).
+ *
+ * - 0.00001 is too fine:
+ *   Weird errors, like selecting the wrong keyframe range (see T39207), occur.
+ *   This lower bound was established in b888a32eee8147b028464336ad2404d8155c64dd.
+ */
+#define FCURVE_EVAL_BINARYSEARCH_THRESH 0.0001f
+
+void BKE_fcurve_segment_cursor_init(FCurveSegmentCursor *cursor)
+{
+  memset(cursor, 0, sizeof(*cursor));
+}
+
+static bool fcurve_segment_cursor_contains(const BezTriple *bezts, int segment, float evaltime)
+{
+  /* Away from both keyframes by more than the threshold, so that the binary search would not
+   * consider any of them as exact match either. */
+  return (bezts[segment - 1].vec[1][0] + FCURVE_EVAL_BINARYSEARCH_THRESH < evaltime) &&
+         (evaltime < bezts[segment].vec[1][0] - FCURVE_EVAL_BINARYSEARCH_THRESH);
+}
+
+/**
+ * Find the segment containing the evaluation time from the cursor, when that gives the same
+ * result as the binary search. This is the case for the cached segment and its successor during
+ * playback.
+ *
+ * \return Index of the keyframe ending the segment, or 0 when a search is needed.
+ */
+static int fcurve_segment_cursor_find(FCurveSegmentCursor *cursor,
+                                      const FCurve *fcu,
+                                      const BezTriple *bezts,
+                                      float evaltime)
+{
+  if (cursor->bezt != bezts || cursor->totvert != fcu->totvert) {
+    BKE_fcurve_segment_cursor_init(cursor);
+    cursor->bezt = bezts;
+    cursor->totvert = fcu->totvert;
+    cursor->is_sorted = true;
+    for (int i = 1; i < fcu->totvert; i++) {
+      if (bezts[i - 1].vec[1][0] > bezts[i].vec[1][0]) {
+        cursor->is_sorted = false;
+        break;
+      }
+    }
+  }
+  if (!cursor->is_sorted || cursor->segment == 0) {
+    return 0;
+  }
+  if (fcurve_segment_cursor_contains(bezts, cursor->segment, evaltime)) {
+    return cursor->segment;
+  }
+  const int next_segment = cursor->segment + 1;
+  if (next_segment < fcu->totvert &&
+      fcurve_segment_cursor_contains(bezts, next_segment, evaltime)) {
+    cursor->segment = next_segment;
+    cursor->has_coefficients = false;
+    return next_segment;
+  }
+  return 0;
+}
+
+static float fcurve_eval_keyframes_interpolate(FCurve *fcu,
+                                               BezTriple *bezts,
+                                               float evaltime,
+                                               FCurveSegmentCursor *cursor)
 {
   const float eps = 1.e-8f;
   BezTriple *bezt, *prevbezt;
@@ -1748,17 +1826,16 @@ static float fcurve_eval_keyframes_interpolate(FCurve *fcu, BezTriple *bezts, fl
   /* Evaltime occurs somewhere in the middle of the curve. */
   bool exact = false;
 
-  /* Use binary search to find appropriate keyframes...
-   *
-   * The threshold here has the following constraints:
-   * - 0.001 is too coarse:
-   *   We get artifacts with 2cm driver movements at 1BU = 1m (see T40332).
-   *
-   * - 0.00001 is too fine:
-   *   Weird errors, like selecting the wrong keyframe range (see T39207), occur.
-   *   This lower bound was established in b888a32eee8147b028464336ad2404d8155c64dd.
-   */
-  a = BKE_fcurve_bezt_binarysearch_index_ex(bezts, evaltime, fcu->totvert, 0.0001, &exact);
+  /* Use the cursor or binary search to find appropriate keyframes. */
+  a = (cursor) ? fcurve_segment_cursor_find(cursor, fcu, bezts, evaltime) : 0;
+  if (a == 0) {
+    a = BKE_fcurve_bezt_binarysearch_index_ex(
+        bezts, evaltime, fcu->totvert, FCURVE_EVAL_BINARYSEARCH_THRESH, &exact);
+    if (cursor && !exact && a != cursor->segment) {
+      cursor->segment = a;
+      cursor->has_coefficients = false;
+    }
+  }
   bezt = bezts + a;
 
   if (exact) {
@@ -1810,6 +1887,17 @@ static float fcurve_eval_keyframes_interpolate(FCurve *fcu, BezTriple *bezts, fl
     case BEZT_IPO_BEZ: {
       float v1[2], v2[2], v3[2], v4[2], opl[32];
 
+      if (cursor && cursor->segment == a && cursor->has_coefficients) {
+        /* Same segment as before, the corrected Bezier curve is known already. */
+        if (cursor->is_flat) {
+          return cursor->y_coefficients[0];
+        }
+        if (!findzero_coefficients(evaltime, cursor->x_coefficients, opl)) {
+          return 0.0f;
+        }
+        return berekeny_coefficients(cursor->y_coefficients, opl[0]);
+      }
+
       /* Bezier interpolation. */
       /* (v1, v2) are the first keyframe and its 2nd handle. */
       v1[0] = prevbezt->vec[1][0];
@@ -1827,11 +1915,23 @@ static float fcurve_eval_keyframes_interpolate(FCurve *fcu, BezTriple *bezts, fl
         /* Optimization: If all the handles are flat/at the same values,
          * the value is simply the shared value (see T40372 -> F91346).
          */
+        if (cursor && cursor->segment == a) {
+          cursor->is_flat = true;
+          cursor->y_coefficients[0] = v1[1];
+          cursor->has_coefficients = true;
+        }
         return v1[1];
       }
       /* Adjust handles so that they don't overlap (forming a loop). */
       BKE_fcurve_correct_bezpart(v1, v2, v3, v4);
 
+      if (cursor && cursor->segment == a) {
+        cursor->is_flat = false;
+        bezier_coefficients(v1[0], v2[0], v3[0], v4[0], cursor->x_coefficients);
+        bezier_coefficients(v1[1], v2[1], v3[1], v4[1], cursor->y_coefficients);
+        cursor->has_coefficients = true;
+      }
+
       /* Try to get a value for this position - if failure, try another set of points. */
       if (!findzero(evaltime, v1[0], v2[0], v3[0], v4[0], opl)) {
         if (G.debug & G_DEBUG) {
@@ -2001,7 +2101,10 @@ static float fcurve_eval_keyframes_interpolate(FCurve *fcu, BezTriple *bezts, fl
 }
 
 /* Calculate F-Curve value for 'evaltime' using #BezTriple keyframes. */
-static float fcurve_eval_keyframes(FCurve *fcu, BezTriple *bezts, float evaltime)
+static float fcurve_eval_keyframes(FCurve *fcu,
+                                   BezTriple *bezts,
+                                   float evaltime,
+                                   FCurveSegmentCursor *cursor)
 {
   if (evaltime <= bezts->vec[1][0]) {
     return fcurve_eval_keyframes_extrapolate(fcu, bezts, evaltime, 0, +1);
@@ -2012,7 +2115,7 @@ static float fcurve_eval_keyframes(FCurve *fcu, BezTriple *bezts, float evaltime
     return fcurve_eval_keyframes_extrapolate(fcu, bezts, evaltime, fcu->totvert - 1, -1);
   }
 
-  return fcurve_eval_keyframes_interpolate(fcu, bezts, evaltime);
+  return fcurve_eval_keyframes_interpolate(fcu, bezts, evaltime, cursor);
 }
 
 /* Calculate F-Curve value for 'evaltime' using #FPoint samples. */
@@ -2061,7 +2164,10 @@ static float fcurve_eval_samples(FCurve *fcu, FPoint *fpts, float evaltime)
 /* Evaluate and return the value of the given F-Curve at the specified frame ("evaltime")
  * Note: this is also used for drivers.
  */
-static float evaluate_fcurve_ex(FCurve *fcu, float evaltime, float cvalue)
+static float evaluate_fcurve_ex(FCurve *fcu,
+                                float evaltime,
+                                float cvalue,
+                                FCurveSegmentCursor *cursor)
 {
   float devaltime;
 
@@ -2078,7 +2184,7 @@ static float evaluate_fcurve_ex(FCurve *fcu, float evaltime, float cvalue)
    *   F-Curve modifier on the stack requested the curve to be evaluated at.
    */
   if (fcu->bezt) {
-    cvalue = fcurve_eval_keyframes(fcu, fcu->bezt, devaltime);
+    cvalue = fcurve_eval_keyframes(fcu, fcu->bezt, devaltime, cursor);
   }
   else if (fcu->fpt) {
     cvalue = fcurve_eval_samples(fcu, fcu->fpt, devaltime);
@@ -2101,7 +2207,15 @@ float evaluate_fcurve(FCurve *fcu, float evaltime)
 {
   BLI_assert(fcu->driver == NULL);
 
-  return evaluate_fcurve_ex(fcu, evaltime, 0.0);
+  return evaluate_fcurve_ex(fcu, evaltime, 0.0, NULL);
+}
+
+/* Same as #evaluate_fcurve, re-using the keyframe segment found by previous evaluations. */
+float evaluate_fcurve_cursor(FCurve *fcu, float evaltime, FCurveSegmentCursor *cursor)
+{
+  BLI_assert(fcu->driver == NULL);
+
+  return evaluate_fcurve_ex(fcu, evaltime, 0.0, cursor);
 }
 
 float evaluate_fcurve_only_curve(FCurve *fcu, float evaltime)
@@ -2109,7 +2223,7 @@ float evaluate_fcurve_only_curve(FCurve *fcu, float evaltime)
   /* Can be used to evaluate the (keyframed) fcurve only.
    * Also works for driver-fcurves when the driver itself is not relevant.
    * E.g. when inserting a keyframe in a driver fcurve. */
-  return evaluate_fcurve_ex(fcu, evaltime, 0.0);
+  return evaluate_fcurve_ex(fcu, evaltime, 0.0, NULL);
 }
 
 float evaluate_fcurve_driver(PathResolvedRNA *anim_rna,
@@ -2157,7 +2271,7 @@ float evaluate_fcurve_driver(PathResolvedRNA *anim_rna,
     }
   }
 
-  return evaluate_fcurve_ex(fcu, evaltime, cvalue);
+  return evaluate_fcurve_ex(fcu, evaltime, cvalue, NULL);
 }
 
 /* Checks if the curve has valid keys, drivers or modifiers that produce an actual curve. */
@@ -2167,10 +2281,12 @@ bool BKE_fcurve_is_empty(FCurve *fcu)
          !list_has_suitable_fmodifier(&fcu->modifiers, 0, FMI_TYPE_GENERATE_CURVE);
 }
 
-/* Calculate the value of the given F-Curve at the given frame, and set its curval. */
-float calculate_fcurve(PathResolvedRNA *anim_rna,
-                       FCurve *fcu,
-                       const AnimationEvalContext *anim_eval_context)
+/* Calculate the value of the given F-Curve at the given frame, and set its curval.
+ * The optional cursor is used for evaluating keyframes of F-Curves without driver. */
+float calculate_fcurve_ex(PathResolvedRNA *anim_rna,
+                          FCurve *fcu,
+                          const AnimationEvalContext *anim_eval_context,
+                          FCurveSegmentCursor *cursor)
 {
   /* Only calculate + set curval (overriding the existing value) if curve has
    * any data which warrants this...
@@ -2185,12 +2301,19 @@ float calculate_fcurve(PathResolvedRNA *anim_rna,
     curval = evaluate_fcurve_driver(anim_rna, fcu, fcu->driver, anim_eval_context);
   }
   else {
-    curval = evaluate_fcurve(fcu, anim_eval_context->eval_time);
+    curval = evaluate_fcurve_ex(fcu, anim_eval_context->eval_time, 0.0f, cursor);
   }
   fcu->curval = curval; /* Debug display only, not thread safe! */
   return curval;
 }
 
+float calculate_fcurve(PathResolvedRNA *anim_rna,
+                       FCurve *fcu,
+                       const AnimationEvalContext *anim_eval_context)
+{
+  return calculate_fcurve_ex(anim_rna, fcu, anim_eval_context, NULL);
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -1044,6 +1044,23 @@ static bool driver_evaluate_simple_expr(ChannelDriver *driver,
   }
 }
 
+/* Untranslated message for a simple expression parse error, NULL when there is no error. */
+static const char *driver_simple_expression_error_message(const eExprPyLike_ParseError error)
+{
+  switch (error) {
+    case EXPR_PYLIKE_PARSE_OK:
+      return NULL;
+    case EXPR_PYLIKE_PARSE_UNSUPPORTED_SYNTAX:
+      return N_("unsupported syntax");
+    case EXPR_PYLIKE_PARSE_UNKNOWN_NAME:
+      return N_("unknown name");
+    case EXPR_PYLIKE_PARSE_WRONG_ARGUMENTS_NUM:
+      return N_("wrong number of function arguments");
+  }
+  BLI_assert(0);
+  return NULL;
+}
+
 /* Compile and cache the driver expression if necessary, with thread safety. */
 static bool driver_compile_simple_expr(ChannelDriver *driver)
 {
@@ -1064,6 +1081,18 @@ static bool driver_compile_simple_expr(ChannelDriver *driver)
   if (atomic_cas_ptr((void **)&driver->expr_simple, NULL, expr) != NULL) {
     BLI_expr_pylike_free(expr);
   }
+  else if (!BLI_expr_pylike_is_valid(expr) && driver->expression[0] != '\0') {
+    /* Report once per compilation, so slow drivers in a rig can be found with `--log`. */
+    int offset;
+    const char *error = driver_simple_expression_error_message(
+        BLI_expr_pylike_get_error(expr, &offset));
+    CLOG_INFO(&LOG,
+              1,
+              "Driver expression '%s' uses Python, %s at '%s'",
+              driver->expression,
+              error,
+              driver->expression + offset);
+  }
 
   return true;
 }
@@ -1088,6 +1117,21 @@ bool BKE_driver_has_simple_expression(ChannelDriver *driver)
   return driver_compile_simple_expr(driver) && BLI_expr_pylike_is_valid(driver->expr_simple);
 }
 
+/**
+ * Get the reason why the driver expression is evaluated with Python instead of the simple
+ * expression evaluator, or NULL if it is a simple expression or not an expression at all.
+ * The message is not translated.
+ * \param r_offset: Offset of the unsupported part in the expression string.
+ */
+const char *BKE_driver_simple_expression_error(ChannelDriver *driver, int *r_offset)
+{
+  if (!driver_compile_simple_expr(driver)) {
+    return NULL;
+  }
+  return driver_simple_expression_error_message(
+      BLI_expr_pylike_get_error(driver->expr_simple, r_offset));
+}
+
 /* TODO(sergey): This is somewhat weak, but we don't want neither false-positive
  * time dependencies nor special exceptions in the depsgraph evaluation. */
 static bool python_driver_exression_depends_on_time(const char *expression)
@@ -21,10 +21,16 @@
 
 #include "BKE_fcurve.h"
 
+#include "BLI_array.hh"
+#include "BLI_rand.h"
+#include "BLI_vector.hh"
+
 #include "ED_keyframing.h"
 
 #include "DNA_anim_types.h"
 
+#include "PIL_time.h"
+
 namespace blender::bke::tests {
 
 /* Epsilon for floating point comparisons. */
@@ -309,4 +315,140 @@ TEST(fcurve_active_keyframe, ActiveKeyframe)
   BKE_fcurve_free(fcu);
 }
 
+/* F-Curve with `keys_num` keyframes one frame apart, alternating interpolation types and with
+ * some flat segments. */
+static FCurve *fcurve_create_mixed(const int keys_num)
+{
+  FCurve *fcu = BKE_fcurve_create();
+  RNG *rng = BLI_rng_new(0);
+  for (int i = 0; i < keys_num; i++) {
+    const float value = (i % 7 == 3) ? 1.0f : BLI_rng_get_float(rng) * 10.0f;
+    insert_vert_fcurve(fcu, (float)i, value, BEZT_KEYTYPE_KEYFRAME, INSERTKEY_NO_USERPREF);
+  }
+  BLI_rng_free(rng);
+  for (int i = 0; i < keys_num; i++) {
+    switch (i % 5) {
+      case 1:
+        fcu->bezt[i].ipo = BEZT_IPO_LIN;
+        break;
+      case 2:
+        fcu->bezt[i].ipo = BEZT_IPO_CONST;
+        break;
+      case 3:
+        fcu->bezt[i].ipo = BEZT_IPO_ELASTIC;
+        break;
+    }
+  }
+  return fcu;
+}
+
+static void fcurve_expect_cursor_matches(FCurve *fcu, const float *times, const int times_num)
+{
+  FCurveSegmentCursor cursor = FCURVE_SEGMENT_CURSOR_INIT;
+  for (int i = 0; i < times_num; i++) {
+    EXPECT_EQ(evaluate_fcurve_cursor(fcu, times[i], &cursor), evaluate_fcurve(fcu, times[i]))
+        << "at time " << times[i];
+  }
+}
+
+TEST(evaluate_fcurve_cursor, MatchesSearch)
+{
+  FCurve *fcu = fcurve_create_mixed(20);
+
+  /* Forward and backward playback, including times close to keyframes. */
+  Vector<float> times;
+  for (float time = -2.0f; time < 22.0f; time += 0.0131f) {
+    times.append(time);
+  }
+  for (float time = 22.0f; time > -2.0f; time -= 0.25f) {
+    times.append(time);
+  }
+  for (int i = 0; i < 20; i++) {
+    times.append((float)i);
+    times.append((float)i + 0.00005f);
+    times.append((float)i + 0.00011f);
+    times.append((float)i + 0.99989f);
+    times.append((float)i + 0.99995f);
+  }
+  /* Random jumps. */
+  RNG *rng = BLI_rng_new(1);
+  for (int i = 0; i < 1000; i++) {
+    times.append(BLI_rng_get_float(rng) * 24.0f - 2.0f);
+  }
+  BLI_rng_free(rng);
+
+  fcurve_expect_cursor_matches(fcu, times.data(), times.size());
+
+  BKE_fcurve_free(fcu);
+}
+
+TEST(evaluate_fcurve_cursor, Unsorted)
+{
+  FCurve *fcu = fcurve_create_mixed(10);
+  /* Keyframes out of order, like during transform. */
+  fcu->bezt[4].vec[1][0] = 7.5f;
+
+  Vector<float> times;
+  for (float time = -1.0f; time < 11.0f; time += 0.05f) {
+    times.append(time);
+  }
+  fcurve_expect_cursor_matches(fcu, times.data(), times.size());
+
+  BKE_fcurve_free(fcu);
+}
+
+TEST(evaluate_fcurve_cursor, Reallocated)
+{
+  FCurve *fcu = fcurve_create_mixed(10);
+  FCurveSegmentCursor cursor = FCURVE_SEGMENT_CURSOR_INIT;
+  EXPECT_EQ(evaluate_fcurve_cursor(fcu, 4.5f, &cursor), evaluate_fcurve(fcu, 4.5f));
+
+  /* Adding a keyframe re-allocates the array, the cursor has to notice. */
+  insert_vert_fcurve(fcu, 4.25f, 100.0f, BEZT_KEYTYPE_KEYFRAME, INSERTKEY_NO_USERPREF);
+  EXPECT_EQ(evaluate_fcurve_cursor(fcu, 4.5f, &cursor), evaluate_fcurve(fcu, 4.5f));
+
+  BKE_fcurve_free(fcu);
+}
+
+/* Sampling a Bezier F-Curve, like the Graph Editor drawing and baking. */
+TEST(evaluate_fcurve_cursor, performance_samples_1000000)
+{
+  FCurve *fcu = BKE_fcurve_create();
+  RNG *rng = BLI_rng_new(0);
+  for (int i = 0; i < 1000; i++) {
+    insert_vert_fcurve(
+        fcu, (float)i, BLI_rng_get_float(rng), BEZT_KEYTYPE_KEYFRAME, INSERTKEY_NO_USERPREF);
+  }
+  BLI_rng_free(rng);
+
+  const int samples_num = 1000000;
+  const float step = 1000.0f / samples_num;
+  Array<float> values_search(samples_num);
+  Array<float> values_cursor(samples_num);
+
+  double time_start = PIL_check_seconds_timer();
+  for (int i = 0; i < samples_num; i++) {
+    values_search[i] = evaluate_fcurve(fcu, i * step);
+  }
+  const double time_search = PIL_check_seconds_timer() - time_start;
+
+  time_start = PIL_check_seconds_timer();
+  FCurveSegmentCursor cursor = FCURVE_SEGMENT_CURSOR_INIT;
+  for (int i = 0; i < samples_num; i++) {
+    values_cursor[i] = evaluate_fcurve_cursor(fcu, i * step, &cursor);
+  }
+  const double time_cursor = PIL_check_seconds_timer() - time_start;
+
+  for (int i = 0; i < samples_num; i++) {
+    EXPECT_EQ(values_search[i], values_cursor[i]);
+  }
+  printf("%d samples of %d keyframes, search: %.3f ms, cursor: %.3f ms\n",
+         samples_num,
+         fcu->totvert,
+         time_search * 1000.0,
+         time_cursor * 1000.0);
+
+  BKE_fcurve_free(fcu);
+}
+
 }  // namespace blender::bke::tests
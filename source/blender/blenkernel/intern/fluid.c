@@ -1023,10 +1023,7 @@ static void obstacles_from_mesh(Object *coll_ob,
     int min[3], max[3], res[3];
 
     /* Duplicate vertices to modify. */
-    if (me->mvert) {
-      me->mvert = MEM_dupallocN(me->mvert);
-      CustomData_set_layer(&me->vdata, CD_MVERT, me->mvert);
-    }
+    me->mvert = CustomData_duplicate_referenced_layer(&me->vdata, CD_MVERT, me->totvert);
 
     BKE_mesh_ensure_normals(me);
     mvert = me->mvert;
@@ -1121,9 +1118,6 @@ static void obstacles_from_mesh(Object *coll_ob,
     if (vert_vel) {
       MEM_freeN(vert_vel);
     }
-    if (me->mvert) {
-      MEM_freeN(me->mvert);
-    }
     BKE_id_free(NULL, me);
   }
 }
@@ -2109,10 +2103,7 @@ static void emit_from_mesh(
     me = BKE_mesh_copy_for_eval(ffs->mesh, true);
 
     /* Duplicate vertices to modify. */
-    if (me->mvert) {
-      me->mvert = MEM_dupallocN(me->mvert);
-      CustomData_set_layer(&me->vdata, CD_MVERT, me->mvert);
-    }
+    me->mvert = CustomData_duplicate_referenced_layer(&me->vdata, CD_MVERT, me->totvert);
 
     BKE_mesh_ensure_normals(me);
     mvert = me->mvert;
@@ -2216,9 +2207,6 @@ static void emit_from_mesh(
     if (vert_vel) {
       MEM_freeN(vert_vel);
     }
-    if (me->mvert) {
-      MEM_freeN(me->mvert);
-    }
     BKE_id_free(NULL, me);
   }
 }
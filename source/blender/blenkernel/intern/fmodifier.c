@@ -1583,7 +1583,8 @@ void fcurve_bake_modifiers(FCurve *fcu, int start, int end)
   fcu->driver = NULL;
 
   /* bake the modifiers, by sampling the curve at each frame */
-  fcurve_store_samples(fcu, NULL, start, end, fcurve_samplingcb_evalcurve);
+  FCurveSegmentCursor cursor = FCURVE_SEGMENT_CURSOR_INIT;
+  fcurve_store_samples(fcu, &cursor, start, end, fcurve_samplingcb_evalcurve);
 
   /* free the modifiers now */
   free_fmodifiers(&fcu->modifiers);
@@ -47,6 +47,7 @@
 #include "BLT_translation.h"
 
 #include "BKE_anim_data.h"
+#include "BKE_bvhutils.h"
 #include "BKE_deform.h"
 #include "BKE_editmesh.h"
 #include "BKE_global.h"
@@ -1766,14 +1767,9 @@ void BKE_mesh_vert_normals_apply(Mesh *mesh, const short (*vert_normals)[3])
   mesh->runtime.cd_dirty_vert &= ~CD_MASK_NORMAL;
 }
 
-/**
- * Compute 'split' (aka loop, or per face corner's) normals.
- *
- * \param r_lnors_spacearr: Allows to get computed loop normal space array.
- * That data, among other things, contains 'smooth fan' info, useful e.g.
- * to split geometry along sharp edges...
- */
-void BKE_mesh_calc_normals_split_ex(Mesh *mesh, MLoopNorSpaceArray *r_lnors_spacearr)
+static void mesh_calc_normals_split(Mesh *mesh,
+                                    MLoopNorSpaceArray *r_lnors_spacearr,
+                                    MeshLoopSplitCache **cache_p)
 {
   float(*r_loopnors)[3];
   float(*polynors)[3];
@@ -1818,21 +1814,22 @@ void BKE_mesh_calc_normals_split_ex(Mesh *mesh, MLoopNorSpaceArray *r_lnors_spac
     free_polynors = true;
   }
 
-  BKE_mesh_normals_loop_split(mesh->mvert,
-                              mesh->totvert,
-                              mesh->medge,
-                              mesh->totedge,
-                              mesh->mloop,
-                              r_loopnors,
-                              mesh->totloop,
-                              mesh->mpoly,
-                              (const float(*)[3])polynors,
-                              mesh->totpoly,
-                              use_split_normals,
-                              split_angle,
-                              r_lnors_spacearr,
-                              clnors,
-                              NULL);
+  BKE_mesh_normals_loop_split_ex(mesh->mvert,
+                                 mesh->totvert,
+                                 mesh->medge,
+                                 mesh->totedge,
+                                 mesh->mloop,
+                                 r_loopnors,
+                                 mesh->totloop,
+                                 mesh->mpoly,
+                                 (const float(*)[3])polynors,
+                                 mesh->totpoly,
+                                 use_split_normals,
+                                 split_angle,
+                                 r_lnors_spacearr,
+                                 clnors,
+                                 NULL,
+                                 cache_p);
 
   if (free_polynors) {
     MEM_freeN(polynors);
@@ -1841,9 +1838,31 @@ void BKE_mesh_calc_normals_split_ex(Mesh *mesh, MLoopNorSpaceArray *r_lnors_spac
   mesh->runtime.cd_dirty_vert &= ~CD_MASK_NORMAL;
 }
 
+/**
+ * Compute 'split' (aka loop, or per face corner's) normals.
+ *
+ * \param r_lnors_spacearr: Allows to get computed loop normal space array.
+ * That data, among other things, contains 'smooth fan' info, useful e.g.
+ * to split geometry along sharp edges...
+ */
+void BKE_mesh_calc_normals_split_ex(Mesh *mesh, MLoopNorSpaceArray *r_lnors_spacearr)
+{
+  mesh_calc_normals_split(mesh, r_lnors_spacearr, NULL);
+}
+
 void BKE_mesh_calc_normals_split(Mesh *mesh)
 {
-  BKE_mesh_calc_normals_split_ex(mesh, NULL);
+  mesh_calc_normals_split(mesh, NULL, NULL);
+}
+
+/**
+ * Same as #BKE_mesh_calc_normals_split, the smooth fans found for \a mesh are kept in
+ * \a cache_p, typically owned by the object the mesh is evaluated for. They are reused as long
+ * as topology and sharp edges stay the same.
+ */
+void BKE_mesh_calc_normals_split_cached(Mesh *mesh, MeshLoopSplitCache **cache_p)
+{
+  mesh_calc_normals_split(mesh, NULL, cache_p);
 }
 
 /* Split faces helper functions. */
@@ -2122,6 +2141,14 @@ void BKE_mesh_eval_geometry(Depsgraph *depsgraph, Mesh *mesh)
    * evaluated mesh, and we don't know what parts of the mesh did change. So we simply delete the
    * evaluated mesh and let objects to re-create it with updated settings. */
   if (mesh->runtime.mesh_eval != NULL) {
+    /* Trees can still be refitted for the next evaluated mesh when only positions changed. */
+    struct BVHCache *bvh_cache = bvhcache_release_for_reuse(mesh->runtime.mesh_eval);
+    if (bvh_cache != NULL) {
+      if (mesh->runtime.bvh_cache_reuse != NULL) {
+        bvhcache_free(mesh->runtime.bvh_cache_reuse);
+      }
+      mesh->runtime.bvh_cache_reuse = bvh_cache;
+    }
     mesh->runtime.mesh_eval->edit_mesh = NULL;
     BKE_id_free(NULL, mesh->runtime.mesh_eval);
     mesh->runtime.mesh_eval = NULL;
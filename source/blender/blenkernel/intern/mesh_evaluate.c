@@ -90,6 +90,10 @@ static void mesh_calc_normals_vert_fallback(MVert *mverts, int numVerts)
 void BKE_mesh_calc_normals_mapping_simple(struct Mesh *mesh)
 {
   const bool only_face_normals = CustomData_is_referenced_layer(&mesh->vdata, CD_MVERT);
+  if (!only_face_normals) {
+    /* Vertices shared with other meshes are copied before writing their normals. */
+    mesh->mvert = CustomData_duplicate_referenced_layer(&mesh->vdata, CD_MVERT, mesh->totvert);
+  }
 
   BKE_mesh_calc_normals_mapping_ex(mesh->mvert,
                                    mesh->totvert,
@@ -213,6 +217,8 @@ typedef struct MeshCalcNormalsData {
   float (*pnors)[3];
   float (*lnors_weighted)[3];
   float (*vnors)[3];
+  const int *vert_loop_offsets;
+  const int *vert_loops;
 } MeshCalcNormalsData;
 
 static void mesh_calc_normals_poly_cb(void *__restrict userdata,
@@ -225,6 +231,65 @@ static void mesh_calc_normals_poly_cb(void *__restrict userdata,
   BKE_mesh_calc_poly_normal(mp, data->mloop + mp->loopstart, data->mverts, data->pnors[pidx]);
 }
 
+/* Specialization of #mesh_calc_normals_poly_prepare_cb for triangles, no edge-vector buffer and
+ * no loops over the corners. */
+static void mesh_calc_normals_tri_prepare(const MLoop *ml,
+                                          const MVert *mverts,
+                                          float pnor[3],
+                                          float (*lnors_weighted)[3])
+{
+  const float *co1 = mverts[ml[0].v].co;
+  const float *co2 = mverts[ml[1].v].co;
+  const float *co3 = mverts[ml[2].v].co;
+
+  if (UNLIKELY(normal_tri_v3(pnor, co1, co2, co3) == 0.0f)) {
+    pnor[2] = 1.0f; /* other axes set to 0.0 */
+  }
+
+  float edvec[3][3];
+  sub_v3_v3v3(edvec[0], co2, co1);
+  sub_v3_v3v3(edvec[1], co3, co2);
+  sub_v3_v3v3(edvec[2], co1, co3);
+  normalize_v3(edvec[0]);
+  normalize_v3(edvec[1]);
+  normalize_v3(edvec[2]);
+
+  mul_v3_v3fl(lnors_weighted[0], pnor, saacos(-dot_v3v3(edvec[2], edvec[0])));
+  mul_v3_v3fl(lnors_weighted[1], pnor, saacos(-dot_v3v3(edvec[0], edvec[1])));
+  mul_v3_v3fl(lnors_weighted[2], pnor, saacos(-dot_v3v3(edvec[1], edvec[2])));
+}
+
+/* Specialization of #mesh_calc_normals_poly_prepare_cb for quads. */
+static void mesh_calc_normals_quad_prepare(const MLoop *ml,
+                                           const MVert *mverts,
+                                           float pnor[3],
+                                           float (*lnors_weighted)[3])
+{
+  const float *co1 = mverts[ml[0].v].co;
+  const float *co2 = mverts[ml[1].v].co;
+  const float *co3 = mverts[ml[2].v].co;
+  const float *co4 = mverts[ml[3].v].co;
+
+  if (UNLIKELY(normal_quad_v3(pnor, co1, co2, co3, co4) == 0.0f)) {
+    pnor[2] = 1.0f; /* other axes set to 0.0 */
+  }
+
+  float edvec[4][3];
+  sub_v3_v3v3(edvec[0], co2, co1);
+  sub_v3_v3v3(edvec[1], co3, co2);
+  sub_v3_v3v3(edvec[2], co4, co3);
+  sub_v3_v3v3(edvec[3], co1, co4);
+  normalize_v3(edvec[0]);
+  normalize_v3(edvec[1]);
+  normalize_v3(edvec[2]);
+  normalize_v3(edvec[3]);
+
+  mul_v3_v3fl(lnors_weighted[0], pnor, saacos(-dot_v3v3(edvec[3], edvec[0])));
+  mul_v3_v3fl(lnors_weighted[1], pnor, saacos(-dot_v3v3(edvec[0], edvec[1])));
+  mul_v3_v3fl(lnors_weighted[2], pnor, saacos(-dot_v3v3(edvec[1], edvec[2])));
+  mul_v3_v3fl(lnors_weighted[3], pnor, saacos(-dot_v3v3(edvec[2], edvec[3])));
+}
+
 static void mesh_calc_normals_poly_prepare_cb(void *__restrict userdata,
                                               const int pidx,
                                               const TaskParallelTLS *__restrict UNUSED(tls))
@@ -236,9 +301,18 @@ static void mesh_calc_normals_poly_prepare_cb(void *__restrict userdata,
 
   float pnor_temp[3];
   float *pnor = data->pnors ? data->pnors[pidx] : pnor_temp;
-  float(*lnors_weighted)[3] = data->lnors_weighted;
+  float(*lnors_weighted)[3] = &data->lnors_weighted[mp->loopstart];
 
   const int nverts = mp->totloop;
+  if (nverts == 3) {
+    mesh_calc_normals_tri_prepare(ml, mverts, pnor, lnors_weighted);
+    return;
+  }
+  if (nverts == 4) {
+    mesh_calc_normals_quad_prepare(ml, mverts, pnor, lnors_weighted);
+    return;
+  }
+
   float(*edgevecbuf)[3] = BLI_array_alloca(edgevecbuf, (size_t)nverts);
 
   /* Polygon Normal and edge-vector */
@@ -268,12 +342,11 @@ static void mesh_calc_normals_poly_prepare_cb(void *__restrict userdata,
 
   /* accumulate angle weighted face normal */
   /* inline version of #accumulate_vertex_normals_poly_v3,
-   * split between this threaded callback and #mesh_calc_normals_poly_accum_cb. */
+   * split between this threaded callback and #mesh_calc_normals_poly_finalize_cb. */
   {
     const float *prev_edge = edgevecbuf[nverts - 1];
 
     for (int i = 0; i < nverts; i++) {
-      const int lidx = mp->loopstart + i;
       const float *cur_edge = edgevecbuf[i];
 
       /* calculate angle between the two poly edges incident on
@@ -281,7 +354,7 @@ static void mesh_calc_normals_poly_prepare_cb(void *__restrict userdata,
       const float fac = saacos(-dot_v3v3(cur_edge, prev_edge));
 
       /* Store for later accumulation */
-      mul_v3_v3fl(lnors_weighted[lidx], pnor, fac);
+      mul_v3_v3fl(lnors_weighted[i], pnor, fac);
 
       prev_edge = cur_edge;
     }
@@ -297,6 +370,13 @@ static void mesh_calc_normals_poly_finalize_cb(void *__restrict userdata,
   MVert *mv = &data->mverts[vidx];
   float *no = data->vnors[vidx];
 
+  /* Gather the weighted normals of the vertex loops, always in the same order so the result
+   * doesn't depend on how the work is split between threads. */
+  zero_v3(no);
+  for (int i = data->vert_loop_offsets[vidx]; i < data->vert_loop_offsets[vidx + 1]; i++) {
+    add_v3_v3(no, data->lnors_weighted[data->vert_loops[i]]);
+  }
+
   if (UNLIKELY(normalize_v3(no) == 0.0f)) {
     /* following Mesh convention; we use vertex coordinate itself for normal in this case */
     normalize_v3_v3(no, mv->co);
@@ -305,6 +385,39 @@ static void mesh_calc_normals_poly_finalize_cb(void *__restrict userdata,
   normal_float_to_short_v3(mv->no, no);
 }
 
+/**
+ * Loops of every vertex, the loops of vertex `i` are
+ * `r_vert_loops[r_vert_loop_offsets[i]]` to `r_vert_loops[r_vert_loop_offsets[i + 1] - 1]`,
+ * in increasing order. Lighter than #BKE_mesh_vert_loop_map_create, which is too slow to be
+ * rebuilt for every normal calculation.
+ */
+static void mesh_calc_normals_vert_loops_create(const MLoop *mloop,
+                                                const int numVerts,
+                                                const int numLoops,
+                                                int **r_vert_loop_offsets,
+                                                int **r_vert_loops)
+{
+  int *offsets = MEM_calloc_arrayN((size_t)numVerts + 1, sizeof(*offsets), __func__);
+  int *vert_loops = MEM_malloc_arrayN((size_t)numLoops, sizeof(*vert_loops), __func__);
+
+  /* Count the loops of each vertex, shifted by one so the sums are the start offsets. */
+  for (int i = 0; i < numLoops; i++) {
+    offsets[mloop[i].v + 1]++;
+  }
+  for (int i = 0; i < numVerts; i++) {
+    offsets[i + 1] += offsets[i];
+  }
+  /* Fill, using the start offsets as insertion positions, which moves them to the ends. */
+  for (int i = 0; i < numLoops; i++) {
+    vert_loops[offsets[mloop[i].v]++] = i;
+  }
+  memmove(&offsets[1], &offsets[0], sizeof(*offsets) * (size_t)numVerts);
+  offsets[0] = 0;
+
+  *r_vert_loop_offsets = offsets;
+  *r_vert_loops = vert_loops;
+}
+
 void BKE_mesh_calc_normals_poly(MVert *mverts,
                                 float (*r_vertnors)[3],
                                 int numVerts,
@@ -343,12 +456,13 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
 
   /* first go through and calculate normals for all the polys */
   if (vnors == NULL) {
-    vnors = MEM_calloc_arrayN((size_t)numVerts, sizeof(*vnors), __func__);
+    vnors = MEM_malloc_arrayN((size_t)numVerts, sizeof(*vnors), __func__);
     free_vnors = true;
   }
-  else {
-    memset(vnors, 0, sizeof(*vnors) * (size_t)numVerts);
-  }
+
+  int *vert_loop_offsets, *vert_loops;
+  mesh_calc_normals_vert_loops_create(
+      mloop, numVerts, numLoops, &vert_loop_offsets, &vert_loops);
 
   MeshCalcNormalsData data = {
       .mpolys = mpolys,
@@ -357,26 +471,23 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
       .pnors = pnors,
       .lnors_weighted = lnors_weighted,
       .vnors = vnors,
+      .vert_loop_offsets = vert_loop_offsets,
+      .vert_loops = vert_loops,
   };
 
   /* Compute poly normals, and prepare weighted loop normals. */
   BLI_task_parallel_range(0, numPolys, &data, mesh_calc_normals_poly_prepare_cb, &settings);
 
-  /* Actually accumulate weighted loop normals into vertex ones. */
-  /* Unfortunately, not possible to thread that
-   * (not in a reasonable, totally lock- and barrier-free fashion),
-   * since several loops will point to the same vertex... */
-  for (int lidx = 0; lidx < numLoops; lidx++) {
-    add_v3_v3(vnors[mloop[lidx].v], data.lnors_weighted[lidx]);
-  }
-
-  /* Normalize and validate computed vertex normals. */
+  /* Gather weighted loop normals into vertex ones, then normalize and validate them. Each vertex
+   * is only written by one thread, so no atomics are needed and the result is deterministic. */
   BLI_task_parallel_range(0, numVerts, &data, mesh_calc_normals_poly_finalize_cb, &settings);
 
+  MEM_freeN(vert_loop_offsets);
+  MEM_freeN(vert_loops);
+  MEM_freeN(lnors_weighted);
   if (free_vnors) {
     MEM_freeN(vnors);
   }
-  MEM_freeN(lnors_weighted);
 }
 
 void BKE_mesh_ensure_normals(Mesh *mesh)
@@ -809,10 +920,15 @@ typedef struct LoopSplitTaskDataCommon {
   int (*edge_to_loops)[2];
   int *loop_to_poly;
   const float (*polynors)[3];
+  /** Work started from each loop, see #loop_split_fans_find. */
+  char *loop_fans;
+  /** The fans were not found beforehand, #loop_split_generator classifies loops itself. */
+  bool find_fans;
 
   int numEdges;
   int numLoops;
   int numPolys;
+  int num_fans;
 } LoopSplitTaskDataCommon;
 
 #define INDEX_UNSET INT_MIN
@@ -1344,22 +1460,42 @@ static void loop_split_worker(TaskPool *__restrict pool, void *taskdata)
 #endif
 }
 
+/** Work started from each loop, see #loop_split_fans_find. */
+enum {
+  LOOP_SPLIT_UNSET = 0,
+  /** The loop is computed as part of a fan started from another loop. */
+  LOOP_SPLIT_SKIP = 1,
+  /** Both edges of the loop are sharp. */
+  LOOP_SPLIT_SINGLE = 2,
+  /** The loop is the entry point of a smooth fan. */
+  LOOP_SPLIT_FAN = 3,
+};
+
 /**
- * Check whether given loop is part of an unknown-so-far cyclic smooth fan, or not.
+ * Check whether given loop is the entry point of a cyclic smooth fan.
  * Needed because cyclic smooth fans have no obvious 'entry point',
  * and yet we need to walk them once, and only once.
+ *
+ * The loop of the fan in the first polygon (and first in that polygon) is used, this is the
+ * loop the fan used to be found from when looping over all polygons in order, so that custom
+ * normals keep the same loop normal spaces.
+ *
+ * Walked loops which can't be an entry point are tagged in \a loop_fans, so they don't have to
+ * walk the fan again. Polygons are checked from multiple threads, but a loop is always tagged
+ * with the same value.
  */
-static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
-                                                         const MPoly *mpolys,
-                                                         const int (*edge_to_loops)[2],
-                                                         const int *loop_to_poly,
-                                                         const int *e2l_prev,
-                                                         BLI_bitmap *skip_loops,
-                                                         const MLoop *ml_curr,
-                                                         const MLoop *ml_prev,
-                                                         const int ml_curr_index,
-                                                         const int ml_prev_index,
-                                                         const int mp_curr_index)
+static bool loop_split_fan_is_cyclic_entry(const MLoop *mloops,
+                                           const MPoly *mpolys,
+                                           const int (*edge_to_loops)[2],
+                                           const int *loop_to_poly,
+                                           const int *e2l_prev,
+                                           const MLoop *ml_curr,
+                                           const MLoop *ml_prev,
+                                           const int ml_curr_index,
+                                           const int ml_prev_index,
+                                           const int mp_curr_index,
+                                           const int numLoops,
+                                           char *loop_fans)
 {
   const unsigned int mv_pivot_index = ml_curr->v; /* The vertex we are "fanning" around! */
   const int *e2lfan_curr;
@@ -1382,10 +1518,9 @@ static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
   BLI_assert(mlfan_vert_index >= 0);
   BLI_assert(mpfan_curr_index >= 0);
 
-  BLI_assert(!BLI_BITMAP_TEST(skip_loops, mlfan_vert_index));
-  BLI_BITMAP_ENABLE(skip_loops, mlfan_vert_index);
-
-  while (true) {
+  /* Fans of valid meshes always lead back to the initial loop,
+   * the limit only avoids endless walks around invalid topology. */
+  for (int i = 0; i < numLoops; i++) {
     /* Find next loop of the smooth fan. */
     BKE_mesh_loop_manifold_fan_around_vert_next(mloops,
                                                 mpolys,
@@ -1404,19 +1539,229 @@ static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
       return false;
     }
     /* Smooth loop/edge... */
-    if (BLI_BITMAP_TEST(skip_loops, mlfan_vert_index)) {
-      if (mlfan_vert_index == ml_curr_index) {
-        /* We walked around a whole cyclic smooth fan without finding any already-processed loop,
-         * means we can use initial ml_curr/ml_prev edge as start for this smooth fan. */
-        return true;
-      }
-      /* ... already checked in some previous looping, we can abort. */
+    if (mlfan_vert_index == ml_curr_index) {
+      /* We walked around a whole cyclic smooth fan without finding any loop coming first,
+       * means we can use initial ml_curr/ml_prev edge as start for this smooth fan. */
+      return true;
+    }
+    if (mpfan_curr_index < mp_curr_index ||
+        (mpfan_curr_index == mp_curr_index && mlfan_vert_index < ml_curr_index)) {
+      /* ... the fan is started from that other loop, or from a sharp edge. */
+      return false;
+    }
+    /* ... both edges of that loop are smooth, and it comes after the current one, so it is
+     * either part of a fan started from a sharp edge, or not the first loop of a cyclic fan. */
+    loop_fans[mlfan_vert_index] = LOOP_SPLIT_SKIP;
+  }
+  return false;
+}
+
+/**
+ * Find the work started from a loop and store it in \a loop_fans. Polygons can be classified in
+ * any order and from multiple threads, see #loop_split_fan_is_cyclic_entry.
+ */
+static char loop_split_fan_classify(const LoopSplitTaskDataCommon *common_data,
+                                    char *loop_fans,
+                                    const int mp_index,
+                                    const int ml_curr_index,
+                                    const int ml_prev_index)
+{
+  if (loop_fans[ml_curr_index] == LOOP_SPLIT_SKIP) {
+    /* Already walked from another loop of the fan. */
+    return LOOP_SPLIT_SKIP;
+  }
+
+  const MLoop *mloops = common_data->mloops;
+  const int(*edge_to_loops)[2] = (const int(*)[2])common_data->edge_to_loops;
+  const MLoop *ml_curr = &mloops[ml_curr_index];
+  const MLoop *ml_prev = &mloops[ml_prev_index];
+  const int *e2l_curr = edge_to_loops[ml_curr->e];
+  const int *e2l_prev = edge_to_loops[ml_prev->e];
+  char loop_fan;
+
+  /* Fans starting from a sharp edge *do not need* any check!
+   * Due to the fact a loop only links to one of its two edges,
+   * a same fan *will never be walked more than once!*
+   * Since we consider edges having neighbor polys with inverted
+   * (flipped) normals as sharp, we are sure that no fan will be skipped,
+   * even only considering the case (sharp curr_edge, smooth prev_edge),
+   * and not the alternative (smooth curr_edge, sharp prev_edge).
+   * All this due/thanks to link between normals and loop ordering (i.e. winding).
+   */
+  if (IS_EDGE_SHARP(e2l_curr)) {
+    loop_fan = IS_EDGE_SHARP(e2l_prev) ? LOOP_SPLIT_SINGLE : LOOP_SPLIT_FAN;
+  }
+  /* A smooth edge, we have to check for cyclic smooth fan case.
+   * If this loop is the entry point of a cyclic smooth fan, the fan is computed from it,
+   * otherwise we can skip it. */
+  else if (loop_split_fan_is_cyclic_entry(mloops,
+                                          common_data->mpolys,
+                                          edge_to_loops,
+                                          common_data->loop_to_poly,
+                                          e2l_prev,
+                                          ml_curr,
+                                          ml_prev,
+                                          ml_curr_index,
+                                          ml_prev_index,
+                                          mp_index,
+                                          common_data->numLoops,
+                                          loop_fans)) {
+    loop_fan = LOOP_SPLIT_FAN;
+  }
+  else {
+    loop_fan = LOOP_SPLIT_SKIP;
+  }
+
+  loop_fans[ml_curr_index] = loop_fan;
+  return loop_fan;
+}
+
+static void loop_split_fans_find_cb(void *__restrict userdata,
+                                    const int mp_index,
+                                    const TaskParallelTLS *__restrict tls)
+{
+  const LoopSplitTaskDataCommon *common_data = userdata;
+  int *num_fans = tls->userdata_chunk;
+
+  const MPoly *mp = &common_data->mpolys[mp_index];
+  const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
+  int ml_curr_index = mp->loopstart;
+  int ml_prev_index = ml_last_index;
+
+  for (; ml_curr_index <= ml_last_index; ml_prev_index = ml_curr_index++) {
+    if (loop_split_fan_classify(
+            common_data, common_data->loop_fans, mp_index, ml_curr_index, ml_prev_index) !=
+        LOOP_SPLIT_SKIP) {
+      (*num_fans)++;
+    }
+  }
+}
+
+static void loop_split_fans_find_reduce(const void *__restrict UNUSED(userdata),
+                                        void *__restrict chunk_join,
+                                        void *__restrict chunk)
+{
+  int *num_fans_join = chunk_join;
+  const int *num_fans = chunk;
+  *num_fans_join += *num_fans;
+}
+
+/**
+ * Find the loops from which smooth fans and single loops are computed, the \a loop_fans of
+ * \a common_data are expected to be zero initialized. Returns the number of fans (single loops
+ * included).
+ */
+static int loop_split_fans_find(const LoopSplitTaskDataCommon *common_data)
+{
+  int num_fans = 0;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  settings.userdata_chunk = &num_fans;
+  settings.userdata_chunk_size = sizeof(num_fans);
+  settings.func_reduce = loop_split_fans_find_reduce;
+  BLI_task_parallel_range(
+      0, common_data->numPolys, (void *)common_data, loop_split_fans_find_cb, &settings);
+
+  return num_fans;
+}
+
+/**
+ * Cached entry points of the fans, valid as long as topology and sharp edges don't change,
+ * see #BKE_mesh_normals_loop_split_ex.
+ */
+typedef struct MeshLoopSplitCache {
+  /**
+   * Topology and sharp edges (part of the edge to loops mapping) the fans were found for.
+   * A copy is kept rather than a hash, any difference can move the entry points of fans.
+   */
+  int numEdges;
+  int numLoops;
+  int numPolys;
+  /** Start and size of each polygon. */
+  int (*poly_loops)[2];
+  MLoop *mloops;
+  int (*edge_to_loops)[2];
+
+  int num_fans;
+  /** #LOOP_SPLIT_SKIP, #LOOP_SPLIT_SINGLE or #LOOP_SPLIT_FAN for each loop. */
+  char *loop_fans;
+} MeshLoopSplitCache;
+
+static void loop_split_cache_clear(MeshLoopSplitCache *cache)
+{
+  MEM_SAFE_FREE(cache->poly_loops);
+  MEM_SAFE_FREE(cache->mloops);
+  MEM_SAFE_FREE(cache->edge_to_loops);
+  MEM_SAFE_FREE(cache->loop_fans);
+}
+
+void BKE_mesh_loop_split_cache_free(MeshLoopSplitCache *cache)
+{
+  loop_split_cache_clear(cache);
+  MEM_freeN(cache);
+}
+
+static bool loop_split_cache_is_valid(const MeshLoopSplitCache *cache,
+                                      const LoopSplitTaskDataCommon *common_data)
+{
+  if (cache->loop_fans == NULL || cache->numEdges != common_data->numEdges ||
+      cache->numLoops != common_data->numLoops || cache->numPolys != common_data->numPolys) {
+    return false;
+  }
+  for (int i = 0; i < common_data->numPolys; i++) {
+    const MPoly *mp = &common_data->mpolys[i];
+    if (cache->poly_loops[i][0] != mp->loopstart || cache->poly_loops[i][1] != mp->totloop) {
       return false;
     }
+  }
+  return (memcmp(cache->mloops,
+                 common_data->mloops,
+                 sizeof(*cache->mloops) * (size_t)common_data->numLoops) == 0) &&
+         (memcmp(cache->edge_to_loops,
+                 common_data->edge_to_loops,
+                 sizeof(*cache->edge_to_loops) * (size_t)common_data->numEdges) == 0);
+}
+
+static void loop_split_cache_ensure(LoopSplitTaskDataCommon *common_data,
+                                    MeshLoopSplitCache **cache_p)
+{
+  MeshLoopSplitCache *cache = *cache_p;
 
-    /* ... we can skip it in future, and keep checking the smooth fan. */
-    BLI_BITMAP_ENABLE(skip_loops, mlfan_vert_index);
+  if (cache == NULL) {
+    cache = *cache_p = MEM_callocN(sizeof(*cache), __func__);
   }
+  else if (loop_split_cache_is_valid(cache, common_data)) {
+    common_data->loop_fans = cache->loop_fans;
+    common_data->num_fans = cache->num_fans;
+    return;
+  }
+  loop_split_cache_clear(cache);
+
+  const int numEdges = common_data->numEdges;
+  const int numLoops = common_data->numLoops;
+  const int numPolys = common_data->numPolys;
+
+  cache->numEdges = numEdges;
+  cache->numLoops = numLoops;
+  cache->numPolys = numPolys;
+  cache->poly_loops = MEM_malloc_arrayN((size_t)numPolys, sizeof(*cache->poly_loops), __func__);
+  for (int i = 0; i < numPolys; i++) {
+    cache->poly_loops[i][0] = common_data->mpolys[i].loopstart;
+    cache->poly_loops[i][1] = common_data->mpolys[i].totloop;
+  }
+  cache->mloops = MEM_malloc_arrayN((size_t)numLoops, sizeof(*cache->mloops), __func__);
+  memcpy(cache->mloops, common_data->mloops, sizeof(*cache->mloops) * (size_t)numLoops);
+  cache->edge_to_loops = MEM_malloc_arrayN(
+      (size_t)numEdges, sizeof(*cache->edge_to_loops), __func__);
+  memcpy(cache->edge_to_loops,
+         common_data->edge_to_loops,
+         sizeof(*cache->edge_to_loops) * (size_t)numEdges);
+
+  cache->loop_fans = MEM_calloc_arrayN((size_t)numLoops, sizeof(*cache->loop_fans), __func__);
+  common_data->loop_fans = cache->loop_fans;
+  cache->num_fans = common_data->num_fans = loop_split_fans_find(common_data);
 }
 
 static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common_data)
@@ -1426,9 +1771,9 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
 
   const MLoop *mloops = common_data->mloops;
   const MPoly *mpolys = common_data->mpolys;
-  const int *loop_to_poly = common_data->loop_to_poly;
   const int(*edge_to_loops)[2] = common_data->edge_to_loops;
-  const int numLoops = common_data->numLoops;
+  char *loop_fans = common_data->loop_fans;
+  const bool find_fans = common_data->find_fans;
   const int numPolys = common_data->numPolys;
 
   const MPoly *mp;
@@ -1439,11 +1784,13 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
   int ml_curr_index;
   int ml_prev_index;
 
-  BLI_bitmap *skip_loops = BLI_BITMAP_NEW(numLoops, __func__);
-
   LoopSplitTaskData *data_buff = NULL;
   int data_idx = 0;
 
+  /* When the fans are known, all spaces are allocated at once, one for each fan. */
+  MLoopNorSpace *lnor_spaces = NULL;
+  int lnor_space_index = 0;
+
   /* Temp edge vectors stack, only used when computing lnor spacearr
    * (and we are not multi-threading). */
   BLI_Stack *edge_vectors = NULL;
@@ -1457,9 +1804,15 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
       edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
     }
   }
+  if (lnors_spacearr && !find_fans) {
+    lnor_spaces = BLI_memarena_calloc(lnors_spacearr->mem,
+                                      sizeof(*lnor_spaces) * (size_t)common_data->num_fans);
+    lnors_spacearr->num_spaces += common_data->num_fans;
+  }
 
   /* We now know edges that can be smoothed (with their vector, and their two loops),
-   * and edges that will be hard! Now, time to generate the normals.
+   * edges that will be hard, and loops from which fans are computed!
+   * Now, time to generate the normals.
    */
   for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
     float(*lnors)[3];
@@ -1472,47 +1825,16 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
     lnors = &loopnors[ml_curr_index];
 
     for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++, lnors++) {
-      const int *e2l_curr = edge_to_loops[ml_curr->e];
-      const int *e2l_prev = edge_to_loops[ml_prev->e];
-
-#if 0
-      printf("Checking loop %d / edge %u / vert %u (sharp edge: %d, skiploop: %d)...",
-             ml_curr_index,
-             ml_curr->e,
-             ml_curr->v,
-             IS_EDGE_SHARP(e2l_curr),
-             BLI_BITMAP_TEST_BOOL(skip_loops, ml_curr_index));
-#endif
-
-      /* A smooth edge, we have to check for cyclic smooth fan case.
-       * If we find a new, never-processed cyclic smooth fan, we can do it now using that loop/edge
-       * as 'entry point', otherwise we can skip it. */
-
-      /* Note: In theory, we could make loop_split_generator_check_cyclic_smooth_fan() store
-       * mlfan_vert_index'es and edge indexes in two stacks, to avoid having to fan again around
-       * the vert during actual computation of clnor & clnorspace. However, this would complicate
-       * the code, add more memory usage, and despite its logical complexity,
-       * loop_manifold_fan_around_vert_next() is quite cheap in term of CPU cycles,
-       * so really think it's not worth it. */
-      if (!IS_EDGE_SHARP(e2l_curr) && (BLI_BITMAP_TEST(skip_loops, ml_curr_index) ||
-                                       !loop_split_generator_check_cyclic_smooth_fan(mloops,
-                                                                                     mpolys,
-                                                                                     edge_to_loops,
-                                                                                     loop_to_poly,
-                                                                                     e2l_prev,
-                                                                                     skip_loops,
-                                                                                     ml_curr,
-                                                                                     ml_prev,
-                                                                                     ml_curr_index,
-                                                                                     ml_prev_index,
-                                                                                     mp_index))) {
-        //              printf("SKIPPING!\n");
-      }
-      else {
+      const char loop_fan = find_fans ? loop_split_fan_classify(common_data,
+                                                                loop_fans,
+                                                                mp_index,
+                                                                ml_curr_index,
+                                                                ml_prev_index) :
+                                        loop_fans[ml_curr_index];
+
+      if (loop_fan != LOOP_SPLIT_SKIP) {
         LoopSplitTaskData *data, data_local;
 
-        //              printf("PROCESSING!\n");
-
         if (pool) {
           if (data_idx == 0) {
             data_buff = MEM_calloc_arrayN(
@@ -1525,7 +1847,7 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
           memset(data, 0, sizeof(*data));
         }
 
-        if (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) {
+        if (loop_fan == LOOP_SPLIT_SINGLE) {
           data->lnor = lnors;
           data->ml_curr = ml_curr;
           data->ml_prev = ml_prev;
@@ -1535,19 +1857,7 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
           data->e2l_prev = NULL; /* Tag as 'single' task. */
 #endif
           data->mp_index = mp_index;
-          if (lnors_spacearr) {
-            data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-          }
         }
-        /* We *do not need* to check/tag loops as already computed!
-         * Due to the fact a loop only links to one of its two edges,
-         * a same fan *will never be walked more than once!*
-         * Since we consider edges having neighbor polys with inverted
-         * (flipped) normals as sharp, we are sure that no fan will be skipped,
-         * even only considering the case (sharp curr_edge, smooth prev_edge),
-         * and not the alternative (smooth curr_edge, sharp prev_edge).
-         * All this due/thanks to link between normals and loop ordering (i.e. winding).
-         */
         else {
 #if 0 /* Not needed for 'fan' loops. */
           data->lnor = lnors;
@@ -1556,11 +1866,12 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
           data->ml_prev = ml_prev;
           data->ml_curr_index = ml_curr_index;
           data->ml_prev_index = ml_prev_index;
-          data->e2l_prev = e2l_prev; /* Also tag as 'fan' task. */
+          data->e2l_prev = edge_to_loops[ml_prev->e]; /* Also tag as 'fan' task. */
           data->mp_index = mp_index;
-          if (lnors_spacearr) {
-            data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-          }
+        }
+        if (lnors_spacearr) {
+          data->lnor_space = find_fans ? BKE_lnor_space_create(lnors_spacearr) :
+                                         &lnor_spaces[lnor_space_index++];
         }
 
         if (pool) {
@@ -1579,6 +1890,7 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
       ml_prev_index = ml_curr_index;
     }
   }
+  BLI_assert(lnors_spacearr == NULL || find_fans || lnor_space_index == common_data->num_fans);
 
   /* Last block of data... Since it is calloc'ed and we use first NULL item as stopper,
    * everything is fine. */
@@ -1589,7 +1901,6 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
   if (edge_vectors) {
     BLI_stack_free(edge_vectors);
   }
-  MEM_freeN(skip_loops);
 
 #ifdef DEBUG_TIME
   TIMEIT_END_AVERAGED(loop_split_generator);
@@ -1602,7 +1913,7 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
  * (splitting edges).
  */
 void BKE_mesh_normals_loop_split(const MVert *mverts,
-                                 const int UNUSED(numVerts),
+                                 const int numVerts,
                                  MEdge *medges,
                                  const int numEdges,
                                  MLoop *mloops,
@@ -1616,6 +1927,46 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
                                  MLoopNorSpaceArray *r_lnors_spacearr,
                                  short (*clnors_data)[2],
                                  int *r_loop_to_poly)
+{
+  BKE_mesh_normals_loop_split_ex(mverts,
+                                 numVerts,
+                                 medges,
+                                 numEdges,
+                                 mloops,
+                                 r_loopnors,
+                                 numLoops,
+                                 mpolys,
+                                 polynors,
+                                 numPolys,
+                                 use_split_normals,
+                                 split_angle,
+                                 r_lnors_spacearr,
+                                 clnors_data,
+                                 r_loop_to_poly,
+                                 NULL);
+}
+
+/**
+ * Same as #BKE_mesh_normals_loop_split, \a cache_p keeps the loops from which smooth fans are
+ * computed (created when NULL, and to be freed with #BKE_mesh_loop_split_cache_free).
+ * They are reused as long as topology and sharp edges stay the same.
+ */
+void BKE_mesh_normals_loop_split_ex(const MVert *mverts,
+                                    const int UNUSED(numVerts),
+                                    MEdge *medges,
+                                    const int numEdges,
+                                    MLoop *mloops,
+                                    float (*r_loopnors)[3],
+                                    const int numLoops,
+                                    MPoly *mpolys,
+                                    const float (*polynors)[3],
+                                    const int numPolys,
+                                    const bool use_split_normals,
+                                    const float split_angle,
+                                    MLoopNorSpaceArray *r_lnors_spacearr,
+                                    short (*clnors_data)[2],
+                                    int *r_loop_to_poly,
+                                    MeshLoopSplitCache **cache_p)
 {
   /* For now this is not supported.
    * If we do not use split normals, we do not generate anything fancy! */
@@ -1710,6 +2061,23 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
   /* This first loop check which edges are actually smooth, and compute edge vectors. */
   mesh_edges_sharp_tag(&common_data, check_angle, split_angle, false);
 
+  char *loop_fans = NULL;
+  if (cache_p) {
+    loop_split_cache_ensure(&common_data, cache_p);
+  }
+  else {
+    loop_fans = MEM_calloc_arrayN((size_t)numLoops, sizeof(*loop_fans), __func__);
+    common_data.loop_fans = loop_fans;
+    if (BLI_task_scheduler_num_threads() > 1) {
+      common_data.num_fans = loop_split_fans_find(&common_data);
+    }
+    else {
+      /* A separate pass finding the fans doesn't pay off without threads, the generator finds
+       * them while creating tasks. */
+      common_data.find_fans = true;
+    }
+  }
+
   if (numLoops < LOOP_SPLIT_TASK_BLOCK_SIZE * 8) {
     /* Not enough loops to be worth the whole threading overhead... */
     loop_split_generator(NULL, &common_data);
@@ -1724,6 +2092,9 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
     BLI_task_pool_free(task_pool);
   }
 
+  if (loop_fans) {
+    MEM_freeN(loop_fans);
+  }
   MEM_freeN(edge_to_loops);
   if (!r_loop_to_poly) {
     MEM_freeN(loop_to_poly);
@@ -0,0 +1,386 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_customdata.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+#include "DNA_customdata_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BLI_array.hh"
+#include "BLI_float3.hh"
+#include "BLI_math.h"
+#include "BLI_task.h"
+
+#include "PIL_time.h"
+
+namespace blender::bke::tests {
+
+class MeshNormalsTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BKE_idtype_init();
+  }
+};
+
+/* A wavy grid of quads, or of triangles when every quad is split in two. */
+static Mesh *mesh_normals_test_grid_new(const int size, const bool use_triangles)
+{
+  const int verts_num = (size + 1) * (size + 1);
+  const int polys_num = size * size * (use_triangles ? 2 : 1);
+  const int loops_num = size * size * (use_triangles ? 6 : 4);
+  Mesh *mesh = BKE_mesh_new_nomain(verts_num, 0, 0, loops_num, polys_num);
+  for (int y = 0; y <= size; y++) {
+    for (int x = 0; x <= size; x++) {
+      const float z = sinf((float)x * 0.3f) * cosf((float)y * 0.2f);
+      copy_v3_fl3(mesh->mvert[y * (size + 1) + x].co, (float)x, (float)y, z);
+    }
+  }
+  int poly_index = 0, loop_index = 0;
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      const int v1 = y * (size + 1) + x;
+      const int corners[4] = {v1, v1 + 1, v1 + size + 2, v1 + size + 1};
+      const int corners_tris[2][3] = {{corners[0], corners[1], corners[2]},
+                                      {corners[0], corners[2], corners[3]}};
+      for (int i = 0; i < (use_triangles ? 2 : 1); i++) {
+        const int *poly_corners = use_triangles ? corners_tris[i] : corners;
+        const int totloop = use_triangles ? 3 : 4;
+        mesh->mpoly[poly_index].loopstart = loop_index;
+        mesh->mpoly[poly_index].totloop = totloop;
+        for (int j = 0; j < totloop; j++) {
+          mesh->mloop[loop_index++].v = (uint)poly_corners[j];
+        }
+        poly_index++;
+      }
+    }
+  }
+  return mesh;
+}
+
+/* Reference implementation, single threaded, using the generic polygon functions. */
+static void mesh_normals_test_reference(const Mesh *mesh,
+                                        float (*r_vnors)[3],
+                                        float (*r_pnors)[3])
+{
+  memset(r_vnors, 0, sizeof(*r_vnors) * (size_t)mesh->totvert);
+  for (int i = 0; i < mesh->totpoly; i++) {
+    const MPoly *mp = &mesh->mpoly[i];
+    const MLoop *ml = &mesh->mloop[mp->loopstart];
+    BKE_mesh_calc_poly_normal(mp, ml, mesh->mvert, r_pnors[i]);
+    Array<float *> vertnos(mp->totloop);
+    Array<const float *> vertcos(mp->totloop);
+    Array<float3> vdiffs(mp->totloop);
+    for (int j = 0; j < mp->totloop; j++) {
+      vertnos[j] = r_vnors[ml[j].v];
+      vertcos[j] = mesh->mvert[ml[j].v].co;
+    }
+    accumulate_vertex_normals_poly_v3(vertnos.data(),
+                                      r_pnors[i],
+                                      vertcos.data(),
+                                      reinterpret_cast<float(*)[3]>(vdiffs.data()),
+                                      mp->totloop);
+  }
+  for (int i = 0; i < mesh->totvert; i++) {
+    normalize_v3(r_vnors[i]);
+  }
+}
+
+static void mesh_normals_test_compare(Mesh *mesh)
+{
+  Array<float3> vnors(mesh->totvert), pnors(mesh->totpoly);
+  Array<float3> vnors_ref(mesh->totvert), pnors_ref(mesh->totpoly);
+  BKE_mesh_calc_normals_poly(mesh->mvert,
+                             reinterpret_cast<float(*)[3]>(vnors.data()),
+                             mesh->totvert,
+                             mesh->mloop,
+                             mesh->mpoly,
+                             mesh->totloop,
+                             mesh->totpoly,
+                             reinterpret_cast<float(*)[3]>(pnors.data()),
+                             false);
+  mesh_normals_test_reference(mesh,
+                              reinterpret_cast<float(*)[3]>(vnors_ref.data()),
+                              reinterpret_cast<float(*)[3]>(pnors_ref.data()));
+  /* The result must not depend on how the work is split between threads. */
+  Array<float3> vnors_again(mesh->totvert);
+  BKE_mesh_calc_normals_poly(mesh->mvert,
+                             reinterpret_cast<float(*)[3]>(vnors_again.data()),
+                             mesh->totvert,
+                             mesh->mloop,
+                             mesh->mpoly,
+                             mesh->totloop,
+                             mesh->totpoly,
+                             nullptr,
+                             false);
+  EXPECT_EQ_ARRAY(
+      (const float *)vnors.data(), (const float *)vnors_again.data(), mesh->totvert * 3);
+  for (int i = 0; i < mesh->totpoly; i++) {
+    EXPECT_V3_NEAR(pnors[i], pnors_ref[i], 1e-5f);
+  }
+  for (int i = 0; i < mesh->totvert; i++) {
+    EXPECT_V3_NEAR(vnors[i], vnors_ref[i], 1e-5f);
+    float no[3];
+    normal_short_to_float_v3(no, mesh->mvert[i].no);
+    EXPECT_V3_NEAR(no, vnors_ref[i], 1e-4f);
+  }
+}
+
+TEST_F(MeshNormalsTest, Quads)
+{
+  Mesh *mesh = mesh_normals_test_grid_new(64, false);
+  mesh_normals_test_compare(mesh);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshNormalsTest, Triangles)
+{
+  Mesh *mesh = mesh_normals_test_grid_new(64, true);
+  mesh_normals_test_compare(mesh);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshNormalsTest, NGon)
+{
+  /* A hexagon surrounded by triangles, with one vertex lifted. */
+  Mesh *mesh = BKE_mesh_new_nomain(7, 0, 0, 6 + 6 * 3, 7);
+  for (int i = 0; i < 6; i++) {
+    const float angle = (float)i * (float)M_PI / 3.0f;
+    copy_v3_fl3(mesh->mvert[i].co, cosf(angle), sinf(angle), (i == 2) ? 0.5f : 0.0f);
+  }
+  copy_v3_fl3(mesh->mvert[6].co, 0.0f, 0.0f, -1.0f);
+  mesh->mpoly[0].loopstart = 0;
+  mesh->mpoly[0].totloop = 6;
+  for (int i = 0; i < 6; i++) {
+    mesh->mloop[i].v = (uint)i;
+    MPoly *mp = &mesh->mpoly[i + 1];
+    mp->loopstart = 6 + i * 3;
+    mp->totloop = 3;
+    mesh->mloop[mp->loopstart + 0].v = (uint)((i + 1) % 6);
+    mesh->mloop[mp->loopstart + 1].v = (uint)i;
+    mesh->mloop[mp->loopstart + 2].v = 6;
+  }
+  mesh_normals_test_compare(mesh);
+  BKE_id_free(nullptr, mesh);
+}
+
+static void mesh_normals_test_performance(const int size, const bool use_triangles)
+{
+  Mesh *mesh = mesh_normals_test_grid_new(size, use_triangles);
+  const double time_start = PIL_check_seconds_timer();
+  BKE_mesh_calc_normals(mesh);
+  printf("Vertex normals of %d vertices, %d %s, %d threads: %.3f ms\n",
+         mesh->totvert,
+         mesh->totpoly,
+         use_triangles ? "triangles" : "quads",
+         BLI_task_scheduler_num_threads(),
+         (PIL_check_seconds_timer() - time_start) * 1000.0);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshNormalsTest, performance_quads_1000000)
+{
+  mesh_normals_test_performance(1000, false);
+}
+
+TEST_F(MeshNormalsTest, performance_triangles_1000000)
+{
+  mesh_normals_test_performance(1000, true);
+}
+
+/* Grid with edges and auto smooth enabled, for split normals. */
+static Mesh *mesh_normals_test_split_grid_new(const int size)
+{
+  Mesh *mesh = mesh_normals_test_grid_new(size, false);
+  BKE_mesh_calc_edges(mesh, false, false);
+  for (int i = 0; i < mesh->totpoly; i++) {
+    mesh->mpoly[i].flag |= ME_SMOOTH;
+  }
+  mesh->flag |= ME_AUTOSMOOTH;
+  mesh->smoothresh = DEG2RADF(30.0f);
+  BKE_mesh_calc_normals(mesh);
+  return mesh;
+}
+
+/* Tag some edges sharp and some polygons flat, to get fans of all kinds. */
+static void mesh_normals_test_split_tag_sharp(Mesh *mesh, const int step)
+{
+  for (int i = 0; i < mesh->totedge; i += step) {
+    mesh->medge[i].flag |= ME_SHARP;
+  }
+  for (int i = 0; i < mesh->totpoly; i += step * 3) {
+    mesh->mpoly[i].flag &= ~ME_SMOOTH;
+  }
+}
+
+static Array<float3> mesh_normals_test_split_calc(Mesh *mesh, MeshLoopSplitCache **cache_p)
+{
+  Array<float3> pnors(mesh->totpoly);
+  BKE_mesh_calc_normals_poly(mesh->mvert,
+                             nullptr,
+                             mesh->totvert,
+                             mesh->mloop,
+                             mesh->mpoly,
+                             mesh->totloop,
+                             mesh->totpoly,
+                             reinterpret_cast<float(*)[3]>(pnors.data()),
+                             false);
+  Array<float3> lnors(mesh->totloop);
+  BKE_mesh_normals_loop_split_ex(
+      mesh->mvert,
+      mesh->totvert,
+      mesh->medge,
+      mesh->totedge,
+      mesh->mloop,
+      reinterpret_cast<float(*)[3]>(lnors.data()),
+      mesh->totloop,
+      mesh->mpoly,
+      reinterpret_cast<const float(*)[3]>(pnors.data()),
+      mesh->totpoly,
+      true,
+      mesh->smoothresh,
+      nullptr,
+      static_cast<short(*)[2]>(CustomData_get_layer(&mesh->ldata, CD_CUSTOMLOOPNORMAL)),
+      nullptr,
+      cache_p);
+  return lnors;
+}
+
+TEST_F(MeshNormalsTest, SplitSmooth)
+{
+  Mesh *mesh = mesh_normals_test_split_grid_new(32);
+  mesh->smoothresh = (float)M_PI;
+  Array<float3> lnors = mesh_normals_test_split_calc(mesh, nullptr);
+  for (int i = 0; i < mesh->totloop; i++) {
+    float no[3];
+    normal_short_to_float_v3(no, mesh->mvert[mesh->mloop[i].v].no);
+    EXPECT_V3_NEAR(lnors[i], no, 1e-4f);
+  }
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshNormalsTest, SplitFlat)
+{
+  Mesh *mesh = mesh_normals_test_split_grid_new(32);
+  for (int i = 0; i < mesh->totpoly; i++) {
+    mesh->mpoly[i].flag &= ~ME_SMOOTH;
+  }
+  Array<float3> lnors = mesh_normals_test_split_calc(mesh, nullptr);
+  for (int i = 0; i < mesh->totpoly; i++) {
+    const MPoly *mp = &mesh->mpoly[i];
+    float pnor[3];
+    BKE_mesh_calc_poly_normal(mp, &mesh->mloop[mp->loopstart], mesh->mvert, pnor);
+    for (int j = mp->loopstart; j < mp->loopstart + mp->totloop; j++) {
+      EXPECT_V3_NEAR(lnors[j], pnor, 1e-5f);
+    }
+  }
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshNormalsTest, SplitCache)
+{
+  /* Enough loops for the multi-threaded code path. */
+  Mesh *mesh = mesh_normals_test_split_grid_new(64);
+  MeshLoopSplitCache *cache = nullptr;
+
+  Array<float3> lnors_smooth = mesh_normals_test_split_calc(mesh, &cache);
+  ASSERT_NE(cache, nullptr);
+  Array<float3> lnors_cached = mesh_normals_test_split_calc(mesh, &cache);
+  for (int i = 0; i < mesh->totloop; i++) {
+    EXPECT_V3_NEAR(lnors_cached[i], lnors_smooth[i], 0.0f);
+  }
+
+  /* New sharp edges must not use the cached fans. */
+  mesh_normals_test_split_tag_sharp(mesh, 7);
+  lnors_cached = mesh_normals_test_split_calc(mesh, &cache);
+  Array<float3> lnors = mesh_normals_test_split_calc(mesh, nullptr);
+  int changed_num = 0;
+  for (int i = 0; i < mesh->totloop; i++) {
+    EXPECT_V3_NEAR(lnors_cached[i], lnors[i], 0.0f);
+    changed_num += !equals_v3v3(lnors[i], lnors_smooth[i]);
+  }
+  EXPECT_GT(changed_num, 0);
+
+  BKE_mesh_loop_split_cache_free(cache);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshNormalsTest, SplitCustomNormals)
+{
+  Mesh *mesh = mesh_normals_test_split_grid_new(64);
+  mesh_normals_test_split_tag_sharp(mesh, 5);
+  float3 custom_nor(0.3f, -0.2f, 1.0f);
+  custom_nor.normalize();
+  Array<float3> custom_nors(mesh->totloop, custom_nor);
+  BKE_mesh_set_custom_normals(mesh, reinterpret_cast<float(*)[3]>(custom_nors.data()));
+
+  Array<float3> lnors = mesh_normals_test_split_calc(mesh, nullptr);
+  for (int i = 0; i < mesh->totloop; i++) {
+    EXPECT_V3_NEAR(lnors[i], custom_nor, 1e-2f);
+  }
+  BKE_id_free(nullptr, mesh);
+}
+
+static void mesh_normals_test_split_performance(const int size)
+{
+  Mesh *mesh = mesh_normals_test_split_grid_new(size);
+  /* Add the loop normals layer, so that its allocation isn't timed. */
+  BKE_mesh_calc_normals_split(mesh);
+
+  /* Best of a few runs each, timings vary a lot between runs. */
+  const int runs_num = 5;
+  double time_uncached = DBL_MAX, time_first = DBL_MAX, time_cached = DBL_MAX;
+  for (int run = 0; run < runs_num; run++) {
+    double time_start = PIL_check_seconds_timer();
+    BKE_mesh_calc_normals_split(mesh);
+    time_uncached = min_dd(time_uncached, PIL_check_seconds_timer() - time_start);
+
+    /* The second evaluation reuses the smooth fans. */
+    MeshLoopSplitCache *cache = nullptr;
+    time_start = PIL_check_seconds_timer();
+    BKE_mesh_calc_normals_split_cached(mesh, &cache);
+    time_first = min_dd(time_first, PIL_check_seconds_timer() - time_start);
+
+    time_start = PIL_check_seconds_timer();
+    BKE_mesh_calc_normals_split_cached(mesh, &cache);
+    time_cached = min_dd(time_cached, PIL_check_seconds_timer() - time_start);
+    BKE_mesh_loop_split_cache_free(cache);
+  }
+  printf("Split normals of %d loops, %d threads: "
+         "%.3f ms uncached, %.3f ms first, %.3f ms cached\n",
+         mesh->totloop,
+         BLI_task_scheduler_num_threads(),
+         time_uncached * 1000.0,
+         time_first * 1000.0,
+         time_cached * 1000.0);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshNormalsTest, performance_split_4000000)
+{
+  mesh_normals_test_split_performance(1000);
+}
+
+}  // namespace blender::bke::tests
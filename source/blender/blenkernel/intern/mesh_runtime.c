@@ -67,6 +67,7 @@ void BKE_mesh_runtime_reset_on_copy(Mesh *mesh, const int UNUSED(flag))
   runtime->subdiv_ccg = NULL;
   memset(&runtime->looptris, 0, sizeof(runtime->looptris));
   runtime->bvh_cache = NULL;
+  runtime->bvh_cache_reuse = NULL;
   runtime->shrinkwrap_data = NULL;
 
   mesh->runtime.eval_mutex = MEM_mallocN(sizeof(ThreadMutex), "mesh runtime eval_mutex");
@@ -233,6 +234,10 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
     bvhcache_free(mesh->runtime.bvh_cache);
     mesh->runtime.bvh_cache = NULL;
   }
+  if (mesh->runtime.bvh_cache_reuse) {
+    bvhcache_free(mesh->runtime.bvh_cache_reuse);
+    mesh->runtime.bvh_cache_reuse = NULL;
+  }
   MEM_SAFE_FREE(mesh->runtime.looptris.array);
   /* TODO(sergey): Does this really belong here? */
   if (mesh->runtime.subdiv_ccg != NULL) {
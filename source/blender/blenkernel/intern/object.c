@@ -81,6 +81,7 @@
 #include "BKE_anim_visualization.h"
 #include "BKE_animsys.h"
 #include "BKE_armature.h"
+#include "BKE_bvhutils.h"
 #include "BKE_camera.h"
 #include "BKE_collection.h"
 #include "BKE_constraint.h"
@@ -285,6 +286,14 @@ static void object_copy_data(Main *bmain, ID *id_dst, const ID *id_src, const in
   }
 }
 
+static void object_free_bvh_cache_reuse(Object *ob)
+{
+  if (ob->runtime.bvh_cache_reuse != NULL) {
+    bvhcache_free(ob->runtime.bvh_cache_reuse);
+    ob->runtime.bvh_cache_reuse = NULL;
+  }
+}
+
 static void object_free_data(ID *id)
 {
   Object *ob = (Object *)id;
@@ -332,6 +341,11 @@ static void object_free_data(ID *id)
     MEM_freeN(ob->runtime.curve_cache);
     ob->runtime.curve_cache = NULL;
   }
+  object_free_bvh_cache_reuse(ob);
+  if (ob->runtime.loop_split_cache != NULL) {
+    BKE_mesh_loop_split_cache_free(ob->runtime.loop_split_cache);
+    ob->runtime.loop_split_cache = NULL;
+  }
 
   BKE_previewimg_free(&ob->preview);
 }
@@ -1522,6 +1536,13 @@ void BKE_object_free_derived_caches(Object *ob)
     if (ob->runtime.is_data_eval_owned) {
       ID *data_eval = ob->runtime.data_eval;
       if (GS(data_eval->name) == ID_ME) {
+        /* Keep the trees for the next evaluated mesh, they can be refitted when only
+         * vertex positions change. */
+        struct BVHCache *bvh_cache = bvhcache_release_for_reuse((Mesh *)data_eval);
+        if (bvh_cache != NULL) {
+          object_free_bvh_cache_reuse(ob);
+          ob->runtime.bvh_cache_reuse = bvh_cache;
+        }
         BKE_mesh_eval_delete((Mesh *)data_eval);
       }
       else {
@@ -4870,6 +4891,8 @@ void BKE_object_runtime_reset_on_copy(Object *object, const int UNUSED(flag))
   runtime->data_eval = NULL;
   runtime->mesh_deform_eval = NULL;
   runtime->curve_cache = NULL;
+  runtime->bvh_cache_reuse = NULL;
+  runtime->loop_split_cache = NULL;
 }
 
 /**
@@ -38,6 +38,7 @@
 #include "BKE_subdiv.h"
 #include "BKE_subdiv_eval.h"
 
+#include "opensubdiv_capi_type.h"
 #include "opensubdiv_topology_refiner_capi.h"
 
 /* -------------------------------------------------------------------- */
@@ -176,27 +177,52 @@ typedef struct CCGEvalGridsData {
   SubdivCCGMaterialFlagsEvaluator *material_flags_evaluator;
 } CCGEvalGridsData;
 
-static void subdiv_ccg_eval_grid_element_limit(CCGEvalGridsData *data,
-                                               const int ptex_face_index,
-                                               const float u,
-                                               const float v,
-                                               unsigned char *element)
+/* Per-thread buffers used to evaluate all elements of a grid in a single batch. */
+typedef struct CCGEvalGridsTLSData {
+  OpenSubdiv_PatchCoord *patch_coords;
+  float (*P)[3];
+  float (*N)[3];
+} CCGEvalGridsTLSData;
+
+static void subdiv_ccg_eval_grids_tls_ensure(const SubdivCCG *subdiv_ccg, CCGEvalGridsTLSData *tls)
+{
+  if (tls->patch_coords != NULL) {
+    return;
+  }
+  const int grid_area = subdiv_ccg->grid_size * subdiv_ccg->grid_size;
+  tls->patch_coords = MEM_malloc_arrayN(
+      grid_area, sizeof(OpenSubdiv_PatchCoord), "CCG TLS patch coords");
+  tls->P = MEM_malloc_arrayN(grid_area, sizeof(float[3]), "CCG TLS positions");
+  if (subdiv_ccg->has_normal) {
+    tls->N = MEM_malloc_arrayN(grid_area, sizeof(float[3]), "CCG TLS normals");
+  }
+}
+
+/* Evaluate limit surface of all grid elements, which coordinates are stored in the TLS. */
+static void subdiv_ccg_eval_grid_elements_limit(CCGEvalGridsData *data,
+                                                CCGEvalGridsTLSData *tls,
+                                                unsigned char *grid)
 {
   Subdiv *subdiv = data->subdiv;
   SubdivCCG *subdiv_ccg = data->subdiv_ccg;
+  const int grid_area = subdiv_ccg->grid_size * subdiv_ccg->grid_size;
+  const int element_size = element_size_bytes_get(subdiv_ccg);
+  const bool use_normals = subdiv_ccg->has_normal && subdiv->displacement_evaluator == NULL;
   if (subdiv->displacement_evaluator != NULL) {
-    BKE_subdiv_eval_final_point(subdiv, ptex_face_index, u, v, (float *)element);
+    BKE_subdiv_eval_final_points(subdiv, tls->patch_coords, grid_area, tls->P);
   }
-  else if (subdiv_ccg->has_normal) {
-    BKE_subdiv_eval_limit_point_and_normal(subdiv,
-                                           ptex_face_index,
-                                           u,
-                                           v,
-                                           (float *)element,
-                                           (float *)(element + subdiv_ccg->normal_offset));
+  else if (use_normals) {
+    BKE_subdiv_eval_limit_points_and_normals(subdiv, tls->patch_coords, grid_area, tls->P, tls->N);
   }
   else {
-    BKE_subdiv_eval_limit_point(subdiv, ptex_face_index, u, v, (float *)element);
+    BKE_subdiv_eval_limit_points(subdiv, tls->patch_coords, grid_area, tls->P);
+  }
+  for (int i = 0; i < grid_area; i++) {
+    unsigned char *element = &grid[(size_t)i * element_size];
+    copy_v3_v3((float *)element, tls->P[i]);
+    if (use_normals) {
+      copy_v3_v3((float *)(element + subdiv_ccg->normal_offset), tls->N[i]);
+    }
   }
 }
 
@@ -219,23 +245,35 @@ static void subdiv_ccg_eval_grid_element_mask(CCGEvalGridsData *data,
   }
 }
 
-static void subdiv_ccg_eval_grid_element(CCGEvalGridsData *data,
-                                         const int ptex_face_index,
-                                         const float u,
-                                         const float v,
-                                         unsigned char *element)
+static void subdiv_ccg_eval_grid_elements(CCGEvalGridsData *data,
+                                          CCGEvalGridsTLSData *tls,
+                                          unsigned char *grid)
 {
-  subdiv_ccg_eval_grid_element_limit(data, ptex_face_index, u, v, element);
-  subdiv_ccg_eval_grid_element_mask(data, ptex_face_index, u, v, element);
+  SubdivCCG *subdiv_ccg = data->subdiv_ccg;
+  subdiv_ccg_eval_grid_elements_limit(data, tls, grid);
+  if (!subdiv_ccg->has_mask) {
+    return;
+  }
+  const int grid_area = subdiv_ccg->grid_size * subdiv_ccg->grid_size;
+  const int element_size = element_size_bytes_get(subdiv_ccg);
+  for (int i = 0; i < grid_area; i++) {
+    const OpenSubdiv_PatchCoord *patch_coord = &tls->patch_coords[i];
+    subdiv_ccg_eval_grid_element_mask(data,
+                                      patch_coord->ptex_face,
+                                      patch_coord->u,
+                                      patch_coord->v,
+                                      &grid[(size_t)i * element_size]);
+  }
 }
 
-static void subdiv_ccg_eval_regular_grid(CCGEvalGridsData *data, const int face_index)
+static void subdiv_ccg_eval_regular_grid(CCGEvalGridsData *data,
+                                         CCGEvalGridsTLSData *tls,
+                                         const int face_index)
 {
   SubdivCCG *subdiv_ccg = data->subdiv_ccg;
   const int ptex_face_index = data->face_ptex_offset[face_index];
   const int grid_size = subdiv_ccg->grid_size;
   const float grid_size_1_inv = 1.0f / (grid_size - 1);
-  const int element_size = element_size_bytes_get(subdiv_ccg);
   SubdivCCGFace *faces = subdiv_ccg->faces;
   SubdivCCGFace **grid_faces = subdiv_ccg->grid_faces;
   const SubdivCCGFace *face = &faces[face_index];
@@ -246,13 +284,12 @@ static void subdiv_ccg_eval_regular_grid(CCGEvalGridsData *data, const int face_
       const float grid_v = y * grid_size_1_inv;
       for (int x = 0; x < grid_size; x++) {
         const float grid_u = x * grid_size_1_inv;
-        float u, v;
-        BKE_subdiv_rotate_grid_to_quad(corner, grid_u, grid_v, &u, &v);
-        const size_t grid_element_index = (size_t)y * grid_size + x;
-        const size_t grid_element_offset = grid_element_index * element_size;
-        subdiv_ccg_eval_grid_element(data, ptex_face_index, u, v, &grid[grid_element_offset]);
+        OpenSubdiv_PatchCoord *patch_coord = &tls->patch_coords[y * grid_size + x];
+        patch_coord->ptex_face = ptex_face_index;
+        BKE_subdiv_rotate_grid_to_quad(corner, grid_u, grid_v, &patch_coord->u, &patch_coord->v);
       }
     }
+    subdiv_ccg_eval_grid_elements(data, tls, grid);
     /* Assign grid's face. */
     grid_faces[grid_index] = &faces[face_index];
     /* Assign material flags. */
@@ -261,12 +298,13 @@ static void subdiv_ccg_eval_regular_grid(CCGEvalGridsData *data, const int face_
   }
 }
 
-static void subdiv_ccg_eval_special_grid(CCGEvalGridsData *data, const int face_index)
+static void subdiv_ccg_eval_special_grid(CCGEvalGridsData *data,
+                                         CCGEvalGridsTLSData *tls,
+                                         const int face_index)
 {
   SubdivCCG *subdiv_ccg = data->subdiv_ccg;
   const int grid_size = subdiv_ccg->grid_size;
   const float grid_size_1_inv = 1.0f / (grid_size - 1);
-  const int element_size = element_size_bytes_get(subdiv_ccg);
   SubdivCCGFace *faces = subdiv_ccg->faces;
   SubdivCCGFace **grid_faces = subdiv_ccg->grid_faces;
   const SubdivCCGFace *face = &faces[face_index];
@@ -278,11 +316,13 @@ static void subdiv_ccg_eval_special_grid(CCGEvalGridsData *data, const int face_
       const float u = 1.0f - (y * grid_size_1_inv);
       for (int x = 0; x < grid_size; x++) {
         const float v = 1.0f - (x * grid_size_1_inv);
-        const size_t grid_element_index = (size_t)y * grid_size + x;
-        const size_t grid_element_offset = grid_element_index * element_size;
-        subdiv_ccg_eval_grid_element(data, ptex_face_index, u, v, &grid[grid_element_offset]);
+        OpenSubdiv_PatchCoord *patch_coord = &tls->patch_coords[y * grid_size + x];
+        patch_coord->ptex_face = ptex_face_index;
+        patch_coord->u = u;
+        patch_coord->v = v;
       }
     }
+    subdiv_ccg_eval_grid_elements(data, tls, grid);
     /* Assign grid's face. */
     grid_faces[grid_index] = &faces[face_index];
     /* Assign material flags. */
@@ -293,19 +333,30 @@ static void subdiv_ccg_eval_special_grid(CCGEvalGridsData *data, const int face_
 
 static void subdiv_ccg_eval_grids_task(void *__restrict userdata_v,
                                        const int face_index,
-                                       const TaskParallelTLS *__restrict UNUSED(tls))
+                                       const TaskParallelTLS *__restrict tls_v)
 {
   CCGEvalGridsData *data = userdata_v;
+  CCGEvalGridsTLSData *tls = tls_v->userdata_chunk;
   SubdivCCG *subdiv_ccg = data->subdiv_ccg;
   SubdivCCGFace *face = &subdiv_ccg->faces[face_index];
+  subdiv_ccg_eval_grids_tls_ensure(subdiv_ccg, tls);
   if (face->num_grids == 4) {
-    subdiv_ccg_eval_regular_grid(data, face_index);
+    subdiv_ccg_eval_regular_grid(data, tls, face_index);
   }
   else {
-    subdiv_ccg_eval_special_grid(data, face_index);
+    subdiv_ccg_eval_special_grid(data, tls, face_index);
   }
 }
 
+static void subdiv_ccg_eval_grids_free(const void *__restrict UNUSED(userdata),
+                                       void *__restrict tls_v)
+{
+  CCGEvalGridsTLSData *tls = tls_v;
+  MEM_SAFE_FREE(tls->patch_coords);
+  MEM_SAFE_FREE(tls->P);
+  MEM_SAFE_FREE(tls->N);
+}
+
 static bool subdiv_ccg_evaluate_grids(SubdivCCG *subdiv_ccg,
                                       Subdiv *subdiv,
                                       SubdivCCGMaskEvaluator *mask_evaluator,
@@ -320,9 +371,13 @@ static bool subdiv_ccg_evaluate_grids(SubdivCCG *subdiv_ccg,
   data.face_ptex_offset = BKE_subdiv_face_ptex_offset_get(subdiv);
   data.mask_evaluator = mask_evaluator;
   data.material_flags_evaluator = material_flags_evaluator;
-  /* Threaded grids evaluation. */
+  /* Threaded grids evaluation, elements of every grid are evaluated in a single batch. */
+  CCGEvalGridsTLSData tls_data = {NULL};
   TaskParallelSettings parallel_range_settings;
   BLI_parallel_range_settings_defaults(&parallel_range_settings);
+  parallel_range_settings.userdata_chunk = &tls_data;
+  parallel_range_settings.userdata_chunk_size = sizeof(tls_data);
+  parallel_range_settings.func_free = subdiv_ccg_eval_grids_free;
   BLI_task_parallel_range(
       0, num_faces, &data, subdiv_ccg_eval_grids_task, &parallel_range_settings);
   /* If displacement is used, need to calculate normals after all final
@@ -27,7 +27,9 @@
 #include "DNA_meshdata_types.h"
 
 #include "BLI_bitmap.h"
+#include "BLI_math_base.h"
 #include "BLI_math_vector.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_customdata.h"
@@ -35,6 +37,7 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "opensubdiv_capi_type.h"
 #include "opensubdiv_evaluator_capi.h"
 #include "opensubdiv_topology_refiner_capi.h"
 
@@ -174,7 +177,8 @@ void BKE_subdiv_eval_limit_point(
   BKE_subdiv_eval_limit_point_and_derivatives(subdiv, ptex_face_index, u, v, r_P, NULL, NULL);
 }
 
-void BKE_subdiv_eval_limit_point_and_derivatives(Subdiv *subdiv,
+/* Re-evaluate point with derivatives which can not be used to calculate a normal. */
+static void subdiv_eval_ensure_valid_derivatives(Subdiv *subdiv,
                                                  const int ptex_face_index,
                                                  const float u,
                                                  const float v,
@@ -182,8 +186,6 @@ void BKE_subdiv_eval_limit_point_and_derivatives(Subdiv *subdiv,
                                                  float r_dPdu[3],
                                                  float r_dPdv[3])
 {
-  subdiv->evaluator->evaluateLimit(subdiv->evaluator, ptex_face_index, u, v, r_P, r_dPdu, r_dPdv);
-
   /* NOTE: In a very rare occasions derivatives are evaluated to zeros or are exactly equal.
    * This happens, for example, in single vertex on Suzannne's nose (where two quads have 2 common
    * edges).
@@ -195,16 +197,28 @@ void BKE_subdiv_eval_limit_point_and_derivatives(Subdiv *subdiv,
    * which there must be proper derivatives. This might break continuity of normals, but is better
    * that giving totally unusable derivatives. */
 
+  if ((is_zero_v3(r_dPdu) || is_zero_v3(r_dPdv)) || equals_v3v3(r_dPdu, r_dPdv)) {
+    subdiv->evaluator->evaluateLimit(subdiv->evaluator,
+                                     ptex_face_index,
+                                     u * 0.999f + 0.0005f,
+                                     v * 0.999f + 0.0005f,
+                                     r_P,
+                                     r_dPdu,
+                                     r_dPdv);
+  }
+}
+
+void BKE_subdiv_eval_limit_point_and_derivatives(Subdiv *subdiv,
+                                                 const int ptex_face_index,
+                                                 const float u,
+                                                 const float v,
+                                                 float r_P[3],
+                                                 float r_dPdu[3],
+                                                 float r_dPdv[3])
+{
+  subdiv->evaluator->evaluateLimit(subdiv->evaluator, ptex_face_index, u, v, r_P, r_dPdu, r_dPdv);
   if (r_dPdu != NULL && r_dPdv != NULL) {
-    if ((is_zero_v3(r_dPdu) || is_zero_v3(r_dPdv)) || equals_v3v3(r_dPdu, r_dPdv)) {
-      subdiv->evaluator->evaluateLimit(subdiv->evaluator,
-                                       ptex_face_index,
-                                       u * 0.999f + 0.0005f,
-                                       v * 0.999f + 0.0005f,
-                                       r_P,
-                                       r_dPdu,
-                                       r_dPdv);
-    }
+    subdiv_eval_ensure_valid_derivatives(subdiv, ptex_face_index, u, v, r_P, r_dPdu, r_dPdv);
   }
 }
 
@@ -274,6 +288,150 @@ void BKE_subdiv_eval_final_point(
   }
 }
 
+/* ============================= Batched queries ============================= */
+
+/* Number of points passed to the evaluator at once. Bigger batches are split into chunks of this
+ * size, which are evaluated in parallel. */
+#define SUBDIV_EVAL_CHUNK_SIZE 256
+
+typedef struct SubdivEvalPointsData {
+  Subdiv *subdiv;
+  const OpenSubdiv_PatchCoord *patch_coords;
+  float (*r_P)[3];
+  /* Optional outputs. */
+  float (*r_dPdu)[3];
+  float (*r_dPdv)[3];
+  float (*r_N)[3];
+  /* Apply displacement to the points. */
+  bool use_displacement;
+  int num_patch_coords;
+} SubdivEvalPointsData;
+
+static void subdiv_eval_points_chunk(const SubdivEvalPointsData *data,
+                                     const int start,
+                                     const int num_patch_coords)
+{
+  Subdiv *subdiv = data->subdiv;
+  OpenSubdiv_Evaluator *evaluator = subdiv->evaluator;
+  const OpenSubdiv_PatchCoord *patch_coords = data->patch_coords + start;
+  float(*P)[3] = data->r_P + start;
+  const bool use_displacement = data->use_displacement && subdiv->displacement_evaluator != NULL;
+  if (data->r_dPdu == NULL && data->r_N == NULL && !use_displacement) {
+    evaluator->evaluatePatchesLimit(
+        evaluator, patch_coords, num_patch_coords, (float *)P, NULL, NULL);
+    return;
+  }
+  float dPdu_buffer[SUBDIV_EVAL_CHUNK_SIZE][3], dPdv_buffer[SUBDIV_EVAL_CHUNK_SIZE][3];
+  float(*dPdu)[3] = (data->r_dPdu != NULL) ? data->r_dPdu + start : dPdu_buffer;
+  float(*dPdv)[3] = (data->r_dPdv != NULL) ? data->r_dPdv + start : dPdv_buffer;
+  evaluator->evaluatePatchesLimit(
+      evaluator, patch_coords, num_patch_coords, (float *)P, (float *)dPdu, (float *)dPdv);
+  for (int i = 0; i < num_patch_coords; i++) {
+    const OpenSubdiv_PatchCoord *patch_coord = &patch_coords[i];
+    subdiv_eval_ensure_valid_derivatives(
+        subdiv, patch_coord->ptex_face, patch_coord->u, patch_coord->v, P[i], dPdu[i], dPdv[i]);
+    if (data->r_N != NULL) {
+      float *N = data->r_N[start + i];
+      cross_v3_v3v3(N, dPdu[i], dPdv[i]);
+      normalize_v3(N);
+    }
+    if (use_displacement) {
+      float D[3];
+      BKE_subdiv_eval_displacement(
+          subdiv, patch_coord->ptex_face, patch_coord->u, patch_coord->v, dPdu[i], dPdv[i], D);
+      add_v3_v3(P[i], D);
+    }
+  }
+}
+
+static void subdiv_eval_points_task(void *__restrict userdata,
+                                    const int chunk_index,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const SubdivEvalPointsData *data = userdata;
+  const int start = chunk_index * SUBDIV_EVAL_CHUNK_SIZE;
+  subdiv_eval_points_chunk(
+      data, start, min_ii(SUBDIV_EVAL_CHUNK_SIZE, data->num_patch_coords - start));
+}
+
+static void subdiv_eval_points(const SubdivEvalPointsData *data)
+{
+  const int num_chunks = (data->num_patch_coords + SUBDIV_EVAL_CHUNK_SIZE - 1) /
+                         SUBDIV_EVAL_CHUNK_SIZE;
+  if (num_chunks <= 1) {
+    subdiv_eval_points_chunk(data, 0, data->num_patch_coords);
+    return;
+  }
+  TaskParallelSettings parallel_range_settings;
+  BLI_parallel_range_settings_defaults(&parallel_range_settings);
+  parallel_range_settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(
+      0, num_chunks, (void *)data, subdiv_eval_points_task, &parallel_range_settings);
+}
+
+void BKE_subdiv_eval_limit_points(Subdiv *subdiv,
+                                  const OpenSubdiv_PatchCoord *patch_coords,
+                                  const int num_patch_coords,
+                                  float (*r_P)[3])
+{
+  const SubdivEvalPointsData data = {
+      .subdiv = subdiv,
+      .patch_coords = patch_coords,
+      .r_P = r_P,
+      .num_patch_coords = num_patch_coords,
+  };
+  subdiv_eval_points(&data);
+}
+
+void BKE_subdiv_eval_limit_points_and_derivatives(Subdiv *subdiv,
+                                                  const OpenSubdiv_PatchCoord *patch_coords,
+                                                  const int num_patch_coords,
+                                                  float (*r_P)[3],
+                                                  float (*r_dPdu)[3],
+                                                  float (*r_dPdv)[3])
+{
+  const SubdivEvalPointsData data = {
+      .subdiv = subdiv,
+      .patch_coords = patch_coords,
+      .r_P = r_P,
+      .r_dPdu = r_dPdu,
+      .r_dPdv = r_dPdv,
+      .num_patch_coords = num_patch_coords,
+  };
+  subdiv_eval_points(&data);
+}
+
+void BKE_subdiv_eval_limit_points_and_normals(Subdiv *subdiv,
+                                              const OpenSubdiv_PatchCoord *patch_coords,
+                                              const int num_patch_coords,
+                                              float (*r_P)[3],
+                                              float (*r_N)[3])
+{
+  const SubdivEvalPointsData data = {
+      .subdiv = subdiv,
+      .patch_coords = patch_coords,
+      .r_P = r_P,
+      .r_N = r_N,
+      .num_patch_coords = num_patch_coords,
+  };
+  subdiv_eval_points(&data);
+}
+
+void BKE_subdiv_eval_final_points(Subdiv *subdiv,
+                                  const OpenSubdiv_PatchCoord *patch_coords,
+                                  const int num_patch_coords,
+                                  float (*r_P)[3])
+{
+  const SubdivEvalPointsData data = {
+      .subdiv = subdiv,
+      .patch_coords = patch_coords,
+      .r_P = r_P,
+      .use_displacement = true,
+      .num_patch_coords = num_patch_coords,
+  };
+  subdiv_eval_points(&data);
+}
+
 /* ===================  Patch queries at given resolution =================== */
 
 /* Move buffer forward by a given number of bytes. */
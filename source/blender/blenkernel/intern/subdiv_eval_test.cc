@@ -0,0 +1,275 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "BKE_subdiv.h"
+#include "BKE_subdiv_eval.h"
+
+#include "BLI_float3.hh"
+#include "BLI_math.h"
+#include "BLI_vector.hh"
+
+#include "opensubdiv_capi_type.h"
+#include "opensubdiv_evaluator_capi.h"
+
+#ifdef WITH_OPENSUBDIV
+#  include "BKE_idtype.h"
+#  include "BKE_lib_id.h"
+#  include "BKE_mesh.h"
+
+#  include "DNA_mesh_types.h"
+#  include "DNA_meshdata_types.h"
+#endif
+
+namespace blender::bke::tests {
+
+/* -------------------------------------------------------------------- */
+/** \name Analytic Evaluator
+ *
+ * Batched queries only differ from single point queries in how they call the evaluator,
+ * which is replaced by an analytic surface here so the test doesn't need OpenSubdiv.
+ * \{ */
+
+static void subdiv_eval_test_point(
+    const int ptex_face, const float u, const float v, float P[3], float dPdu[3], float dPdv[3])
+{
+  if (ptex_face == 0) {
+    copy_v3_fl3(P, u + sinf(v), v * v, u * v);
+    if (dPdu != nullptr) {
+      copy_v3_fl3(dPdu, 1.0f, 0.0f, v);
+      copy_v3_fl3(dPdv, cosf(v), 2.0f * v, u);
+    }
+  }
+  else {
+    /* The derivative along u vanishes at (0, 0), where points are nudged into the face. */
+    copy_v3_fl3(P, u * v, v + (float)ptex_face, u * u);
+    if (dPdu != nullptr) {
+      copy_v3_fl3(dPdu, v, 0.0f, 2.0f * u);
+      copy_v3_fl3(dPdv, u, 1.0f, 0.0f);
+    }
+  }
+}
+
+static void subdiv_eval_test_evaluate_limit(OpenSubdiv_Evaluator *UNUSED(evaluator),
+                                            const int ptex_face_index,
+                                            float face_u,
+                                            float face_v,
+                                            float P[3],
+                                            float dPdu[3],
+                                            float dPdv[3])
+{
+  subdiv_eval_test_point(ptex_face_index, face_u, face_v, P, dPdu, dPdv);
+}
+
+static void subdiv_eval_test_evaluate_patches_limit(OpenSubdiv_Evaluator *UNUSED(evaluator),
+                                                    const OpenSubdiv_PatchCoord *patch_coords,
+                                                    const int num_patch_coords,
+                                                    float *P,
+                                                    float *dPdu,
+                                                    float *dPdv)
+{
+  for (int i = 0; i < num_patch_coords; i++) {
+    subdiv_eval_test_point(patch_coords[i].ptex_face,
+                           patch_coords[i].u,
+                           patch_coords[i].v,
+                           P + i * 3,
+                           dPdu ? dPdu + i * 3 : nullptr,
+                           dPdv ? dPdv + i * 3 : nullptr);
+  }
+}
+
+static void subdiv_eval_test_displacement(SubdivDisplacement *UNUSED(displacement),
+                                          const int ptex_face_index,
+                                          const float u,
+                                          const float v,
+                                          const float dPdu[3],
+                                          const float dPdv[3],
+                                          float r_D[3])
+{
+  cross_v3_v3v3(r_D, dPdu, dPdv);
+  mul_v3_fl(r_D, 0.1f);
+  r_D[0] += (float)ptex_face_index * 0.01f;
+  r_D[1] += u * 0.02f;
+  r_D[2] -= v * 0.03f;
+}
+
+/* Coordinates of both faces, on the boundary, close to it and outside of the [0, 1] range,
+ * repeated to get the given number of coordinates. */
+static Vector<OpenSubdiv_PatchCoord> subdiv_eval_test_patch_coords(const int num_patch_coords)
+{
+  const float values[] = {-0.25f, 0.0f, 1e-6f, 0.3f, 0.5f, 0.999999f, 1.0f, 1.25f};
+  const int values_len = ARRAY_SIZE(values);
+  Vector<OpenSubdiv_PatchCoord> patch_coords;
+  for (int i = 0; i < num_patch_coords; i++) {
+    const int j = i % (values_len * values_len * 2);
+    patch_coords.append({j / (values_len * values_len),
+                         values[j % values_len],
+                         values[(j / values_len) % values_len]});
+  }
+  return patch_coords;
+}
+
+/* Compare all batched queries against the single point queries they replace. */
+static void subdiv_eval_test_batch(Subdiv *subdiv, const Span<OpenSubdiv_PatchCoord> patch_coords)
+{
+  const int num = (int)patch_coords.size();
+  Vector<float3> P(num), dPdu(num), dPdv(num), N(num);
+  float P_expect[3], dPdu_expect[3], dPdv_expect[3], N_expect[3];
+
+  BKE_subdiv_eval_limit_points(subdiv, patch_coords.data(), num, (float(*)[3])P.data());
+  for (int i = 0; i < num; i++) {
+    const OpenSubdiv_PatchCoord &co = patch_coords[i];
+    BKE_subdiv_eval_limit_point(subdiv, co.ptex_face, co.u, co.v, P_expect);
+    EXPECT_EQ_ARRAY((const float *)P[i], P_expect, 3);
+  }
+
+  BKE_subdiv_eval_limit_points_and_derivatives(subdiv,
+                                               patch_coords.data(),
+                                               num,
+                                               (float(*)[3])P.data(),
+                                               (float(*)[3])dPdu.data(),
+                                               (float(*)[3])dPdv.data());
+  for (int i = 0; i < num; i++) {
+    const OpenSubdiv_PatchCoord &co = patch_coords[i];
+    BKE_subdiv_eval_limit_point_and_derivatives(
+        subdiv, co.ptex_face, co.u, co.v, P_expect, dPdu_expect, dPdv_expect);
+    EXPECT_EQ_ARRAY((const float *)P[i], P_expect, 3);
+    EXPECT_EQ_ARRAY((const float *)dPdu[i], dPdu_expect, 3);
+    EXPECT_EQ_ARRAY((const float *)dPdv[i], dPdv_expect, 3);
+  }
+
+  BKE_subdiv_eval_limit_points_and_normals(
+      subdiv, patch_coords.data(), num, (float(*)[3])P.data(), (float(*)[3])N.data());
+  for (int i = 0; i < num; i++) {
+    const OpenSubdiv_PatchCoord &co = patch_coords[i];
+    BKE_subdiv_eval_limit_point_and_normal(subdiv, co.ptex_face, co.u, co.v, P_expect, N_expect);
+    EXPECT_EQ_ARRAY((const float *)P[i], P_expect, 3);
+    EXPECT_EQ_ARRAY((const float *)N[i], N_expect, 3);
+  }
+
+  BKE_subdiv_eval_final_points(subdiv, patch_coords.data(), num, (float(*)[3])P.data());
+  for (int i = 0; i < num; i++) {
+    const OpenSubdiv_PatchCoord &co = patch_coords[i];
+    BKE_subdiv_eval_final_point(subdiv, co.ptex_face, co.u, co.v, P_expect);
+    EXPECT_EQ_ARRAY((const float *)P[i], P_expect, 3);
+  }
+}
+
+TEST(subdiv_eval, BatchMatchesSinglePoints)
+{
+  OpenSubdiv_Evaluator evaluator = {nullptr};
+  evaluator.evaluateLimit = subdiv_eval_test_evaluate_limit;
+  evaluator.evaluatePatchesLimit = subdiv_eval_test_evaluate_patches_limit;
+  SubdivDisplacement displacement = {nullptr};
+  displacement.eval_displacement = subdiv_eval_test_displacement;
+
+  Subdiv subdiv = {{0}};
+  subdiv.evaluator = &evaluator;
+
+  /* Empty, single point, and sizes around and above the size of the parallel chunks. */
+  for (const int num : {0, 1, 128, 255, 256, 257, 1000}) {
+    const Vector<OpenSubdiv_PatchCoord> patch_coords = subdiv_eval_test_patch_coords(num);
+    subdiv.displacement_evaluator = nullptr;
+    subdiv_eval_test_batch(&subdiv, patch_coords);
+    subdiv.displacement_evaluator = &displacement;
+    subdiv_eval_test_batch(&subdiv, patch_coords);
+  }
+}
+
+/** \} */
+
+#ifdef WITH_OPENSUBDIV
+
+/* -------------------------------------------------------------------- */
+/** \name OpenSubdiv Evaluator
+ * \{ */
+
+class SubdivEvalTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BKE_idtype_init();
+    BKE_subdiv_init();
+  }
+  static void TearDownTestCase()
+  {
+    BKE_subdiv_exit();
+  }
+};
+
+/* A grid of quads with a raised center vertex. */
+static Mesh *subdiv_eval_test_mesh_new(const int size)
+{
+  Mesh *mesh = BKE_mesh_new_nomain(
+      (size + 1) * (size + 1), 0, 0, size * size * 4, size * size);
+  for (int y = 0; y <= size; y++) {
+    for (int x = 0; x <= size; x++) {
+      const float z = (x == size / 2 && y == size / 2) ? 1.0f : 0.0f;
+      copy_v3_fl3(mesh->mvert[y * (size + 1) + x].co, (float)x, (float)y, z);
+    }
+  }
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      const int poly = y * size + x;
+      const int v = y * (size + 1) + x;
+      MLoop *ml = &mesh->mloop[poly * 4];
+      ml[0].v = v;
+      ml[1].v = v + 1;
+      ml[2].v = v + size + 2;
+      ml[3].v = v + size + 1;
+      mesh->mpoly[poly].loopstart = poly * 4;
+      mesh->mpoly[poly].totloop = 4;
+    }
+  }
+  BKE_mesh_calc_edges(mesh, false, false);
+  return mesh;
+}
+
+TEST_F(SubdivEvalTest, BatchMatchesSinglePoints)
+{
+  Mesh *mesh = subdiv_eval_test_mesh_new(4);
+  SubdivSettings settings = {false};
+  settings.is_adaptive = true;
+  settings.level = 3;
+  settings.vtx_boundary_interpolation = SUBDIV_VTX_BOUNDARY_EDGE_ONLY;
+  settings.fvar_linear_interpolation = SUBDIV_FVAR_LINEAR_INTERPOLATION_ALL;
+  Subdiv *subdiv = BKE_subdiv_new_from_mesh(&settings, mesh);
+  ASSERT_NE(subdiv, nullptr);
+  ASSERT_TRUE(BKE_subdiv_eval_begin_from_mesh(subdiv, mesh, nullptr));
+
+  /* The evaluator only accepts coordinates in the [0, 1] range, include its boundaries. */
+  const float values[] = {0.0f, 1e-6f, 0.25f, 0.5f, 0.999999f, 1.0f};
+  Vector<OpenSubdiv_PatchCoord> patch_coords;
+  for (int ptex_face = 0; ptex_face < mesh->totpoly; ptex_face++) {
+    for (const float u : values) {
+      for (const float v : values) {
+        patch_coords.append({ptex_face, u, v});
+      }
+    }
+  }
+  subdiv_eval_test_batch(subdiv, patch_coords);
+
+  BKE_subdiv_free(subdiv);
+  BKE_id_free(nullptr, mesh);
+}
+
+/** \} */
+
+#endif /* WITH_OPENSUBDIV */
+
+}  // namespace blender::bke::tests
@@ -23,6 +23,8 @@
 
 #include "BKE_subdiv_mesh.h"
 
+#include <string.h>
+
 #include "atomic_ops.h"
 
 #include "DNA_key_types.h"
@@ -35,12 +37,15 @@
 #include "BKE_customdata.h"
 #include "BKE_key.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
 #include "BKE_subdiv.h"
 #include "BKE_subdiv_eval.h"
 #include "BKE_subdiv_foreach.h"
 
 #include "MEM_guardedalloc.h"
 
+#include "opensubdiv_capi_type.h"
+
 /* -------------------------------------------------------------------- */
 /** \name Subdivision Context
  * \{ */
@@ -76,6 +81,9 @@ typedef struct SubdivMeshContext {
    * when it's not possible is when displacement is used. */
   bool can_evaluate_normals;
   bool have_displacement;
+  /* Only evaluate positions and normals of vertices of an existing subdivided mesh, keeping all
+   * other data of it. */
+  bool positions_only;
 } SubdivMeshContext;
 
 static void subdiv_mesh_ctx_cache_uv_layers(SubdivMeshContext *ctx)
@@ -425,7 +433,21 @@ static void loop_interpolation_end(LoopsForInterpolation *loop_interpolation)
 /** \name TLS
  * \{ */
 
+/* Number of inner vertices which are evaluated at once. */
+#define SUBDIV_MESH_VERTEX_BATCH_SIZE 64
+
+/* Inner vertices which positions and normals are to be evaluated. */
+typedef struct SubdivMeshVertexBatch {
+  Subdiv *subdiv;
+  MVert *subdiv_mvert;
+  OpenSubdiv_PatchCoord patch_coords[SUBDIV_MESH_VERTEX_BATCH_SIZE];
+  int subdiv_vertex_indices[SUBDIV_MESH_VERTEX_BATCH_SIZE];
+  int num_vertices;
+} SubdivMeshVertexBatch;
+
 typedef struct SubdivMeshTLS {
+  SubdivMeshVertexBatch vertex_batch;
+
   bool vertex_interpolation_initialized;
   VerticesForInterpolation vertex_interpolation;
   const MPoly *vertex_interpolation_coarse_poly;
@@ -437,9 +459,12 @@ typedef struct SubdivMeshTLS {
   int loop_interpolation_coarse_corner;
 } SubdivMeshTLS;
 
+static void subdiv_mesh_vertex_batch_flush(SubdivMeshVertexBatch *batch);
+
 static void subdiv_mesh_tls_free(void *tls_v)
 {
   SubdivMeshTLS *tls = tls_v;
+  subdiv_mesh_vertex_batch_flush(&tls->vertex_batch);
   if (tls->vertex_interpolation_initialized) {
     vertex_interpolation_end(&tls->vertex_interpolation);
   }
@@ -454,18 +479,52 @@ static void subdiv_mesh_tls_free(void *tls_v)
 /** \name Evaluation helper functions
  * \{ */
 
-static void eval_final_point_and_vertex_normal(Subdiv *subdiv,
-                                               const int ptex_face_index,
-                                               const float u,
-                                               const float v,
-                                               float r_P[3],
-                                               short r_N[3])
+static void subdiv_mesh_vertex_batch_flush(SubdivMeshVertexBatch *batch)
 {
+  const int num_vertices = batch->num_vertices;
+  if (num_vertices == 0) {
+    return;
+  }
+  Subdiv *subdiv = batch->subdiv;
+  MVert *subdiv_mvert = batch->subdiv_mvert;
+  float P[SUBDIV_MESH_VERTEX_BATCH_SIZE][3];
   if (subdiv->displacement_evaluator == NULL) {
-    BKE_subdiv_eval_limit_point_and_short_normal(subdiv, ptex_face_index, u, v, r_P, r_N);
+    float N[SUBDIV_MESH_VERTEX_BATCH_SIZE][3];
+    BKE_subdiv_eval_limit_points_and_normals(subdiv, batch->patch_coords, num_vertices, P, N);
+    for (int i = 0; i < num_vertices; i++) {
+      MVert *subdiv_vert = &subdiv_mvert[batch->subdiv_vertex_indices[i]];
+      copy_v3_v3(subdiv_vert->co, P[i]);
+      normal_float_to_short_v3(subdiv_vert->no, N[i]);
+    }
   }
   else {
-    BKE_subdiv_eval_final_point(subdiv, ptex_face_index, u, v, r_P);
+    BKE_subdiv_eval_final_points(subdiv, batch->patch_coords, num_vertices, P);
+    for (int i = 0; i < num_vertices; i++) {
+      copy_v3_v3(subdiv_mvert[batch->subdiv_vertex_indices[i]].co, P[i]);
+    }
+  }
+  batch->num_vertices = 0;
+}
+
+/* Queue evaluation of the vertex position and normal, the batch is evaluated once it is full or
+ * when the TLS is freed. */
+static void subdiv_mesh_vertex_batch_add(SubdivMeshContext *ctx,
+                                         SubdivMeshVertexBatch *batch,
+                                         const int ptex_face_index,
+                                         const float u,
+                                         const float v,
+                                         const int subdiv_vertex_index)
+{
+  batch->subdiv = ctx->subdiv;
+  batch->subdiv_mvert = ctx->subdiv_mesh->mvert;
+  OpenSubdiv_PatchCoord *patch_coord = &batch->patch_coords[batch->num_vertices];
+  patch_coord->ptex_face = ptex_face_index;
+  patch_coord->u = u;
+  patch_coord->v = v;
+  batch->subdiv_vertex_indices[batch->num_vertices] = subdiv_vertex_index;
+  batch->num_vertices++;
+  if (batch->num_vertices == SUBDIV_MESH_VERTEX_BATCH_SIZE) {
+    subdiv_mesh_vertex_batch_flush(batch);
   }
 }
 
@@ -522,8 +581,23 @@ static bool subdiv_mesh_topology_info(const SubdivForeachContext *foreach_contex
   mask.lmask &= ~CD_MASK_MULTIRES_GRIDS;
 
   SubdivMeshContext *subdiv_context = foreach_context->user_data;
-  subdiv_context->subdiv_mesh = BKE_mesh_new_nomain_from_template_ex(
-      subdiv_context->coarse_mesh, num_vertices, num_edges, 0, num_loops, num_polygons, mask);
+  if (subdiv_context->positions_only) {
+    Mesh *subdiv_mesh = subdiv_context->subdiv_mesh;
+    if (subdiv_mesh->totvert != num_vertices || subdiv_mesh->totedge != num_edges ||
+        subdiv_mesh->totloop != num_loops || subdiv_mesh->totpoly != num_polygons) {
+      return false;
+    }
+    if (subdiv_context->have_displacement) {
+      /* Displacement is accumulated in the vertex positions. */
+      for (int i = 0; i < num_vertices; i++) {
+        zero_v3(subdiv_mesh->mvert[i].co);
+      }
+    }
+  }
+  else {
+    subdiv_context->subdiv_mesh = BKE_mesh_new_nomain_from_template_ex(
+        subdiv_context->coarse_mesh, num_vertices, num_edges, 0, num_loops, num_polygons, mask);
+  }
   subdiv_mesh_ctx_cache_custom_data_layers(subdiv_context);
   subdiv_mesh_prepare_accumulator(subdiv_context, num_vertices);
   return true;
@@ -539,6 +613,9 @@ static void subdiv_vertex_data_copy(const SubdivMeshContext *ctx,
                                     const MVert *coarse_vertex,
                                     MVert *subdiv_vertex)
 {
+  if (ctx->positions_only) {
+    return;
+  }
   const Mesh *coarse_mesh = ctx->coarse_mesh;
   Mesh *subdiv_mesh = ctx->subdiv_mesh;
   const int coarse_vertex_index = coarse_vertex - coarse_mesh->mvert;
@@ -553,6 +630,9 @@ static void subdiv_vertex_data_interpolate(const SubdivMeshContext *ctx,
                                            const float u,
                                            const float v)
 {
+  if (ctx->positions_only) {
+    return;
+  }
   const int subdiv_vertex_index = subdiv_vertex - ctx->subdiv_mesh->mvert;
   const float weights[4] = {(1.0f - u) * (1.0f - v), u * (1.0f - v), u * v, (1.0f - u) * v};
   CustomData_interp(vertex_interpolation->vertex_data,
@@ -783,7 +863,6 @@ static void subdiv_mesh_vertex_inner(const SubdivForeachContext *foreach_context
 {
   SubdivMeshContext *ctx = foreach_context->user_data;
   SubdivMeshTLS *tls = tls_v;
-  Subdiv *subdiv = ctx->subdiv;
   const Mesh *coarse_mesh = ctx->coarse_mesh;
   const MPoly *coarse_mpoly = coarse_mesh->mpoly;
   const MPoly *coarse_poly = &coarse_mpoly[coarse_poly_index];
@@ -792,8 +871,7 @@ static void subdiv_mesh_vertex_inner(const SubdivForeachContext *foreach_context
   MVert *subdiv_vert = &subdiv_mvert[subdiv_vertex_index];
   subdiv_mesh_ensure_vertex_interpolation(ctx, tls, coarse_poly, coarse_corner);
   subdiv_vertex_data_interpolate(ctx, subdiv_vert, &tls->vertex_interpolation, u, v);
-  eval_final_point_and_vertex_normal(
-      subdiv, ptex_face_index, u, v, subdiv_vert->co, subdiv_vert->no);
+  subdiv_mesh_vertex_batch_add(ctx, &tls->vertex_batch, ptex_face_index, u, v, subdiv_vertex_index);
   subdiv_mesh_tag_center_vertex(coarse_poly, subdiv_vert, u, v);
 }
 
@@ -999,6 +1077,10 @@ static void subdiv_mesh_vertex_loose(const SubdivForeachContext *foreach_context
   MVert *subdiv_mvert = subdiv_mesh->mvert;
   MVert *subdiv_vertex = &subdiv_mvert[subdiv_vertex_index];
   subdiv_vertex_data_copy(ctx, coarse_vertex, subdiv_vertex);
+  if (ctx->positions_only) {
+    copy_v3_v3(subdiv_vertex->co, coarse_vertex->co);
+    copy_v3_v3_short(subdiv_vertex->no, coarse_vertex->no);
+  }
 }
 
 /* Get neighbor edges of the given one.
@@ -1081,6 +1163,9 @@ static void subdiv_mesh_vertex_of_loose_edge_interpolate(SubdivMeshContext *ctx,
                                                          const float u,
                                                          const int subdiv_vertex_index)
 {
+  if (ctx->positions_only) {
+    return;
+  }
   const Mesh *coarse_mesh = ctx->coarse_mesh;
   Mesh *subdiv_mesh = ctx->subdiv_mesh;
   if (u == 0.0f) {
@@ -1239,4 +1324,92 @@ Mesh *BKE_subdiv_to_mesh(Subdiv *subdiv,
   return result;
 }
 
+bool BKE_subdiv_mesh_update_positions(Subdiv *subdiv,
+                                      const SubdivToMeshSettings *settings,
+                                      const Mesh *coarse_mesh,
+                                      Mesh *subdiv_mesh)
+{
+  BKE_subdiv_stats_begin(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH);
+  /* Refine the evaluator for the new positions of coarse vertices, re-using its stencils. */
+  if (!BKE_subdiv_eval_begin_from_mesh(subdiv, coarse_mesh, NULL)) {
+    if (coarse_mesh->totpoly) {
+      BKE_subdiv_stats_end(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH);
+      return false;
+    }
+  }
+  subdiv_mesh->mvert = CustomData_duplicate_referenced_layer(
+      &subdiv_mesh->vdata, CD_MVERT, subdiv_mesh->totvert);
+  SubdivMeshContext subdiv_context = {0};
+  subdiv_context.settings = settings;
+  subdiv_context.coarse_mesh = coarse_mesh;
+  subdiv_context.subdiv = subdiv;
+  subdiv_context.subdiv_mesh = subdiv_mesh;
+  subdiv_context.have_displacement = (subdiv->displacement_evaluator != NULL);
+  subdiv_context.can_evaluate_normals = !subdiv_context.have_displacement &&
+                                        subdiv_context.subdiv->settings.is_adaptive;
+  subdiv_context.positions_only = true;
+  /* Multi-threaded traversal of vertices only. */
+  BKE_subdiv_stats_begin(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH_GEOMETRY);
+  SubdivForeachContext foreach_context;
+  setup_foreach_callbacks(&subdiv_context, &foreach_context);
+  foreach_context.edge = NULL;
+  foreach_context.loop = NULL;
+  foreach_context.poly = NULL;
+  SubdivMeshTLS tls = {0};
+  foreach_context.user_data = &subdiv_context;
+  foreach_context.user_data_tls_size = sizeof(SubdivMeshTLS);
+  foreach_context.user_data_tls = &tls;
+  const bool ok = BKE_subdiv_foreach_subdiv_geometry(
+      subdiv, &foreach_context, settings, coarse_mesh);
+  BKE_subdiv_stats_end(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH_GEOMETRY);
+  BKE_subdiv_stats_end(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH);
+  /* Caches which depend on positions. */
+  BKE_mesh_runtime_clear_geometry(subdiv_mesh);
+  if (!subdiv_context.can_evaluate_normals) {
+    subdiv_mesh->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+  }
+  subdiv_mesh_context_free(&subdiv_context);
+  return ok;
+}
+
+bool BKE_subdiv_mesh_coarse_positions_only_differ(const Mesh *coarse_mesh,
+                                                  const Mesh *coarse_mesh_prev)
+{
+  if (coarse_mesh->totvert != coarse_mesh_prev->totvert ||
+      coarse_mesh->totedge != coarse_mesh_prev->totedge ||
+      coarse_mesh->totloop != coarse_mesh_prev->totloop ||
+      coarse_mesh->totpoly != coarse_mesh_prev->totpoly) {
+    return false;
+  }
+  /* Settings which are copied to the subdivided mesh. */
+  if (coarse_mesh->flag != coarse_mesh_prev->flag ||
+      coarse_mesh->cd_flag != coarse_mesh_prev->cd_flag ||
+      coarse_mesh->smoothresh != coarse_mesh_prev->smoothresh ||
+      coarse_mesh->totcol != coarse_mesh_prev->totcol) {
+    return false;
+  }
+  if (coarse_mesh->totcol &&
+      memcmp(coarse_mesh->mat, coarse_mesh_prev->mat, sizeof(void *) * coarse_mesh->totcol)) {
+    return false;
+  }
+  /* Vertex coordinates and normals are allowed to change, other vertex data is not. */
+  const MVert *mvert = coarse_mesh->mvert;
+  const MVert *mvert_prev = coarse_mesh_prev->mvert;
+  for (int i = 0; i < coarse_mesh->totvert; i++) {
+    if (mvert[i].flag != mvert_prev[i].flag || mvert[i].bweight != mvert_prev[i].bweight) {
+      return false;
+    }
+  }
+  return CustomData_layers_data_equal(&coarse_mesh->vdata,
+                                      &coarse_mesh_prev->vdata,
+                                      CD_MASK_ALL & ~CD_MASK_MVERT,
+                                      coarse_mesh->totvert) &&
+         CustomData_layers_data_equal(
+             &coarse_mesh->edata, &coarse_mesh_prev->edata, CD_MASK_ALL, coarse_mesh->totedge) &&
+         CustomData_layers_data_equal(
+             &coarse_mesh->ldata, &coarse_mesh_prev->ldata, CD_MASK_ALL, coarse_mesh->totloop) &&
+         CustomData_layers_data_equal(
+             &coarse_mesh->pdata, &coarse_mesh_prev->pdata, CD_MASK_ALL, coarse_mesh->totpoly);
+}
+
 /** \} */
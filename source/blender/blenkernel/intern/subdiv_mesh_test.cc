@@ -0,0 +1,152 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+/* The subdivided mesh can only be created with OpenSubdiv, the stub has no topology refiner. */
+#ifdef WITH_OPENSUBDIV
+
+#  include "BKE_idtype.h"
+#  include "BKE_lib_id.h"
+#  include "BKE_mesh.h"
+#  include "BKE_subdiv.h"
+#  include "BKE_subdiv_mesh.h"
+
+#  include "DNA_mesh_types.h"
+#  include "DNA_meshdata_types.h"
+
+#  include "BLI_math.h"
+
+namespace blender::bke::tests {
+
+class SubdivMeshTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BKE_idtype_init();
+    BKE_subdiv_init();
+  }
+  static void TearDownTestCase()
+  {
+    BKE_subdiv_exit();
+  }
+};
+
+/* A grid of quads, with a triangle and a pentagon in the last row for irregular ptex faces. */
+static Mesh *subdiv_mesh_test_coarse_new(const int size)
+{
+  const int quads_num = size * size - 2;
+  Mesh *mesh = BKE_mesh_new_nomain(
+      (size + 1) * (size + 1), 0, 0, quads_num * 4 + 3 + 5, size * size);
+  for (int y = 0; y <= size; y++) {
+    for (int x = 0; x <= size; x++) {
+      copy_v3_fl3(mesh->mvert[y * (size + 1) + x].co, (float)x, (float)y, 0.0f);
+    }
+  }
+
+  int poly = 0, loop = 0;
+  auto add_poly = [&](std::initializer_list<int> verts) {
+    mesh->mpoly[poly].loopstart = loop;
+    mesh->mpoly[poly].totloop = (int)verts.size();
+    for (const int v : verts) {
+      mesh->mloop[loop++].v = (uint)v;
+    }
+    poly++;
+  };
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      const int v = y * (size + 1) + x;
+      if (y < size - 1 || x < size - 2) {
+        add_poly({v, v + 1, v + size + 2, v + size + 1});
+      }
+      else if (x == size - 2) {
+        add_poly({v, v + 1, v + size + 1});
+      }
+      else {
+        /* Also covers the rest of the previous quad. */
+        add_poly({v, v + 1, v + size + 2, v + size + 1, v + size});
+      }
+    }
+  }
+  BLI_assert(poly == mesh->totpoly && loop == mesh->totloop);
+  BKE_mesh_calc_edges(mesh, false, false);
+  return mesh;
+}
+
+static void subdiv_mesh_test_update_positions(const bool is_adaptive)
+{
+  Mesh *coarse_mesh = subdiv_mesh_test_coarse_new(4);
+
+  SubdivSettings settings = {false};
+  settings.is_adaptive = is_adaptive;
+  settings.level = 2;
+  settings.vtx_boundary_interpolation = SUBDIV_VTX_BOUNDARY_EDGE_ONLY;
+  settings.fvar_linear_interpolation = SUBDIV_FVAR_LINEAR_INTERPOLATION_ALL;
+  SubdivToMeshSettings mesh_settings = {0};
+  mesh_settings.resolution = 5;
+  mesh_settings.use_optimal_display = false;
+
+  Subdiv *subdiv = BKE_subdiv_new_from_mesh(&settings, coarse_mesh);
+  ASSERT_NE(subdiv, nullptr);
+  Mesh *mesh = BKE_subdiv_to_mesh(subdiv, &mesh_settings, coarse_mesh);
+  ASSERT_NE(mesh, nullptr);
+
+  /* Move coarse vertices, keeping everything else. */
+  Mesh *coarse_mesh_moved = BKE_mesh_copy_for_eval(coarse_mesh, false);
+  for (int i = 0; i < coarse_mesh_moved->totvert; i++) {
+    float *co = coarse_mesh_moved->mvert[i].co;
+    co[2] = sinf(co[0] * 0.7f) * cosf(co[1] * 0.4f);
+  }
+  EXPECT_TRUE(BKE_subdiv_mesh_coarse_positions_only_differ(coarse_mesh_moved, coarse_mesh));
+  ASSERT_TRUE(BKE_subdiv_mesh_update_positions(subdiv, &mesh_settings, coarse_mesh_moved, mesh));
+
+  Subdiv *subdiv_expect = BKE_subdiv_new_from_mesh(&settings, coarse_mesh_moved);
+  ASSERT_NE(subdiv_expect, nullptr);
+  Mesh *mesh_expect = BKE_subdiv_to_mesh(subdiv_expect, &mesh_settings, coarse_mesh_moved);
+  ASSERT_NE(mesh_expect, nullptr);
+
+  BKE_mesh_ensure_normals(mesh);
+  BKE_mesh_ensure_normals(mesh_expect);
+  ASSERT_EQ(mesh->totvert, mesh_expect->totvert);
+  for (int i = 0; i < mesh->totvert; i++) {
+    EXPECT_V3_NEAR(mesh->mvert[i].co, mesh_expect->mvert[i].co, 1e-6f);
+    for (int j = 0; j < 3; j++) {
+      EXPECT_NEAR(mesh->mvert[i].no[j], mesh_expect->mvert[i].no[j], 1);
+    }
+  }
+
+  BKE_id_free(nullptr, mesh);
+  BKE_id_free(nullptr, mesh_expect);
+  BKE_id_free(nullptr, coarse_mesh);
+  BKE_id_free(nullptr, coarse_mesh_moved);
+  BKE_subdiv_free(subdiv);
+  BKE_subdiv_free(subdiv_expect);
+}
+
+TEST_F(SubdivMeshTest, UpdatePositionsMatchesFullSubdivision)
+{
+  subdiv_mesh_test_update_positions(false);
+}
+
+TEST_F(SubdivMeshTest, UpdatePositionsMatchesFullSubdivisionAdaptive)
+{
+  subdiv_mesh_test_update_positions(true);
+}
+
+}  // namespace blender::bke::tests
+
+#endif /* WITH_OPENSUBDIV */
@@ -0,0 +1,107 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * A lock-free variant of #DisjointSet that can be joined from multiple threads at the same time.
+ *
+ * Sets are always linked under the root with the lowest index, so the root of a set is its
+ * smallest element, independent of the order in which elements were joined. Paths are shortened
+ * with path halving using compare-and-swap, which is safe because parents only ever decrease.
+ */
+
+#include <atomic>
+
+#include "BLI_array.hh"
+
+namespace blender {
+
+class AtomicDisjointSet {
+ private:
+  Array<std::atomic<int>> parents_;
+
+ public:
+  /**
+   * Create a new disjoint set with the given size. Initially, every element is in a separate set.
+   */
+  AtomicDisjointSet(const int size) : parents_(size)
+  {
+    BLI_assert(size >= 0);
+    for (int i = 0; i < size; i++) {
+      parents_[i].store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Join the sets containing elements x and y. Nothing happens when they have been in the same set
+   * before. Can be called from multiple threads.
+   */
+  void join(int x, int y)
+  {
+    while (true) {
+      x = this->find_root(x);
+      y = this->find_root(y);
+
+      /* x and y are in the same set already. */
+      if (x == y) {
+        return;
+      }
+
+      /* Link the root with the higher index under the other one. */
+      if (x < y) {
+        std::swap(x, y);
+      }
+      int expected = x;
+      if (parents_[x].compare_exchange_strong(expected, y, std::memory_order_acq_rel)) {
+        return;
+      }
+      /* Another thread linked x in the meantime, try again from the new roots. */
+    }
+  }
+
+  /**
+   * Return true when x and y are in the same set. Only reliable once all joins are done.
+   */
+  bool in_same_set(const int x, const int y)
+  {
+    return this->find_root(x) == this->find_root(y);
+  }
+
+  /**
+   * Find the element that represents the set containing x currently, which is the smallest
+   * element of that set.
+   */
+  int find_root(int x)
+  {
+    while (true) {
+      int parent = parents_[x].load(std::memory_order_acquire);
+      if (parent == x) {
+        return x;
+      }
+      const int grandparent = parents_[parent].load(std::memory_order_acquire);
+      if (grandparent != parent) {
+        /* Path halving, failing is fine since another thread shortened the path already. */
+        parents_[x].compare_exchange_weak(parent, grandparent, std::memory_order_acq_rel);
+      }
+      x = grandparent;
+    }
+  }
+};
+
+}  // namespace blender
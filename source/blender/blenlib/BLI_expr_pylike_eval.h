@@ -41,9 +41,18 @@ typedef enum eExprPyLike_EvalStatus {
   EXPR_PYLIKE_FATAL_ERROR,
 } eExprPyLike_EvalStatus;
 
+/** Why an expression is not supported by the parser. */
+typedef enum eExprPyLike_ParseError {
+  EXPR_PYLIKE_PARSE_OK = 0,
+  EXPR_PYLIKE_PARSE_UNSUPPORTED_SYNTAX,
+  EXPR_PYLIKE_PARSE_UNKNOWN_NAME,
+  EXPR_PYLIKE_PARSE_WRONG_ARGUMENTS_NUM,
+} eExprPyLike_ParseError;
+
 void BLI_expr_pylike_free(struct ExprPyLike_Parsed *expr);
 bool BLI_expr_pylike_is_valid(struct ExprPyLike_Parsed *expr);
 bool BLI_expr_pylike_is_constant(struct ExprPyLike_Parsed *expr);
+eExprPyLike_ParseError BLI_expr_pylike_get_error(struct ExprPyLike_Parsed *expr, int *r_offset);
 bool BLI_expr_pylike_is_using_param(struct ExprPyLike_Parsed *expr, int index);
 ExprPyLike_Parsed *BLI_expr_pylike_parse(const char *expression,
                                          const char **param_names,
@@ -88,6 +88,15 @@ typedef struct BVHTreeRayHit {
   float dist;
 } BVHTreeRayHit;
 
+/* BLI_bvhtree_new_ex flag */
+enum {
+  BVH_TREE_DEFAULT = 0,
+  /* Split using a surface area heuristic instead of at the median,
+   * slower to build but faster to query when elements are unevenly distributed. */
+  BVH_TREE_SAH = (1 << 0),
+  /* Let BLI_bvhtree_update_tree rebuild the tree when refitting made it too slow to query. */
+  BVH_TREE_REBUILD_ON_UPDATE = (1 << 1),
+};
 enum {
   /* Use a priority queue to process nodes in the optimal order (for slow callbacks) */
   BVH_OVERLAP_USE_THREADING = (1 << 0),
@@ -142,6 +151,7 @@ typedef bool (*BVHTree_WalkOrderCallback)(const BVHTreeAxisRange *bounds,
                                           char axis,
                                           void *userdata);
 
+BVHTree *BLI_bvhtree_new_ex(int maxsize, float epsilon, char tree_type, char axis, int flag);
 BVHTree *BLI_bvhtree_new(int maxsize, float epsilon, char tree_type, char axis);
 void BLI_bvhtree_free(BVHTree *tree);
 
@@ -153,6 +163,7 @@ void BLI_bvhtree_balance(BVHTree *tree);
 bool BLI_bvhtree_update_node(
     BVHTree *tree, int index, const float co[3], const float co_moving[3], int numpoints);
 void BLI_bvhtree_update_tree(BVHTree *tree);
+void BLI_bvhtree_rebuild_on_update_enable(BVHTree *tree);
 
 int BLI_bvhtree_overlap_thread_num(const BVHTree *tree);
 
@@ -216,6 +227,16 @@ int BLI_bvhtree_ray_cast(BVHTree *tree,
                          BVHTree_RayCastCallback callback,
                          void *userdata);
 
+void BLI_bvhtree_ray_cast_batch(BVHTree *tree,
+                                const float (*co)[3],
+                                const float (*dir)[3],
+                                int rays_num,
+                                float radius,
+                                BVHTreeRayHit *hits,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata,
+                                int flag);
+
 void BLI_bvhtree_ray_cast_all_ex(BVHTree *tree,
                                  const float co[3],
                                  const float dir[3],
@@ -83,6 +83,15 @@ enum {
    * order of allocation when no chunks have been freed.
    */
   BLI_MEMPOOL_ALLOW_ITER = (1 << 0),
+  /** Allow allocating and freeing elements from multiple threads at the same time.
+   *
+   * Each thread allocates from and frees into its own free list, only getting new elements
+   * (a chunk worth at most) from the pool is shared between threads.
+   * \note Other operations (clearing, iterating, creating tables...)
+   * must not run concurrently with allocations.
+   * \note Chunks are never freed before clearing or destroying the pool.
+   */
+  BLI_MEMPOOL_THREADSAFE = (1 << 1),
 };
 
 void BLI_mempool_iternew(BLI_mempool *pool, BLI_mempool_iter *iter) ATTR_NONNULL();
@@ -50,6 +50,10 @@
 
 #include "BLI_strict_flags.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 /* used for iterative_raycast */
 // #define USE_SKIP_LINKS
 
@@ -61,6 +65,17 @@
 
 #define MAX_TREETYPE 32
 
+/* Maximum tree type for which a packed copy of the branches is built, see #BVHPackedNode. */
+#define BVH_PACKED_WIDTH 4
+
+/* Number of bins per axis used to find the best split of #BVH_TREE_SAH trees. */
+#define BVH_SAH_BINS 16
+/* Bin leafs on multiple threads for ranges with more leafs than this. */
+#define BVH_SAH_PARALLEL_BINNING_THRESHOLD (1 << 14)
+
+/* Refitted #BVH_TREE_REBUILD_ON_UPDATE trees are rebuilt when their cost grew by this factor. */
+#define BVH_REBUILD_COST_FACTOR 1.5f
+
 /* Setting zero so we can catch bugs in BLI_task/KDOPBVH.
  * TODO(sergey): Deduplicate the limits with PBVH from BKE.
  */
@@ -88,23 +103,45 @@ typedef struct BVHNode {
   char main_axis; /* Axis used to split this node */
 } BVHNode;
 
+/**
+ * Copy of a branch storing the bounds of all its children next to each other,
+ * so ray-casts and nearest searches can test all children at once.
+ *
+ * Only the X/Y/Z axes are stored, these are the only axes used by these queries.
+ * Node zero is the root, branch nodes are stored in the same order as in #BVHTree.nodearray.
+ */
+typedef struct BVHPackedNode {
+  /** Child bounds: `bv[axis * 2][child]` is the minimum, `bv[axis * 2 + 1][child]` the maximum. */
+  float bv[6][BVH_PACKED_WIDTH];
+  /** Index of the packed child branch, or `-1 - index` of a leaf in #BVHTree.nodearray. */
+  int children[BVH_PACKED_WIDTH];
+  char totnode;
+  char main_axis;
+  char _pad[14];
+} BVHPackedNode;
+
+BLI_STATIC_ASSERT(sizeof(BVHPackedNode) == 128, "packed node should fill two cache lines")
+
 /* keep under 26 bytes for speed purposes */
 struct BVHTree {
   BVHNode **nodes;
   BVHNode *nodearray;  /* pre-alloc branch nodes */
   BVHNode **nodechild; /* pre-alloc children for nodes */
   float *nodebv;       /* pre-alloc bounding-volumes for nodes */
+  BVHPackedNode *packed_nodes; /* optional copy of the branches, built by balancing */
   float epsilon;       /* epslion is used for inflation of the k-dop      */
   int totleaf;         /* leafs */
   int totbranch;
   axis_t start_axis, stop_axis; /* bvhtree_kdop_axes array indices according to axis */
   axis_t axis;                  /* kdop type (6 => OBB, 7 => AABB, ...) */
   char tree_type;               /* type of tree (4 => quadtree) */
+  char flag;                    /* BVH_TREE_* flags passed to #BLI_bvhtree_new_ex */
+  float build_cost; /* #bvhtree_sah_cost after building, used to detect degraded trees */
 };
 
 /* optimization, ensure we stay small */
-BLI_STATIC_ASSERT((sizeof(void *) == 8 && sizeof(BVHTree) <= 48) ||
-                      (sizeof(void *) == 4 && sizeof(BVHTree) <= 32),
+BLI_STATIC_ASSERT((sizeof(void *) == 8 && sizeof(BVHTree) <= 64) ||
+                      (sizeof(void *) == 4 && sizeof(BVHTree) <= 44),
                   "over sized")
 
 /* avoid duplicating vars in BVHOverlapData_Thread */
@@ -439,7 +476,7 @@ static char get_largest_axis(const float *bv)
 /**
  * bottom-up update of bvh node BV
  * join the children on the parent BV */
-static void node_join(BVHTree *tree, BVHNode *node)
+static void node_join(const BVHTree *tree, BVHNode *node)
 {
   int i;
   axis_t axis_iter;
@@ -863,14 +900,477 @@ static void non_recursive_bvh_div_nodes(const BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name SAH Build
+ *
+ * Alternative to #non_recursive_bvh_div_nodes used by #BVH_TREE_SAH trees.
+ *
+ * Leafs are split using a binned surface area heuristic (as done by Cycles),
+ * branches are split until they have #BVHTree.tree_type children, splitting the child with the
+ * most leafs first. The resulting trees are not balanced, they take longer to build but can be
+ * a lot faster to query when leafs are unevenly distributed.
+ *
+ * Branches are first built in a temporary array which can be written from multiple threads,
+ * the branch of a range of leafs `[begin, end)` is stored at an index within `[begin, end - 1)`.
+ * Once all branches are known they are copied in breadth first order to #BVHTree.nodearray,
+ * so children still have a greater index than their parent.
+ * \{ */
+
+typedef struct BVHSAHBounds {
+  float min[3], max[3];
+} BVHSAHBounds;
+
+typedef struct BVHSAHBin {
+  BVHSAHBounds bounds;
+  int count;
+} BVHSAHBin;
+
+typedef struct BVHSAHBins {
+  BVHSAHBin bins[3][BVH_SAH_BINS];
+} BVHSAHBins;
+
+typedef struct BVHSAHBuildData {
+  const BVHTree *tree;
+  BVHNode **leafs_array;
+  /** Temporary branches, children are the index of a branch or `-1 - index` of a leaf. */
+  int *branch_children;
+  char *branch_totnode;
+  char *branch_main_axis;
+  TaskPool *task_pool;
+} BVHSAHBuildData;
+
+BLI_INLINE void sah_bounds_init(BVHSAHBounds *bounds)
+{
+  copy_v3_fl(bounds->min, FLT_MAX);
+  copy_v3_fl(bounds->max, -FLT_MAX);
+}
+
+BLI_INLINE void sah_bounds_add_bv(BVHSAHBounds *bounds, const float *bv)
+{
+  for (int axis = 0; axis < 3; axis++) {
+    bounds->min[axis] = min_ff(bounds->min[axis], bv[axis * 2]);
+    bounds->max[axis] = max_ff(bounds->max[axis], bv[axis * 2 + 1]);
+  }
+}
+
+BLI_INLINE void sah_bounds_add_bounds(BVHSAHBounds *bounds, const BVHSAHBounds *other)
+{
+  for (int axis = 0; axis < 3; axis++) {
+    bounds->min[axis] = min_ff(bounds->min[axis], other->min[axis]);
+    bounds->max[axis] = max_ff(bounds->max[axis], other->max[axis]);
+  }
+}
+
+BLI_INLINE float sah_bounds_half_area(const BVHSAHBounds *bounds)
+{
+  float size[3];
+  sub_v3_v3v3(size, bounds->max, bounds->min);
+  if (size[0] < 0.0f || size[1] < 0.0f || size[2] < 0.0f) {
+    return 0.0f;
+  }
+  return size[0] * size[1] + size[1] * size[2] + size[2] * size[0];
+}
+
+BLI_INLINE float sah_bv_center(const float *bv, const int axis)
+{
+  return (bv[axis * 2] + bv[axis * 2 + 1]) * 0.5f;
+}
+
+typedef struct BVHSAHBinningData {
+  BVHNode **leafs_array;
+  float center_min[3];
+  float bin_scale[3];
+} BVHSAHBinningData;
+
+BLI_INLINE int sah_bin_index(const BVHSAHBinningData *data, const float *bv, const int axis)
+{
+  const int bin = (int)((sah_bv_center(bv, axis) - data->center_min[axis]) *
+                        data->bin_scale[axis]);
+  return CLAMPIS(bin, 0, BVH_SAH_BINS - 1);
+}
+
+static void sah_bins_init(BVHSAHBins *bins)
+{
+  for (int axis = 0; axis < 3; axis++) {
+    for (int i = 0; i < BVH_SAH_BINS; i++) {
+      sah_bounds_init(&bins->bins[axis][i].bounds);
+      bins->bins[axis][i].count = 0;
+    }
+  }
+}
+
+static void sah_binning_cb(void *__restrict userdata,
+                           const int i,
+                           const TaskParallelTLS *__restrict tls)
+{
+  const BVHSAHBinningData *data = userdata;
+  BVHSAHBins *bins = tls->userdata_chunk;
+  const float *bv = data->leafs_array[i]->bv;
+  for (int axis = 0; axis < 3; axis++) {
+    BVHSAHBin *bin = &bins->bins[axis][sah_bin_index(data, bv, axis)];
+    sah_bounds_add_bv(&bin->bounds, bv);
+    bin->count++;
+  }
+}
+
+static void sah_binning_reduce(const void *__restrict UNUSED(userdata),
+                               void *__restrict chunk_join,
+                               void *__restrict chunk)
+{
+  BVHSAHBins *join = chunk_join;
+  const BVHSAHBins *bins = chunk;
+  for (int axis = 0; axis < 3; axis++) {
+    for (int i = 0; i < BVH_SAH_BINS; i++) {
+      sah_bounds_add_bounds(&join->bins[axis][i].bounds, &bins->bins[axis][i].bounds);
+      join->bins[axis][i].count += bins->bins[axis][i].count;
+    }
+  }
+}
+
+/**
+ * Split the leafs `[begin, end)` in two, reordering them in \a leafs_array.
+ *
+ * \return The index of the first leaf of the second half.
+ */
+static int sah_split_leafs(BVHNode **leafs_array, const int begin, const int end, int *r_axis)
+{
+  const int leafs_num = end - begin;
+
+  BVHSAHBinningData data = {.leafs_array = leafs_array};
+  float center_max[3];
+  copy_v3_fl(data.center_min, FLT_MAX);
+  copy_v3_fl(center_max, -FLT_MAX);
+  for (int i = begin; i < end; i++) {
+    for (int axis = 0; axis < 3; axis++) {
+      const float center = sah_bv_center(leafs_array[i]->bv, axis);
+      data.center_min[axis] = min_ff(data.center_min[axis], center);
+      center_max[axis] = max_ff(center_max[axis], center);
+    }
+  }
+  for (int axis = 0; axis < 3; axis++) {
+    const float extent = center_max[axis] - data.center_min[axis];
+    /* Scale slightly down so the largest center still falls in the last bin. */
+    data.bin_scale[axis] = (extent > FLT_EPSILON) ? (BVH_SAH_BINS * 0.999f) / extent : 0.0f;
+  }
+
+  BVHSAHBins bins;
+  sah_bins_init(&bins);
+  {
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = (leafs_num > BVH_SAH_PARALLEL_BINNING_THRESHOLD);
+    settings.userdata_chunk = &bins;
+    settings.userdata_chunk_size = sizeof(bins);
+    settings.func_reduce = sah_binning_reduce;
+    settings.min_iter_per_thread = BVH_SAH_PARALLEL_BINNING_THRESHOLD / 4;
+    BLI_task_parallel_range(begin, end, &data, sah_binning_cb, &settings);
+  }
+
+  /* Evaluate the cost of splitting after every bin, on every axis. */
+  float best_cost = FLT_MAX;
+  int best_axis = -1, best_bin = -1;
+  for (int axis = 0; axis < 3; axis++) {
+    if (data.bin_scale[axis] == 0.0f) {
+      continue;
+    }
+    const BVHSAHBin *axis_bins = bins.bins[axis];
+    float cost_right[BVH_SAH_BINS];
+    BVHSAHBounds bounds;
+    sah_bounds_init(&bounds);
+    int count = 0;
+    for (int i = BVH_SAH_BINS - 1; i > 0; i--) {
+      sah_bounds_add_bounds(&bounds, &axis_bins[i].bounds);
+      count += axis_bins[i].count;
+      cost_right[i] = (count != 0) ? sah_bounds_half_area(&bounds) * (float)count : -1.0f;
+    }
+    sah_bounds_init(&bounds);
+    count = 0;
+    for (int i = 0; i < BVH_SAH_BINS - 1; i++) {
+      sah_bounds_add_bounds(&bounds, &axis_bins[i].bounds);
+      count += axis_bins[i].count;
+      if (count == 0 || cost_right[i + 1] < 0.0f) {
+        continue;
+      }
+      const float cost = sah_bounds_half_area(&bounds) * (float)count + cost_right[i + 1];
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_axis = axis;
+        best_bin = i;
+      }
+    }
+  }
+
+  if (best_axis == -1) {
+    /* All centers are (nearly) at the same location, any split is as good as another. */
+    *r_axis = 0;
+    return begin + leafs_num / 2;
+  }
+
+  int mid = begin;
+  for (int i = begin; i < end; i++) {
+    if (sah_bin_index(&data, leafs_array[i]->bv, best_axis) <= best_bin) {
+      SWAP(BVHNode *, leafs_array[i], leafs_array[mid]);
+      mid++;
+    }
+  }
+  if (UNLIKELY(mid == begin || mid == end)) {
+    /* Only happens with invalid (NAN) coordinates. */
+    *r_axis = 0;
+    return begin + leafs_num / 2;
+  }
+
+  *r_axis = best_axis;
+  return mid;
+}
+
+typedef struct BVHSAHBuildTask {
+  int begin, end;
+  /* Location to store the resulting child. */
+  int *r_child;
+} BVHSAHBuildTask;
+
+static void sah_build_task(TaskPool *__restrict pool, void *taskdata);
+
+/**
+ * Build the branches of the leafs `[begin, end)`.
+ *
+ * \return the index of the temporary branch, or `-1 - index` for a single leaf.
+ */
+static int sah_build_recursive(BVHSAHBuildData *data, const int begin, const int end)
+{
+  const int tree_type = data->tree->tree_type;
+  if (end - begin == 1) {
+    return -1 - begin;
+  }
+
+  /* Split the range with the most leafs until there are enough children. */
+  int ranges[MAX_TREETYPE + 1];
+  int ranges_num = 1;
+  int main_axis = 0;
+  ranges[0] = begin;
+  ranges[1] = end;
+  while (ranges_num < tree_type) {
+    int split = 0;
+    for (int i = 1; i < ranges_num; i++) {
+      if (ranges[i + 1] - ranges[i] > ranges[split + 1] - ranges[split]) {
+        split = i;
+      }
+    }
+    if (ranges[split + 1] - ranges[split] < 2) {
+      break;
+    }
+    int axis;
+    const int mid = sah_split_leafs(data->leafs_array, ranges[split], ranges[split + 1], &axis);
+    if (ranges_num == 1) {
+      main_axis = axis;
+    }
+    memmove(&ranges[split + 2], &ranges[split + 1], sizeof(int) * (size_t)(ranges_num - split));
+    ranges[split + 1] = mid;
+    ranges_num++;
+  }
+
+  /* See the section comment, the first child doesn't use the last index of its range. */
+  const int branch = ranges[1] - 1;
+  int *children = &data->branch_children[branch * tree_type];
+  data->branch_totnode[branch] = (char)ranges_num;
+  data->branch_main_axis[branch] = (char)main_axis;
+
+  for (int i = 0; i < ranges_num; i++) {
+    if (data->task_pool && (ranges[i + 1] - ranges[i] > KDOPBVH_THREAD_LEAF_THRESHOLD)) {
+      BVHSAHBuildTask *task = MEM_mallocN(sizeof(*task), __func__);
+      task->begin = ranges[i];
+      task->end = ranges[i + 1];
+      task->r_child = &children[i];
+      BLI_task_pool_push(data->task_pool, sah_build_task, task, true, NULL);
+    }
+    else {
+      children[i] = sah_build_recursive(data, ranges[i], ranges[i + 1]);
+    }
+  }
+
+  return branch;
+}
+
+static void sah_build_task(TaskPool *__restrict pool, void *taskdata)
+{
+  BVHSAHBuildData *data = BLI_task_pool_user_data(pool);
+  BVHSAHBuildTask *task = taskdata;
+  *task->r_child = sah_build_recursive(data, task->begin, task->end);
+}
+
+/**
+ * Build the branches of a #BVH_TREE_SAH tree, at least 2 leafs are expected.
+ *
+ * \return The number of branches.
+ */
+static int sah_bvh_div_nodes(const BVHTree *tree,
+                             BVHNode *branches_array,
+                             BVHNode **leafs_array,
+                             int num_leafs)
+{
+  const int tree_type = tree->tree_type;
+  BLI_assert(num_leafs > 1);
+
+  BVHSAHBuildData data = {
+      .tree = tree,
+      .leafs_array = leafs_array,
+      .branch_children = MEM_mallocN(sizeof(int) * (size_t)(num_leafs * tree_type), __func__),
+      .branch_totnode = MEM_mallocN(sizeof(char) * (size_t)num_leafs, __func__),
+      .branch_main_axis = MEM_mallocN(sizeof(char) * (size_t)num_leafs, __func__),
+  };
+
+  int root;
+  if (num_leafs > KDOPBVH_THREAD_LEAF_THRESHOLD) {
+    data.task_pool = BLI_task_pool_create(&data, TASK_PRIORITY_HIGH);
+    BVHSAHBuildTask *task = MEM_mallocN(sizeof(*task), __func__);
+    task->begin = 0;
+    task->end = num_leafs;
+    task->r_child = &root;
+    BLI_task_pool_push(data.task_pool, sah_build_task, task, true, NULL);
+    BLI_task_pool_work_and_wait(data.task_pool);
+    BLI_task_pool_free(data.task_pool);
+  }
+  else {
+    root = sah_build_recursive(&data, 0, num_leafs);
+  }
+
+  /* Copy the temporary branches in breadth first order, reusing `branch_order` as a queue. */
+  int *branch_order = MEM_mallocN(sizeof(int) * (size_t)num_leafs, __func__);
+  int branches_num = 1;
+  branch_order[0] = root;
+  branches_array[0].parent = NULL;
+  for (int i = 0; i < branches_num; i++) {
+    const int branch = branch_order[i];
+    const int *children = &data.branch_children[branch * tree_type];
+    BVHNode *node = &branches_array[i];
+    node->totnode = data.branch_totnode[branch];
+    node->main_axis = data.branch_main_axis[branch];
+    for (int k = 0; k < tree_type; k++) {
+      if (k >= node->totnode) {
+        node->children[k] = NULL;
+        continue;
+      }
+      if (children[k] >= 0) {
+        branch_order[branches_num] = children[k];
+        node->children[k] = &branches_array[branches_num];
+        branches_num++;
+      }
+      else {
+        node->children[k] = leafs_array[-1 - children[k]];
+      }
+      node->children[k]->parent = node;
+    }
+  }
+  BLI_assert(branches_num < num_leafs);
+
+  /* Children always come after their parent, refit bottom up. */
+  for (int i = branches_num - 1; i >= 0; i--) {
+    node_join(tree, &branches_array[i]);
+  }
+
+  MEM_freeN(branch_order);
+  MEM_freeN(data.branch_children);
+  MEM_freeN(data.branch_totnode);
+  MEM_freeN(data.branch_main_axis);
+
+  return branches_num;
+}
+
+/**
+ * Cost of a tree (sum of the area of all branches relative to the root),
+ * this is only used to detect trees which got a lot worse when refitting.
+ */
+static float bvhtree_sah_cost(const BVHTree *tree)
+{
+  BVHSAHBounds bounds;
+  sah_bounds_init(&bounds);
+  sah_bounds_add_bv(&bounds, tree->nodes[tree->totleaf]->bv);
+  const float root_area = sah_bounds_half_area(&bounds);
+  if (root_area == 0.0f) {
+    return 0.0f;
+  }
+
+  float cost = 0.0f;
+  for (int i = 0; i < tree->totbranch; i++) {
+    sah_bounds_init(&bounds);
+    sah_bounds_add_bv(&bounds, tree->nodes[tree->totleaf + i]->bv);
+    cost += sah_bounds_half_area(&bounds);
+  }
+  return cost / root_area;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Packed Nodes
+ *
+ * A copy of the branches of trees with up to #BVH_PACKED_WIDTH children, see #BVHPackedNode.
+ * The packed nodes reference the leafs in #BVHTree.nodearray,
+ * so only their bounds need to be updated when the tree is refitted.
+ * \{ */
+
+static bool bvhtree_packed_nodes_supported(const BVHTree *tree)
+{
+  return (tree->tree_type <= BVH_PACKED_WIDTH) && (tree->start_axis == 0) &&
+         (tree->totleaf > 0);
+}
+
+static void bvhtree_packed_nodes_update_bounds(BVHTree *tree)
+{
+  BVHPackedNode *pnode = tree->packed_nodes;
+  for (int i = 0; i < tree->totbranch; i++, pnode++) {
+    const BVHNode *node = tree->nodes[tree->totleaf + i];
+    for (int child = 0; child < BVH_PACKED_WIDTH; child++) {
+      if (child < node->totnode) {
+        const float *bv = node->children[child]->bv;
+        for (int axis = 0; axis < 6; axis++) {
+          pnode->bv[axis][child] = bv[axis];
+        }
+      }
+      else {
+        /* Empty bounds, never hit. */
+        for (int axis = 0; axis < 6; axis += 2) {
+          pnode->bv[axis][child] = FLT_MAX;
+          pnode->bv[axis + 1][child] = -FLT_MAX;
+        }
+      }
+    }
+  }
+}
+
+static void bvhtree_packed_nodes_build(BVHTree *tree)
+{
+  BLI_assert(tree->packed_nodes == NULL);
+
+  tree->packed_nodes = MEM_mallocN_aligned(
+      sizeof(BVHPackedNode) * (size_t)tree->totbranch, 64, "BVHPackedNodes");
+
+  BVHPackedNode *pnode = tree->packed_nodes;
+  for (int i = 0; i < tree->totbranch; i++, pnode++) {
+    const BVHNode *node = tree->nodes[tree->totleaf + i];
+    memset(pnode, 0, sizeof(*pnode));
+    pnode->totnode = node->totnode;
+    pnode->main_axis = node->main_axis;
+    for (int child = 0; child < node->totnode; child++) {
+      const int index = (int)(node->children[child] - tree->nodearray);
+      pnode->children[child] = (index < tree->totleaf) ? (-1 - index) : (index - tree->totleaf);
+    }
+  }
+
+  bvhtree_packed_nodes_update_bounds(tree);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree API
  * \{ */
 
 /**
+ * \param flag: #BVH_TREE_SAH and #BVH_TREE_REBUILD_ON_UPDATE.
  * \note many callers don't check for ``NULL`` return.
  */
-BVHTree *BLI_bvhtree_new(int maxsize, float epsilon, char tree_type, char axis)
+BVHTree *BLI_bvhtree_new_ex(int maxsize, float epsilon, char tree_type, char axis, int flag)
 {
   BVHTree *tree;
   int numnodes, i;
@@ -889,6 +1389,7 @@ BVHTree *BLI_bvhtree_new(int maxsize, float epsilon, char tree_type, char axis)
     tree->epsilon = epsilon;
     tree->tree_type = tree_type;
     tree->axis = axis;
+    tree->flag = (char)flag;
 
     if (axis == 26) {
       tree->start_axis = 0;
@@ -917,8 +1418,20 @@ BVHTree *BLI_bvhtree_new(int maxsize, float epsilon, char tree_type, char axis)
       goto fail;
     }
 
+    /* The SAH build splits along the X/Y/Z axes only. */
+    if (tree->start_axis != 0) {
+      tree->flag &= (char)~BVH_TREE_SAH;
+    }
+
     /* Allocate arrays */
-    numnodes = maxsize + implicit_needed_branches(tree_type, maxsize) + tree_type;
+    numnodes = maxsize + tree_type;
+    if (tree->flag & BVH_TREE_SAH) {
+      /* Branches can have less than #BVHTree.tree_type children. */
+      numnodes += max_ii(1, maxsize - 1);
+    }
+    else {
+      numnodes += implicit_needed_branches(tree_type, maxsize);
+    }
 
     tree->nodes = MEM_callocN(sizeof(BVHNode *) * (size_t)numnodes, "BVHNodes");
     tree->nodebv = MEM_callocN(sizeof(float) * (size_t)(axis * numnodes), "BVHNodeBV");
@@ -942,6 +1455,11 @@ fail:
   return NULL;
 }
 
+BVHTree *BLI_bvhtree_new(int maxsize, float epsilon, char tree_type, char axis)
+{
+  return BLI_bvhtree_new_ex(maxsize, epsilon, tree_type, axis, BVH_TREE_DEFAULT);
+}
+
 void BLI_bvhtree_free(BVHTree *tree)
 {
   if (tree) {
@@ -949,29 +1467,68 @@ void BLI_bvhtree_free(BVHTree *tree)
     MEM_SAFE_FREE(tree->nodearray);
     MEM_SAFE_FREE(tree->nodebv);
     MEM_SAFE_FREE(tree->nodechild);
+    MEM_SAFE_FREE(tree->packed_nodes);
     MEM_freeN(tree);
   }
 }
 
-void BLI_bvhtree_balance(BVHTree *tree)
+/**
+ * Build the branches from the leafs, also used to rebuild refitted trees.
+ */
+static void bvhtree_build(BVHTree *tree)
 {
   BVHNode **leafs_array = tree->nodes;
 
-  /* This function should only be called once
-   * (some big bug goes here if its being called more than once per tree) */
-  BLI_assert(tree->totbranch == 0);
-
-  /* Build the implicit tree */
-  non_recursive_bvh_div_nodes(
-      tree, tree->nodearray + (tree->totleaf - 1), leafs_array, tree->totleaf);
+  if ((tree->flag & BVH_TREE_SAH) && (tree->totleaf > 1)) {
+    tree->totbranch = sah_bvh_div_nodes(
+        tree, tree->nodearray + tree->totleaf, leafs_array, tree->totleaf);
+  }
+  else {
+    /* Build the implicit tree */
+    non_recursive_bvh_div_nodes(
+        tree, tree->nodearray + (tree->totleaf - 1), leafs_array, tree->totleaf);
+    tree->totbranch = implicit_needed_branches(tree->tree_type, tree->totleaf);
+  }
 
   /* current code expects the branches to be linked to the nodes array
    * we perform that linkage here */
-  tree->totbranch = implicit_needed_branches(tree->tree_type, tree->totleaf);
   for (int i = 0; i < tree->totbranch; i++) {
     tree->nodes[tree->totleaf + i] = &tree->nodearray[tree->totleaf + i];
   }
 
+  if (bvhtree_packed_nodes_supported(tree)) {
+    bvhtree_packed_nodes_build(tree);
+  }
+
+  if (tree->flag & BVH_TREE_REBUILD_ON_UPDATE) {
+    tree->build_cost = bvhtree_sah_cost(tree);
+  }
+}
+
+/**
+ * Rebuild a tree which got too slow to query after refitting (in #BLI_bvhtree_update_tree).
+ */
+static void bvhtree_rebuild(BVHTree *tree)
+{
+  for (int i = 0; i < tree->totbranch; i++) {
+    BVHNode *node = tree->nodes[tree->totleaf + i];
+    memset(node->children, 0, sizeof(*node->children) * (size_t)tree->tree_type);
+    node->totnode = 0;
+  }
+  MEM_SAFE_FREE(tree->packed_nodes);
+  tree->totbranch = 0;
+
+  bvhtree_build(tree);
+}
+
+void BLI_bvhtree_balance(BVHTree *tree)
+{
+  /* This function should only be called once
+   * (some big bug goes here if its being called more than once per tree) */
+  BLI_assert(tree->totbranch == 0);
+
+  bvhtree_build(tree);
+
 #ifdef USE_SKIP_LINKS
   build_skip_links(tree, tree->nodes[tree->totleaf], NULL, NULL);
 #endif
@@ -1053,6 +1610,34 @@ void BLI_bvhtree_update_tree(BVHTree *tree)
   for (; index >= root; index--) {
     node_join(tree, *index);
   }
+
+  /* Deforming leafs may have made the tree a lot slower to query,
+   * refitting is cheaper than rebuilding but only as long as the tree remains good enough. */
+  if ((tree->flag & BVH_TREE_REBUILD_ON_UPDATE) && (tree->build_cost > 0.0f) &&
+      (bvhtree_sah_cost(tree) > tree->build_cost * BVH_REBUILD_COST_FACTOR)) {
+    bvhtree_rebuild(tree);
+    return;
+  }
+
+  if (tree->packed_nodes) {
+    bvhtree_packed_nodes_update_bounds(tree);
+  }
+}
+
+/**
+ * Enable #BVH_TREE_REBUILD_ON_UPDATE for a tree built without it,
+ * when it only turns out to be deformed after building.
+ * The current state of the tree is the reference to detect degraded trees,
+ * so this is to be called before refitting it.
+ */
+void BLI_bvhtree_rebuild_on_update_enable(BVHTree *tree)
+{
+  BLI_assert(tree->totbranch > 0);
+  if (tree->flag & BVH_TREE_REBUILD_ON_UPDATE) {
+    return;
+  }
+  tree->flag |= BVH_TREE_REBUILD_ON_UPDATE;
+  tree->build_cost = bvhtree_sah_cost(tree);
 }
 /**
  * Number of times #BLI_bvhtree_insert has been called.
@@ -1528,6 +2113,73 @@ static void dfs_find_nearest_dfs(BVHNearestData *data, BVHNode *node)
   }
 }
 
+/**
+ * Same as #calc_nearest_point_squared for all children of \a pnode at once.
+ */
+static void calc_nearest_point_squared_packed(const float proj[3],
+                                              const BVHPackedNode *pnode,
+                                              float r_dist_sq[BVH_PACKED_WIDTH])
+{
+#ifdef __SSE2__
+  __m128 dist_sq = _mm_setzero_ps();
+  for (int i = 0; i != 3; i++) {
+    const __m128 co = _mm_set1_ps(proj[i]);
+    const __m128 nearest = _mm_min_ps(_mm_max_ps(co, _mm_load_ps(pnode->bv[i * 2])),
+                                      _mm_load_ps(pnode->bv[i * 2 + 1]));
+    const __m128 delta = _mm_sub_ps(co, nearest);
+    dist_sq = _mm_add_ps(dist_sq, _mm_mul_ps(delta, delta));
+  }
+  _mm_storeu_ps(r_dist_sq, dist_sq);
+#else
+  for (int child = 0; child != BVH_PACKED_WIDTH; child++) {
+    float delta[3];
+    for (int i = 0; i != 3; i++) {
+      float val = proj[i];
+      if (pnode->bv[i * 2][child] > val) {
+        val = pnode->bv[i * 2][child];
+      }
+      if (pnode->bv[i * 2 + 1][child] < val) {
+        val = pnode->bv[i * 2 + 1][child];
+      }
+      delta[i] = proj[i] - val;
+    }
+    r_dist_sq[child] = len_squared_v3(delta);
+  }
+#endif
+}
+
+/* Same as #dfs_find_nearest_dfs, using the packed copy of the branches. */
+static void dfs_find_nearest_packed_dfs(BVHNearestData *data, const BVHPackedNode *pnode)
+{
+  const BVHTree *tree = data->tree;
+  float dist_sq[BVH_PACKED_WIDTH];
+  calc_nearest_point_squared_packed(data->proj, pnode, dist_sq);
+
+  /* Better heuristic to pick the closest node to dive on */
+  const bool forward = data->proj[pnode->main_axis] <= pnode->bv[pnode->main_axis * 2 + 1][0];
+
+  for (int iter = 0; iter != pnode->totnode; iter++) {
+    const int i = forward ? iter : pnode->totnode - 1 - iter;
+    if (dist_sq[i] >= data->nearest.dist_sq) {
+      continue;
+    }
+    const int child = pnode->children[i];
+    if (child >= 0) {
+      dfs_find_nearest_packed_dfs(data, &tree->packed_nodes[child]);
+    }
+    else {
+      BVHNode *leaf = &tree->nodearray[-1 - child];
+      if (data->callback) {
+        data->callback(data->userdata, leaf->index, data->co, &data->nearest);
+      }
+      else {
+        data->nearest.index = leaf->index;
+        data->nearest.dist_sq = calc_nearest_point_squared(data->proj, leaf, data->nearest.co);
+      }
+    }
+  }
+}
+
 static void dfs_find_nearest_begin(BVHNearestData *data, BVHNode *node)
 {
   float nearest[3], dist_sq;
@@ -1535,7 +2187,13 @@ static void dfs_find_nearest_begin(BVHNearestData *data, BVHNode *node)
   if (dist_sq >= data->nearest.dist_sq) {
     return;
   }
-  dfs_find_nearest_dfs(data, node);
+  if (data->tree->packed_nodes) {
+    /* The root is always the first packed node. */
+    dfs_find_nearest_packed_dfs(data, data->tree->packed_nodes);
+  }
+  else {
+    dfs_find_nearest_dfs(data, node);
+  }
 }
 
 /* Priority queue method */
@@ -1787,10 +2445,8 @@ static float ray_nearest_hit(const BVHRayCastData *data, const float bv[6])
  * [http://tog.acm.org/resources/RTNews/html/rtnv21n1.html#art9]
  *
  * TODO this doesn't take data->ray.radius into consideration */
-static float fast_ray_nearest_hit(const BVHRayCastData *data, const BVHNode *node)
+static float fast_ray_nearest_hit(const BVHRayCastData *data, const float bv[6])
 {
-  const float *bv = node->bv;
-
   float t1x = (bv[data->index[0]] - data->ray.origin[0]) * data->idot_axis[0];
   float t2x = (bv[data->index[1]] - data->ray.origin[0]) * data->idot_axis[0];
   float t1y = (bv[data->index[2]] - data->ray.origin[1]) * data->idot_axis[1];
@@ -1813,7 +2469,7 @@ static void dfs_raycast(BVHRayCastData *data, BVHNode *node)
   /* ray-bv is really fast.. and simple tests revealed its worth to test it
    * before calling the ray-primitive functions */
   /* XXX: temporary solution for particles until fast_ray_nearest_hit supports ray.radius */
-  float dist = (data->ray.radius == 0.0f) ? fast_ray_nearest_hit(data, node) :
+  float dist = (data->ray.radius == 0.0f) ? fast_ray_nearest_hit(data, node->bv) :
                                             ray_nearest_hit(data, node->bv);
   if (dist >= data->hit.dist) {
     return;
@@ -1854,7 +2510,7 @@ static void dfs_raycast_all(BVHRayCastData *data, BVHNode *node)
   /* ray-bv is really fast.. and simple tests revealed its worth to test it
    * before calling the ray-primitive functions */
   /* XXX: temporary solution for particles until fast_ray_nearest_hit supports ray.radius */
-  float dist = (data->ray.radius == 0.0f) ? fast_ray_nearest_hit(data, node) :
+  float dist = (data->ray.radius == 0.0f) ? fast_ray_nearest_hit(data, node->bv) :
                                             ray_nearest_hit(data, node->bv);
   if (dist >= data->hit.dist) {
     return;
@@ -1882,6 +2538,151 @@ static void dfs_raycast_all(BVHRayCastData *data, BVHNode *node)
   }
 }
 
+/**
+ * Same as #fast_ray_nearest_hit and #ray_nearest_hit (when the ray has a radius)
+ * for all children of \a pnode at once.
+ *
+ * \return A bit-mask of the children hit, their distances are written to \a r_dist.
+ */
+static int packed_ray_nearest_hit(const BVHRayCastData *data,
+                                  const BVHPackedNode *pnode,
+                                  float r_dist[BVH_PACKED_WIDTH])
+{
+#ifdef __SSE2__
+  if (data->ray.radius == 0.0f) {
+    __m128 t_near = _mm_setzero_ps(), t_far = _mm_setzero_ps();
+    for (int i = 0; i != 3; i++) {
+      const __m128 origin = _mm_set1_ps(data->ray.origin[i]);
+      const __m128 idot = _mm_set1_ps(data->idot_axis[i]);
+      const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(pnode->bv[data->index[i * 2]]), origin),
+                                   idot);
+      const __m128 t2 = _mm_mul_ps(
+          _mm_sub_ps(_mm_load_ps(pnode->bv[data->index[i * 2 + 1]]), origin), idot);
+      t_near = (i == 0) ? t1 : _mm_max_ps(t_near, t1);
+      t_far = (i == 0) ? t2 : _mm_min_ps(t_far, t2);
+    }
+    const __m128 hit = _mm_and_ps(
+        _mm_and_ps(_mm_cmple_ps(t_near, t_far), _mm_cmpge_ps(t_far, _mm_setzero_ps())),
+        _mm_cmple_ps(t_near, _mm_set1_ps(data->hit.dist)));
+    _mm_storeu_ps(r_dist, t_near);
+    return _mm_movemask_ps(hit);
+  }
+
+  const __m128 radius = _mm_set1_ps(data->ray.radius);
+  __m128 low = _mm_setzero_ps(), upper = _mm_set1_ps(data->hit.dist);
+  __m128 hit = _mm_castsi128_ps(_mm_set1_epi32(-1));
+  for (int i = 0; i != 3; i++) {
+    const __m128 origin = _mm_set1_ps(data->ray.origin[i]);
+    const __m128 bv_min = _mm_sub_ps(_mm_load_ps(pnode->bv[i * 2]), radius);
+    const __m128 bv_max = _mm_add_ps(_mm_load_ps(pnode->bv[i * 2 + 1]), radius);
+    if (data->ray_dot_axis[i] == 0.0f) {
+      /* axis aligned ray */
+      hit = _mm_and_ps(hit,
+                       _mm_and_ps(_mm_cmpnlt_ps(origin, bv_min), _mm_cmpngt_ps(origin, bv_max)));
+    }
+    else {
+      const __m128 dot = _mm_set1_ps(data->ray_dot_axis[i]);
+      const __m128 ll = _mm_div_ps(_mm_sub_ps(bv_min, origin), dot);
+      const __m128 lu = _mm_div_ps(_mm_sub_ps(bv_max, origin), dot);
+      if (data->ray_dot_axis[i] > 0.0f) {
+        low = _mm_max_ps(ll, low);
+        upper = _mm_min_ps(lu, upper);
+      }
+      else {
+        low = _mm_max_ps(lu, low);
+        upper = _mm_min_ps(ll, upper);
+      }
+    }
+  }
+  hit = _mm_and_ps(hit, _mm_cmpngt_ps(low, upper));
+  _mm_storeu_ps(r_dist, low);
+  return _mm_movemask_ps(hit);
+#else
+  int hit = 0;
+  for (int child = 0; child != pnode->totnode; child++) {
+    float bv[6];
+    for (int axis = 0; axis != 6; axis++) {
+      bv[axis] = pnode->bv[axis][child];
+    }
+    r_dist[child] = (data->ray.radius == 0.0f) ? fast_ray_nearest_hit(data, bv) :
+                                                 ray_nearest_hit(data, bv);
+    if (r_dist[child] != FLT_MAX) {
+      hit |= 1 << child;
+    }
+  }
+  return hit;
+#endif
+}
+
+/**
+ * Same as #dfs_raycast and #dfs_raycast_all (when \a use_all is set),
+ * using the packed copy of the branches.
+ */
+static void dfs_raycast_packed(BVHRayCastData *data,
+                               const BVHPackedNode *pnode,
+                               const bool use_all)
+{
+  const BVHTree *tree = data->tree;
+  float dist[BVH_PACKED_WIDTH];
+  const int hit = packed_ray_nearest_hit(data, pnode, dist);
+  if (hit == 0) {
+    return;
+  }
+
+  /* pick loop direction to dive into the tree (based on ray direction and split axis) */
+  const bool forward = data->ray_dot_axis[pnode->main_axis] > 0.0f;
+
+  for (int iter = 0; iter != pnode->totnode; iter++) {
+    const int i = forward ? iter : pnode->totnode - 1 - iter;
+    /* The distance has to be checked again, children visited before may have shortened it. */
+    if (!(hit & (1 << i)) || dist[i] >= data->hit.dist) {
+      continue;
+    }
+    const int child = pnode->children[i];
+    if (child >= 0) {
+      dfs_raycast_packed(data, &tree->packed_nodes[child], use_all);
+      continue;
+    }
+
+    const BVHNode *leaf = &tree->nodearray[-1 - child];
+    if (use_all) {
+      const float hit_dist = data->hit.dist;
+      data->callback(data->userdata, leaf->index, &data->ray, &data->hit);
+      data->hit.index = -1;
+      data->hit.dist = hit_dist;
+    }
+    else if (data->callback) {
+      data->callback(data->userdata, leaf->index, &data->ray, &data->hit);
+    }
+    else {
+      data->hit.index = leaf->index;
+      data->hit.dist = dist[i];
+      madd_v3_v3v3fl(data->hit.co, data->ray.origin, data->ray.direction, dist[i]);
+    }
+  }
+}
+
+static void dfs_raycast_begin(BVHRayCastData *data, BVHNode *root, const bool use_all)
+{
+  if (data->tree->packed_nodes == NULL) {
+    if (use_all) {
+      dfs_raycast_all(data, root);
+    }
+    else {
+      dfs_raycast(data, root);
+    }
+    return;
+  }
+
+  const float dist = (data->ray.radius == 0.0f) ? fast_ray_nearest_hit(data, root->bv) :
+                                                  ray_nearest_hit(data, root->bv);
+  if (dist >= data->hit.dist) {
+    return;
+  }
+  /* The root is always the first packed node. */
+  dfs_raycast_packed(data, data->tree->packed_nodes, use_all);
+}
+
 static void bvhtree_ray_cast_data_precalc(BVHRayCastData *data, int flag)
 {
   int i;
@@ -1951,7 +2752,7 @@ int BLI_bvhtree_ray_cast_ex(BVHTree *tree,
   }
 
   if (root) {
-    dfs_raycast(&data, root);
+    dfs_raycast_begin(&data, root, false);
     //      iterative_raycast(&data, root);
   }
 
@@ -1974,6 +2775,67 @@ int BLI_bvhtree_ray_cast(BVHTree *tree,
       tree, co, dir, radius, hit, callback, userdata, BVH_RAYCAST_DEFAULT);
 }
 
+typedef struct BVHRayCastBatchData {
+  BVHTree *tree;
+  const float (*co)[3];
+  const float (*dir)[3];
+  float radius;
+  BVHTreeRayHit *hits;
+  BVHTree_RayCastCallback callback;
+  void *userdata;
+  int flag;
+} BVHRayCastBatchData;
+
+static void bvhtree_ray_cast_batch_cb(void *__restrict userdata,
+                                      const int i,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const BVHRayCastBatchData *data = userdata;
+  BLI_bvhtree_ray_cast_ex(data->tree,
+                          data->co[i],
+                          data->dir[i],
+                          data->radius,
+                          &data->hits[i],
+                          data->callback,
+                          data->userdata,
+                          data->flag);
+}
+
+/**
+ * Cast \a rays_num rays, each result is the same as #BLI_bvhtree_ray_cast_ex would give.
+ *
+ * \param hits: Initialized by the caller like the \a hit argument of #BLI_bvhtree_ray_cast_ex
+ * (the index and the maximum distance of each ray).
+ * \note Rays are cast in parallel, the \a callback must be thread-safe.
+ */
+void BLI_bvhtree_ray_cast_batch(BVHTree *tree,
+                                const float (*co)[3],
+                                const float (*dir)[3],
+                                int rays_num,
+                                float radius,
+                                BVHTreeRayHit *hits,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata,
+                                int flag)
+{
+  BVHRayCastBatchData data = {
+      .tree = tree,
+      .co = co,
+      .dir = dir,
+      .radius = radius,
+      .hits = hits,
+      .callback = callback,
+      .userdata = userdata,
+      .flag = flag,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (rays_num > KDOPBVH_THREAD_LEAF_THRESHOLD);
+  settings.min_iter_per_thread = 256;
+  BLI_task_parallel_range(0, rays_num, &data, bvhtree_ray_cast_batch_cb, &settings);
+}
+
 float BLI_bvhtree_bb_raycast(const float bv[6],
                              const float light_start[3],
                              const float light_end[3],
@@ -2040,7 +2902,7 @@ void BLI_bvhtree_ray_cast_all_ex(BVHTree *tree,
   data.hit.dist = hit_dist;
 
   if (root) {
-    dfs_raycast_all(&data, root);
+    dfs_raycast_begin(&data, root, true);
   }
 }
 
@@ -27,6 +27,8 @@
  * - Freeing chunks.
  * - Iterating over allocated chunks
  *   (optionally when using the #BLI_MEMPOOL_ALLOW_ITER flag).
+ * - Allocating and freeing from multiple threads
+ *   (optionally when using the #BLI_MEMPOOL_THREADSAFE flag).
  */
 
 #include <stdlib.h>
@@ -86,6 +88,20 @@
 static bool mempool_debug_memset = false;
 #endif
 
+/**
+ * Number of free lists of #BLI_MEMPOOL_THREADSAFE pools. Threads are assigned to them by index,
+ * so a free list is only shared (and its lock contended) when more threads use the pool.
+ */
+#define MEMPOOL_THREAD_CACHE_NUM 32
+#define MEMPOOL_CACHE_LINE_SIZE 64
+
+/* Not using #ThreadLocal from BLI_threads.h, mempool is also used without the threading API. */
+#ifdef _MSC_VER
+#  define MEMPOOL_THREAD_LOCAL __declspec(thread)
+#else
+#  define MEMPOOL_THREAD_LOCAL __thread
+#endif
+
 /**
  * A free element from #BLI_mempool_chunk. Data is cast to this type and stored in
  * #BLI_mempool.free as a single linked list, each item #BLI_mempool.esize large.
@@ -106,6 +122,21 @@ typedef struct BLI_mempool_chunk {
   struct BLI_mempool_chunk *next;
 } BLI_mempool_chunk;
 
+/**
+ * Free list used by the threads which are assigned to it, see #BLI_MEMPOOL_THREADSAFE.
+ */
+typedef struct BLI_mempool_thread_cache {
+  /** Spin lock, only contended when multiple threads use the same cache. */
+  uint32_t lock;
+  /** Number of elements allocated minus the number of elements freed using this cache,
+   * negative when elements are freed by another thread than the one that allocated them. */
+  int totused;
+  /** Free elements of this cache, taken from #BLI_mempool.free when empty. */
+  BLI_freenode *free;
+  /** Avoid false sharing between threads. */
+  char _pad[MEMPOOL_CACHE_LINE_SIZE - sizeof(uint32_t) - sizeof(int) - sizeof(void *)];
+} BLI_mempool_thread_cache;
+
 /**
  * The mempool, stores and tracks memory \a chunks and elements within those chunks \a free.
  */
@@ -131,6 +162,11 @@ struct BLI_mempool {
   uint maxchunks;
   /** Number of elements currently in use. */
   uint totused;
+  /** Per-thread free lists (#BLI_MEMPOOL_THREADSAFE only), in that case #BLI_mempool.free only
+   * holds the elements not given to any thread yet and #BLI_mempool.totused is unused. */
+  BLI_mempool_thread_cache *thread_caches;
+  /** Spin lock protecting #BLI_mempool.free and the chunks list (#BLI_MEMPOOL_THREADSAFE only). */
+  uint32_t lock;
 #ifdef USE_TOTALLOC
   /** Number of elements allocated in total. */
   uint totalloc;
@@ -250,6 +286,77 @@ static BLI_freenode *mempool_chunk_add(BLI_mempool *pool,
   return curnode;
 }
 
+static uint mempool_thread_index_last = 0;
+static MEMPOOL_THREAD_LOCAL uint mempool_thread_index = 0;
+
+BLI_INLINE BLI_mempool_thread_cache *mempool_thread_cache_get(BLI_mempool *pool)
+{
+  if (UNLIKELY(mempool_thread_index == 0)) {
+    mempool_thread_index = atomic_add_and_fetch_uint32(&mempool_thread_index_last, 1);
+  }
+  return &pool->thread_caches[mempool_thread_index % MEMPOOL_THREAD_CACHE_NUM];
+}
+
+BLI_INLINE void mempool_spin_lock(uint32_t *lock)
+{
+  while (atomic_cas_uint32(lock, 0, 1) != 0) {
+    /* pass */
+  }
+}
+
+BLI_INLINE void mempool_spin_unlock(uint32_t *lock)
+{
+  atomic_cas_uint32(lock, 1, 0);
+}
+
+/**
+ * Move up to a chunk worth of free elements from the pool into the \a cache,
+ * allocating a new chunk when there are none left.
+ */
+static void mempool_thread_cache_refill(BLI_mempool *pool, BLI_mempool_thread_cache *cache)
+{
+  mempool_spin_lock(&pool->lock);
+
+  if (pool->free == NULL) {
+    BLI_mempool_chunk *mpchunk = mempool_chunk_alloc(pool);
+    mempool_chunk_add(pool, mpchunk, NULL);
+  }
+
+  BLI_freenode *first = pool->free;
+  BLI_freenode *last = first;
+  for (uint i = 1; (i < pool->pchunk) && (last->next != NULL); i++) {
+    last = last->next;
+  }
+  pool->free = last->next;
+
+  mempool_spin_unlock(&pool->lock);
+
+  last->next = cache->free;
+  cache->free = first;
+}
+
+static void mempool_thread_caches_clear(BLI_mempool *pool)
+{
+  for (int i = 0; i < MEMPOOL_THREAD_CACHE_NUM; i++) {
+    pool->thread_caches[i].free = NULL;
+    pool->thread_caches[i].totused = 0;
+  }
+}
+
+/** Number of elements in use, not thread-safe. */
+static uint mempool_totused(const BLI_mempool *pool)
+{
+  if (pool->flag & BLI_MEMPOOL_THREADSAFE) {
+    int totused = 0;
+    for (int i = 0; i < MEMPOOL_THREAD_CACHE_NUM; i++) {
+      totused += pool->thread_caches[i].totused;
+    }
+    BLI_assert(totused >= 0);
+    return (uint)totused;
+  }
+  return pool->totused;
+}
+
 static void mempool_chunk_free(BLI_mempool_chunk *mpchunk)
 {
   MEM_freeN(mpchunk);
@@ -315,6 +422,16 @@ BLI_mempool *BLI_mempool_create(uint esize, uint totelem, uint pchunk, uint flag
   pool->totalloc = 0;
 #endif
   pool->totused = 0;
+  pool->lock = 0;
+  pool->thread_caches = NULL;
+
+  if (flag & BLI_MEMPOOL_THREADSAFE) {
+    pool->thread_caches = MEM_mallocN_aligned(sizeof(BLI_mempool_thread_cache) *
+                                                  MEMPOOL_THREAD_CACHE_NUM,
+                                              MEMPOOL_CACHE_LINE_SIZE,
+                                              "BLI_Mempool thread caches");
+    memset(pool->thread_caches, 0, sizeof(BLI_mempool_thread_cache) * MEMPOOL_THREAD_CACHE_NUM);
+  }
 
   if (totelem) {
     /* Allocate the actual chunks. */
@@ -331,10 +448,62 @@ BLI_mempool *BLI_mempool_create(uint esize, uint totelem, uint pchunk, uint flag
   return pool;
 }
 
+static void *mempool_alloc_threadsafe(BLI_mempool *pool)
+{
+  BLI_mempool_thread_cache *cache = mempool_thread_cache_get(pool);
+
+  mempool_spin_lock(&cache->lock);
+  if (UNLIKELY(cache->free == NULL)) {
+    mempool_thread_cache_refill(pool, cache);
+  }
+  BLI_freenode *free_pop = cache->free;
+  cache->free = free_pop->next;
+  cache->totused++;
+  mempool_spin_unlock(&cache->lock);
+
+  if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+    free_pop->freeword = USEDWORD;
+  }
+
+#ifdef WITH_MEM_VALGRIND
+  VALGRIND_MEMPOOL_ALLOC(pool, free_pop, pool->esize);
+#endif
+
+  return (void *)free_pop;
+}
+
+static void mempool_free_threadsafe(BLI_mempool *pool, void *addr)
+{
+  BLI_freenode *newhead = addr;
+
+  if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+#ifndef NDEBUG
+    /* This will detect double free's. */
+    BLI_assert(newhead->freeword != FREEWORD);
+#endif
+    newhead->freeword = FREEWORD;
+  }
+
+  BLI_mempool_thread_cache *cache = mempool_thread_cache_get(pool);
+  mempool_spin_lock(&cache->lock);
+  newhead->next = cache->free;
+  cache->free = newhead;
+  cache->totused--;
+  mempool_spin_unlock(&cache->lock);
+
+#ifdef WITH_MEM_VALGRIND
+  VALGRIND_MEMPOOL_FREE(pool, addr);
+#endif
+}
+
 void *BLI_mempool_alloc(BLI_mempool *pool)
 {
   BLI_freenode *free_pop;
 
+  if (pool->flag & BLI_MEMPOOL_THREADSAFE) {
+    return mempool_alloc_threadsafe(pool);
+  }
+
   if (UNLIKELY(pool->free == NULL)) {
     /* Need to allocate a new chunk. */
     BLI_mempool_chunk *mpchunk = mempool_chunk_alloc(pool);
@@ -375,6 +544,11 @@ void BLI_mempool_free(BLI_mempool *pool, void *addr)
 {
   BLI_freenode *newhead = addr;
 
+  if (pool->flag & BLI_MEMPOOL_THREADSAFE) {
+    mempool_free_threadsafe(pool, addr);
+    return;
+  }
+
 #ifndef NDEBUG
   {
     BLI_mempool_chunk *chunk;
@@ -453,14 +627,14 @@ void BLI_mempool_free(BLI_mempool *pool, void *addr)
 
 int BLI_mempool_len(BLI_mempool *pool)
 {
-  return (int)pool->totused;
+  return (int)mempool_totused(pool);
 }
 
 void *BLI_mempool_findelem(BLI_mempool *pool, uint index)
 {
   BLI_assert(pool->flag & BLI_MEMPOOL_ALLOW_ITER);
 
-  if (index < pool->totused) {
+  if (index < mempool_totused(pool)) {
     /* We could have some faster mem chunk stepping code inline. */
     BLI_mempool_iter iter;
     void *elem;
@@ -491,7 +665,7 @@ void BLI_mempool_as_table(BLI_mempool *pool, void **data)
   while ((elem = BLI_mempool_iterstep(&iter))) {
     *p++ = elem;
   }
-  BLI_assert((uint)(p - data) == pool->totused);
+  BLI_assert((uint)(p - data) == mempool_totused(pool));
 }
 
 /**
@@ -499,7 +673,7 @@ void BLI_mempool_as_table(BLI_mempool *pool, void **data)
  */
 void **BLI_mempool_as_tableN(BLI_mempool *pool, const char *allocstr)
 {
-  void **data = MEM_mallocN((size_t)pool->totused * sizeof(void *), allocstr);
+  void **data = MEM_mallocN((size_t)mempool_totused(pool) * sizeof(void *), allocstr);
   BLI_mempool_as_table(pool, data);
   return data;
 }
@@ -518,7 +692,7 @@ void BLI_mempool_as_array(BLI_mempool *pool, void *data)
     memcpy(p, elem, (size_t)esize);
     p = NODE_STEP_NEXT(p);
   }
-  BLI_assert((uint)(p - (char *)data) == pool->totused * esize);
+  BLI_assert((uint)(p - (char *)data) == mempool_totused(pool) * esize);
 }
 
 /**
@@ -526,7 +700,7 @@ void BLI_mempool_as_array(BLI_mempool *pool, void *data)
  */
 void *BLI_mempool_as_arrayN(BLI_mempool *pool, const char *allocstr)
 {
-  char *data = MEM_malloc_arrayN(pool->totused, pool->esize, allocstr);
+  char *data = MEM_malloc_arrayN(mempool_totused(pool), pool->esize, allocstr);
   BLI_mempool_as_array(pool, data);
   return data;
 }
@@ -729,6 +903,9 @@ void BLI_mempool_clear_ex(BLI_mempool *pool, const int totelem_reserve)
   /* re-initialize */
   pool->free = NULL;
   pool->totused = 0;
+  if (pool->flag & BLI_MEMPOOL_THREADSAFE) {
+    mempool_thread_caches_clear(pool);
+  }
 #ifdef USE_TOTALLOC
   pool->totalloc = 0;
 #endif
@@ -758,6 +935,10 @@ void BLI_mempool_destroy(BLI_mempool *pool)
 {
   mempool_chunk_free_all(pool->chunks);
 
+  if (pool->thread_caches != NULL) {
+    MEM_freeN(pool->thread_caches);
+  }
+
 #ifdef WITH_MEM_VALGRIND
   VALGRIND_DESTROY_MEMPOOL(pool);
 #endif
@@ -29,16 +29,20 @@
  *  - Literals:
  *      floating point and decimal integer.
  *  - Constants:
- *      pi, True, False
+ *      pi, tau, e, True, False
  *  - Operators:
- *      +, -, *, /, ==, !=, <, <=, >, >=, and, or, not, ternary if
+ *      +, -, *, /, //, %, **, ==, !=, <, <=, >, >=, and, or, not, ternary if
  *  - Functions:
  *      min, max, radians, degrees,
- *      abs, fabs, floor, ceil, trunc, int,
+ *      abs, fabs, floor, ceil, trunc, round, int, float, bool,
  *      sin, cos, tan, asin, acos, atan, atan2,
- *      exp, log, sqrt, pow, fmod
+ *      sinh, cosh, tanh, asinh, acosh, atanh,
+ *      exp, log, log2, log10, sqrt, pow, fmod, hypot, copysign,
+ *      lerp, clamp, smoothstep
  *
  * The implementation has no global state and can be used multi-threaded.
+ * When an expression is outside of this subset, the reason is stored in the
+ * parse result, so that callers can report why they fall back to Python.
  */
 
 #include <ctype.h>
@@ -115,6 +119,10 @@ struct ExprPyLike_Parsed {
   int ops_count;
   int max_stack;
 
+  /* Why parsing failed and the offset in the expression string. */
+  eExprPyLike_ParseError error;
+  int error_offset;
+
   ExprOp ops[];
 };
 
@@ -144,6 +152,22 @@ bool BLI_expr_pylike_is_constant(ExprPyLike_Parsed *expr)
   return expr != NULL && expr->ops_count == 1 && expr->ops[0].opcode == OPCODE_CONST;
 }
 
+/**
+ * Get the reason why the expression could not be parsed, #EXPR_PYLIKE_PARSE_OK if it is valid.
+ * \param r_offset: Offset of the unsupported part in the expression string.
+ */
+eExprPyLike_ParseError BLI_expr_pylike_get_error(ExprPyLike_Parsed *expr, int *r_offset)
+{
+  if (expr == NULL) {
+    return EXPR_PYLIKE_PARSE_OK;
+  }
+
+  if (r_offset) {
+    *r_offset = expr->error_offset;
+  }
+  return expr->error;
+}
+
 /** Check if the parsed expression uses the parameter with the given index. */
 bool BLI_expr_pylike_is_using_param(ExprPyLike_Parsed *expr, int index)
 {
@@ -315,6 +339,43 @@ static double op_div(double a, double b)
   return a / b;
 }
 
+/* Python floor division, ported from `float_floor_div` of CPython. Dividing first and then
+ * rounding down is off by one when the quotient is rounded up to an integer, e.g. `1 // 0.1`. */
+static double op_floordiv(double a, double b)
+{
+  if (b == 0.0) {
+    /* Report division by zero the same way as true division. */
+    return a / b;
+  }
+
+  double mod = fmod(a, b);
+  /* The remainder is exact, so the difference is an exact multiple of the divisor. */
+  double div = (a - mod) / b;
+  if (mod != 0.0 && ((mod < 0.0) != (b < 0.0))) {
+    div -= 1.0;
+  }
+
+  if (div == 0.0) {
+    return copysign(0.0, a / b);
+  }
+  /* Snap the quotient to the nearest integer. */
+  double floordiv = floor(div);
+  if (div - floordiv > 0.5) {
+    floordiv += 1.0;
+  }
+  return floordiv;
+}
+
+/* Python modulo, the result has the sign of the divisor. */
+static double op_mod(double a, double b)
+{
+  double result = fmod(a, b);
+  if (result != 0.0 && ((result < 0.0) != (b < 0.0))) {
+    result += b;
+  }
+  return result;
+}
+
 static double op_add(double a, double b)
 {
   return a + b;
@@ -340,6 +401,16 @@ static double op_log2(double a, double b)
   return log(a) / log(b);
 }
 
+static double op_float(double arg)
+{
+  return arg;
+}
+
+static double op_bool(double arg)
+{
+  return arg ? 1.0 : 0.0;
+}
+
 static double op_lerp(double a, double b, double x)
 {
   return a * (1.0 - x) + b * x;
@@ -405,7 +476,13 @@ typedef struct BuiltinConstDef {
 } BuiltinConstDef;
 
 static BuiltinConstDef builtin_consts[] = {
-    {"pi", M_PI}, {"True", 1.0}, {"False", 0.0}, {NULL, 0.0}};
+    {"pi", M_PI},
+    {"tau", 2.0 * M_PI},
+    {"e", M_E},
+    {"True", 1.0},
+    {"False", 0.0},
+    {NULL, 0.0},
+};
 
 typedef struct BuiltinOpDef {
   const char *name;
@@ -430,6 +507,8 @@ static BuiltinOpDef builtin_ops[] = {
     {"trunc", OPCODE_FUNC1, trunc},
     {"round", OPCODE_FUNC1, round},
     {"int", OPCODE_FUNC1, trunc},
+    {"float", OPCODE_FUNC1, op_float},
+    {"bool", OPCODE_FUNC1, op_bool},
     {"sin", OPCODE_FUNC1, sin},
     {"cos", OPCODE_FUNC1, cos},
     {"tan", OPCODE_FUNC1, tan},
@@ -437,12 +516,22 @@ static BuiltinOpDef builtin_ops[] = {
     {"acos", OPCODE_FUNC1, acos},
     {"atan", OPCODE_FUNC1, atan},
     {"atan2", OPCODE_FUNC2, atan2},
+    {"sinh", OPCODE_FUNC1, sinh},
+    {"cosh", OPCODE_FUNC1, cosh},
+    {"tanh", OPCODE_FUNC1, tanh},
+    {"asinh", OPCODE_FUNC1, asinh},
+    {"acosh", OPCODE_FUNC1, acosh},
+    {"atanh", OPCODE_FUNC1, atanh},
     {"exp", OPCODE_FUNC1, exp},
     {"log", OPCODE_FUNC1, log},
     {"log", OPCODE_FUNC2, op_log2},
+    {"log2", OPCODE_FUNC1, log2},
+    {"log10", OPCODE_FUNC1, log10},
     {"sqrt", OPCODE_FUNC1, sqrt},
     {"pow", OPCODE_FUNC2, pow},
     {"fmod", OPCODE_FUNC2, fmod},
+    {"hypot", OPCODE_FUNC2, hypot},
+    {"copysign", OPCODE_FUNC2, copysign},
     {"lerp", OPCODE_FUNC3, op_lerp},
     {"clamp", OPCODE_FUNC1, op_clamp},
     {"clamp", OPCODE_FUNC3, op_clamp3},
@@ -470,6 +559,8 @@ static BuiltinOpDef builtin_ops[] = {
 #define TOKEN_NUMBER MAKE_CHAR2('0', '0')
 #define TOKEN_GE MAKE_CHAR2('>', '=')
 #define TOKEN_LE MAKE_CHAR2('<', '=')
+#define TOKEN_POW MAKE_CHAR2('*', '*')
+#define TOKEN_FLOORDIV MAKE_CHAR2('/', '/')
 #define TOKEN_NE MAKE_CHAR2('!', '=')
 #define TOKEN_EQ MAKE_CHAR2('=', '=')
 #define TOKEN_AND MAKE_CHAR2('A', 'N')
@@ -505,9 +596,14 @@ typedef struct ExprParseState {
 
   /* Current token */
   short token;
+  const char *token_start;
   char *tokenbuf;
   double tokenval;
 
+  /* Reason of a parse failure, for error reporting. */
+  eExprPyLike_ParseError error;
+  const char *error_pos;
+
   /* Opcode buffer */
   int ops_count, max_ops, last_jmp;
   ExprOp *ops;
@@ -516,6 +612,18 @@ typedef struct ExprParseState {
   int stack_ptr, max_stack;
 } ExprParseState;
 
+/* Record the reason of a parse failure; the innermost error is kept. Always returns false. */
+static bool parse_error(ExprParseState *state,
+                        const char *position,
+                        const eExprPyLike_ParseError error)
+{
+  if (state->error == EXPR_PYLIKE_PARSE_OK) {
+    state->error = error;
+    state->error_pos = position;
+  }
+  return false;
+}
+
 /* Reserve space for the specified number of operations in the buffer. */
 static ExprOp *parse_alloc_ops(ExprParseState *state, int count)
 {
@@ -658,6 +766,8 @@ static bool parse_next_token(ExprParseState *state)
     state->cur++;
   }
 
+  state->token_start = state->cur;
+
   /* End of string. */
   if (*state->cur == 0) {
     state->token = 0;
@@ -720,6 +830,13 @@ static bool parse_next_token(ExprParseState *state)
     return true;
   }
 
+  /* ** and // tokens */
+  if (ELEM(state->cur[0], '*', '/') && state->cur[1] == state->cur[0]) {
+    state->token = MAKE_CHAR2(state->cur[0], state->cur[1]);
+    state->cur += 2;
+    return true;
+  }
+
   /* Special characters (single character tokens) */
   if (strchr(token_characters, *state->cur)) {
     state->token = *state->cur++;
@@ -757,6 +874,7 @@ static bool parse_next_token(ExprParseState *state)
  * \{ */
 
 static bool parse_expr(ExprParseState *state);
+static bool parse_unary(ExprParseState *state);
 
 static int parse_function_args(ExprParseState *state)
 {
@@ -766,6 +884,10 @@ static int parse_function_args(ExprParseState *state)
 
   int arg_count = 0;
 
+  if (state->token == ')') {
+    return parse_next_token(state) ? 0 : -1;
+  }
+
   for (;;) {
     if (!parse_expr(state)) {
       return -1;
@@ -792,19 +914,12 @@ static int parse_function_args(ExprParseState *state)
   }
 }
 
-static bool parse_unary(ExprParseState *state)
+static bool parse_primary(ExprParseState *state)
 {
+  const char *token_start = state->token_start;
   int i;
 
   switch (state->token) {
-    case '+':
-      return parse_next_token(state) && parse_unary(state);
-
-    case '-':
-      CHECK_ERROR(parse_next_token(state) && parse_unary(state));
-      parse_add_func(state, OPCODE_FUNC1, 1, op_negate);
-      return true;
-
     case '(':
       return parse_next_token(state) && parse_expr(state) && state->token == ')' &&
              parse_next_token(state);
@@ -836,6 +951,10 @@ static bool parse_unary(ExprParseState *state)
         if (STREQ(state->tokenbuf, builtin_ops[i].name)) {
           int args = parse_function_args(state);
 
+          if (args < 0) {
+            return parse_error(state, state->token_start, EXPR_PYLIKE_PARSE_UNSUPPORTED_SYNTAX);
+          }
+
           /* Search for other arg count versions if necessary. */
           if (args != opcode_arg_count(builtin_ops[i].op)) {
             for (int j = i + 1; builtin_ops[j].name; j++) {
@@ -847,6 +966,10 @@ static bool parse_unary(ExprParseState *state)
             }
           }
 
+          if (args != opcode_arg_count(builtin_ops[i].op)) {
+            return parse_error(state, token_start, EXPR_PYLIKE_PARSE_WRONG_ARGUMENTS_NUM);
+          }
+
           return parse_add_func(state, builtin_ops[i].op, args, builtin_ops[i].funcptr);
         }
       }
@@ -854,7 +977,12 @@ static bool parse_unary(ExprParseState *state)
       /* Specially supported functions. */
       if (STREQ(state->tokenbuf, "min")) {
         int cnt = parse_function_args(state);
-        CHECK_ERROR(cnt > 0);
+        if (cnt < 0) {
+          return parse_error(state, state->token_start, EXPR_PYLIKE_PARSE_UNSUPPORTED_SYNTAX);
+        }
+        if (cnt == 0) {
+          return parse_error(state, token_start, EXPR_PYLIKE_PARSE_WRONG_ARGUMENTS_NUM);
+        }
 
         parse_add_op(state, OPCODE_MIN, 1 - cnt)->arg.ival = cnt;
         return true;
@@ -862,19 +990,53 @@ static bool parse_unary(ExprParseState *state)
 
       if (STREQ(state->tokenbuf, "max")) {
         int cnt = parse_function_args(state);
-        CHECK_ERROR(cnt > 0);
+        if (cnt < 0) {
+          return parse_error(state, state->token_start, EXPR_PYLIKE_PARSE_UNSUPPORTED_SYNTAX);
+        }
+        if (cnt == 0) {
+          return parse_error(state, token_start, EXPR_PYLIKE_PARSE_WRONG_ARGUMENTS_NUM);
+        }
 
         parse_add_op(state, OPCODE_MAX, 1 - cnt)->arg.ival = cnt;
         return true;
       }
 
-      return false;
+      return parse_error(state, token_start, EXPR_PYLIKE_PARSE_UNKNOWN_NAME);
 
     default:
       return false;
   }
 }
 
+/* Python power binds tighter than unary operators on its left, but not on its right. */
+static bool parse_power(ExprParseState *state)
+{
+  CHECK_ERROR(parse_primary(state));
+
+  if (state->token == TOKEN_POW) {
+    CHECK_ERROR(parse_next_token(state) && parse_unary(state));
+    parse_add_func(state, OPCODE_FUNC2, 2, pow);
+  }
+
+  return true;
+}
+
+static bool parse_unary(ExprParseState *state)
+{
+  switch (state->token) {
+    case '+':
+      return parse_next_token(state) && parse_unary(state);
+
+    case '-':
+      CHECK_ERROR(parse_next_token(state) && parse_unary(state));
+      parse_add_func(state, OPCODE_FUNC1, 1, op_negate);
+      return true;
+
+    default:
+      return parse_power(state);
+  }
+}
+
 static bool parse_mul(ExprParseState *state)
 {
   CHECK_ERROR(parse_unary(state));
@@ -891,6 +1053,16 @@ static bool parse_mul(ExprParseState *state)
         parse_add_func(state, OPCODE_FUNC2, 2, op_div);
         break;
 
+      case TOKEN_FLOORDIV:
+        CHECK_ERROR(parse_next_token(state) && parse_unary(state));
+        parse_add_func(state, OPCODE_FUNC2, 2, op_floordiv);
+        break;
+
+      case '%':
+        CHECK_ERROR(parse_next_token(state) && parse_unary(state));
+        parse_add_func(state, OPCODE_FUNC2, 2, op_mod);
+        break;
+
       default:
         return true;
     }
@@ -1108,12 +1280,19 @@ ExprPyLike_Parsed *BLI_expr_pylike_parse(const char *expression,
     expr = MEM_mallocN(bytesize, "ExprPyLike_Parsed");
     expr->ops_count = state.ops_count;
     expr->max_stack = state.max_stack;
+    expr->error = EXPR_PYLIKE_PARSE_OK;
+    expr->error_offset = 0;
 
     memcpy(expr->ops, state.ops, state.ops_count * sizeof(ExprOp));
   }
   else {
     /* Always return a non-NULL object so that parse failure can be cached. */
     expr = MEM_callocN(sizeof(ExprPyLike_Parsed), "ExprPyLike_Parsed(empty)");
+
+    /* Anything not caught by a specific check stops parsing at the current token. */
+    parse_error(&state, state.token_start, EXPR_PYLIKE_PARSE_UNSUPPORTED_SYNTAX);
+    expr->error = state.error;
+    expr->error_offset = (int)(state.error_pos - expression);
   }
 
   MEM_freeN(state.tokenbuf);
@@ -0,0 +1,452 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bli
+ *
+ * Points are binned into the cells of a uniform grid, which are stored in a hash table of buckets
+ * built with a counting sort. The cell size is chosen so that all points in a cell are within
+ * range of each other, this way clustering only has to compare points of neighboring cells and
+ * dense clusters don't degrade into quadratic behavior. Clusters are merged with a lock-free
+ * disjoint set, so all steps run multi-threaded.
+ */
+
+#include <cmath>
+#include <cstring>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_array.hh"
+#include "BLI_atomic_disjoint_set.hh"
+#include "BLI_math_base.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+
+#include "BLI_spatial_hash.h"
+
+#include "atomic_ops.h"
+
+namespace blender {
+
+/**
+ * Ratio between the cell size and the range. Must be below `1 / sqrt(3)`, so the diagonal of a
+ * cell is shorter than the range.
+ */
+static constexpr double CELL_SIZE_FAC = 0.57;
+/** Cells up to this far away along each axis can contain points in range. */
+static constexpr int CELL_NEIGHBOR_DIST = 2;
+
+struct SpatialHashCell {
+  int64_t x, y, z;
+
+  bool operator==(const SpatialHashCell &other) const
+  {
+    return x == other.x && y == other.y && z == other.z;
+  }
+};
+
+struct SpatialHashData {
+  const float (*co)[3];
+  const BLI_bitmap *mask;
+  float range_sq;
+  /** Inverse of the cell size, zero when only exact duplicates are searched. */
+  double cell_scale;
+  uint64_t buckets_mask;
+  /** Bit per cell hash, to skip empty neighbor cells without touching the buckets. */
+  BLI_bitmap *cells_used;
+  uint64_t cells_used_mask;
+
+  /** Size of `buckets_len + 1`, the points of bucket `b` are in
+   * `[bucket_offsets[b], bucket_offsets[b + 1])`. */
+  uint32_t *bucket_offsets;
+  /** Point indices and their full cell hash, sorted by bucket. */
+  int *bucket_points;
+  uint64_t *bucket_hashes;
+
+  AtomicDisjointSet *disjoint_set;
+  int *duplicates;
+};
+
+static int64_t spatial_hash_cell_coord(const float value, const double cell_scale)
+{
+  /* Clamp to keep the conversion defined for points far outside of the grid. */
+  const double cell_max = (double)(1LL << 60);
+  const double cell = floor((double)value * cell_scale);
+  return (int64_t)max_dd(min_dd(cell, cell_max), -cell_max);
+}
+
+static int64_t spatial_hash_cell_coord_exact(const float value)
+{
+  /* Adding zero makes negative zero positive, so both end up in the same cell. */
+  const float value_unsigned_zero = value + 0.0f;
+  uint32_t bits;
+  memcpy(&bits, &value_unsigned_zero, sizeof(bits));
+  return (int64_t)bits;
+}
+
+static SpatialHashCell spatial_hash_cell(const SpatialHashData *data, const int index)
+{
+  const float *co = data->co[index];
+  if (data->cell_scale == 0.0) {
+    return {spatial_hash_cell_coord_exact(co[0]),
+            spatial_hash_cell_coord_exact(co[1]),
+            spatial_hash_cell_coord_exact(co[2])};
+  }
+  return {spatial_hash_cell_coord(co[0], data->cell_scale),
+          spatial_hash_cell_coord(co[1], data->cell_scale),
+          spatial_hash_cell_coord(co[2], data->cell_scale)};
+}
+
+/**
+ * Cells are hashed in blocks of 4x4x4, with the position in the block in the lowest bits.
+ * This way neighboring cells mostly end up in nearby buckets and bits of #cells_used,
+ * which avoids most cache misses when looking up the neighbors of a cell.
+ */
+static uint64_t spatial_hash_cell_hash(const SpatialHashCell &cell)
+{
+  uint64_t hash = (uint64_t)(cell.x >> 2) * 0x9E3779B97F4A7C15ull;
+  hash ^= (uint64_t)(cell.y >> 2) * 0xC2B2AE3D27D4EB4Full;
+  hash ^= (uint64_t)(cell.z >> 2) * 0x165667B19E3779F9ull;
+  hash ^= hash >> 32;
+  return (hash << 6) | (uint64_t)((cell.x & 3) | ((cell.y & 3) << 2) | ((cell.z & 3) << 4));
+}
+
+static bool spatial_hash_is_masked(const SpatialHashData *data, const int index)
+{
+  return data->mask == nullptr || BLI_BITMAP_TEST(data->mask, index);
+}
+
+static void spatial_hash_count_cb(void *__restrict userdata,
+                                  const int index,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const SpatialHashData *data = static_cast<const SpatialHashData *>(userdata);
+  if (!spatial_hash_is_masked(data, index)) {
+    return;
+  }
+  const uint64_t hash = spatial_hash_cell_hash(spatial_hash_cell(data, index));
+  atomic_add_and_fetch_uint32(&data->bucket_offsets[hash & data->buckets_mask], 1);
+}
+
+static void spatial_hash_fill_cb(void *__restrict userdata,
+                                 const int index,
+                                 const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const SpatialHashData *data = static_cast<const SpatialHashData *>(userdata);
+  if (!spatial_hash_is_masked(data, index)) {
+    return;
+  }
+  const uint64_t hash = spatial_hash_cell_hash(spatial_hash_cell(data, index));
+  /* Offsets hold the end of each bucket, filling moves them to the start. */
+  const uint64_t bucket = hash & data->buckets_mask;
+  const uint32_t ofs = atomic_sub_and_fetch_uint32(&data->bucket_offsets[bucket], 1);
+  data->bucket_points[ofs] = index;
+  data->bucket_hashes[ofs] = hash;
+
+  const uint64_t cell_bit = hash & data->cells_used_mask;
+  atomic_fetch_and_or_uint32(&data->cells_used[cell_bit >> _BITMAP_POWER],
+                             1u << (cell_bit & _BITMAP_MASK));
+}
+
+/**
+ * Find any point of \a cell in the bucket it hashes to, or -1 when the cell is empty.
+ * Returns the position in #SpatialHashData.bucket_points.
+ */
+static int spatial_hash_cell_find(const SpatialHashData *data, const SpatialHashCell &cell)
+{
+  const uint64_t hash = spatial_hash_cell_hash(cell);
+  if (!BLI_BITMAP_TEST(data->cells_used, hash & data->cells_used_mask)) {
+    return -1;
+  }
+  const uint64_t bucket = hash & data->buckets_mask;
+  const uint32_t end = data->bucket_offsets[bucket + 1];
+  for (uint32_t i = data->bucket_offsets[bucket]; i < end; i++) {
+    if (data->bucket_hashes[i] == hash &&
+        spatial_hash_cell(data, data->bucket_points[i]) == cell) {
+      return (int)i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Join the clusters of two cells when any of their points are in range. The points of each cell
+ * are part of a single cluster already.
+ */
+static void spatial_hash_cells_join(const SpatialHashData *data,
+                                    const SpatialHashCell &cell_a,
+                                    const uint32_t ofs_a,
+                                    const SpatialHashCell &cell_b,
+                                    const uint32_t ofs_b)
+{
+  const uint64_t hash_a = data->bucket_hashes[ofs_a];
+  const uint64_t hash_b = data->bucket_hashes[ofs_b];
+  const uint32_t end_a = data->bucket_offsets[(hash_a & data->buckets_mask) + 1];
+  const uint32_t end_b = data->bucket_offsets[(hash_b & data->buckets_mask) + 1];
+  for (uint32_t i = ofs_a; i < end_a; i++) {
+    const int index_a = data->bucket_points[i];
+    if (data->bucket_hashes[i] != hash_a || !(spatial_hash_cell(data, index_a) == cell_a)) {
+      continue;
+    }
+    for (uint32_t j = ofs_b; j < end_b; j++) {
+      const int index_b = data->bucket_points[j];
+      if (data->bucket_hashes[j] != hash_b || !(spatial_hash_cell(data, index_b) == cell_b)) {
+        continue;
+      }
+      const float *co_a = data->co[index_a];
+      const float *co_b = data->co[index_b];
+      const float len_sq = square_f(co_a[0] - co_b[0]) + square_f(co_a[1] - co_b[1]) +
+                           square_f(co_a[2] - co_b[2]);
+      if (len_sq <= data->range_sq) {
+        data->disjoint_set->join(index_a, index_b);
+        return;
+      }
+    }
+  }
+}
+
+/**
+ * Calculate the squared gaps between the bounds of the points in \a cell and the cells next to
+ * it along each axis, in cell units.
+ */
+static void spatial_hash_cell_gaps_sq(const SpatialHashData *data,
+                                      const SpatialHashCell &cell,
+                                      const uint32_t ofs,
+                                      float r_gaps_sq[3][CELL_NEIGHBOR_DIST * 2 + 1])
+{
+  const uint64_t hash = data->bucket_hashes[ofs];
+  const uint32_t end = data->bucket_offsets[(hash & data->buckets_mask) + 1];
+  const int64_t cell_co[3] = {cell.x, cell.y, cell.z};
+  float min[3] = {1.0f, 1.0f, 1.0f};
+  float max[3] = {0.0f, 0.0f, 0.0f};
+  for (uint32_t i = ofs; i < end; i++) {
+    const int index = data->bucket_points[i];
+    if (data->bucket_hashes[i] != hash || !(spatial_hash_cell(data, index) == cell)) {
+      continue;
+    }
+    for (int axis = 0; axis < 3; axis++) {
+      /* Position inside of the cell, in the [0, 1] range. */
+      const float local = (float)((double)data->co[index][axis] * data->cell_scale -
+                                  (double)cell_co[axis]);
+      min[axis] = min_ff(min[axis], local);
+      max[axis] = max_ff(max[axis], local);
+    }
+  }
+  for (int axis = 0; axis < 3; axis++) {
+    for (int d = -CELL_NEIGHBOR_DIST; d <= CELL_NEIGHBOR_DIST; d++) {
+      float gap = 0.0f;
+      if (d > 0) {
+        gap = max_ff((float)d - max[axis], 0.0f);
+      }
+      else if (d < 0) {
+        gap = max_ff(min[axis] + (float)(-d - 1), 0.0f);
+      }
+      r_gaps_sq[axis][d + CELL_NEIGHBOR_DIST] = square_f(gap);
+    }
+  }
+}
+
+static void spatial_hash_cluster_cb(void *__restrict userdata,
+                                    const int bucket,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const SpatialHashData *data = static_cast<const SpatialHashData *>(userdata);
+  const uint32_t start = data->bucket_offsets[bucket];
+  const uint32_t end = data->bucket_offsets[bucket + 1];
+  for (uint32_t i = start; i < end; i++) {
+    const int index = data->bucket_points[i];
+    const uint64_t hash = data->bucket_hashes[i];
+    const SpatialHashCell cell = spatial_hash_cell(data, index);
+
+    /* All points of a cell are in range of each other, join them with the first one. */
+    bool is_cell_first = true;
+    for (uint32_t j = start; j < i; j++) {
+      if (data->bucket_hashes[j] == hash &&
+          spatial_hash_cell(data, data->bucket_points[j]) == cell) {
+        data->disjoint_set->join(index, data->bucket_points[j]);
+        is_cell_first = false;
+        break;
+      }
+    }
+    if (!is_cell_first || data->cell_scale == 0.0) {
+      continue;
+    }
+
+    /* Squared distance from the points of this cell to the neighboring cells along each axis, in
+     * cell units. Neighbors that are too far from all points of this cell are skipped. */
+    float gaps_sq[3][CELL_NEIGHBOR_DIST * 2 + 1];
+    spatial_hash_cell_gaps_sq(data, cell, i, gaps_sq);
+    const float gap_max_sq = data->range_sq * (float)square_d(data->cell_scale) * 1.0001f;
+
+    /* Compare with the neighboring cells, only half of them as each pair is visited once. */
+    for (int dx = 0; dx <= CELL_NEIGHBOR_DIST; dx++) {
+      const float gap_x_sq = gaps_sq[0][dx + CELL_NEIGHBOR_DIST];
+      for (int dy = (dx == 0) ? 0 : -CELL_NEIGHBOR_DIST; dy <= CELL_NEIGHBOR_DIST; dy++) {
+        const float gap_xy_sq = gap_x_sq + gaps_sq[1][dy + CELL_NEIGHBOR_DIST];
+        if (gap_xy_sq > gap_max_sq) {
+          continue;
+        }
+        for (int dz = (dx == 0 && dy == 0) ? 1 : -CELL_NEIGHBOR_DIST; dz <= CELL_NEIGHBOR_DIST;
+             dz++) {
+          if (gap_xy_sq + gaps_sq[2][dz + CELL_NEIGHBOR_DIST] > gap_max_sq) {
+            continue;
+          }
+          const SpatialHashCell cell_other = {cell.x + dx, cell.y + dy, cell.z + dz};
+          const int ofs_other = spatial_hash_cell_find(data, cell_other);
+          if (ofs_other == -1) {
+            continue;
+          }
+          const int index_other = data->bucket_points[ofs_other];
+          if (data->disjoint_set->in_same_set(index, index_other)) {
+            continue;
+          }
+          spatial_hash_cells_join(data, cell, i, cell_other, (uint32_t)ofs_other);
+        }
+      }
+    }
+  }
+}
+
+struct SpatialHashMergeTLS {
+  int merge_len;
+};
+
+static void spatial_hash_duplicates_cb(void *__restrict userdata,
+                                       const int index,
+                                       const TaskParallelTLS *__restrict tls)
+{
+  const SpatialHashData *data = static_cast<const SpatialHashData *>(userdata);
+  if (!spatial_hash_is_masked(data, index)) {
+    data->duplicates[index] = -1;
+    return;
+  }
+  const int root = data->disjoint_set->find_root(index);
+  if (root == index) {
+    data->duplicates[index] = -1;
+  }
+  else {
+    data->duplicates[index] = root;
+    SpatialHashMergeTLS *merge_tls = static_cast<SpatialHashMergeTLS *>(tls->userdata_chunk);
+    merge_tls->merge_len++;
+  }
+}
+
+static void spatial_hash_duplicates_reduce(const void *__restrict UNUSED(userdata),
+                                           void *__restrict chunk_join,
+                                           void *__restrict chunk)
+{
+  SpatialHashMergeTLS *join = static_cast<SpatialHashMergeTLS *>(chunk_join);
+  const SpatialHashMergeTLS *merge_tls = static_cast<const SpatialHashMergeTLS *>(chunk);
+  join->merge_len += merge_tls->merge_len;
+}
+
+static void spatial_hash_duplicates_targets_cb(void *__restrict userdata,
+                                               const int index,
+                                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const SpatialHashData *data = static_cast<const SpatialHashData *>(userdata);
+  const int root = data->duplicates[index];
+  /* Roots always have a lower index than the other points of their cluster. */
+  if (root != -1 && root < index) {
+    atomic_cas_int32(&data->duplicates[root], -1, root);
+  }
+}
+
+}  // namespace blender
+
+using namespace blender;
+
+/**
+ * Find clusters of points in \a range, using all available threads.
+ *
+ * Unlike #BLI_kdtree_3d_calc_duplicates_fast, clustering is transitive: points are merged when
+ * they are connected by a chain of points that are each in range of the next one.
+ * The result doesn't depend on the order of the points or on threading.
+ *
+ * \param mask: Only points enabled in the mask are considered, may be NULL.
+ * \param range: Coordinates in this range are merged, zero only merges exact duplicates.
+ * \param r_duplicates: An array of \a co_len ints, filled with the index of the point each point
+ * is merged into, or -1 when it isn't merged. Points are merged into the lowest index of their
+ * cluster, which is set to its own index.
+ * \returns The number of points merged into another one.
+ */
+int BLI_spatial_hash_3d_calc_duplicates(const float (*co)[3],
+                                        const int co_len,
+                                        const BLI_bitmap *mask,
+                                        const float range,
+                                        int *r_duplicates)
+{
+  if (co_len == 0) {
+    return 0;
+  }
+
+  SpatialHashData data;
+  data.co = co;
+  data.mask = mask;
+  data.range_sq = square_f(max_ff(range, 0.0f));
+  data.cell_scale = (range > 0.0f) ? 1.0 / ((double)range * CELL_SIZE_FAC) : 0.0;
+
+  int points_len = co_len;
+  if (mask) {
+    points_len = 0;
+    for (int i = 0; i < co_len; i++) {
+      if (BLI_BITMAP_TEST(mask, i)) {
+        points_len++;
+      }
+    }
+  }
+  const uint64_t buckets_len = power_of_2_max_u((uint)max_ii(points_len, 1));
+  data.buckets_mask = buckets_len - 1;
+  /* Around 8 bits per point, so few empty cells pass the test. */
+  const uint64_t cells_used_len = buckets_len * 8;
+  data.cells_used_mask = cells_used_len - 1;
+
+  Array<uint32_t> bucket_offsets(buckets_len + 1, 0);
+  Array<int> bucket_points(points_len, NoInitialization());
+  Array<uint64_t> bucket_hashes(points_len, NoInitialization());
+  data.bucket_offsets = bucket_offsets.data();
+  data.bucket_points = bucket_points.data();
+  data.bucket_hashes = bucket_hashes.data();
+  data.cells_used = BLI_BITMAP_NEW(cells_used_len, __func__);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+
+  /* Counting sort of the points into their buckets. */
+  BLI_task_parallel_range(0, co_len, &data, spatial_hash_count_cb, &settings);
+  for (uint64_t i = 1; i < buckets_len; i++) {
+    bucket_offsets[i] += bucket_offsets[i - 1];
+  }
+  bucket_offsets[buckets_len] = (uint32_t)points_len;
+  BLI_task_parallel_range(0, co_len, &data, spatial_hash_fill_cb, &settings);
+
+  AtomicDisjointSet disjoint_set(co_len);
+  data.disjoint_set = &disjoint_set;
+  BLI_task_parallel_range(0, (int)buckets_len, &data, spatial_hash_cluster_cb, &settings);
+
+  data.duplicates = r_duplicates;
+  SpatialHashMergeTLS merge_tls = {0};
+  TaskParallelSettings settings_merge = settings;
+  settings_merge.userdata_chunk = &merge_tls;
+  settings_merge.userdata_chunk_size = sizeof(merge_tls);
+  settings_merge.func_reduce = spatial_hash_duplicates_reduce;
+  BLI_task_parallel_range(0, co_len, &data, spatial_hash_duplicates_cb, &settings_merge);
+  BLI_task_parallel_range(0, co_len, &data, spatial_hash_duplicates_targets_cb, &settings);
+
+  MEM_freeN(data.cells_used);
+  return merge_tls.merge_len;
+}
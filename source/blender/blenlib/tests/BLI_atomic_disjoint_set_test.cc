@@ -0,0 +1,97 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_atomic_disjoint_set.hh"
+#include "BLI_disjoint_set.hh"
+#include "BLI_rand.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+
+namespace blender::tests {
+
+TEST(atomic_disjoint_set, Test)
+{
+  AtomicDisjointSet disjoint_set(6);
+  EXPECT_FALSE(disjoint_set.in_same_set(1, 2));
+  EXPECT_FALSE(disjoint_set.in_same_set(5, 3));
+  EXPECT_TRUE(disjoint_set.in_same_set(2, 2));
+  EXPECT_EQ(disjoint_set.find_root(3), 3);
+
+  disjoint_set.join(1, 2);
+
+  EXPECT_TRUE(disjoint_set.in_same_set(1, 2));
+  EXPECT_FALSE(disjoint_set.in_same_set(0, 1));
+
+  disjoint_set.join(4, 3);
+
+  EXPECT_FALSE(disjoint_set.in_same_set(2, 3));
+  EXPECT_TRUE(disjoint_set.in_same_set(3, 4));
+
+  disjoint_set.join(4, 1);
+
+  EXPECT_TRUE(disjoint_set.in_same_set(1, 4));
+  EXPECT_TRUE(disjoint_set.in_same_set(1, 3));
+  EXPECT_TRUE(disjoint_set.in_same_set(2, 4));
+  EXPECT_FALSE(disjoint_set.in_same_set(0, 4));
+
+  /* The root is always the lowest element of the set. */
+  EXPECT_EQ(disjoint_set.find_root(4), 1);
+  EXPECT_EQ(disjoint_set.find_root(5), 5);
+}
+
+struct AtomicDisjointSetJoinData {
+  AtomicDisjointSet *disjoint_set;
+  const Array<std::pair<int, int>> *pairs;
+};
+
+static void atomic_disjoint_set_join_func(void *__restrict userdata,
+                                          const int index,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  AtomicDisjointSetJoinData *data = static_cast<AtomicDisjointSetJoinData *>(userdata);
+  const std::pair<int, int> &pair = (*data->pairs)[index];
+  data->disjoint_set->join(pair.first, pair.second);
+}
+
+TEST(atomic_disjoint_set, Threaded)
+{
+  const int size = 100000;
+  const int pairs_len = 80000;
+
+  BLI_threadapi_init();
+
+  RNG *rng = BLI_rng_new(0);
+  Array<std::pair<int, int>> pairs(pairs_len);
+  for (std::pair<int, int> &pair : pairs) {
+    pair.first = (int)(BLI_rng_get_uint(rng) % size);
+    pair.second = (int)(BLI_rng_get_uint(rng) % size);
+  }
+  BLI_rng_free(rng);
+
+  DisjointSet disjoint_set_serial(size);
+  for (const std::pair<int, int> &pair : pairs) {
+    disjoint_set_serial.join(pair.first, pair.second);
+  }
+
+  AtomicDisjointSet disjoint_set(size);
+  AtomicDisjointSetJoinData data = {&disjoint_set, &pairs};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, pairs_len, &data, atomic_disjoint_set_join_func, &settings);
+
+  /* Both must agree on all sets, the lowest element of a set is its root. */
+  Array<int> lowest(size, size);
+  for (int i = 0; i < size; i++) {
+    const int root_serial = (int)disjoint_set_serial.find_root(i);
+    lowest[root_serial] = std::min(lowest[root_serial], i);
+  }
+  for (int i = 0; i < size; i++) {
+    EXPECT_EQ(disjoint_set.find_root(i), lowest[disjoint_set_serial.find_root(i)]);
+  }
+
+  BLI_threadapi_exit();
+}
+
+}  // namespace blender::tests
@@ -111,6 +111,11 @@ TEST_PARSE_FAIL(Truncated7, "1 and")
 TEST_PARSE_FAIL(Truncated8, "1 or")
 TEST_PARSE_FAIL(Truncated9, "sqrt(1")
 TEST_PARSE_FAIL(Truncated10, "fmod(1,")
+TEST_PARSE_FAIL(Truncated11, "1 **")
+TEST_PARSE_FAIL(Truncated12, "1 //")
+TEST_PARSE_FAIL(Truncated13, "1 %")
+TEST_PARSE_FAIL(BadPower, "1 ***2")
+TEST_PARSE_FAIL(Attribute, "math.pi")
 
 /* Constant expression with working constant folding */
 #define TEST_CONST(name, str, value) \
@@ -143,6 +148,8 @@ TEST_CONST(TenE, "1.e+1", 10.0)
 TEST_CONST(Half, ".5", 0.5)
 
 TEST_CONST(Pi, "pi", M_PI)
+TEST_CONST(Tau, "tau", 2.0 * M_PI)
+TEST_CONST(E, "e", M_E)
 TEST_CONST(True, "True", TRUE_VAL)
 TEST_CONST(False, "False", FALSE_VAL)
 
@@ -156,6 +163,19 @@ TEST_CONST(Pow, "pow(4, 0.5)", 2.0)
 TEST_EVAL(Pow, "pow(4, x)", 0.5, 2.0)
 
 TEST_CONST(Log2_1, "log(4, 2)", 2.0)
+TEST_CONST(Log2_2, "log2(8)", 3.0)
+TEST_CONST(Log10, "log10(1000)", 3.0)
+
+TEST_CONST(Hypot, "hypot(3, 4)", 5.0)
+TEST_EVAL(Hypot, "hypot(x, 4)", 3, 5.0)
+
+TEST_CONST(CopySign, "copysign(2, -0.5)", -2.0)
+TEST_CONST(Tanh, "tanh(0)", 0.0)
+TEST_EVAL(Cosh, "cosh(x)", 0, 1.0)
+
+TEST_CONST(Float, "float(2)", 2.0)
+TEST_CONST(Bool1, "bool(2)", TRUE_VAL)
+TEST_CONST(Bool2, "bool(0)", FALSE_VAL)
 
 TEST_CONST(Round1, "round(-0.5)", -1.0)
 TEST_CONST(Round2, "round(-0.4)", 0.0)
@@ -205,6 +225,25 @@ TEST_EVAL(BinaryMul, "x*3", 2, 6.0)
 TEST_CONST(BinaryDiv, "3/2", 1.5)
 TEST_EVAL(BinaryDiv, "3/x", 2, 1.5)
 
+TEST_CONST(FloorDiv1, "7 // 2", 3.0)
+TEST_CONST(FloorDiv2, "-7 // 2", -4.0)
+TEST_CONST(FloorDiv3, "1 // 0.1", 9.0)
+TEST_EVAL(FloorDiv, "x // 0.5", 1.2, 2.0)
+
+/* Modulo follows Python, the result has the sign of the divisor. */
+TEST_CONST(Mod1, "7 % 3", 1.0)
+TEST_CONST(Mod2, "-7 % 3", 2.0)
+TEST_CONST(Mod3, "7 % -3", -2.0)
+TEST_CONST(Mod4, "-6 % 3", 0.0)
+TEST_EVAL(Mod, "x % 1", 2.25, 0.25)
+
+TEST_CONST(Power1, "2 ** 3", 8.0)
+TEST_CONST(Power2, "2 ** 3 ** 2", 512.0)
+TEST_CONST(Power3, "-2 ** 2", -4.0)
+TEST_CONST(Power4, "2 ** -1", 0.5)
+TEST_CONST(Power5, "2 * 3 ** 2", 18.0)
+TEST_EVAL(Power, "x ** 2", 3, 9.0)
+
 TEST_CONST(Arith1, "1 + -2 * 3", -5.0)
 TEST_CONST(Arith2, "(1 + -2) * 3", -3.0)
 TEST_CONST(Arith3, "-1 + 2 * 3", 5.0)
@@ -338,6 +377,10 @@ TEST_ERROR(PowDomain1, "pow(-1, 0.5)", 0.0, EXPR_PYLIKE_MATH_ERROR)
 TEST_ERROR(PowDomain2, "pow(-1, x)", 0.5, EXPR_PYLIKE_MATH_ERROR)
 TEST_ERROR(PowDomain3, "pow(-1, x)", 2.0, EXPR_PYLIKE_SUCCESS)
 
+TEST_ERROR(FloorDivZero, "1 // x", 0.0, EXPR_PYLIKE_DIV_BY_ZERO)
+TEST_ERROR(ModZero, "1 % x", 0.0, EXPR_PYLIKE_MATH_ERROR)
+TEST_ERROR(PowerDomain, "x ** 0.5", -1.0, EXPR_PYLIKE_MATH_ERROR)
+
 TEST_ERROR(Mixed1, "sqrt(x) + 1 / max(0, x)", -1.0, EXPR_PYLIKE_MATH_ERROR)
 TEST_ERROR(Mixed2, "sqrt(x) + 1 / max(0, x)", 0.0, EXPR_PYLIKE_DIV_BY_ZERO)
 TEST_ERROR(Mixed3, "sqrt(x) + 1 / max(0, x)", 1.0, EXPR_PYLIKE_SUCCESS)
@@ -361,3 +404,30 @@ TEST(expr_pylike, Error_ArgumentCount)
 
   BLI_expr_pylike_free(expr);
 }
+
+static void expr_pylike_parse_error_test(const char *str, eExprPyLike_ParseError error, int offset)
+{
+  const char *names[1] = {"x"};
+  ExprPyLike_Parsed *expr = BLI_expr_pylike_parse(str, names, ARRAY_SIZE(names));
+
+  int error_offset = -1;
+  EXPECT_EQ(BLI_expr_pylike_get_error(expr, &error_offset), error);
+  if (error != EXPR_PYLIKE_PARSE_OK) {
+    EXPECT_EQ(error_offset, offset);
+  }
+
+  BLI_expr_pylike_free(expr);
+}
+
+TEST(expr_pylike, ParseError)
+{
+  expr_pylike_parse_error_test("x * 2 if x > 0 else -x", EXPR_PYLIKE_PARSE_OK, 0);
+  expr_pylike_parse_error_test("x * noise.random()", EXPR_PYLIKE_PARSE_UNKNOWN_NAME, 4);
+  expr_pylike_parse_error_test("self.location[0]", EXPR_PYLIKE_PARSE_UNKNOWN_NAME, 0);
+  expr_pylike_parse_error_test("x.real", EXPR_PYLIKE_PARSE_UNSUPPORTED_SYNTAX, 1);
+  expr_pylike_parse_error_test("sqrt(x, 2)", EXPR_PYLIKE_PARSE_WRONG_ARGUMENTS_NUM, 0);
+  expr_pylike_parse_error_test("1 + min()", EXPR_PYLIKE_PARSE_WRONG_ARGUMENTS_NUM, 4);
+  expr_pylike_parse_error_test("sin(x[0])", EXPR_PYLIKE_PARSE_UNSUPPORTED_SYNTAX, 5);
+  expr_pylike_parse_error_test("x + 0x10", EXPR_PYLIKE_PARSE_UNSUPPORTED_SYNTAX, 5);
+  expr_pylike_parse_error_test("", EXPR_PYLIKE_PARSE_UNSUPPORTED_SYNTAX, 0);
+}
@@ -2,12 +2,17 @@
 
 #include "testing/testing.h"
 
+#include <algorithm>
+#include <array>
+#include <vector>
+
 /* TODO: ray intersection, overlap ... etc.*/
 
 #include "MEM_guardedalloc.h"
 
 #include "BLI_compiler_attrs.h"
 #include "BLI_kdopbvh.h"
+#include "BLI_math_geom.h"
 #include "BLI_math_vector.h"
 #include "BLI_rand.h"
 
@@ -66,11 +71,16 @@ static void optimal_check_callback(void *userdata,
  * Note that a small epsilon is added to the BVH nodes bounds, even if we pass in zero.
  * Use rounding to ensure very close nodes don't cause the wrong node to be found as nearest.
  */
-static void find_nearest_points_test(
-    int points_len, float scale, int round, int random_seed, bool optimal = false)
+static void find_nearest_points_test(int points_len,
+                                     float scale,
+                                     int round,
+                                     int random_seed,
+                                     bool optimal = false,
+                                     char tree_type = 8,
+                                     int tree_flag = BVH_TREE_DEFAULT)
 {
   struct RNG *rng = BLI_rng_new(random_seed);
-  BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, 8, 8);
+  BVHTree *tree = BLI_bvhtree_new_ex(points_len, 0.0, tree_type, 8, tree_flag);
 
   void *mem = MEM_mallocN(sizeof(float[3]) * points_len, __func__);
   float(*points)[3] = (float(*)[3])mem;
@@ -132,3 +142,293 @@ TEST(kdopbvh, OptimalFindNearest_500)
 {
   find_nearest_points_test(500, 1.0, 1000, 12, true);
 }
+
+/* Quad-trees use the packed nodes. */
+TEST(kdopbvh, FindNearestQuad_500)
+{
+  find_nearest_points_test(500, 1.0, 1000, 12, false, 4);
+}
+TEST(kdopbvh, FindNearestBinary_500)
+{
+  find_nearest_points_test(500, 1.0, 1000, 12, false, 2);
+}
+
+TEST(kdopbvh, FindNearestSAH_500)
+{
+  find_nearest_points_test(500, 1.0, 1000, 12, false, 4, BVH_TREE_SAH);
+}
+TEST(kdopbvh, FindNearestSAH_5000)
+{
+  find_nearest_points_test(5000, 1.0, 10000, 12, false, 2, BVH_TREE_SAH);
+}
+TEST(kdopbvh, OptimalFindNearestSAH_500)
+{
+  find_nearest_points_test(500, 1.0, 1000, 12, true, 8, BVH_TREE_SAH);
+}
+
+static void raycast_tri_callback(void *userdata,
+                                 int index,
+                                 const BVHTreeRay *ray,
+                                 BVHTreeRayHit *hit)
+{
+  const float(*tris)[3][3] = (const float(*)[3][3])userdata;
+  float dist;
+  if (isect_ray_tri_v3(ray->origin,
+                       ray->direction,
+                       tris[index][0],
+                       tris[index][1],
+                       tris[index][2],
+                       &dist,
+                       nullptr) &&
+      dist < hit->dist) {
+    hit->index = index;
+    hit->dist = dist;
+  }
+}
+
+/**
+ * Compare ray-casts against a brute force search over all triangles,
+ * then check casting all rays at once gives the same results.
+ */
+static void raycast_tris_test(int tris_len,
+                              int rays_len,
+                              char tree_type,
+                              float radius,
+                              int random_seed,
+                              int tree_flag = BVH_TREE_DEFAULT)
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+  BVHTree *tree = BLI_bvhtree_new_ex(tris_len, 0.0, tree_type, 6, tree_flag);
+
+  float(*tris)[3][3] = (float(*)[3][3])MEM_mallocN(sizeof(float[3][3]) * tris_len, __func__);
+  for (int i = 0; i < tris_len; i++) {
+    float center[3];
+    rng_v3_round(center, 3, rng, 1000, 1.0f);
+    for (int j = 0; j < 3; j++) {
+      rng_v3_round(tris[i][j], 3, rng, 1000, 0.1f);
+      add_v3_v3(tris[i][j], center);
+    }
+    BLI_bvhtree_insert(tree, i, tris[i][0], 3);
+  }
+  BLI_bvhtree_balance(tree);
+
+  float(*ray_co)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * rays_len, __func__);
+  float(*ray_dir)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * rays_len, __func__);
+  BVHTreeRayHit *hits = (BVHTreeRayHit *)MEM_mallocN(sizeof(BVHTreeRayHit) * rays_len, __func__);
+
+  for (int i = 0; i < rays_len; i++) {
+    rng_v3_round(ray_co[i], 3, rng, 1000, 1.5f);
+    if (i % 8 == 0) {
+      /* Axis aligned rays. */
+      zero_v3(ray_dir[i]);
+      ray_dir[i][(i / 8) % 3] = (i % 16 == 0) ? 1.0f : -1.0f;
+    }
+    else {
+      BLI_rng_get_float_unit_v3(rng, ray_dir[i]);
+    }
+
+    BVHTreeRayHit hit_expect = {-1};
+    hit_expect.dist = BVH_RAYCAST_DIST_MAX;
+    for (int j = 0; j < tris_len; j++) {
+      BVHTreeRay ray = {{0}};
+      copy_v3_v3(ray.origin, ray_co[i]);
+      copy_v3_v3(ray.direction, ray_dir[i]);
+      raycast_tri_callback(tris, j, &ray, &hit_expect);
+    }
+
+    BVHTreeRayHit hit = {-1};
+    hit.dist = BVH_RAYCAST_DIST_MAX;
+    BLI_bvhtree_ray_cast(tree, ray_co[i], ray_dir[i], radius, &hit, raycast_tri_callback, tris);
+    EXPECT_EQ(hit.index, hit_expect.index);
+    EXPECT_EQ(hit.dist, hit_expect.dist);
+
+    hits[i] = {-1};
+    hits[i].dist = BVH_RAYCAST_DIST_MAX;
+  }
+
+  BLI_bvhtree_ray_cast_batch(tree,
+                             ray_co,
+                             ray_dir,
+                             rays_len,
+                             radius,
+                             hits,
+                             raycast_tri_callback,
+                             tris,
+                             BVH_RAYCAST_DEFAULT);
+  for (int i = 0; i < rays_len; i++) {
+    BVHTreeRayHit hit = {-1};
+    hit.dist = BVH_RAYCAST_DIST_MAX;
+    BLI_bvhtree_ray_cast(tree, ray_co[i], ray_dir[i], radius, &hit, raycast_tri_callback, tris);
+    EXPECT_EQ(hits[i].index, hit.index);
+    EXPECT_EQ(hits[i].dist, hit.dist);
+  }
+
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(tris);
+  MEM_freeN(ray_co);
+  MEM_freeN(ray_dir);
+  MEM_freeN(hits);
+}
+
+TEST(kdopbvh, RayCastQuad_1)
+{
+  raycast_tris_test(1, 100, 4, 0.0f, 1234);
+}
+TEST(kdopbvh, RayCastQuad_1000)
+{
+  raycast_tris_test(1000, 5000, 4, 0.0f, 12);
+}
+TEST(kdopbvh, RayCastQuadRadius_1000)
+{
+  raycast_tris_test(1000, 5000, 4, 0.05f, 123);
+}
+TEST(kdopbvh, RayCastBinary_1000)
+{
+  raycast_tris_test(1000, 5000, 2, 0.0f, 12);
+}
+TEST(kdopbvh, RayCastOctree_1000)
+{
+  raycast_tris_test(1000, 5000, 8, 0.0f, 12);
+}
+TEST(kdopbvh, RayCastQuadSAH_1000)
+{
+  raycast_tris_test(1000, 5000, 4, 0.0f, 12, BVH_TREE_SAH);
+}
+TEST(kdopbvh, RayCastBinarySAH_1000)
+{
+  raycast_tris_test(1000, 5000, 2, 0.05f, 123, BVH_TREE_SAH);
+}
+TEST(kdopbvh, RayCastOctreeSAH_1000)
+{
+  raycast_tris_test(1000, 5000, 8, 0.0f, 12, BVH_TREE_SAH);
+}
+/* Enough triangles for sub-trees to be built on multiple threads. */
+TEST(kdopbvh, RayCastQuadSAH_20000)
+{
+  raycast_tris_test(20000, 500, 4, 0.0f, 1234, BVH_TREE_SAH);
+}
+
+/* Bounds of all branches, sorted so trees with the same branches compare equal
+ * regardless of the order of children. */
+static bool tree_branch_bounds_cb(const BVHTreeAxisRange *bounds, void *userdata)
+{
+  std::vector<std::array<float, 6>> *branch_bounds = (std::vector<std::array<float, 6>> *)
+      userdata;
+  branch_bounds->push_back({bounds[0].min,
+                            bounds[0].max,
+                            bounds[1].min,
+                            bounds[1].max,
+                            bounds[2].min,
+                            bounds[2].max});
+  return true;
+}
+
+static bool tree_branch_bounds_leaf_cb(const BVHTreeAxisRange *UNUSED(bounds),
+                                       int UNUSED(index),
+                                       void *UNUSED(userdata))
+{
+  return true;
+}
+
+static bool tree_branch_bounds_order_cb(const BVHTreeAxisRange *UNUSED(bounds),
+                                        char UNUSED(axis),
+                                        void *UNUSED(userdata))
+{
+  return true;
+}
+
+static std::vector<std::array<float, 6>> tree_branch_bounds(BVHTree *tree)
+{
+  std::vector<std::array<float, 6>> branch_bounds;
+  BLI_bvhtree_walk_dfs(tree,
+                       tree_branch_bounds_cb,
+                       tree_branch_bounds_leaf_cb,
+                       tree_branch_bounds_order_cb,
+                       &branch_bounds);
+  std::sort(branch_bounds.begin(), branch_bounds.end());
+  return branch_bounds;
+}
+
+static BVHTree *update_rebuild_tree_new(const float (*points)[3],
+                                        int points_len,
+                                        char tree_type,
+                                        int tree_flag)
+{
+  BVHTree *tree = BLI_bvhtree_new_ex(points_len, 0.0, tree_type, 6, tree_flag);
+  for (int i = 0; i < points_len; i++) {
+    BLI_bvhtree_insert(tree, i, points[i], 1);
+  }
+  BLI_bvhtree_balance(tree);
+  return tree;
+}
+
+/**
+ * Move every point to the location of another point, refitting then gives a very poor tree.
+ * With #BVH_TREE_REBUILD_ON_UPDATE #BLI_bvhtree_update_tree must rebuild it, giving the same
+ * branches as a tree built from the moved points, without the flag the tree is only refitted.
+ * When \a enable_after_build is set, the flag is enabled with
+ * #BLI_bvhtree_rebuild_on_update_enable instead.
+ */
+static void update_rebuild_test(
+    int points_len, char tree_type, int tree_flag, bool enable_after_build, int random_seed)
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+
+  /* Not rounded, so the median splits don't depend on the order of points with equal
+   * coordinates. */
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+  for (int i = 0; i < points_len; i++) {
+    for (int j = 0; j < 3; j++) {
+      points[i][j] = BLI_rng_get_float(rng) * 2.0f - 1.0f;
+    }
+  }
+
+  BVHTree *tree = update_rebuild_tree_new(
+      points,
+      points_len,
+      tree_type,
+      enable_after_build ? tree_flag : tree_flag | BVH_TREE_REBUILD_ON_UPDATE);
+  if (enable_after_build) {
+    BLI_bvhtree_rebuild_on_update_enable(tree);
+  }
+  BVHTree *tree_refit = update_rebuild_tree_new(points, points_len, tree_type, tree_flag);
+
+  BLI_array_randomize(points, sizeof(*points), points_len, (uint)random_seed);
+  for (int i = 0; i < points_len; i++) {
+    EXPECT_TRUE(BLI_bvhtree_update_node(tree, i, points[i], nullptr, 1));
+    EXPECT_TRUE(BLI_bvhtree_update_node(tree_refit, i, points[i], nullptr, 1));
+  }
+  BLI_bvhtree_update_tree(tree);
+  BLI_bvhtree_update_tree(tree_refit);
+
+  BVHTree *tree_expect = update_rebuild_tree_new(points, points_len, tree_type, tree_flag);
+  EXPECT_EQ(tree_branch_bounds(tree), tree_branch_bounds(tree_expect));
+  EXPECT_NE(tree_branch_bounds(tree_refit), tree_branch_bounds(tree_expect));
+
+  for (int i = 0; i < points_len; i++) {
+    const int j = BLI_bvhtree_find_nearest(tree, points[i], nullptr, nullptr, nullptr);
+    EXPECT_GE(j, 0);
+    EXPECT_LT(j, points_len);
+    EXPECT_EQ_ARRAY(points[i], points[j], 3);
+  }
+
+  BLI_bvhtree_free(tree);
+  BLI_bvhtree_free(tree_refit);
+  BLI_bvhtree_free(tree_expect);
+  BLI_rng_free(rng);
+  MEM_freeN(points);
+}
+
+TEST(kdopbvh, UpdateRebuild_500)
+{
+  update_rebuild_test(500, 4, BVH_TREE_DEFAULT, false, 12);
+}
+TEST(kdopbvh, UpdateRebuildSAH_500)
+{
+  update_rebuild_test(500, 2, BVH_TREE_SAH, false, 12);
+}
+TEST(kdopbvh, UpdateRebuildEnable_500)
+{
+  update_rebuild_test(500, 4, BVH_TREE_DEFAULT, true, 12);
+}
@@ -0,0 +1,194 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_array.hh"
+#include "BLI_disjoint_set.hh"
+#include "BLI_float3.hh"
+#include "BLI_kdtree.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+#include "BLI_spatial_hash.h"
+#include "BLI_threads.h"
+#include "BLI_vector.hh"
+
+#include "PIL_time.h"
+
+namespace blender::tests {
+
+class SpatialHashTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BLI_threadapi_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    BLI_threadapi_exit();
+  }
+};
+
+/* Compare with clusters found by testing all pairs of points. */
+static void spatial_hash_test_compare(const Array<float3> &co,
+                                      const BLI_bitmap *mask,
+                                      const float range)
+{
+  const int co_len = (int)co.size();
+  DisjointSet disjoint_set(co_len);
+  for (int i = 0; i < co_len; i++) {
+    for (int j = i + 1; j < co_len; j++) {
+      if (mask && !(BLI_BITMAP_TEST(mask, i) && BLI_BITMAP_TEST(mask, j))) {
+        continue;
+      }
+      if (len_squared_v3v3(co[i], co[j]) <= range * range) {
+        disjoint_set.join(i, j);
+      }
+    }
+  }
+  Array<int> lowest(co_len, co_len);
+  Array<int> cluster_len(co_len, 0);
+  for (int i = 0; i < co_len; i++) {
+    const int root = (int)disjoint_set.find_root(i);
+    lowest[root] = std::min(lowest[root], i);
+    cluster_len[root]++;
+  }
+
+  Array<int> duplicates(co_len);
+  const int merge_len = BLI_spatial_hash_3d_calc_duplicates(
+      reinterpret_cast<const float(*)[3]>(co.data()), co_len, mask, range, duplicates.data());
+
+  int merge_len_expect = 0;
+  for (int i = 0; i < co_len; i++) {
+    const int root = (int)disjoint_set.find_root(i);
+    if (cluster_len[root] == 1) {
+      EXPECT_EQ(duplicates[i], -1);
+    }
+    else {
+      EXPECT_EQ(duplicates[i], lowest[root]);
+      merge_len_expect += (lowest[root] != i);
+    }
+  }
+  EXPECT_EQ(merge_len, merge_len_expect);
+}
+
+static Array<float3> spatial_hash_test_random_points(const int co_len, const float size)
+{
+  RNG *rng = BLI_rng_new(0);
+  Array<float3> co(co_len);
+  for (float3 &co_point : co) {
+    BLI_rng_get_float_unit_v3(rng, co_point);
+    mul_v3_fl(co_point, size * BLI_rng_get_float(rng));
+  }
+  BLI_rng_free(rng);
+  return co;
+}
+
+TEST_F(SpatialHashTest, Random)
+{
+  const Array<float3> co = spatial_hash_test_random_points(2000, 10.0f);
+  spatial_hash_test_compare(co, nullptr, 0.1f);
+  spatial_hash_test_compare(co, nullptr, 0.5f);
+  spatial_hash_test_compare(co, nullptr, 2.0f);
+}
+
+TEST_F(SpatialHashTest, Lattice)
+{
+  /* Points exactly at the range of each other. */
+  Array<float3> co(1000);
+  for (int i = 0; i < co.size(); i++) {
+    co[i] = float3((float)(i % 10), (float)((i / 10) % 10), (float)(i / 100)) * 0.5f;
+  }
+  spatial_hash_test_compare(co, nullptr, 0.5f);
+  spatial_hash_test_compare(co, nullptr, 0.49f);
+  spatial_hash_test_compare(co, nullptr, 0.71f);
+}
+
+TEST_F(SpatialHashTest, Mask)
+{
+  const Array<float3> co = spatial_hash_test_random_points(2000, 10.0f);
+  BLI_bitmap *mask = BLI_BITMAP_NEW(co.size(), __func__);
+  for (int i = 0; i < co.size(); i += 3) {
+    BLI_BITMAP_ENABLE(mask, i);
+  }
+  spatial_hash_test_compare(co, mask, 0.5f);
+  MEM_freeN(mask);
+}
+
+TEST_F(SpatialHashTest, Dense)
+{
+  /* All points in a single cell. */
+  const Array<float3> co = spatial_hash_test_random_points(2000, 1.0f);
+  spatial_hash_test_compare(co, nullptr, 10.0f);
+}
+
+TEST_F(SpatialHashTest, Exact)
+{
+  Array<float3> co = {
+      {0.0f, 0.0f, 0.0f},
+      {1.0f, 0.0f, 0.0f},
+      {-0.0f, 0.0f, 0.0f},
+      {1.0f, 0.0f, 0.0f},
+      {1.0f, 0.0f, 1e-6f},
+  };
+  Array<int> duplicates(co.size());
+  const int merge_len = BLI_spatial_hash_3d_calc_duplicates(
+      reinterpret_cast<const float(*)[3]>(co.data()), co.size(), nullptr, 0.0f, duplicates.data());
+  EXPECT_EQ(merge_len, 2);
+  EXPECT_EQ(duplicates[0], 0);
+  EXPECT_EQ(duplicates[1], 1);
+  EXPECT_EQ(duplicates[2], 0);
+  EXPECT_EQ(duplicates[3], 1);
+  EXPECT_EQ(duplicates[4], -1);
+}
+
+/* Grid of `size * size` points, with a slightly moved copy of every other point. */
+static void spatial_hash_test_performance(const int size)
+{
+  const float range = 1e-3f;
+  Vector<float3> co;
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      co.append(float3((float)x, (float)y, 0.0f) * 0.01f);
+      if ((x + y) % 2) {
+        co.append(float3((float)x, (float)y, 0.0f) * 0.01f + float3(range * 0.5f));
+      }
+    }
+  }
+  const int co_len = (int)co.size();
+  const float(*co_data)[3] = reinterpret_cast<const float(*)[3]>(co.data());
+
+  Array<int> duplicates_kdtree(co_len, -1);
+  double time_start = PIL_check_seconds_timer();
+  KDTree_3d *tree = BLI_kdtree_3d_new(co_len);
+  for (int i = 0; i < co_len; i++) {
+    BLI_kdtree_3d_insert(tree, i, co_data[i]);
+  }
+  BLI_kdtree_3d_balance(tree);
+  const int merge_len_kdtree = BLI_kdtree_3d_calc_duplicates_fast(
+      tree, range, false, duplicates_kdtree.data());
+  BLI_kdtree_3d_free(tree);
+  const double time_kdtree = PIL_check_seconds_timer() - time_start;
+
+  Array<int> duplicates(co_len);
+  time_start = PIL_check_seconds_timer();
+  const int merge_len = BLI_spatial_hash_3d_calc_duplicates(
+      co_data, co_len, nullptr, range, duplicates.data());
+  const double time_spatial_hash = PIL_check_seconds_timer() - time_start;
+
+  EXPECT_EQ(merge_len, merge_len_kdtree);
+  EXPECT_EQ(merge_len, (size * size) / 2);
+  printf("Duplicates of %d points, kd-tree: %.3f ms, spatial hash: %.3f ms\n",
+         co_len,
+         time_kdtree * 1000.0,
+         time_spatial_hash * 1000.0);
+}
+
+TEST_F(SpatialHashTest, performance_grid_1500000)
+{
+  spatial_hash_test_performance(1000);
+}
+
+}  // namespace blender::tests
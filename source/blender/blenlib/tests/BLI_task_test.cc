@@ -134,6 +134,72 @@ TEST(task, MempoolIter)
   BLI_threadapi_exit();
 }
 
+/* *** Parallel allocations from a thread-safe mempool. *** */
+
+static void task_mempool_alloc_func(void *userdata,
+                                    const int index,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  void **data = (void **)userdata;
+  BLI_mempool *mempool = (BLI_mempool *)data[NUM_ITEMS];
+
+  int *item = (int *)BLI_mempool_alloc(mempool);
+  *item = index;
+  data[index] = item;
+
+  /* Free some items right away, from another thread than the allocating one in some cases. */
+  if (index % 3 == 0 && index > 0) {
+    const int index_free = index - 1;
+    int *item_free = (int *)atomic_cas_ptr(&data[index_free], data[index_free], nullptr);
+    if (item_free != nullptr) {
+      BLI_mempool_free(mempool, item_free);
+    }
+  }
+}
+
+TEST(task, MempoolThreadsafeAlloc)
+{
+  void *data[NUM_ITEMS + 1] = {nullptr};
+  BLI_threadapi_init();
+  BLI_mempool *mempool = BLI_mempool_create(
+      sizeof(int), 0, 32, BLI_MEMPOOL_ALLOW_ITER | BLI_MEMPOOL_THREADSAFE);
+  data[NUM_ITEMS] = mempool;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, NUM_ITEMS, data, task_mempool_alloc_func, &settings);
+
+  int num_items = 0;
+  for (int i = 0; i < NUM_ITEMS; i++) {
+    if (data[i] != nullptr) {
+      EXPECT_EQ(*(int *)data[i], i);
+      num_items++;
+    }
+  }
+  EXPECT_EQ(BLI_mempool_len(mempool), num_items);
+
+  /* All remaining items are found when iterating in parallel. */
+  int num_items_iter = num_items;
+  BLI_task_parallel_mempool(mempool, &num_items_iter, task_mempool_iter_func, true);
+  EXPECT_EQ(num_items_iter, 0);
+  for (int i = 0; i < NUM_ITEMS; i++) {
+    if (data[i] != nullptr) {
+      EXPECT_EQ(*(int *)data[i], i + 1);
+      BLI_mempool_free(mempool, data[i]);
+    }
+  }
+  EXPECT_EQ(BLI_mempool_len(mempool), 0);
+
+  BLI_mempool_clear(mempool);
+  int *item = (int *)BLI_mempool_alloc(mempool);
+  EXPECT_EQ(BLI_mempool_len(mempool), 1);
+  BLI_mempool_free(mempool, item);
+
+  BLI_mempool_destroy(mempool);
+  BLI_threadapi_exit();
+}
+
 /* *** Parallel iterations over double-linked list items. *** */
 
 static void task_listbase_iter_func(void *userdata,
@@ -24,7 +24,12 @@
  * \ingroup blenloader
  */
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 struct GHash;
+struct GSet;
 struct Scene;
 
 typedef struct {
@@ -34,6 +39,10 @@ typedef struct {
   size_t size;
   /** When true, this chunk doesn't own the memory, it's shared with a previous #MemFileChunk */
   bool is_identical;
+  /** When true, this chunk doesn't own the memory, it's shared with another #MemFileChunk that
+   * has the same content, found by its hash rather than by its position in the file.
+   * Unlike #is_identical this doesn't tell whether the ID that wrote it changed. */
+  bool is_shared;
   /** When true, this chunk is also identical to the one in the next step (used by undo code to
    * detect unchanged IDs).
    * Defined when writing the next step (i.e. last undo step has those always false). */
@@ -41,11 +50,18 @@ typedef struct {
   /** Session UUID of the ID being currently written (MAIN_ID_SESSION_UUID_UNSET when not writing
    * ID-related data). Used to find matching chunks in previous memundo step. */
   uint id_session_uuid;
+  /** Hash of the content of #buf, used to find identical chunks regardless of their position. */
+  uint hash;
 } MemFileChunk;
 
 typedef struct MemFile {
   ListBase chunks;
+  /** Size of the memory owned by this memfile (i.e. not shared with other memfiles). */
   size_t size;
+  /** Size of all chunks, including the ones shared with other memfiles. */
+  size_t size_total;
+  /** Size of the chunks found by content hash, that position based comparison did not share. */
+  size_t size_shared_by_content;
 } MemFile;
 
 typedef struct MemFileWriteData {
@@ -57,6 +73,9 @@ typedef struct MemFileWriteData {
 
   /** Maps an ID session uuid to its first reference MemFileChunk, if existing. */
   struct GHash *id_session_uuid_mapping;
+  /** Set of the chunks of both the reference and the written memfiles, keyed by content, used
+   * to share memory between identical chunks regardless of their position. */
+  struct GSet *content_chunks;
 } MemFileWriteData;
 
 typedef struct MemFileUndoData {
@@ -84,3 +103,7 @@ extern struct Main *BLO_memfile_main_get(struct MemFile *memfile,
                                          struct Main *bmain,
                                          struct Scene **r_scene);
 extern bool BLO_memfile_write_file(struct MemFile *memfile, const char *filename);
+
+#ifdef __cplusplus
+}
+#endif
@@ -65,6 +65,8 @@
 #include "BLI_math.h"
 #include "BLI_memarena.h"
 #include "BLI_mempool.h"
+#include "BLI_mmap.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BLT_translation.h"
@@ -164,11 +166,17 @@
  * Delay reading blocks we might not use (especially applies to library linking).
  * which keeps large arrays in memory from data-blocks we may not even use.
  *
- * \note This is disabled when using compression,
+ * \note This is disabled when using compression without a seek table,
  * while zlib supports seek it's unusably slow, see: T61880.
  */
 #define USE_BHEAD_READ_ON_DEMAND
 
+/**
+ * Read and reconstruct the data of all #DATA blocks in parallel,
+ * before the ID blocks are linked, see #read_data_prepare_parallel.
+ */
+#define USE_PARALLEL_DATA_READ
+
 /* use GHash for BHead name-based lookups (speeds up linking) */
 #define USE_GHASH_BHEAD
 
@@ -187,6 +195,7 @@
 /* local prototypes */
 static void read_libraries(FileData *basefd, ListBase *mainlist);
 static void *read_struct(FileData *fd, BHead *bh, const char *blockname);
+static const char *dataname(short id_code);
 static BHead *find_bhead_from_code_name(FileData *fd, const short idcode, const char *name);
 static BHead *find_bhead_from_idname(FileData *fd, const char *idname);
 static bool library_link_idcode_needs_tag_check(const short idcode, const int flag);
@@ -200,6 +209,10 @@ typedef struct BHeadN {
   bool has_data;
 #endif
   bool is_memchunk_identical;
+#ifdef USE_PARALLEL_DATA_READ
+  /** Result of #read_struct computed ahead of time, owned by this block until it's used. */
+  void *data_prepared;
+#endif
   struct BHead bhead;
 } BHeadN;
 
@@ -245,154 +258,19 @@ static const char *library_parent_filepath(Library *lib)
 /** \name OldNewMap API
  * \{ */
 
-typedef struct OldNew {
-  const void *oldp;
-  void *newp;
-  /* `nr` is "user count" for data, and ID code for libdata. */
-  int nr;
-} OldNew;
-
-typedef struct OldNewMap {
-  /* Array that stores the actual entries. */
-  OldNew *entries;
-  int nentries;
-  /* Hashmap that stores indices into the `entries` array. */
-  int32_t *map;
-
-  int capacity_exp;
-} OldNewMap;
-
-#define ENTRIES_CAPACITY(onm) (1ll << (onm)->capacity_exp)
-#define MAP_CAPACITY(onm) (1ll << ((onm)->capacity_exp + 1))
-#define SLOT_MASK(onm) (MAP_CAPACITY(onm) - 1)
-#define DEFAULT_SIZE_EXP 6
-#define PERTURB_SHIFT 5
-
-/* based on the probing algorithm used in Python dicts. */
-#define ITER_SLOTS(onm, KEY, SLOT_NAME, INDEX_NAME) \
-  uint32_t hash = BLI_ghashutil_ptrhash(KEY); \
-  uint32_t mask = SLOT_MASK(onm); \
-  uint perturb = hash; \
-  int SLOT_NAME = mask & hash; \
-  int INDEX_NAME = onm->map[SLOT_NAME]; \
-  for (;; SLOT_NAME = mask & ((5 * SLOT_NAME) + 1 + perturb), \
-          perturb >>= PERTURB_SHIFT, \
-          INDEX_NAME = onm->map[SLOT_NAME])
-
-static void oldnewmap_insert_index_in_map(OldNewMap *onm, const void *ptr, int index)
-{
-  ITER_SLOTS (onm, ptr, slot, stored_index) {
-    if (stored_index == -1) {
-      onm->map[slot] = index;
-      break;
-    }
-  }
-}
-
-static void oldnewmap_insert_or_replace(OldNewMap *onm, OldNew entry)
-{
-  ITER_SLOTS (onm, entry.oldp, slot, index) {
-    if (index == -1) {
-      onm->entries[onm->nentries] = entry;
-      onm->map[slot] = onm->nentries;
-      onm->nentries++;
-      break;
-    }
-    if (onm->entries[index].oldp == entry.oldp) {
-      onm->entries[index] = entry;
-      break;
-    }
-  }
-}
-
-static OldNew *oldnewmap_lookup_entry(const OldNewMap *onm, const void *addr)
-{
-  ITER_SLOTS (onm, addr, slot, index) {
-    if (index >= 0) {
-      OldNew *entry = &onm->entries[index];
-      if (entry->oldp == addr) {
-        return entry;
-      }
-    }
-    else {
-      return NULL;
-    }
-  }
-}
-
-static void oldnewmap_clear_map(OldNewMap *onm)
-{
-  memset(onm->map, 0xFF, MAP_CAPACITY(onm) * sizeof(*onm->map));
-}
-
-static void oldnewmap_increase_size(OldNewMap *onm)
-{
-  onm->capacity_exp++;
-  onm->entries = MEM_reallocN(onm->entries, sizeof(*onm->entries) * ENTRIES_CAPACITY(onm));
-  onm->map = MEM_reallocN(onm->map, sizeof(*onm->map) * MAP_CAPACITY(onm));
-  oldnewmap_clear_map(onm);
-  for (int i = 0; i < onm->nentries; i++) {
-    oldnewmap_insert_index_in_map(onm, onm->entries[i].oldp, i);
-  }
-}
-
-/* Public OldNewMap API */
-
-static OldNewMap *oldnewmap_new(void)
-{
-  OldNewMap *onm = MEM_callocN(sizeof(*onm), "OldNewMap");
-
-  onm->capacity_exp = DEFAULT_SIZE_EXP;
-  onm->entries = MEM_malloc_arrayN(
-      ENTRIES_CAPACITY(onm), sizeof(*onm->entries), "OldNewMap.entries");
-  onm->map = MEM_malloc_arrayN(MAP_CAPACITY(onm), sizeof(*onm->map), "OldNewMap.map");
-  oldnewmap_clear_map(onm);
-
-  return onm;
-}
-
-static void oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr, int nr)
-{
-  if (oldaddr == NULL || newaddr == NULL) {
-    return;
-  }
-
-  if (UNLIKELY(onm->nentries == ENTRIES_CAPACITY(onm))) {
-    oldnewmap_increase_size(onm);
-  }
-
-  OldNew entry;
-  entry.oldp = oldaddr;
-  entry.newp = newaddr;
-  entry.nr = nr;
-  oldnewmap_insert_or_replace(onm, entry);
-}
-
 void blo_do_versions_oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr, int nr)
 {
-  oldnewmap_insert(onm, oldaddr, newaddr, nr);
-}
-
-static void *oldnewmap_lookup_and_inc(OldNewMap *onm, const void *addr, bool increase_users)
-{
-  OldNew *entry = oldnewmap_lookup_entry(onm, addr);
-  if (entry == NULL) {
-    return NULL;
-  }
-  if (increase_users) {
-    entry->nr++;
-  }
-  return entry->newp;
+  blo_oldnewmap_insert(onm, oldaddr, newaddr, nr);
 }
 
-/* for libdata, OldNew.nr has ID code, no increment */
+/* for libdata, OldNewMapEntry.nr has ID code, no increment */
 static void *oldnewmap_liblookup(OldNewMap *onm, const void *addr, const void *lib)
 {
   if (addr == NULL) {
     return NULL;
   }
 
-  ID *id = oldnewmap_lookup_and_inc(onm, addr, false);
+  ID *id = blo_oldnewmap_lookup_and_inc(onm, addr, false);
   if (id == NULL) {
     return NULL;
   }
@@ -402,36 +280,6 @@ static void *oldnewmap_liblookup(OldNewMap *onm, const void *addr, const void *l
   return NULL;
 }
 
-static void oldnewmap_clear(OldNewMap *onm)
-{
-  /* Free unused data. */
-  for (int i = 0; i < onm->nentries; i++) {
-    OldNew *entry = &onm->entries[i];
-    if (entry->nr == 0) {
-      MEM_freeN(entry->newp);
-      entry->newp = NULL;
-    }
-  }
-
-  onm->capacity_exp = DEFAULT_SIZE_EXP;
-  oldnewmap_clear_map(onm);
-  onm->nentries = 0;
-}
-
-static void oldnewmap_free(OldNewMap *onm)
-{
-  MEM_freeN(onm->entries);
-  MEM_freeN(onm->map);
-  MEM_freeN(onm);
-}
-
-#undef ENTRIES_CAPACITY
-#undef MAP_CAPACITY
-#undef SLOT_MASK
-#undef DEFAULT_SIZE_EXP
-#undef PERTURB_SHIFT
-#undef ITER_SLOTS
-
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -812,6 +660,9 @@ static BHeadN *get_bhead(FileData *fd)
           new_bhead->file_offset = fd->file_offset;
           new_bhead->has_data = false;
           new_bhead->is_memchunk_identical = false;
+#ifdef USE_PARALLEL_DATA_READ
+          new_bhead->data_prepared = NULL;
+#endif
           new_bhead->bhead = bhead;
           off64_t seek_new = fd->seek(fd, bhead.len, SEEK_CUR);
           if (seek_new == -1) {
@@ -835,6 +686,9 @@ static BHeadN *get_bhead(FileData *fd)
           new_bhead->has_data = true;
 #endif
           new_bhead->is_memchunk_identical = false;
+#ifdef USE_PARALLEL_DATA_READ
+          new_bhead->data_prepared = NULL;
+#endif
           new_bhead->bhead = bhead;
 
           readsize = fd->read(
@@ -947,6 +801,9 @@ static BHead *blo_bhead_read_full(FileData *fd, BHead *thisblock)
   new_bhead_data->file_offset = new_bhead->file_offset;
   new_bhead_data->has_data = true;
   new_bhead_data->is_memchunk_identical = false;
+#ifdef USE_PARALLEL_DATA_READ
+  new_bhead_data->data_prepared = NULL;
+#endif
   if (!blo_bhead_read_data(fd, thisblock, new_bhead_data + 1)) {
     MEM_freeN(new_bhead_data);
     return NULL;
@@ -1124,6 +981,72 @@ static off64_t fd_seek_data_from_file(FileData *filedata, off64_t offset, int wh
   return filedata->file_offset;
 }
 
+/* Memory mapped file reading. */
+
+static ssize_t fd_read_from_mmap(FileData *filedata,
+                                 void *buffer,
+                                 size_t size,
+                                 bool *UNUSED(r_is_memchunck_identical))
+{
+  /* Don't read more bytes than there are available in the file. */
+  const size_t file_len = BLI_mmap_get_length(filedata->mmap_file);
+  size_t readsize = MIN2(size, file_len - (size_t)filedata->file_offset);
+
+  if (!BLI_mmap_read(filedata->mmap_file, buffer, (size_t)filedata->file_offset, readsize)) {
+    return EOF;
+  }
+  filedata->file_offset += readsize;
+
+  return (ssize_t)readsize;
+}
+
+static off64_t fd_seek_from_mmap(FileData *filedata, off64_t offset, int whence)
+{
+  const off64_t file_len = (off64_t)BLI_mmap_get_length(filedata->mmap_file);
+  off64_t offset_new;
+  switch (whence) {
+    case SEEK_SET:
+      offset_new = offset;
+      break;
+    case SEEK_CUR:
+      offset_new = filedata->file_offset + offset;
+      break;
+    case SEEK_END:
+      offset_new = file_len + offset;
+      break;
+    default:
+      return -1;
+  }
+  if ((offset_new < 0) || (offset_new > file_len)) {
+    return -1;
+  }
+  filedata->file_offset = offset_new;
+  return offset_new;
+}
+
+/**
+ * Access the data of a block that has not been read yet (see #USE_BHEAD_READ_ON_DEMAND)
+ * without copying it, only possible for memory mapped files.
+ *
+ * Returns NULL on Windows, where IO errors are only handled when copying the data with
+ * #BLI_mmap_read (direct access to the mapping would crash on errors of network drives).
+ *
+ * \note Callers must check #BLI_mmap_any_io_error once they are done reading the data.
+ */
+static const void *fd_bhead_data_from_mmap(FileData *fd, off64_t file_offset, size_t len)
+{
+#ifdef WIN32
+  UNUSED_VARS(fd, file_offset, len);
+  return NULL;
+#else
+  if ((fd->mmap_file == NULL) || BLI_mmap_any_io_error(fd->mmap_file) ||
+      ((size_t)file_offset + len > BLI_mmap_get_length(fd->mmap_file))) {
+    return NULL;
+  }
+  return POINTER_OFFSET(BLI_mmap_get_pointer(fd->mmap_file), file_offset);
+#endif
+}
+
 /* GZip file reading. */
 
 static ssize_t fd_read_gzip_from_file(FileData *filedata,
@@ -1145,6 +1068,186 @@ static ssize_t fd_read_gzip_from_file(FileData *filedata,
   return readsize;
 }
 
+/* Seekable GZip file reading. */
+
+static uint32_t gzip_seek_decode_u32(const uchar *buf)
+{
+  return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) |
+         ((uint32_t)buf[3] << 24);
+}
+
+/**
+ * Read the seek table written at the end of compressed files (see #GzipSeekData).
+ *
+ * \return NULL for gzip files without a seek table (written by older versions or other tools).
+ */
+static GzipSeekData *gzip_seek_data_read(int file)
+{
+  const off64_t file_size = BLI_lseek(file, 0, SEEK_END);
+  uchar tail[BLO_GZIP_SEEK_TRAILER_SIZE + 8];
+  if ((file_size < (off64_t)(BLO_GZIP_SEEK_HEADER_SIZE + sizeof(tail))) ||
+      (BLI_lseek(file, file_size - (off64_t)sizeof(tail), SEEK_SET) == -1) ||
+      (read(file, tail, sizeof(tail)) != sizeof(tail)) ||
+      (memcmp(tail + 4, BLO_GZIP_SEEK_MAGIC, 4) != 0)) {
+    return NULL;
+  }
+
+  const uint32_t frames_num = gzip_seek_decode_u32(tail);
+  if ((frames_num == 0) || (frames_num > BLO_GZIP_SEEK_FRAMES_MAX)) {
+    return NULL;
+  }
+  const size_t data_len = BLO_GZIP_SEEK_DATA_SIZE(frames_num);
+  const size_t member_len = BLO_GZIP_SEEK_HEADER_SIZE + data_len + BLO_GZIP_SEEK_TRAILER_SIZE;
+  const off64_t member_offset = file_size - (off64_t)member_len;
+  if (member_offset < 0) {
+    return NULL;
+  }
+
+  uchar *member = MEM_mallocN(member_len, __func__);
+  GzipSeekData *gz = NULL;
+  if ((BLI_lseek(file, member_offset, SEEK_SET) != -1) &&
+      (read(file, member, member_len) == (ssize_t)member_len) &&
+      /* Gzip magic with #FEXTRA flag. */
+      (member[0] == 0x1f) && (member[1] == 0x8b) && (member[3] & 4) &&
+      (member[12] == BLO_GZIP_SEEK_SI1) && (member[13] == BLO_GZIP_SEEK_SI2) &&
+      ((member[14] | (member[15] << 8)) == (int)data_len)) {
+    const uchar *p = member + BLO_GZIP_SEEK_HEADER_SIZE;
+    gz = MEM_callocN(sizeof(*gz), __func__);
+    gz->frame_size = gzip_seek_decode_u32(p);
+    gz->frame_last_size = gzip_seek_decode_u32(p + 4);
+    gz->frames_num = (int)frames_num;
+    gz->frame_cached = -1;
+    gz->frame_offsets = MEM_mallocN(sizeof(*gz->frame_offsets) * (frames_num + 1), __func__);
+    gz->frame_offsets[0] = 0;
+    p += 8;
+    for (uint32_t i = 0; i < frames_num; i++, p += 4) {
+      gz->frame_offsets[i + 1] = gz->frame_offsets[i] + gzip_seek_decode_u32(p);
+    }
+
+    /* The frames must exactly fill the file up to the seek table. */
+    if ((gz->frame_offsets[frames_num] != member_offset) || (gz->frame_size == 0) ||
+        (gz->frame_last_size > gz->frame_size)) {
+      MEM_freeN(gz->frame_offsets);
+      MEM_freeN(gz);
+      gz = NULL;
+    }
+    else {
+      gz->frame_buf = MEM_mallocN(gz->frame_size, __func__);
+    }
+  }
+  MEM_freeN(member);
+
+  BLI_lseek(file, 0, SEEK_SET);
+  return gz;
+}
+
+static void gzip_seek_data_free(GzipSeekData *gz)
+{
+  MEM_freeN(gz->frame_offsets);
+  MEM_freeN(gz->frame_buf);
+  MEM_SAFE_FREE(gz->in_buf);
+  MEM_freeN(gz);
+}
+
+static off64_t gzip_seek_data_size(const GzipSeekData *gz)
+{
+  return (off64_t)gz->frame_size * (gz->frames_num - 1) + gz->frame_last_size;
+}
+
+/** Decompress a single frame into #GzipSeekData.frame_buf. */
+static bool gzip_seek_frame_ensure(FileData *filedata, int frame)
+{
+  GzipSeekData *gz = filedata->gzip_seek;
+  if (gz->frame_cached == frame) {
+    return true;
+  }
+  gz->frame_cached = -1;
+
+  const size_t in_len = (size_t)(gz->frame_offsets[frame + 1] - gz->frame_offsets[frame]);
+  if (in_len > gz->in_buf_len) {
+    MEM_SAFE_FREE(gz->in_buf);
+    gz->in_buf = MEM_mallocN(in_len, __func__);
+    gz->in_buf_len = in_len;
+  }
+  if ((BLI_lseek(filedata->filedes, gz->frame_offsets[frame], SEEK_SET) == -1) ||
+      (read(filedata->filedes, gz->in_buf, in_len) != (ssize_t)in_len)) {
+    return false;
+  }
+
+  const uint32_t out_len = (frame == gz->frames_num - 1) ? gz->frame_last_size : gz->frame_size;
+  z_stream strm = {NULL};
+  if (inflateInit2(&strm, 16 + MAX_WBITS) != Z_OK) {
+    return false;
+  }
+  strm.next_in = (Bytef *)gz->in_buf;
+  strm.avail_in = (uInt)in_len;
+  strm.next_out = (Bytef *)gz->frame_buf;
+  strm.avail_out = out_len;
+  const int err = inflate(&strm, Z_FINISH);
+  const bool ok = (err == Z_STREAM_END) && (strm.total_out == out_len);
+  inflateEnd(&strm);
+
+  if (!ok) {
+    printf("%s: zlib error in frame %d\n", __func__, frame);
+    return false;
+  }
+  gz->frame_cached = frame;
+  return true;
+}
+
+static ssize_t fd_read_gzip_seek_from_file(FileData *filedata,
+                                           void *buffer,
+                                           size_t size,
+                                           bool *UNUSED(r_is_memchunck_identical))
+{
+  GzipSeekData *gz = filedata->gzip_seek;
+  const off64_t data_size = gzip_seek_data_size(gz);
+  size_t totread = 0;
+
+  while ((totread < size) && (filedata->file_offset < data_size)) {
+    const int frame = (int)(filedata->file_offset / gz->frame_size);
+    if (!gzip_seek_frame_ensure(filedata, frame)) {
+      return EOF;
+    }
+    const size_t frame_len = (frame == gz->frames_num - 1) ? gz->frame_last_size :
+                                                             gz->frame_size;
+    const size_t frame_offset = (size_t)(filedata->file_offset -
+                                         (off64_t)frame * gz->frame_size);
+    const size_t readsize = MIN2(size - totread, frame_len - frame_offset);
+
+    memcpy(POINTER_OFFSET(buffer, totread), gz->frame_buf + frame_offset, readsize);
+    totread += readsize;
+    filedata->file_offset += readsize;
+  }
+
+  return (ssize_t)totread;
+}
+
+static off64_t fd_seek_gzip_seek_from_file(FileData *filedata, off64_t offset, int whence)
+{
+  const off64_t data_size = gzip_seek_data_size(filedata->gzip_seek);
+  off64_t offset_new;
+  switch (whence) {
+    case SEEK_SET:
+      offset_new = offset;
+      break;
+    case SEEK_CUR:
+      offset_new = filedata->file_offset + offset;
+      break;
+    case SEEK_END:
+      offset_new = data_size + offset;
+      break;
+    default:
+      return -1;
+  }
+  if ((offset_new < 0) || (offset_new > data_size)) {
+    return -1;
+  }
+  /* Decompression is delayed until data is read. */
+  filedata->file_offset = offset_new;
+  return offset_new;
+}
+
 /* Memory reading. */
 
 static ssize_t fd_read_from_memory(FileData *filedata,
@@ -1252,9 +1355,9 @@ static FileData *filedata_new(void)
 
   fd->memsdna = DNA_sdna_current_get();
 
-  fd->datamap = oldnewmap_new();
-  fd->globmap = oldnewmap_new();
-  fd->libmap = oldnewmap_new();
+  fd->datamap = blo_oldnewmap_new();
+  fd->globmap = blo_oldnewmap_new();
+  fd->libmap = blo_oldnewmap_new();
 
   return fd;
 }
@@ -1290,6 +1393,8 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
   FileDataSeekFn *seek_fn = NULL; /* Optional. */
 
   gzFile gzfile = (gzFile)Z_NULL;
+  GzipSeekData *gzip_seek = NULL;
+  BLI_mmap_file *mmap_file = NULL;
 
   char header[7];
 
@@ -1308,8 +1413,18 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
 
   /* Regular file. */
   if (memcmp(header, "BLENDER", sizeof(header)) == 0) {
-    read_fn = fd_read_data_from_file;
-    seek_fn = fd_seek_data_from_file;
+    /* Prefer memory mapping, data is then copied directly from the page cache
+     * and blocks can be reconstructed from the mapping without an intermediate copy. */
+    mmap_file = BLI_mmap_open(file);
+    if (mmap_file != NULL) {
+      read_fn = fd_read_from_mmap;
+      seek_fn = fd_seek_from_mmap;
+    }
+    else {
+      read_fn = fd_read_data_from_file;
+      seek_fn = fd_seek_data_from_file;
+    }
+    BLI_lseek(file, 0, SEEK_SET);
   }
 
   /* Gzip file. */
@@ -1317,20 +1432,28 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
   if ((read_fn == NULL) &&
       /* Check header magic. */
       (header[0] == 0x1f && header[1] == 0x8b)) {
-    gzfile = BLI_gzopen(filepath, "rb");
-    if (gzfile == (gzFile)Z_NULL) {
-      BKE_reportf(reports,
-                  RPT_WARNING,
-                  "Unable to open '%s': %s",
-                  filepath,
-                  errno ? strerror(errno) : TIP_("unknown error reading file"));
-      return NULL;
+    /* Files with a seek table support random access, see #GzipSeekData. */
+    gzip_seek = gzip_seek_data_read(file);
+    if (gzip_seek != NULL) {
+      read_fn = fd_read_gzip_seek_from_file;
+      seek_fn = fd_seek_gzip_seek_from_file;
     }
+    else {
+      gzfile = BLI_gzopen(filepath, "rb");
+      if (gzfile == (gzFile)Z_NULL) {
+        BKE_reportf(reports,
+                    RPT_WARNING,
+                    "Unable to open '%s': %s",
+                    filepath,
+                    errno ? strerror(errno) : TIP_("unknown error reading file"));
+        return NULL;
+      }
 
-    /* 'seek_fn' is too slow for gzip, don't set it. */
-    read_fn = fd_read_gzip_from_file;
-    /* Caller must close. */
-    file = -1;
+      /* 'seek_fn' is too slow for gzip, don't set it. */
+      read_fn = fd_read_gzip_from_file;
+      /* Caller must close. */
+      file = -1;
+    }
   }
 
   if (read_fn == NULL) {
@@ -1342,6 +1465,8 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
 
   fd->filedes = file;
   fd->gzfiledes = gzfile;
+  fd->gzip_seek = gzip_seek;
+  fd->mmap_file = mmap_file;
 
   fd->read = read_fn;
   fd->seek = seek_fn;
@@ -1404,25 +1529,38 @@ static ssize_t fd_read_gzip_from_memory(FileData *filedata,
                                         size_t size,
                                         bool *UNUSED(r_is_memchunck_identical))
 {
-  int err;
-
   filedata->strm.next_out = (Bytef *)buffer;
   filedata->strm.avail_out = (uint)size;
 
-  /* Inflate another chunk. */
-  err = inflate(&filedata->strm, Z_SYNC_FLUSH);
+  while (filedata->strm.avail_out != 0) {
+    /* Inflate another chunk. */
+    const int err = inflate(&filedata->strm, Z_SYNC_FLUSH);
 
-  if (err == Z_STREAM_END) {
-    return 0;
-  }
-  if (err != Z_OK) {
-    printf("fd_read_gzip_from_memory: zlib error\n");
-    return 0;
+    if (err == Z_STREAM_END) {
+      /* Compressed files are written as a sequence of gzip members, continue with the next one
+       * (the seek table is stored in an empty trailing member). */
+      if (filedata->strm.avail_in == 0) {
+        break;
+      }
+      if (inflateReset(&filedata->strm) != Z_OK) {
+        printf("fd_read_gzip_from_memory: zlib error\n");
+        return 0;
+      }
+    }
+    else if (err == Z_BUF_ERROR && filedata->strm.avail_in == 0) {
+      /* Truncated data, return what could be read. */
+      break;
+    }
+    else if (err != Z_OK) {
+      printf("fd_read_gzip_from_memory: zlib error\n");
+      return 0;
+    }
   }
 
-  filedata->file_offset += size;
+  const size_t readsize = size - filedata->strm.avail_out;
+  filedata->file_offset += readsize;
 
-  return (ssize_t)size;
+  return (ssize_t)readsize;
 }
 
 static int fd_read_gzip_from_memory_init(FileData *fd)
@@ -1502,6 +1640,14 @@ void blo_filedata_free(FileData *fd)
       gzclose(fd->gzfiledes);
     }
 
+    if (fd->gzip_seek != NULL) {
+      gzip_seek_data_free(fd->gzip_seek);
+    }
+
+    if (fd->mmap_file != NULL) {
+      BLI_mmap_free(fd->mmap_file);
+    }
+
     if (fd->strm.next_in) {
       if (inflateEnd(&fd->strm) != Z_OK) {
         printf("close gzip stream error\n");
@@ -1513,6 +1659,15 @@ void blo_filedata_free(FileData *fd)
       fd->buffer = NULL;
     }
 
+#ifdef USE_PARALLEL_DATA_READ
+    /* Data of blocks that were never used (skipped or unknown ID types). */
+    LISTBASE_FOREACH (BHeadN *, new_bhead, &fd->bhead_list) {
+      if (new_bhead->data_prepared != NULL) {
+        MEM_freeN(new_bhead->data_prepared);
+      }
+    }
+#endif
+
     /* Free all BHeadN data blocks */
 #ifndef NDEBUG
     BLI_freelistN(&fd->bhead_list);
@@ -1536,17 +1691,30 @@ void blo_filedata_free(FileData *fd)
       DNA_reconstruct_info_free(fd->reconstruct_info);
     }
 
+    if (G.debug & G_DEBUG_IO) {
+      printf("Pointer map statistics for '%s':\n", fd->relabase);
+      if (fd->datamap) {
+        blo_oldnewmap_print_stats(fd->datamap, "datamap");
+      }
+      if (fd->globmap) {
+        blo_oldnewmap_print_stats(fd->globmap, "globmap");
+      }
+      if (fd->libmap) {
+        blo_oldnewmap_print_stats(fd->libmap, "libmap");
+      }
+    }
+
     if (fd->datamap) {
-      oldnewmap_free(fd->datamap);
+      blo_oldnewmap_free(fd->datamap);
     }
     if (fd->globmap) {
-      oldnewmap_free(fd->globmap);
+      blo_oldnewmap_free(fd->globmap);
     }
     if (fd->packedmap) {
-      oldnewmap_free(fd->packedmap);
+      blo_oldnewmap_free(fd->packedmap);
     }
     if (fd->libmap && !(fd->flags & FD_FLAGS_NOT_MY_LIBMAP)) {
-      oldnewmap_free(fd->libmap);
+      blo_oldnewmap_free(fd->libmap);
     }
     if (fd->old_idmap != NULL) {
       BKE_main_idmap_destroy(fd->old_idmap);
@@ -1703,29 +1871,29 @@ BlendThumbnail *BLO_thumbnail_from_file(const char *filepath)
 /* only direct databocks */
 static void *newdataadr(FileData *fd, const void *adr)
 {
-  return oldnewmap_lookup_and_inc(fd->datamap, adr, true);
+  return blo_oldnewmap_lookup_and_inc(fd->datamap, adr, true);
 }
 
 /* only direct databocks */
 static void *newdataadr_no_us(FileData *fd, const void *adr)
 {
-  return oldnewmap_lookup_and_inc(fd->datamap, adr, false);
+  return blo_oldnewmap_lookup_and_inc(fd->datamap, adr, false);
 }
 
 /* direct datablocks with global linking */
 void *blo_read_get_new_globaldata_address(FileData *fd, const void *adr)
 {
-  return oldnewmap_lookup_and_inc(fd->globmap, adr, true);
+  return blo_oldnewmap_lookup_and_inc(fd->globmap, adr, true);
 }
 
 /* used to restore packed data after undo */
 static void *newpackedadr(FileData *fd, const void *adr)
 {
   if (fd->packedmap && adr) {
-    return oldnewmap_lookup_and_inc(fd->packedmap, adr, true);
+    return blo_oldnewmap_lookup_and_inc(fd->packedmap, adr, true);
   }
 
-  return oldnewmap_lookup_and_inc(fd->datamap, adr, true);
+  return blo_oldnewmap_lookup_and_inc(fd->datamap, adr, true);
 }
 
 /* only lib data */
@@ -1741,20 +1909,28 @@ void *blo_do_versions_newlibadr(FileData *fd, const void *lib, const void *adr)
 }
 
 /* increases user number */
-static void change_link_placeholder_to_real_ID_pointer_fd(FileData *fd, const void *old, void *new)
-{
-  for (int i = 0; i < fd->libmap->nentries; i++) {
-    OldNew *entry = &fd->libmap->entries[i];
+typedef struct LinkPlaceholderReplaceData {
+  const void *old;
+  void *new;
+} LinkPlaceholderReplaceData;
 
-    if (old == entry->newp && entry->nr == ID_LINK_PLACEHOLDER) {
-      entry->newp = new;
-      if (new) {
-        entry->nr = GS(((ID *)new)->name);
-      }
+static void change_link_placeholder_to_real_ID_pointer_cb(OldNewMapEntry *entry, void *user_data)
+{
+  const LinkPlaceholderReplaceData *data = user_data;
+  if (data->old == entry->newp && entry->nr == ID_LINK_PLACEHOLDER) {
+    entry->newp = data->new;
+    if (data->new) {
+      entry->nr = GS(((ID *)data->new)->name);
     }
   }
 }
 
+static void change_link_placeholder_to_real_ID_pointer_fd(FileData *fd, const void *old, void *new)
+{
+  LinkPlaceholderReplaceData data = {old, new};
+  blo_oldnewmap_foreach(fd->libmap, change_link_placeholder_to_real_ID_pointer_cb, &data);
+}
+
 static void change_link_placeholder_to_real_ID_pointer(ListBase *mainlist,
                                                        FileData *basefd,
                                                        void *old,
@@ -1796,13 +1972,13 @@ void blo_clear_proxy_pointers_from_lib(Main *oldmain)
 
 static void insert_packedmap(FileData *fd, PackedFile *pf)
 {
-  oldnewmap_insert(fd->packedmap, pf, pf, 0);
-  oldnewmap_insert(fd->packedmap, pf->data, pf->data, 0);
+  blo_oldnewmap_insert(fd->packedmap, pf, pf, 0);
+  blo_oldnewmap_insert(fd->packedmap, pf->data, pf->data, 0);
 }
 
 void blo_make_packed_pointer_map(FileData *fd, Main *oldmain)
 {
-  fd->packedmap = oldnewmap_new();
+  fd->packedmap = blo_oldnewmap_new();
 
   LISTBASE_FOREACH (Image *, ima, &oldmain->images) {
     if (ima->packedfile) {
@@ -1841,18 +2017,19 @@ void blo_make_packed_pointer_map(FileData *fd, Main *oldmain)
   }
 }
 
+static void end_packed_pointer_map_cb(OldNewMapEntry *entry, void *UNUSED(user_data))
+{
+  if (entry->nr > 0) {
+    entry->newp = NULL;
+  }
+}
+
 /* set old main packed data to zero if it has been restored */
 /* this works because freeing old main only happens after this call */
 void blo_end_packed_pointer_map(FileData *fd, Main *oldmain)
 {
-  OldNew *entry = fd->packedmap->entries;
-
   /* used entries were restored, so we put them to zero */
-  for (int i = 0; i < fd->packedmap->nentries; i++, entry++) {
-    if (entry->nr > 0) {
-      entry->newp = NULL;
-    }
-  }
+  blo_oldnewmap_foreach(fd->packedmap, end_packed_pointer_map_cb, NULL);
 
   LISTBASE_FOREACH (Image *, ima, &oldmain->images) {
     ima->packedfile = newpackedadr(fd, ima->packedfile);
@@ -1888,7 +2065,7 @@ void blo_add_library_pointer_map(ListBase *old_mainlist, FileData *fd)
     int i = set_listbasepointers(ptr, lbarray);
     while (i--) {
       LISTBASE_FOREACH (ID *, id, lbarray[i]) {
-        oldnewmap_insert(fd->libmap, id, id, GS(id->name));
+        blo_oldnewmap_insert(fd->libmap, id, id, GS(id->name));
       }
     }
   }
@@ -2068,10 +2245,85 @@ static void switch_endian_structs(const struct SDNA *filesdna, BHead *bhead)
   }
 }
 
+/**
+ * Arrays of structs larger than this (in bytes) are reconstructed on multiple threads,
+ * split in ranges of #RECONSTRUCT_PARALLEL_RANGE_SIZE bytes.
+ */
+#define RECONSTRUCT_PARALLEL_MIN_SIZE (1 << 20)
+#define RECONSTRUCT_PARALLEL_RANGE_SIZE (1 << 16)
+
+typedef struct ReconstructParallelData {
+  const struct DNA_ReconstructInfo *reconstruct_info;
+  int old_struct_nr;
+  int blocks;
+  int blocks_per_range;
+  const void *old_blocks;
+  void *new_blocks;
+} ReconstructParallelData;
+
+static void reconstruct_parallel_cb(void *__restrict userdata,
+                                    const int range,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ReconstructParallelData *data = userdata;
+  const int blocks_start = range * data->blocks_per_range;
+  const int blocks = min_ii(data->blocks_per_range, data->blocks - blocks_start);
+  DNA_struct_reconstruct_range(data->reconstruct_info,
+                               data->old_struct_nr,
+                               blocks_start,
+                               blocks,
+                               data->old_blocks,
+                               data->new_blocks);
+}
+
+/**
+ * Same as #DNA_struct_reconstruct, large arrays (e.g. mesh data of old files) are
+ * reconstructed on multiple threads.
+ */
+static void *read_struct_reconstruct(FileData *fd, BHead *bh, const void *old_blocks)
+{
+  const SDNA *filesdna = fd->filesdna;
+  const int old_block_size = filesdna->types_size[filesdna->structs[bh->SDNAnr]->type];
+  if (bh->len < RECONSTRUCT_PARALLEL_MIN_SIZE || old_block_size == 0) {
+    return DNA_struct_reconstruct(fd->reconstruct_info, bh->SDNAnr, bh->nr, old_blocks);
+  }
+
+  const int new_block_size = DNA_struct_reconstruct_size(fd->reconstruct_info, bh->SDNAnr);
+  if (new_block_size == 0) {
+    return NULL;
+  }
+
+  ReconstructParallelData data = {
+      .reconstruct_info = fd->reconstruct_info,
+      .old_struct_nr = bh->SDNAnr,
+      .blocks = bh->nr,
+      .blocks_per_range = max_ii(RECONSTRUCT_PARALLEL_RANGE_SIZE / old_block_size, 1),
+      .old_blocks = old_blocks,
+      .new_blocks = MEM_callocN((size_t)bh->nr * (size_t)new_block_size, "reconstruct"),
+  };
+  const int ranges_num = (data.blocks + data.blocks_per_range - 1) / data.blocks_per_range;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  BLI_task_parallel_range(0, ranges_num, &data, reconstruct_parallel_cb, &settings);
+
+  return data.new_blocks;
+}
+
 static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
 {
   void *temp = NULL;
 
+#ifdef USE_PARALLEL_DATA_READ
+  BHeadN *new_bhead = BHEADN_FROM_BHEAD(bh);
+  if (new_bhead->data_prepared != NULL) {
+    /* Pass ownership to the caller. */
+    temp = new_bhead->data_prepared;
+    new_bhead->data_prepared = NULL;
+    return temp;
+  }
+#endif
+
   if (bh->len) {
 #ifdef USE_BHEAD_READ_ON_DEMAND
     BHead *bh_orig = bh;
@@ -2093,16 +2345,29 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
 
     if (fd->compflags[bh->SDNAnr] != SDNA_CMP_REMOVED) {
       if (fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL) {
+        const void *data = (bh + 1);
 #ifdef USE_BHEAD_READ_ON_DEMAND
         if (BHEADN_FROM_BHEAD(bh)->has_data == false) {
-          bh = blo_bhead_read_full(fd, bh);
-          if (UNLIKELY(bh == NULL)) {
-            fd->flags &= ~FD_FLAGS_FILE_OK;
-            return NULL;
+          /* Reconstruct from the memory mapped file when possible,
+           * to avoid reading the data into a temporary block first. */
+          data = fd_bhead_data_from_mmap(fd, BHEADN_FROM_BHEAD(bh)->file_offset, (size_t)bh->len);
+          if (data == NULL) {
+            bh = blo_bhead_read_full(fd, bh);
+            if (UNLIKELY(bh == NULL)) {
+              fd->flags &= ~FD_FLAGS_FILE_OK;
+              return NULL;
+            }
+            data = (bh + 1);
           }
         }
 #endif
-        temp = DNA_struct_reconstruct(fd->reconstruct_info, bh->SDNAnr, bh->nr, (bh + 1));
+        temp = read_struct_reconstruct(fd, bh, data);
+#ifdef USE_BHEAD_READ_ON_DEMAND
+        if (UNLIKELY(fd->mmap_file && BLI_mmap_any_io_error(fd->mmap_file))) {
+          fd->flags &= ~FD_FLAGS_FILE_OK;
+          MEM_SAFE_FREE(temp);
+        }
+#endif
       }
       else {
         /* SDNA_CMP_EQUAL */
@@ -2136,6 +2401,127 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
   return temp;
 }
 
+#ifdef USE_PARALLEL_DATA_READ
+
+typedef struct DataPrepareData {
+  FileData *fd;
+  BHead **bheads;
+  const char **allocnames;
+} DataPrepareData;
+
+static void read_data_prepare_cb(void *__restrict userdata,
+                                 const int i,
+                                 const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  DataPrepareData *data = userdata;
+  FileData *fd = data->fd;
+  BHead *bh = data->bheads[i];
+  BHeadN *new_bhead = BHEADN_FROM_BHEAD(bh);
+
+  /* Same as #read_struct, without going through #FileData.read. */
+  const void *src = new_bhead->has_data ?
+                        (bh + 1) :
+                        fd_bhead_data_from_mmap(fd, new_bhead->file_offset, (size_t)bh->len);
+  void *src_copy = NULL;
+  if (src == NULL) {
+    /* Direct access isn't possible, copy the data with the IO error handling of the mapping. */
+    src_copy = MEM_mallocN((size_t)bh->len, __func__);
+    if (!BLI_mmap_read(fd->mmap_file, src_copy, (size_t)new_bhead->file_offset, (size_t)bh->len)) {
+      MEM_freeN(src_copy);
+      return;
+    }
+    src = src_copy;
+  }
+
+  void *temp = NULL;
+  switch (fd->compflags[bh->SDNAnr]) {
+    case SDNA_CMP_REMOVED:
+      break;
+    case SDNA_CMP_NOT_EQUAL:
+      temp = read_struct_reconstruct(fd, bh, src);
+      break;
+    default: /* SDNA_CMP_EQUAL */
+      temp = MEM_mallocN((size_t)bh->len, data->allocnames[i]);
+      memcpy(temp, src, (size_t)bh->len);
+      break;
+  }
+  new_bhead->data_prepared = temp;
+
+  MEM_SAFE_FREE(src_copy);
+}
+
+/**
+ * Index all blocks of the file, then read and reconstruct the data of all #DATA blocks on
+ * multiple threads. #read_struct takes the results when the IDs are read, the direct linking
+ * itself remains single threaded (it uses #FileData.datamap and modifies #Main).
+ *
+ * Only done when the data can be accessed without #FileData.read, which is not thread-safe
+ * (memory mapped files or data that is already in memory).
+ */
+static void read_data_prepare_parallel(FileData *fd)
+{
+  if (fd->flags & FD_FLAGS_SWITCH_ENDIAN) {
+    /* Switching endian modifies the data in place, keep it simple. */
+    return;
+  }
+
+  BHead **bheads = NULL;
+  const char **allocnames = NULL;
+  int bheads_len = 0, bheads_len_alloc = 0;
+  const char *allocname = NULL;
+
+  for (BHead *bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
+    if (bhead->code == ENDB) {
+      break;
+    }
+    if (bhead->code != DATA) {
+      /* Use the same names as #read_libblock, for memory debugging. */
+      allocname = dataname(bhead->code);
+      continue;
+    }
+    if (bhead->len == 0) {
+      continue;
+    }
+#  ifdef USE_BHEAD_READ_ON_DEMAND
+    if ((BHEADN_FROM_BHEAD(bhead)->has_data == false) && (fd->mmap_file == NULL)) {
+      /* Can't access this data from multiple threads. */
+      bheads_len = 0;
+      break;
+    }
+#  endif
+    if (bheads_len == bheads_len_alloc) {
+      bheads_len_alloc = max_ii(bheads_len_alloc * 2, 1024);
+      bheads = MEM_reallocN_id(bheads, sizeof(*bheads) * (size_t)bheads_len_alloc, __func__);
+      allocnames = MEM_reallocN_id(
+          allocnames, sizeof(*allocnames) * (size_t)bheads_len_alloc, __func__);
+    }
+    bheads[bheads_len] = bhead;
+    allocnames[bheads_len] = allocname;
+    bheads_len++;
+  }
+
+  if (bheads_len != 0) {
+    DataPrepareData data = {
+        .fd = fd,
+        .bheads = bheads,
+        .allocnames = allocnames,
+    };
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = 16;
+    BLI_task_parallel_range(0, bheads_len, &data, read_data_prepare_cb, &settings);
+
+    if (fd->mmap_file && BLI_mmap_any_io_error(fd->mmap_file)) {
+      fd->flags &= ~FD_FLAGS_FILE_OK;
+    }
+  }
+
+  MEM_SAFE_FREE(bheads);
+  MEM_SAFE_FREE(allocnames);
+}
+
+#endif /* USE_PARALLEL_DATA_READ */
+
 /* Like read_struct, but gets a pointer without allocating. Only works for
  * undo since DNA must match. */
 static const void *peek_struct_undo(FileData *fd, BHead *bhead)
@@ -2155,7 +2541,7 @@ static void link_glob_list(FileData *fd, ListBase *lb) /* for glob data */
   }
   poin = newdataadr(fd, lb->first);
   if (lb->first) {
-    oldnewmap_insert(fd->globmap, lb->first, poin, 0);
+    blo_oldnewmap_insert(fd->globmap, lb->first, poin, 0);
   }
   lb->first = poin;
 
@@ -2164,7 +2550,7 @@ static void link_glob_list(FileData *fd, ListBase *lb) /* for glob data */
   while (ln) {
     poin = newdataadr(fd, ln->next);
     if (ln->next) {
-      oldnewmap_insert(fd->globmap, ln->next, poin, 0);
+      blo_oldnewmap_insert(fd->globmap, ln->next, poin, 0);
     }
     ln->next = poin;
     ln->prev = prev;
@@ -3251,7 +3637,7 @@ static BHead *read_data_into_datamap(FileData *fd, BHead *bhead, const char *all
 
     void *data = read_struct(fd, bhead, allocname);
     if (data) {
-      oldnewmap_insert(fd->datamap, bhead->old, data, 0);
+      blo_oldnewmap_insert(fd->datamap, bhead->old, data, 0);
     }
 
     bhead = blo_bhead_next(fd, bhead);
@@ -3333,7 +3719,7 @@ static bool read_libblock_undo_restore_linked(FileData *fd, Main *main, const ID
     /* Even though we found our linked ID, there is no guarantee its address
      * is still the same. */
     if (id_old != bhead->old) {
-      oldnewmap_insert(fd->libmap, bhead->old, id_old, GS(id_old->name));
+      blo_oldnewmap_insert(fd->libmap, bhead->old, id_old, GS(id_old->name));
     }
 
     /* No need to do anything else for ID_LINK_PLACEHOLDER, it's assumed
@@ -3479,7 +3865,7 @@ static bool read_libblock_undo_restore(
     /* Insert into library map for lookup by newly read datablocks (with pointer value bhead->old).
      * Note that existing datablocks in memory (which pointer value would be id_old) are not
      * remapped anymore, so no need to store this info here. */
-    oldnewmap_insert(fd->libmap, bhead->old, id_old, bhead->code);
+    blo_oldnewmap_insert(fd->libmap, bhead->old, id_old, bhead->code);
 
     *r_id_old = id_old;
     return true;
@@ -3553,7 +3939,7 @@ static BHead *read_libblock(FileData *fd,
    * Note that existing datablocks in memory (which pointer value would be id_old) are not remapped
    * remapped anymore, so no need to store this info here. */
   ID *id_target = id_old ? id_old : id;
-  oldnewmap_insert(fd->libmap, bhead->old, id_target, bhead->code);
+  blo_oldnewmap_insert(fd->libmap, bhead->old, id_target, bhead->code);
 
   if (r_id) {
     *r_id = id_target;
@@ -3585,7 +3971,7 @@ static BHead *read_libblock(FileData *fd,
   const char *allocname = dataname(idcode);
   bhead = read_data_into_datamap(fd, bhead, allocname);
   const bool success = direct_link_id(fd, main, id_tag, id, id_old);
-  oldnewmap_clear(fd->datamap);
+  blo_oldnewmap_clear(fd->datamap);
 
   if (!success) {
     /* XXX This is probably working OK currently given the very limited scope of that flag.
@@ -3925,7 +4311,7 @@ static BHead *read_userdef(BlendFileData *bfd, FileData *fd, BHead *bhead)
   user->edit_studio_light = 0;
 
   /* free fd->datamap again */
-  oldnewmap_clear(fd->datamap);
+  blo_oldnewmap_clear(fd->datamap);
 
   return bhead;
 }
@@ -3981,6 +4367,13 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
     }
   }
 
+#ifdef USE_PARALLEL_DATA_READ
+  /* Undo only reads changed data, skip it there. */
+  if ((fd->memfile == NULL) && (fd->skip_flags & BLO_READ_SKIP_DATA) == 0) {
+    read_data_prepare_parallel(fd);
+  }
+#endif
+
   while (bhead) {
     switch (bhead->code) {
       case DATA:
@@ -4314,7 +4707,7 @@ static void expand_doit_library(void *fdhandle, Main *mainvar, void *old)
        * (B) forest.blend: contains Forest collection linking in Tree from tree.blend.
        * (C) shot.blend: links in both Tree from tree.blend and Forest from forest.blend.
        */
-      oldnewmap_insert(fd->libmap, bhead->old, id, bhead->code);
+      blo_oldnewmap_insert(fd->libmap, bhead->old, id, bhead->code);
 
       /* If "id" is a real data-lock and not a placeholder, we need to
        * update fd->libmap to replace ID_LINK_PLACEHOLDER with the real
@@ -4356,7 +4749,7 @@ static void expand_doit_library(void *fdhandle, Main *mainvar, void *old)
       /* this is actually only needed on UI call? when ID was already read before,
        * and another append happens which invokes same ID...
        * in that case the lookup table needs this entry */
-      oldnewmap_insert(fd->libmap, bhead->old, id, bhead->code);
+      blo_oldnewmap_insert(fd->libmap, bhead->old, id, bhead->code);
       /* commented because this can print way too much */
       // if (G.debug & G_DEBUG) printf("expand: already read %s\n", id->name);
     }
@@ -4732,7 +5125,7 @@ static ID *link_named_part(
       if (G.debug) {
         printf("append: already linked\n");
       }
-      oldnewmap_insert(fd->libmap, bhead->old, id, bhead->code);
+      blo_oldnewmap_insert(fd->libmap, bhead->old, id, bhead->code);
       if (!force_indirect && (id->tag & LIB_TAG_INDIRECT)) {
         id->tag &= ~LIB_TAG_INDIRECT;
         id->flag &= ~LIB_INDIRECT_WEAK_LINK;
@@ -5278,10 +5671,10 @@ static FileData *read_library_file_data(FileData *basefd,
     fd->reports = basefd->reports;
 
     if (fd->libmap) {
-      oldnewmap_free(fd->libmap);
+      blo_oldnewmap_free(fd->libmap);
     }
 
-    fd->libmap = oldnewmap_new();
+    fd->libmap = blo_oldnewmap_new();
 
     mainptr->curlib->filedata = fd;
     mainptr->versionfile = fd->fileversion;
@@ -5575,7 +5968,7 @@ bool BLO_read_data_is_undo(BlendDataReader *reader)
 
 void BLO_read_data_globmap_add(BlendDataReader *reader, void *oldaddr, void *newaddr)
 {
-  oldnewmap_insert(reader->fd->globmap, oldaddr, newaddr, 0);
+  blo_oldnewmap_insert(reader->fd->globmap, oldaddr, newaddr, 0);
 }
 
 void BLO_read_glob_list(BlendDataReader *reader, ListBase *list)
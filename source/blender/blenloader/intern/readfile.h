@@ -33,6 +33,11 @@
 #include "DNA_windowmanager_types.h" /* for ReportType */
 #include "zlib.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct BLI_mmap_file;
 struct BLOCacheStorage;
 struct GSet;
 struct IDNameLib_Map;
@@ -46,6 +51,7 @@ struct UserDef;
 struct View3D;
 
 typedef struct IDNameLib_Map IDNameLib_Map;
+typedef struct OldNewMap OldNewMap;
 
 enum eFileDataFlag {
   FD_FLAGS_SWITCH_ENDIAN = 1 << 0,
@@ -72,6 +78,47 @@ typedef ssize_t(FileDataReadFn)(struct FileData *filedata,
                                 bool *r_is_memchunk_identical);
 typedef off64_t(FileDataSeekFn)(struct FileData *filedata, off64_t offset, int whence);
 
+/**
+ * Seekable GZip, see "Compression" in `writefile.c`.
+ *
+ * Compressed files are written as a sequence of independent gzip members ("frames") that each
+ * hold #BLO_GZIP_FRAME_SIZE bytes of uncompressed data (the last may hold less),
+ * followed by an empty gzip member which stores the seek table in its header's extra field.
+ */
+#define BLO_GZIP_FRAME_SIZE (1 << 20)
+/** Extra field sub-field identifier of the seek table. */
+#define BLO_GZIP_SEEK_SI1 'B'
+#define BLO_GZIP_SEEK_SI2 'S'
+/** Stored at the very end of the seek table data. */
+#define BLO_GZIP_SEEK_MAGIC "BLZS"
+/** Size of the seek table data for `frames_num` frames, without gzip header and trailer. */
+#define BLO_GZIP_SEEK_DATA_SIZE(frames_num) (16 + 4 * (size_t)(frames_num))
+/** The extra field length is stored as 16 bits, which limits the number of frames. */
+#define BLO_GZIP_SEEK_FRAMES_MAX ((0xffff - 4 - 16) / 4)
+/** Gzip header (10 bytes), extra field length (2 bytes), sub-field identifier #BLO_GZIP_SEEK_SI1
+ * & #BLO_GZIP_SEEK_SI2 (2 bytes) and sub-field length (2 bytes) before the data. */
+#define BLO_GZIP_SEEK_HEADER_SIZE 16
+/** Empty final deflate block (2 bytes), CRC32 and uncompressed size (both zero). */
+#define BLO_GZIP_SEEK_TRAILER_SIZE 10
+
+/** Random access into gzip files that contain a seek table. */
+typedef struct GzipSeekData {
+  /** Uncompressed size of each frame, except for the last one. */
+  uint32_t frame_size;
+  /** Uncompressed size of the last frame. */
+  uint32_t frame_last_size;
+  int frames_num;
+  /** Offset of each frame in the file, with an additional element for the end of the data. */
+  off64_t *frame_offsets;
+
+  /** The frame stored (decompressed) in #frame_buf, -1 when none. */
+  int frame_cached;
+  char *frame_buf;
+  /** Compressed data of the frame being decompressed. */
+  char *in_buf;
+  size_t in_buf_len;
+} GzipSeekData;
+
 typedef struct FileData {
   /** Linked list of BHeadN's. */
   ListBase bhead_list;
@@ -85,6 +132,8 @@ typedef struct FileData {
 
   /** Regular file reading. */
   int filedes;
+  /** Memory mapped regular file reading (uses #FileData.filedes), NULL otherwise. */
+  struct BLI_mmap_file *mmap_file;
 
   /** Variables needed for reading from memory / stream. */
   const char *buffer;
@@ -96,6 +145,8 @@ typedef struct FileData {
 
   /** Variables needed for reading from file. */
   gzFile gzfiledes;
+  /** Seekable gzip file reading (uses #FileData.filedes), NULL otherwise. */
+  GzipSeekData *gzip_seek;
   /** Gzip stream for memory decompression. */
   z_stream strm;
 
@@ -175,6 +226,25 @@ const char *blo_bhead_id_name(const FileData *fd, const BHead *bhead);
 
 void blo_do_versions_dna(struct SDNA *sdna, const int versionfile, const int subversionfile);
 
+/* Old/new pointer map, see `readfile_oldnewmap.cc`. */
+
+typedef struct OldNewMapEntry {
+  void *newp;
+  /** `nr` is "user count" for data, and ID code for libdata. */
+  int nr;
+} OldNewMapEntry;
+
+typedef void (*OldNewMapForeachFn)(OldNewMapEntry *entry, void *user_data);
+
+struct OldNewMap *blo_oldnewmap_new(void);
+void blo_oldnewmap_insert(struct OldNewMap *onm, const void *oldaddr, void *newaddr, int nr);
+void *blo_oldnewmap_lookup_and_inc(struct OldNewMap *onm, const void *addr, bool increase_users);
+void blo_oldnewmap_foreach(struct OldNewMap *onm, OldNewMapForeachFn func, void *user_data);
+/** Free data that has no users and empty the map. */
+void blo_oldnewmap_clear(struct OldNewMap *onm);
+void blo_oldnewmap_print_stats(struct OldNewMap *onm, const char *name);
+void blo_oldnewmap_free(struct OldNewMap *onm);
+
 void blo_do_versions_oldnewmap_insert(struct OldNewMap *onm,
                                       const void *oldaddr,
                                       void *newaddr,
@@ -205,3 +275,7 @@ void do_versions_after_linking_cycles(struct Main *bmain);
 /* This is rather unfortunate to have to expose this here, but better use that nasty hack in
  * do_version than readfile itself. */
 void *blo_read_get_new_globaldata_address(struct FileData *fd, const void *adr);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,145 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup blenloader
+ *
+ * Maps addresses stored in the file (at the time of writing) to the newly read data.
+ *
+ * Once a map has been filled, lookups don't modify the map itself (user counts are incremented
+ * atomically), so multiple threads can look up addresses at the same time.
+ * Inserting and clearing must not happen concurrently with anything else.
+ */
+
+#include <algorithm>
+#include <cstdio>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_map.hh"
+#include "BLI_utildefines.h"
+
+#include "BKE_global.h"
+
+#include "BLO_readfile.h"
+
+#include "atomic_ops.h"
+
+#include "readfile.h"
+
+using blender::Map;
+
+struct OldNewMap {
+  Map<const void *, OldNewMapEntry> map;
+
+  /* Statistics for `--debug-io`, gathered before the map is cleared. */
+  int64_t insert_num = 0;
+  int64_t size_max = 0;
+  double load_factor_max = 0.0;
+  int64_t collisions_num = 0;
+  int64_t collisions_keys_num = 0;
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("OldNewMap")
+};
+
+static void oldnewmap_stats_update(OldNewMap *onm)
+{
+  const int64_t size = onm->map.size();
+  if (size == 0) {
+    return;
+  }
+  onm->size_max = std::max(onm->size_max, size);
+  onm->load_factor_max = std::max(onm->load_factor_max,
+                                  (double)size / (double)onm->map.capacity());
+  for (const void *key : onm->map.keys()) {
+    onm->collisions_num += onm->map.count_collisions(key);
+  }
+  onm->collisions_keys_num += size;
+}
+
+OldNewMap *blo_oldnewmap_new(void)
+{
+  return new OldNewMap();
+}
+
+void blo_oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr, int nr)
+{
+  if (oldaddr == nullptr || newaddr == nullptr) {
+    return;
+  }
+  onm->map.add_overwrite(oldaddr, {newaddr, nr});
+  onm->insert_num++;
+}
+
+void *blo_oldnewmap_lookup_and_inc(OldNewMap *onm, const void *addr, bool increase_users)
+{
+  OldNewMapEntry *entry = onm->map.lookup_ptr(addr);
+  if (entry == nullptr) {
+    return nullptr;
+  }
+  if (increase_users) {
+    atomic_add_and_fetch_int32(&entry->nr, 1);
+  }
+  return entry->newp;
+}
+
+void blo_oldnewmap_foreach(OldNewMap *onm, OldNewMapForeachFn func, void *user_data)
+{
+  for (OldNewMapEntry &entry : onm->map.values()) {
+    func(&entry, user_data);
+  }
+}
+
+void blo_oldnewmap_clear(OldNewMap *onm)
+{
+  if (G.debug & G_DEBUG_IO) {
+    oldnewmap_stats_update(onm);
+  }
+
+  /* Free unused data. */
+  for (OldNewMapEntry &entry : onm->map.values()) {
+    if (entry.nr == 0) {
+      MEM_freeN(entry.newp);
+      entry.newp = nullptr;
+    }
+  }
+
+  /* Go back to the default size, the next ID may need a lot less memory. */
+  onm->map.clear();
+}
+
+void blo_oldnewmap_print_stats(OldNewMap *onm, const char *name)
+{
+  oldnewmap_stats_update(onm);
+  if (onm->insert_num == 0) {
+    return;
+  }
+  printf("OldNewMap '%s': %lld inserts, peak size %lld, peak load factor %.3f",
+         name,
+         (long long)onm->insert_num,
+         (long long)onm->size_max,
+         onm->load_factor_max);
+  if (onm->collisions_keys_num != 0) {
+    printf(", average collisions per lookup %.3f",
+           (double)onm->collisions_num / (double)onm->collisions_keys_num);
+  }
+  printf("\n");
+}
+
+void blo_oldnewmap_free(OldNewMap *onm)
+{
+  delete onm;
+}
@@ -42,6 +42,7 @@
 
 #include "BLI_blenlib.h"
 #include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
 
 #include "BLO_readfile.h"
 #include "BLO_undofile.h"
@@ -54,18 +55,26 @@
 
 /* **************** support for memory-write, for undo buffers *************** */
 
+/** Whether the chunk owns its buffer, or shares it with another chunk. */
+static bool memfile_chunk_owns_buf(const MemFileChunk *chunk)
+{
+  return !(chunk->is_identical || chunk->is_shared);
+}
+
 /* not memfile itself */
 void BLO_memfile_free(MemFile *memfile)
 {
   MemFileChunk *chunk;
 
   while ((chunk = BLI_pophead(&memfile->chunks))) {
-    if (chunk->is_identical == false) {
+    if (memfile_chunk_owns_buf(chunk)) {
       MEM_freeN((void *)chunk->buf);
     }
     MEM_freeN(chunk);
   }
   memfile->size = 0;
+  memfile->size_total = 0;
+  memfile->size_shared_by_content = 0;
 }
 
 /* to keep list of memfiles consistent, 'first' is always first in list */
@@ -77,21 +86,30 @@ void BLO_memfile_merge(MemFile *first, MemFile *second)
   GHash *buffer_to_second_memchunk = BLI_ghash_new(
       BLI_ghashutil_ptrhash, BLI_ghashutil_ptrcmp, __func__);
 
-  /* First, detect all memchunks in second memfile that are not owned by it. */
+  /* First, detect all memchunks in second memfile that are not owned by it. Several of them may
+   * share the same buffer (when de-duplicated by content), only one needs to take ownership. */
   for (MemFileChunk *sc = second->chunks.first; sc != NULL; sc = sc->next) {
-    if (sc->is_identical) {
-      BLI_ghash_insert(buffer_to_second_memchunk, (void *)sc->buf, sc);
+    if (!memfile_chunk_owns_buf(sc)) {
+      void **entry;
+      if (!BLI_ghash_ensure_p(buffer_to_second_memchunk, (void *)sc->buf, &entry)) {
+        *entry = sc;
+      }
     }
   }
 
   /* Now, check all chunks from first memfile (the one we are removing), and if a memchunk owned by
    * it is also used by the second memfile, transfer the ownership. */
   for (MemFileChunk *fc = first->chunks.first; fc != NULL; fc = fc->next) {
-    if (!fc->is_identical) {
+    if (memfile_chunk_owns_buf(fc)) {
       MemFileChunk *sc = BLI_ghash_lookup(buffer_to_second_memchunk, fc->buf);
       if (sc != NULL) {
-        BLI_assert(sc->is_identical);
+        BLI_assert(!memfile_chunk_owns_buf(sc));
+        if (sc->is_shared) {
+          second->size_shared_by_content -= sc->size;
+        }
         sc->is_identical = false;
+        sc->is_shared = false;
+        second->size += sc->size;
         fc->is_identical = true;
       }
       /* Note that if the second memfile does not use that chunk, we assume that the first one
@@ -113,6 +131,20 @@ void BLO_memfile_clear_future(MemFile *memfile)
   }
 }
 
+static uint memfile_chunk_content_hash(const void *key)
+{
+  const MemFileChunk *chunk = key;
+  return chunk->hash;
+}
+
+static bool memfile_chunk_content_cmp(const void *a, const void *b)
+{
+  const MemFileChunk *chunk_a = a;
+  const MemFileChunk *chunk_b = b;
+  return !((chunk_a->hash == chunk_b->hash) && (chunk_a->size == chunk_b->size) &&
+           (memcmp(chunk_a->buf, chunk_b->buf, chunk_a->size) == 0));
+}
+
 void BLO_memfile_write_init(MemFileWriteData *mem_data,
                             MemFile *written_memfile,
                             MemFile *reference_memfile)
@@ -121,6 +153,18 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
   mem_data->reference_memfile = reference_memfile;
   mem_data->reference_current_chunk = reference_memfile ? reference_memfile->chunks.first : NULL;
 
+  /* Index all chunks of the reference memfile by content, so that data which moved (e.g. an ID
+   * that was duplicated, or a data-block that got a new array inserted before existing ones) can
+   * still be shared with the previous undo step. Chunks of the written memfile are added as they
+   * are written. */
+  mem_data->content_chunks = BLI_gset_new(
+      memfile_chunk_content_hash, memfile_chunk_content_cmp, __func__);
+  if (reference_memfile != NULL) {
+    LISTBASE_FOREACH (MemFileChunk *, mem_chunk, &reference_memfile->chunks) {
+      BLI_gset_add(mem_data->content_chunks, mem_chunk);
+    }
+  }
+
   /* If we have a reference memfile, we generate a mapping between the session_uuid's of the
    * IDs stored in that previous undo step, and its first matching memchunk. This will allow
    * us to easily find the existing undo memory storage of IDs even when some re-ordering in
@@ -152,6 +196,7 @@ void BLO_memfile_write_finalize(MemFileWriteData *mem_data)
   if (mem_data->id_session_uuid_mapping != NULL) {
     BLI_ghash_free(mem_data->id_session_uuid_mapping, NULL, NULL);
   }
+  BLI_gset_free(mem_data->content_chunks, NULL);
 }
 
 void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t size)
@@ -163,6 +208,7 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
   curchunk->size = size;
   curchunk->buf = NULL;
   curchunk->is_identical = false;
+  curchunk->is_shared = false;
   /* This is unsafe in the sense that an app handler or other code that does not
    * perform an undo push may make changes after the last undo push that
    * will then not be undo. Though it's not entirely clear that is wrong behavior. */
@@ -176,6 +222,7 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
     if (compchunk->size == curchunk->size) {
       if (memcmp(compchunk->buf, buf, size) == 0) {
         curchunk->buf = compchunk->buf;
+        curchunk->hash = compchunk->hash;
         curchunk->is_identical = true;
         compchunk->is_identical_future = true;
       }
@@ -183,13 +230,27 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
     *compchunk_step = compchunk->next;
   }
 
-  /* not equal... */
+  /* Not equal to the matching chunk of the previous step, look for the same content anywhere in
+   * the previous step or in what was written so far. */
   if (curchunk->buf == NULL) {
-    char *buf_new = MEM_mallocN(size, "Chunk buffer");
-    memcpy(buf_new, buf, size);
-    curchunk->buf = buf_new;
-    memfile->size += size;
+    curchunk->buf = buf;
+    curchunk->hash = BLI_hash_mm2((const unsigned char *)buf, size, 0);
+    void **entry;
+    if (BLI_gset_ensure_p_ex(mem_data->content_chunks, curchunk, &entry)) {
+      const MemFileChunk *chunk_shared = *entry;
+      curchunk->buf = chunk_shared->buf;
+      curchunk->is_shared = true;
+      memfile->size_shared_by_content += size;
+    }
+    else {
+      char *buf_new = MEM_mallocN(size, "Chunk buffer");
+      memcpy(buf_new, buf, size);
+      curchunk->buf = buf_new;
+      memfile->size += size;
+      *entry = curchunk;
+    }
   }
+  memfile->size_total += size;
 }
 
 struct Main *BLO_memfile_main_get(struct MemFile *memfile,
@@ -70,6 +70,21 @@
  * - write #GLOB (#FileGlobal struct) (some global vars).
  * - write #DNA1 (#SDNA struct)
  * - write #USER (#UserDef struct) if filename is ``~/.config/blender/X.XX/config/startup.blend``.
+ *
+ * COMPRESSION
+ * ===========
+ *
+ * Compressed files (#G_FILE_COMPRESS) are gzip files made of multiple members,
+ * so they can still be read by any gzip reader.
+ *
+ * - The data is split into frames of #BLO_GZIP_FRAME_SIZE bytes,
+ *   each frame is compressed on a worker thread into a separate gzip member.
+ * - An empty gzip member follows, its header's extra field holds the seek table:
+ *   frame size, last frame size, compressed size of each frame,
+ *   number of frames and #BLO_GZIP_SEEK_MAGIC (all `uint32` little endian).
+ *
+ * The seek table allows the reader to decompress only the frames that are needed,
+ * see #GzipSeekData.
  */
 
 #include <fcntl.h>
@@ -99,7 +114,9 @@
 
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
+#include "BLI_math_base.h"
 #include "BLI_mempool.h"
+#include "BLI_threads.h"
 #include "MEM_guardedalloc.h" /* MEM_freeN */
 
 #include "BKE_blender_version.h"
@@ -161,7 +178,7 @@ struct WriteWrap {
   /* internal */
   union {
     int file_handle;
-    gzFile gz_handle;
+    struct GzipWriteData *gzip;
   } _user_data;
 };
 
@@ -191,31 +208,243 @@ static size_t ww_write_none(WriteWrap *ww, const char *buf, size_t buf_len)
 }
 #undef FILE_HANDLE
 
-/* zlib */
-#define FILE_HANDLE(ww) (ww)->_user_data.gz_handle
+/* zlib (multi-threaded, seekable) */
+#define GZIP_HANDLE(ww) (ww)->_user_data.gzip
 
-static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
+typedef struct GzipWriteTask {
+  struct GzipWriteTask *next, *prev;
+  WriteWrap *ww;
+  /** Uncompressed frame data, owned by the task. */
+  void *data;
+  size_t data_len;
+  int frame_index;
+} GzipWriteTask;
+
+typedef struct GzipWriteData {
+  int file_handle;
+
+  /** Worker threads, each compresses a single frame. */
+  ListBase threadpool;
+  /** Tasks passed to #GzipWriteData.threadpool, in frame order (only accessed by the caller). */
+  ListBase tasks;
+
+  /** Serializes writing frames to the file in order. */
+  ThreadMutex mutex;
+  ThreadCondition condition;
+  /** Frame that may be written next. */
+  int frame_write_next;
+  /** Compressed size of every frame written so far (for the seek table). */
+  uint32_t *frame_sizes;
+  int frame_sizes_len_alloc;
+  /** Uncompressed size of the last frame written. */
+  uint32_t frame_last_size;
+  bool write_error;
+
+  /** Number of frames passed to the thread-pool. */
+  int frames_num;
+  /** Uncompressed data collected for the next frame. */
+  char *buf;
+  size_t buf_used_len;
+} GzipWriteData;
+
+static void *ww_zlib_compress_frame(void *task_v)
 {
-  gzFile file;
+  GzipWriteTask *task = task_v;
+  GzipWriteData *gz = GZIP_HANDLE(task->ww);
+
+  /* Every frame is a complete gzip member, so the result can be read as a regular gzip file. */
+  z_stream strm = {NULL};
+  void *out_buf = NULL;
+  size_t out_len = 0;
+  bool ok = false;
+  if (deflateInit2(&strm, 1, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK) {
+    const size_t out_len_max = deflateBound(&strm, (uLong)task->data_len);
+    out_buf = MEM_mallocN(out_len_max, __func__);
+    strm.next_in = task->data;
+    strm.avail_in = (uInt)task->data_len;
+    strm.next_out = out_buf;
+    strm.avail_out = (uInt)out_len_max;
+    ok = (deflate(&strm, Z_FINISH) == Z_STREAM_END);
+    out_len = strm.total_out;
+    deflateEnd(&strm);
+  }
+  MEM_freeN(task->data);
+  task->data = NULL;
+
+  BLI_mutex_lock(&gz->mutex);
+  while (gz->frame_write_next != task->frame_index) {
+    BLI_condition_wait(&gz->condition, &gz->mutex);
+  }
+  if (ok && !gz->write_error &&
+      (write(gz->file_handle, out_buf, out_len) == (ssize_t)out_len)) {
+    if (task->frame_index >= gz->frame_sizes_len_alloc) {
+      gz->frame_sizes_len_alloc = max_ii(gz->frame_sizes_len_alloc * 2, 256);
+      gz->frame_sizes = MEM_reallocN(gz->frame_sizes,
+                                     sizeof(*gz->frame_sizes) * gz->frame_sizes_len_alloc);
+    }
+    gz->frame_sizes[task->frame_index] = (uint32_t)out_len;
+    gz->frame_last_size = (uint32_t)task->data_len;
+  }
+  else {
+    gz->write_error = true;
+  }
+  gz->frame_write_next++;
+  BLI_condition_notify_all(&gz->condition);
+  BLI_mutex_unlock(&gz->mutex);
 
-  file = BLI_gzopen(filepath, "wb1");
+  if (out_buf) {
+    MEM_freeN(out_buf);
+  }
+  return NULL;
+}
 
-  if (file != Z_NULL) {
-    FILE_HANDLE(ww) = file;
-    return true;
+/** Pass the collected data to a worker thread, waiting for the oldest frame when all are busy. */
+static void ww_zlib_frame_dispatch(WriteWrap *ww)
+{
+  GzipWriteData *gz = GZIP_HANDLE(ww);
+  if (gz->buf_used_len == 0) {
+    return;
   }
 
-  return false;
+  GzipWriteTask *task = MEM_mallocN(sizeof(*task), __func__);
+  task->ww = ww;
+  task->data = gz->buf;
+  task->data_len = gz->buf_used_len;
+  task->frame_index = gz->frames_num++;
+
+  gz->buf = MEM_mallocN(BLO_GZIP_FRAME_SIZE, __func__);
+  gz->buf_used_len = 0;
+
+  if (BLI_available_threads(&gz->threadpool) == 0) {
+    /* Frames are written in order, so the oldest one is the first to finish. */
+    GzipWriteTask *task_first = gz->tasks.first;
+    BLI_threadpool_remove(&gz->threadpool, task_first);
+    BLI_remlink(&gz->tasks, task_first);
+    MEM_freeN(task_first);
+  }
+  BLI_addtail(&gz->tasks, task);
+  BLI_threadpool_insert(&gz->threadpool, task);
+}
+
+static void ww_zlib_encode_u32(uchar *buf, const uint32_t value)
+{
+  buf[0] = (uchar)(value & 0xff);
+  buf[1] = (uchar)((value >> 8) & 0xff);
+  buf[2] = (uchar)((value >> 16) & 0xff);
+  buf[3] = (uchar)((value >> 24) & 0xff);
+}
+
+/**
+ * Write the seek table as an empty gzip member, stored in its header's extra field,
+ * so regular gzip readers skip it.
+ */
+static bool ww_zlib_write_seek_table(GzipWriteData *gz)
+{
+  const size_t data_len = BLO_GZIP_SEEK_DATA_SIZE(gz->frames_num);
+  const size_t member_len = BLO_GZIP_SEEK_HEADER_SIZE + data_len + BLO_GZIP_SEEK_TRAILER_SIZE;
+  uchar *member = MEM_callocN(member_len, __func__);
+
+  uchar *p = member;
+  /* Magic, deflate, #FEXTRA flag, zero time-stamp, no extra flags, unknown OS. */
+  const uchar header[10] = {0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff};
+  memcpy(p, header, sizeof(header));
+  p += sizeof(header);
+  p[0] = (uchar)((data_len + 4) & 0xff);
+  p[1] = (uchar)((data_len + 4) >> 8);
+  p[2] = BLO_GZIP_SEEK_SI1;
+  p[3] = BLO_GZIP_SEEK_SI2;
+  p[4] = (uchar)(data_len & 0xff);
+  p[5] = (uchar)(data_len >> 8);
+  p += 6;
+
+  ww_zlib_encode_u32(p, BLO_GZIP_FRAME_SIZE);
+  ww_zlib_encode_u32(p + 4, gz->frame_last_size);
+  p += 8;
+  for (int i = 0; i < gz->frames_num; i++, p += 4) {
+    ww_zlib_encode_u32(p, gz->frame_sizes[i]);
+  }
+  ww_zlib_encode_u32(p, (uint32_t)gz->frames_num);
+  memcpy(p + 4, BLO_GZIP_SEEK_MAGIC, 4);
+  p += 8;
+
+  /* Empty final block, the CRC32 and size (all zero) follow. */
+  p[0] = 0x03;
+
+  const bool ok = (write(gz->file_handle, member, member_len) == (ssize_t)member_len);
+  MEM_freeN(member);
+  return ok;
+}
+
+static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
+{
+  const int file = BLI_open(filepath, O_BINARY + O_WRONLY + O_CREAT + O_TRUNC, 0666);
+  if (file == -1) {
+    return false;
+  }
+
+  GzipWriteData *gz = MEM_callocN(sizeof(*gz), __func__);
+  gz->file_handle = file;
+  gz->buf = MEM_mallocN(BLO_GZIP_FRAME_SIZE, __func__);
+  BLI_mutex_init(&gz->mutex);
+  BLI_condition_init(&gz->condition);
+  /* Leave one thread for the caller, which generates the data to compress. */
+  BLI_threadpool_init(
+      &gz->threadpool, ww_zlib_compress_frame, max_ii(1, BLI_system_thread_count() - 1));
+
+  GZIP_HANDLE(ww) = gz;
+  return true;
 }
 static bool ww_close_zlib(WriteWrap *ww)
 {
-  return (gzclose(FILE_HANDLE(ww)) == Z_OK);
+  GzipWriteData *gz = GZIP_HANDLE(ww);
+
+  ww_zlib_frame_dispatch(ww);
+  BLI_threadpool_end(&gz->threadpool);
+  BLI_freelistN(&gz->tasks);
+
+  bool ok = !gz->write_error;
+  /* Files with too many frames remain valid, they just can't be accessed randomly. */
+  if (ok && (gz->frames_num != 0) && (gz->frames_num <= BLO_GZIP_SEEK_FRAMES_MAX)) {
+    ok = ww_zlib_write_seek_table(gz);
+  }
+  if (close(gz->file_handle) == -1) {
+    ok = false;
+  }
+
+  BLI_mutex_end(&gz->mutex);
+  BLI_condition_end(&gz->condition);
+  MEM_SAFE_FREE(gz->frame_sizes);
+  MEM_freeN(gz->buf);
+  MEM_freeN(gz);
+  GZIP_HANDLE(ww) = NULL;
+
+  return ok;
 }
 static size_t ww_write_zlib(WriteWrap *ww, const char *buf, size_t buf_len)
 {
-  return gzwrite(FILE_HANDLE(ww), buf, buf_len);
+  GzipWriteData *gz = GZIP_HANDLE(ww);
+  size_t len_remaining = buf_len;
+
+  while (len_remaining != 0) {
+    const size_t len = MIN2(len_remaining, BLO_GZIP_FRAME_SIZE - gz->buf_used_len);
+    memcpy(&gz->buf[gz->buf_used_len], buf, len);
+    gz->buf_used_len += len;
+    buf += len;
+    len_remaining -= len;
+
+    if (gz->buf_used_len == BLO_GZIP_FRAME_SIZE) {
+      ww_zlib_frame_dispatch(ww);
+    }
+  }
+
+  /* Errors are detected asynchronously, report them on the next write. */
+  BLI_mutex_lock(&gz->mutex);
+  const bool write_error = gz->write_error;
+  BLI_mutex_unlock(&gz->mutex);
+
+  return write_error ? 0 : buf_len;
 }
-#undef FILE_HANDLE
+#undef GZIP_HANDLE
 
 /* --- end compression types --- */
 
@@ -0,0 +1,164 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "blendfile_loading_base_test.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_appdir.h"
+#include "BKE_customdata.h"
+#include "BKE_global.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+
+#include "BLI_fileops.h"
+#include "BLI_path_util.h"
+
+#include "BLO_readfile.h"
+#include "BLO_writefile.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "../intern/readfile.h"
+
+class BlendfileCompressionTest : public BlendfileLoadingBaseTest {
+};
+
+/* Enough vertices for the mesh to be split over multiple compressed frames. */
+static const int compression_test_verts_num = 200000;
+
+static void compression_test_filepath(char filepath[FILE_MAX])
+{
+  BKE_tempdir_init(nullptr);
+  BLI_join_dirfile(filepath, FILE_MAX, BKE_tempdir_base(), "compression_test.blend");
+}
+
+static bool compression_test_write(const char *filepath, const int write_flags)
+{
+  Main *bmain = BKE_main_new();
+  Mesh *mesh = BKE_mesh_add(bmain, "CompressionTest");
+  mesh->totvert = compression_test_verts_num;
+  CustomData_add_layer(&mesh->vdata, CD_MVERT, CD_CALLOC, nullptr, mesh->totvert);
+  BKE_mesh_update_customdata_pointers(mesh, false);
+  for (int i = 0; i < mesh->totvert; i++) {
+    mesh->mvert[i].co[0] = (float)i;
+    mesh->mvert[i].co[1] = (float)(i % 7);
+    mesh->mvert[i].co[2] = -(float)i;
+  }
+
+  BlendFileWriteParams params = {BLO_WRITE_PATH_REMAP_NONE};
+  const bool ok = BLO_write_file(bmain, filepath, write_flags, &params, nullptr);
+  BKE_main_free(bmain);
+  return ok;
+}
+
+static void compression_test_check(BlendFileData *bfd)
+{
+  ASSERT_NE(bfd, nullptr);
+
+  Mesh *mesh = static_cast<Mesh *>(bfd->main->meshes.first);
+  ASSERT_NE(mesh, nullptr);
+  EXPECT_STREQ(mesh->id.name, "MECompressionTest");
+  ASSERT_EQ(mesh->totvert, compression_test_verts_num);
+  ASSERT_NE(mesh->mvert, nullptr);
+  bool is_equal = true;
+  for (int i = 0; i < mesh->totvert; i++) {
+    const float *co = mesh->mvert[i].co;
+    is_equal &= (co[0] == (float)i) && (co[1] == (float)(i % 7)) && (co[2] == -(float)i);
+  }
+  EXPECT_TRUE(is_equal);
+}
+
+static void compression_test_read(const char *filepath)
+{
+  BlendFileData *bfd = BLO_read_from_file(filepath, BLO_READ_SKIP_NONE, nullptr);
+  compression_test_check(bfd);
+  if (bfd) {
+    BLO_blendfiledata_free(bfd);
+  }
+}
+
+/* Read the file as a whole like packed libraries and previews do. */
+static void compression_test_read_from_memory(const char *filepath)
+{
+  size_t mem_size;
+  void *mem = BLI_file_read_binary_as_mem(filepath, 0, &mem_size);
+  ASSERT_NE(mem, nullptr);
+
+  BlendFileData *bfd = BLO_read_from_memory(mem, (int)mem_size, BLO_READ_SKIP_NONE, nullptr);
+  compression_test_check(bfd);
+  if (bfd) {
+    BLO_blendfiledata_free(bfd);
+  }
+  MEM_freeN(mem);
+}
+
+/* Check that the file is read through its seek table, which holds all the uncompressed data. */
+static void compression_test_check_seek_table(const char *filepath, const size_t uncompressed_size)
+{
+  FileData *fd = blo_filedata_from_file(filepath, nullptr);
+  ASSERT_NE(fd, nullptr);
+  const GzipSeekData *gz = fd->gzip_seek;
+  EXPECT_NE(gz, nullptr);
+  if (gz) {
+    /* The mesh must be split over multiple frames. */
+    EXPECT_GT(gz->frames_num, 2);
+    EXPECT_EQ(gz->frame_size, BLO_GZIP_FRAME_SIZE);
+    EXPECT_EQ((size_t)gz->frame_size * (gz->frames_num - 1) + gz->frame_last_size,
+              uncompressed_size);
+  }
+  blo_filedata_free(fd);
+}
+
+TEST_F(BlendfileCompressionTest, WriteReadCompressed)
+{
+  char filepath[FILE_MAX];
+  compression_test_filepath(filepath);
+
+  ASSERT_TRUE(compression_test_write(filepath, 0));
+  const size_t uncompressed_size = BLI_file_size(filepath);
+  ASSERT_GT(uncompressed_size, 2 * BLO_GZIP_FRAME_SIZE);
+
+  ASSERT_TRUE(compression_test_write(filepath, G_FILE_COMPRESS));
+
+  /* The file must remain a valid gzip file. */
+  FILE *file = BLI_fopen(filepath, "rb");
+  ASSERT_NE(file, nullptr);
+  unsigned char magic[2] = {0};
+  EXPECT_EQ(fread(magic, 1, sizeof(magic), file), sizeof(magic));
+  fclose(file);
+  EXPECT_EQ(magic[0], 0x1f);
+  EXPECT_EQ(magic[1], 0x8b);
+
+  compression_test_check_seek_table(filepath, uncompressed_size);
+  compression_test_read(filepath);
+  compression_test_read_from_memory(filepath);
+
+  BLI_delete(filepath, false, false);
+}
+
+TEST_F(BlendfileCompressionTest, WriteReadUncompressed)
+{
+  char filepath[FILE_MAX];
+  compression_test_filepath(filepath);
+
+  ASSERT_TRUE(compression_test_write(filepath, 0));
+  compression_test_read(filepath);
+
+  BLI_delete(filepath, false, false);
+}
@@ -0,0 +1,109 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "blendfile_loading_base_test.h"
+
+#include "BKE_appdir.h"
+#include "BKE_customdata.h"
+#include "BKE_lib_id.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+
+#include "BLI_fileops.h"
+#include "BLI_listbase.h"
+#include "BLI_path_util.h"
+
+#include "BLO_readfile.h"
+#include "BLO_undofile.h"
+#include "BLO_writefile.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+class BlendfileUndoMemfileTest : public BlendfileLoadingBaseTest {
+};
+
+static const int memfile_test_verts_num = 100000;
+
+static Mesh *memfile_test_mesh_add(Main *bmain)
+{
+  Mesh *mesh = BKE_mesh_add(bmain, "MemfileTest");
+  mesh->totvert = memfile_test_verts_num;
+  CustomData_add_layer(&mesh->vdata, CD_MVERT, CD_CALLOC, nullptr, mesh->totvert);
+  BKE_mesh_update_customdata_pointers(mesh, false);
+  for (int i = 0; i < mesh->totvert; i++) {
+    mesh->mvert[i].co[0] = (float)i;
+  }
+  return mesh;
+}
+
+static bool memfile_test_mesh_is_valid(const Mesh *mesh)
+{
+  if (mesh->totvert != memfile_test_verts_num || mesh->mvert == nullptr) {
+    return false;
+  }
+  for (int i = 0; i < mesh->totvert; i++) {
+    if (mesh->mvert[i].co[0] != (float)i) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST_F(BlendfileUndoMemfileTest, DuplicatedIDSharesData)
+{
+  const size_t verts_size = sizeof(MVert) * memfile_test_verts_num;
+  Main *bmain = BKE_main_new();
+  Mesh *mesh = memfile_test_mesh_add(bmain);
+
+  MemFile memfile_prev = {{nullptr}};
+  ASSERT_TRUE(BLO_write_file_mem(bmain, nullptr, &memfile_prev, 0));
+  EXPECT_GE(memfile_prev.size, verts_size);
+  EXPECT_EQ(memfile_prev.size, memfile_prev.size_total);
+
+  /* The copy is a new ID, there is no matching chunk in the previous step for its data, but the
+   * content of its vertex array is identical to the one of the original mesh. */
+  BKE_id_copy(bmain, &mesh->id);
+  ASSERT_EQ(BLI_listbase_count(&bmain->meshes), 2);
+
+  MemFile memfile = {{nullptr}};
+  ASSERT_TRUE(BLO_write_file_mem(bmain, &memfile_prev, &memfile, 0));
+  EXPECT_GE(memfile.size_total, verts_size * 2);
+  EXPECT_GE(memfile.size_shared_by_content, verts_size);
+  EXPECT_LT(memfile.size, verts_size);
+
+  /* Freeing the previous step must keep the memory shared with the current one. */
+  BLO_memfile_merge(&memfile_prev, &memfile);
+  EXPECT_GE(memfile.size, verts_size);
+
+  char filepath[FILE_MAX];
+  BKE_tempdir_init(nullptr);
+  BLI_join_dirfile(filepath, FILE_MAX, BKE_tempdir_base(), "undo_memfile_test.blend");
+  ASSERT_TRUE(BLO_memfile_write_file(&memfile, filepath));
+  BLO_memfile_free(&memfile);
+  BKE_main_free(bmain);
+
+  BlendFileData *bfd = BLO_read_from_file(filepath, BLO_READ_SKIP_NONE, nullptr);
+  ASSERT_NE(bfd, nullptr);
+  ASSERT_EQ(BLI_listbase_count(&bfd->main->meshes), 2);
+  LISTBASE_FOREACH (const Mesh *, mesh_read, &bfd->main->meshes) {
+    EXPECT_TRUE(memfile_test_mesh_is_valid(mesh_read));
+  }
+  BLO_blendfiledata_free(bfd);
+
+  BLI_delete(filepath, false, false);
+}
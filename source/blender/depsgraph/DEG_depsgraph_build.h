@@ -75,9 +75,16 @@ void DEG_graph_tag_relations_update(struct Depsgraph *graph);
 /* Create or update relations in the specified graph. */
 void DEG_graph_relations_update(struct Depsgraph *graph);
 
+/* Tag relations of the given ID for update. Only nodes and relations of this ID and its direct
+ * neighbors are rebuilt, unless the whole graph is tagged for update as well. */
+void DEG_graph_id_tag_relations_update(struct Depsgraph *graph, struct ID *id);
+
 /* Tag all relations in the database for update.*/
 void DEG_relations_tag_update(struct Main *bmain);
 
+/* Tag relations of the given ID for update in all dependency graphs of the database. */
+void DEG_id_tag_relations_update(struct Main *bmain, struct ID *id);
+
 /* Add Dependencies  ----------------------------- */
 
 /* Handle for components to define their dependencies from callbacks.
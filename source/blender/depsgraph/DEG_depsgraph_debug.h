@@ -63,8 +63,19 @@ void DEG_debug_stats_gnuplot(const struct Depsgraph *graph,
                              const char *output_filename);
 
 /* ************************************************ */
+/* Evaluation Trace */
 
-/* Compare two dependency graphs. */
+/* Record every operation evaluated by any dependency graph, with its thread and timing.
+ * Recording stops after `frames_num` different frames were evaluated (when not zero).
+ * The trace is written to `filepath` in the Chrome trace event format (viewable in
+ * `chrome://tracing` or Perfetto) by #DEG_debug_trace_end. */
+void DEG_debug_trace_begin(const char *filepath, int frames_num);
+bool DEG_debug_trace_end(void);
+
+/* ************************************************ */
+
+/* Compare ID nodes, operations and relations of two dependency graphs, differences are
+ * printed. */
 bool DEG_debug_compare(const struct Depsgraph *graph1, const struct Depsgraph *graph2);
 
 /* Check that dependencies in the graph are really up to date. */
@@ -64,6 +64,11 @@ eEvaluationMode DEG_get_mode(const Depsgraph *graph);
 /* Get time that depsgraph is being evaluated or was last evaluated at. */
 float DEG_get_ctime(const Depsgraph *graph);
 
+/* Get counter which changes whenever the evaluated copy of the given datablock is re-created
+ * from the original. Runtime caches of other datablocks which store pointers into its data can
+ * compare it against the value they were built with to detect that they are outdated. */
+uint64_t DEG_get_copy_on_write_generation(const Depsgraph *graph, struct ID *id);
+
 /* ********************* DEG evaluated data ******************* */
 
 /* Check if given ID type was tagged for update. */
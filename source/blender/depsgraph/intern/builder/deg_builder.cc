@@ -28,13 +28,20 @@
 #include "DNA_ID.h"
 #include "DNA_anim_types.h"
 #include "DNA_armature_types.h"
+#include "DNA_constraint_types.h"
 #include "DNA_layer_types.h"
 #include "DNA_object_types.h"
 
+#include "BLI_array.hh"
+#include "BLI_listbase.h"
+#include "BLI_map.hh"
 #include "BLI_stack.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_action.h"
+#include "BKE_armature.h"
+#include "BKE_constraint.h"
+#include "BKE_fcurve_driver.h"
 
 #include "intern/builder/deg_builder_cache.h"
 #include "intern/builder/deg_builder_remove_noop.h"
@@ -142,6 +149,152 @@ bool DepsgraphBuilder::check_pchan_has_bbone_segments(Object *object, const char
   return check_pchan_has_bbone_segments(object, pchan);
 }
 
+static bool animdata_has_driver_targets(const AnimData *adt)
+{
+  if (adt == nullptr) {
+    return false;
+  }
+  LISTBASE_FOREACH (FCurve *, fcu, &adt->drivers) {
+    if (fcu->driver == nullptr) {
+      continue;
+    }
+    LISTBASE_FOREACH (DriverVar *, dvar, &fcu->driver->variables) {
+      DRIVER_TARGETS_USED_LOOPER_BEGIN (dvar) {
+        if (dtar->id != nullptr) {
+          return true;
+        }
+      }
+      DRIVER_TARGETS_LOOPER_END;
+    }
+  }
+  return false;
+}
+
+static void constraint_check_self_walk(bConstraint * /*con*/,
+                                       ID **idpoin,
+                                       bool /*is_reference*/,
+                                       void *user_data)
+{
+  pair<const ID *, bool> *data = static_cast<pair<const ID *, bool> *>(user_data);
+  if (*idpoin != nullptr && *idpoin != data->first) {
+    data->second = false;
+  }
+}
+
+bool DepsgraphBuilder::check_pose_batch(Object *object, Vector<int> *r_pchan_order)
+{
+  BLI_assert(object->type == OB_ARMATURE);
+  const bArmature *armature = static_cast<const bArmature *>(object->data);
+  if ((armature->flag & ARM_POSE_BATCH) == 0 || object->pose == nullptr) {
+    return false;
+  }
+  /* Proxies copy the bones of another rig. */
+  if (ID_IS_LINKED(object) && object->proxy_from != nullptr) {
+    return false;
+  }
+  /* Drivers reading bones or other data-blocks may need operations in-between bones. */
+  if (animdata_has_driver_targets(object->adt) || animdata_has_driver_targets(armature->adt)) {
+    return false;
+  }
+
+  Map<const bPoseChannel *, int> pchan_indices;
+  LISTBASE_FOREACH (bPoseChannel *, pchan, &object->pose->chanbase) {
+    pchan_indices.add_new(pchan, pchan_indices.size());
+  }
+  const int pchans_num = pchan_indices.size();
+  /* Channels depending on each channel, and the number of dependencies of each channel. */
+  Array<Vector<int>> pchan_users(pchans_num);
+  Array<int> pchan_deps_num(pchans_num, 0);
+  auto add_dependency = [&](const bPoseChannel *pchan_from, const int index_to) {
+    pchan_users[pchan_indices.lookup(pchan_from)].append(index_to);
+    pchan_deps_num[index_to]++;
+  };
+
+  LISTBASE_FOREACH (bPoseChannel *, pchan, &object->pose->chanbase) {
+    const int index = pchan_indices.lookup(pchan);
+    if (pchan->parent != nullptr) {
+      add_dependency(pchan->parent, index);
+    }
+    /* Only constraints between bones of this rig. */
+    pair<const ID *, bool> self_data(&object->id, true);
+    BKE_constraints_id_loop(&pchan->constraints, constraint_check_self_walk, &self_data);
+    if (!self_data.second) {
+      return false;
+    }
+    LISTBASE_FOREACH (bConstraint *, con, &pchan->constraints) {
+      if (ELEM(con->type,
+               CONSTRAINT_TYPE_KINEMATIC,
+               CONSTRAINT_TYPE_SPLINEIK,
+               CONSTRAINT_TYPE_FOLLOWTRACK,
+               CONSTRAINT_TYPE_CAMERASOLVER,
+               CONSTRAINT_TYPE_OBJECTSOLVER,
+               CONSTRAINT_TYPE_TRANSFORM_CACHE)) {
+        return false;
+      }
+      const bConstraintTypeInfo *cti = BKE_constraint_typeinfo_get(con);
+      if (cti == nullptr || cti->get_constraint_targets == nullptr) {
+        continue;
+      }
+      ListBase targets = {nullptr, nullptr};
+      cti->get_constraint_targets(con, &targets);
+      bool is_supported = true;
+      LISTBASE_FOREACH (bConstraintTarget *, ct, &targets) {
+        if (ct->tar == nullptr || ct->subtarget[0] == '\0') {
+          continue;
+        }
+        /* B-Bone shapes are computed after all bones are done. */
+        if (BKE_constraint_target_uses_bbone(con, ct)) {
+          is_supported = false;
+          break;
+        }
+        const bPoseChannel *pchan_target = BKE_pose_channel_find_name(object->pose,
+                                                                      ct->subtarget);
+        if (pchan_target != nullptr) {
+          add_dependency(pchan_target, index);
+        }
+      }
+      if (cti->flush_constraint_targets) {
+        cti->flush_constraint_targets(con, &targets, true);
+      }
+      if (!is_supported) {
+        return false;
+      }
+    }
+    /* Inheriting the end roll needs the B-Bone shape of the previous handle. */
+    if (pchan->bone != nullptr && (pchan->bone->flag & BONE_ADD_PARENT_END_ROLL) != 0 &&
+        check_pchan_has_bbone(object, pchan)) {
+      bPoseChannel *prev, *next;
+      BKE_pchan_bbone_handles_get(pchan, &prev, &next);
+      if (prev != nullptr) {
+        add_dependency(prev, index);
+      }
+    }
+  }
+
+  /* Topological order, cycles between bones are left to the per-bone operations to report. */
+  Vector<int> pchan_order;
+  pchan_order.reserve(pchans_num);
+  for (int index = 0; index < pchans_num; index++) {
+    if (pchan_deps_num[index] == 0) {
+      pchan_order.append(index);
+    }
+  }
+  for (int i = 0; i < pchan_order.size(); i++) {
+    for (const int index_user : pchan_users[pchan_order[i]]) {
+      if (--pchan_deps_num[index_user] == 0) {
+        pchan_order.append(index_user);
+      }
+    }
+  }
+  if (pchan_order.size() != pchans_num) {
+    return false;
+  }
+  if (r_pchan_order != nullptr) {
+    *r_pchan_order = std::move(pchan_order);
+  }
+  return true;
+}
+
 /*******************************************************************************
  * Builder finalizer.
  */
@@ -23,6 +23,8 @@
 
 #pragma once
 
+#include "BLI_vector.hh"
+
 struct Base;
 struct ID;
 struct Main;
@@ -45,6 +47,11 @@ class DepsgraphBuilder {
   virtual bool check_pchan_has_bbone_segments(Object *object, const bPoseChannel *pchan);
   virtual bool check_pchan_has_bbone_segments(Object *object, const char *bone_name);
 
+  /* Check whether the pose is evaluated in a single operation, see #ARM_POSE_BATCH.
+   * Fills in the order of channel indices to evaluate the bones in when `r_pchan_order` is
+   * given. */
+  virtual bool check_pose_batch(Object *object, Vector<int> *r_pchan_order);
+
  protected:
   /* NOTE: The builder does NOT take ownership over any of those resources. */
   DepsgraphBuilder(Main *bmain, Depsgraph *graph, DepsgraphBuilderCache *cache);
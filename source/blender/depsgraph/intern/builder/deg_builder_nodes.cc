@@ -157,12 +157,14 @@ IDNode *DepsgraphNodeBuilder::add_id_node(ID *id)
   IDComponentsMask previously_visible_components_mask = 0;
   uint32_t previous_eval_flags = 0;
   DEGCustomDataMeshMasks previous_customdata_masks;
+  uint64_t copy_on_write_generation = 0;
   IDInfo *id_info = id_info_hash_.lookup_default(id, nullptr);
   if (id_info != nullptr) {
     id_cow = id_info->id_cow;
     previously_visible_components_mask = id_info->previously_visible_components_mask;
     previous_eval_flags = id_info->previous_eval_flags;
     previous_customdata_masks = id_info->previous_customdata_masks;
+    copy_on_write_generation = id_info->copy_on_write_generation;
     /* Tag ID info to not free the CoW ID pointer. */
     id_info->id_cow = nullptr;
   }
@@ -170,6 +172,7 @@ IDNode *DepsgraphNodeBuilder::add_id_node(ID *id)
   id_node->previously_visible_components_mask = previously_visible_components_mask;
   id_node->previous_eval_flags = previous_eval_flags;
   id_node->previous_customdata_masks = previous_customdata_masks;
+  id_node->copy_on_write_generation = copy_on_write_generation;
   /* Currently all ID nodes are supposed to have copy-on-write logic.
    *
    * NOTE: Zero number of components indicates that ID node was just created. */
@@ -312,43 +315,11 @@ void DepsgraphNodeBuilder::begin_build()
   /* Store existing copy-on-write versions of datablock, so we can re-use
    * them for new ID nodes. */
   for (IDNode *id_node : graph_->id_nodes) {
-    /* It is possible that the ID does not need to have CoW version in which case id_cow is the
-     * same as id_orig. Additionally, such ID might have been removed, which makes the check
-     * for whether id_cow is expanded to access freed memory. In order to deal with this we
-     * check whether CoW is needed based on a scalar value which does not lead to access of
-     * possibly deleted memory.
-     * Additionally, this saves some space in the map by skipping mapping for datablocks which
-     * do not need CoW, */
-    if (!deg_copy_on_write_is_needed(id_node->id_type)) {
-      id_node->id_cow = nullptr;
-      continue;
-    }
-
-    IDInfo *id_info = (IDInfo *)MEM_mallocN(sizeof(IDInfo), "depsgraph id info");
-    if (deg_copy_on_write_is_expanded(id_node->id_cow) && id_node->id_orig != id_node->id_cow) {
-      id_info->id_cow = id_node->id_cow;
-    }
-    else {
-      id_info->id_cow = nullptr;
-    }
-    id_info->previously_visible_components_mask = id_node->visible_components_mask;
-    id_info->previous_eval_flags = id_node->eval_flags;
-    id_info->previous_customdata_masks = id_node->customdata_masks;
-    id_info_hash_.add_new(id_node->id_orig, id_info);
-    id_node->id_cow = nullptr;
+    save_id_info(id_node);
   }
 
   for (OperationNode *op_node : graph_->entry_tags) {
-    ComponentNode *comp_node = op_node->owner;
-    IDNode *id_node = comp_node->owner;
-
-    SavedEntryTag entry_tag;
-    entry_tag.id_orig = id_node->id_orig;
-    entry_tag.component_type = comp_node->type;
-    entry_tag.opcode = op_node->opcode;
-    entry_tag.name = op_node->name;
-    entry_tag.name_tag = op_node->name_tag;
-    saved_entry_tags_.append(entry_tag);
+    save_entry_tag(op_node);
   }
 
   /* Make sure graph has no nodes left from previous state. */
@@ -357,6 +328,113 @@ void DepsgraphNodeBuilder::begin_build()
   graph_->entry_tags.clear();
 }
 
+void DepsgraphNodeBuilder::begin_build_incremental(Span<IDNode *> rebuild_id_nodes)
+{
+  Set<IDNode *> rebuild_id_nodes_set;
+  for (IDNode *id_node : rebuild_id_nodes) {
+    save_id_info(id_node);
+    rebuild_id_nodes_set.add_new(id_node);
+  }
+
+  Vector<OperationNode *> entry_tags_to_remove;
+  for (OperationNode *op_node : graph_->entry_tags) {
+    if (rebuild_id_nodes_set.contains(op_node->owner->owner)) {
+      save_entry_tag(op_node);
+      entry_tags_to_remove.append(op_node);
+    }
+  }
+  for (OperationNode *op_node : entry_tags_to_remove) {
+    graph_->entry_tags.remove(op_node);
+  }
+
+  /* Relations of the nodes are freed from both sides, kept nodes are not to point to them. */
+  for (IDNode *id_node : rebuild_id_nodes) {
+    for (ComponentNode *comp_node : id_node->components.values()) {
+      for (OperationNode *op_node : comp_node->operations) {
+        op_node->unlink_relations();
+      }
+      if (comp_node->operations_map != nullptr) {
+        for (OperationNode *op_node : comp_node->operations_map->values()) {
+          op_node->unlink_relations();
+        }
+      }
+      comp_node->unlink_relations();
+    }
+  }
+
+  Vector<OperationNode *> kept_operations;
+  kept_operations.reserve(graph_->operations.size());
+  for (OperationNode *op_node : graph_->operations) {
+    if (!rebuild_id_nodes_set.contains(op_node->owner->owner)) {
+      kept_operations.append(op_node);
+    }
+  }
+  graph_->operations = std::move(kept_operations);
+
+  Vector<IDNode *> kept_id_nodes;
+  kept_id_nodes.reserve(graph_->id_nodes.size());
+  for (IDNode *id_node : graph_->id_nodes) {
+    if (!rebuild_id_nodes_set.contains(id_node)) {
+      kept_id_nodes.append(id_node);
+    }
+  }
+  graph_->id_nodes = std::move(kept_id_nodes);
+
+  for (IDNode *id_node : rebuild_id_nodes) {
+    graph_->id_hash.remove(id_node->id_orig);
+    delete id_node;
+  }
+
+  /* Nodes of all other IDs are kept as-is. */
+  for (IDNode *id_node : graph_->id_nodes) {
+    built_map_.tagBuild(id_node->id_orig);
+  }
+}
+
+void DepsgraphNodeBuilder::save_id_info(IDNode *id_node)
+{
+  /* It is possible that the ID does not need to have CoW version in which case id_cow is the
+   * same as id_orig. Additionally, such ID might have been removed, which makes the check
+   * for whether id_cow is expanded to access freed memory. In order to deal with this we
+   * check whether CoW is needed based on a scalar value which does not lead to access of
+   * possibly deleted memory.
+   * Additionally, this saves some space in the map by skipping mapping for datablocks which
+   * do not need CoW, */
+  if (!deg_copy_on_write_is_needed(id_node->id_type)) {
+    id_node->id_cow = nullptr;
+    return;
+  }
+
+  IDInfo *id_info = (IDInfo *)MEM_mallocN(sizeof(IDInfo), "depsgraph id info");
+  if (deg_copy_on_write_is_expanded(id_node->id_cow) && id_node->id_orig != id_node->id_cow) {
+    id_info->id_cow = id_node->id_cow;
+    id_info->copy_on_write_generation = id_node->copy_on_write_generation;
+  }
+  else {
+    id_info->id_cow = nullptr;
+    id_info->copy_on_write_generation = 0;
+  }
+  id_info->previously_visible_components_mask = id_node->visible_components_mask;
+  id_info->previous_eval_flags = id_node->eval_flags;
+  id_info->previous_customdata_masks = id_node->customdata_masks;
+  id_info_hash_.add_new(id_node->id_orig, id_info);
+  id_node->id_cow = nullptr;
+}
+
+void DepsgraphNodeBuilder::save_entry_tag(OperationNode *op_node)
+{
+  ComponentNode *comp_node = op_node->owner;
+  IDNode *id_node = comp_node->owner;
+
+  SavedEntryTag entry_tag;
+  entry_tag.id_orig = id_node->id_orig;
+  entry_tag.component_type = comp_node->type;
+  entry_tag.opcode = op_node->opcode;
+  entry_tag.name = op_node->name;
+  entry_tag.name_tag = op_node->name_tag;
+  saved_entry_tags_.append(entry_tag);
+}
+
 void DepsgraphNodeBuilder::end_build()
 {
   for (const SavedEntryTag &entry_tag : saved_entry_tags_) {
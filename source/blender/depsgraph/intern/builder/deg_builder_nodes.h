@@ -101,6 +101,10 @@ class DepsgraphNodeBuilder : public DepsgraphBuilder {
   virtual void begin_build();
   virtual void end_build();
 
+  /* Incremental relations update: free nodes of the given IDs, keeping their copy-on-write
+   * datablocks for re-use, and consider nodes of all other IDs of the graph as built. */
+  virtual void begin_build_incremental(Span<IDNode *> rebuild_id_nodes);
+
   IDNode *add_id_node(ID *id);
   IDNode *find_id_node(ID *id);
   TimeSourceNode *add_time_source();
@@ -162,6 +166,8 @@ class DepsgraphNodeBuilder : public DepsgraphBuilder {
   virtual void build_view_layer(Scene *scene,
                                 ViewLayer *view_layer,
                                 eDepsNode_LinkedState_Type linked_state);
+  /* Build nodes of the given IDs of the view layer only, see #begin_build_incremental(). */
+  virtual void build_view_layer_ids(Scene *scene, ViewLayer *view_layer, Span<ID *> ids);
   virtual void build_collection(LayerCollection *from_layer_collection, Collection *collection);
   virtual void build_object(int base_index,
                             Object *object,
@@ -244,6 +250,8 @@ class DepsgraphNodeBuilder : public DepsgraphBuilder {
     uint32_t previous_eval_flags;
     /* Mesh CustomData mask from the previous depsgraph. */
     DEGCustomDataMeshMasks previous_customdata_masks;
+    /* Generation of the copy-on-written datablock, kept together with it. */
+    uint64_t copy_on_write_generation;
   };
 
  protected:
@@ -259,6 +267,10 @@ class DepsgraphNodeBuilder : public DepsgraphBuilder {
   };
   Vector<SavedEntryTag> saved_entry_tags_;
 
+  /* Store information from the ID node which is re-used by the new node of the same ID. */
+  void save_id_info(IDNode *id_node);
+  void save_entry_tag(OperationNode *op_node);
+
   struct BuilderWalkUserData {
     DepsgraphNodeBuilder *builder;
     /* Denotes whether object the walk is invoked from is visible. */
@@ -189,10 +189,28 @@ void DepsgraphNodeBuilder::build_rig(Object *object, bool is_object_visible)
                                function_bind(BKE_pose_eval_init, _1, scene_cow, object_cow));
   op_node->set_as_entry();
 
-  op_node = add_operation_node(&object->id,
-                               NodeType::EVAL_POSE,
-                               OperationCode::POSE_INIT_IK,
-                               function_bind(BKE_pose_eval_init_ik, _1, scene_cow, object_cow));
+  /* Rigs without external dependencies can evaluate all bones at once, leaving the bone
+   * operations as no-ops for relations from other data-blocks. */
+  Vector<int> pchan_order;
+  const bool is_pose_batch = check_pose_batch(object, &pchan_order);
+  if (is_pose_batch) {
+    add_operation_node(&object->id,
+                       NodeType::EVAL_POSE,
+                       OperationCode::POSE_BATCH,
+                       [scene_cow, object_cow, pchan_order](::Depsgraph *depsgraph) {
+                         BKE_pose_eval_batch(depsgraph,
+                                             scene_cow,
+                                             object_cow,
+                                             pchan_order.data(),
+                                             (int)pchan_order.size());
+                       });
+  }
+  else {
+    add_operation_node(&object->id,
+                       NodeType::EVAL_POSE,
+                       OperationCode::POSE_INIT_IK,
+                       function_bind(BKE_pose_eval_init_ik, _1, scene_cow, object_cow));
+  }
 
   add_operation_node(&object->id,
                      NodeType::EVAL_POSE,
@@ -212,29 +230,43 @@ void DepsgraphNodeBuilder::build_rig(Object *object, bool is_object_visible)
         &object->id, NodeType::BONE, pchan->name, OperationCode::BONE_LOCAL);
     op_node->set_as_entry();
 
-    add_operation_node(&object->id,
-                       NodeType::BONE,
-                       pchan->name,
-                       OperationCode::BONE_POSE_PARENT,
-                       function_bind(BKE_pose_eval_bone, _1, scene_cow, object_cow, pchan_index));
-
-    /* NOTE: Dedicated noop for easier relationship construction. */
-    add_operation_node(&object->id, NodeType::BONE, pchan->name, OperationCode::BONE_READY);
+    if (is_pose_batch) {
+      /* Evaluated by the pose batch operation. */
+      add_operation_node(&object->id, NodeType::BONE, pchan->name, OperationCode::BONE_READY);
+      op_node = add_operation_node(
+          &object->id, NodeType::BONE, pchan->name, OperationCode::BONE_DONE);
+      if (check_pchan_has_bbone(object, pchan)) {
+        op_node = add_operation_node(
+            &object->id, NodeType::BONE, pchan->name, OperationCode::BONE_SEGMENTS);
+      }
+    }
+    else {
+      add_operation_node(
+          &object->id,
+          NodeType::BONE,
+          pchan->name,
+          OperationCode::BONE_POSE_PARENT,
+          function_bind(BKE_pose_eval_bone, _1, scene_cow, object_cow, pchan_index));
 
-    op_node = add_operation_node(&object->id,
-                                 NodeType::BONE,
-                                 pchan->name,
-                                 OperationCode::BONE_DONE,
-                                 function_bind(BKE_pose_bone_done, _1, object_cow, pchan_index));
+      /* NOTE: Dedicated noop for easier relationship construction. */
+      add_operation_node(&object->id, NodeType::BONE, pchan->name, OperationCode::BONE_READY);
 
-    /* B-Bone shape computation - the real last step if present. */
-    if (check_pchan_has_bbone(object, pchan)) {
       op_node = add_operation_node(
           &object->id,
           NodeType::BONE,
           pchan->name,
-          OperationCode::BONE_SEGMENTS,
-          function_bind(BKE_pose_eval_bbone_segments, _1, object_cow, pchan_index));
+          OperationCode::BONE_DONE,
+          function_bind(BKE_pose_bone_done, _1, object_cow, pchan_index));
+
+      /* B-Bone shape computation - the real last step if present. */
+      if (check_pchan_has_bbone(object, pchan)) {
+        op_node = add_operation_node(
+            &object->id,
+            NodeType::BONE,
+            pchan->name,
+            OperationCode::BONE_SEGMENTS,
+            function_bind(BKE_pose_eval_bbone_segments, _1, object_cow, pchan_index));
+      }
     }
 
     op_node->set_as_exit();
@@ -246,7 +278,7 @@ void DepsgraphNodeBuilder::build_rig(Object *object, bool is_object_visible)
           &object->id, NodeType::PARAMETERS, OperationCode::PARAMETERS_EVAL, nullptr, pchan->name);
     }
     /* Build constraints. */
-    if (pchan->constraints.first != nullptr) {
+    if (pchan->constraints.first != nullptr && !is_pose_batch) {
       build_pose_constraints(object, pchan, pchan_index, is_object_visible);
     }
     /**
@@ -174,4 +174,30 @@ void DepsgraphNodeBuilder::build_view_layer(Scene *scene,
   }
 }
 
+void DepsgraphNodeBuilder::build_view_layer_ids(Scene *scene,
+                                                ViewLayer *view_layer,
+                                                Span<ID *> ids)
+{
+  view_layer_index_ = 0;
+  scene_ = scene;
+  view_layer_ = view_layer;
+  Set<ID *> ids_set;
+  ids_set.add_multiple(ids);
+  /* Objects of the view layer are built with the same base index as in #build_view_layer(). */
+  int base_index = 0;
+  LISTBASE_FOREACH (Base *, base, &view_layer->object_bases) {
+    if (need_pull_base_into_graph(base)) {
+      if (ids_set.contains(&base->object->id)) {
+        build_object(base_index, base->object, DEG_ID_LINKED_DIRECTLY, true);
+      }
+      base_index++;
+    }
+  }
+  for (ID *id : ids) {
+    if (!built_map_.checkIsBuilt(id)) {
+      build_id(id);
+    }
+  }
+}
+
 }  // namespace blender::deg
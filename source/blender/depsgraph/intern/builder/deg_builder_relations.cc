@@ -478,6 +478,13 @@ void DepsgraphRelationBuilder::begin_build()
 {
 }
 
+void DepsgraphRelationBuilder::begin_build_incremental(Span<IDNode *> kept_id_nodes)
+{
+  for (IDNode *id_node : kept_id_nodes) {
+    built_map_.tagBuild(id_node->id_orig);
+  }
+}
+
 void DepsgraphRelationBuilder::build_id(ID *id)
 {
   if (id == nullptr) {
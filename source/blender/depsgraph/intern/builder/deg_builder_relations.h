@@ -164,6 +164,8 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
   DepsgraphRelationBuilder(Main *bmain, Depsgraph *graph, DepsgraphBuilderCache *cache);
 
   void begin_build();
+  /* Incremental relations update: consider relations of the given IDs as built. */
+  void begin_build_incremental(Span<IDNode *> kept_id_nodes);
 
   template<typename KeyFrom, typename KeyTo>
   Relation *add_relation(const KeyFrom &key_from,
@@ -209,6 +211,8 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
   virtual void build_view_layer(Scene *scene,
                                 ViewLayer *view_layer,
                                 eDepsNode_LinkedState_Type linked_state);
+  /* Build relations of the given IDs of the scene only, see #begin_build_incremental(). */
+  virtual void build_view_layer_ids(Scene *scene, Span<ID *> ids);
   virtual void build_collection(LayerCollection *from_layer_collection,
                                 Object *object,
                                 Collection *collection);
@@ -270,6 +274,7 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
                                      const bPoseChannel *rootchan,
                                      const RootPChanMap *root_map);
   virtual void build_rig(Object *object);
+  virtual void build_rig_batch(Object *object);
   virtual void build_proxy_rig(Object *object);
   virtual void build_shapekeys(Key *key);
   virtual void build_armature(bArmature *armature);
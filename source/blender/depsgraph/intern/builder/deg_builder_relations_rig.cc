@@ -294,14 +294,18 @@ void DepsgraphRelationBuilder::build_rig(Object *object)
   OperationKey pose_cleanup_key(&object->id, NodeType::EVAL_POSE, OperationCode::POSE_CLEANUP);
   OperationKey pose_done_key(&object->id, NodeType::EVAL_POSE, OperationCode::POSE_DONE);
   add_relation(local_transform, pose_init_key, "Local Transform -> Pose Init");
-  add_relation(pose_init_key, pose_init_ik_key, "Pose Init -> Pose Init IK");
-  add_relation(pose_init_ik_key, pose_done_key, "Pose Init IK -> Pose Cleanup");
   /* Make sure pose is up-to-date with armature updates. */
   build_armature(armature);
   OperationKey armature_key(&armature->id, NodeType::ARMATURE, OperationCode::ARMATURE_EVAL);
   add_relation(armature_key, pose_init_key, "Data dependency");
   /* Run cleanup even when there are no bones. */
   add_relation(pose_init_key, pose_cleanup_key, "Init -> Cleanup");
+  if (check_pose_batch(object, nullptr)) {
+    build_rig_batch(object);
+    return;
+  }
+  add_relation(pose_init_key, pose_init_ik_key, "Pose Init -> Pose Init IK");
+  add_relation(pose_init_ik_key, pose_done_key, "Pose Init IK -> Pose Cleanup");
   /* IK Solvers.
    *
    * - These require separate processing steps are pose-level to be executed
@@ -454,6 +458,41 @@ void DepsgraphRelationBuilder::build_rig(Object *object)
   }
 }
 
+/* All bones are evaluated by a single operation, the bone operations are no-ops which are only
+ * used by relations from other data-blocks. */
+void DepsgraphRelationBuilder::build_rig_batch(Object *object)
+{
+  OperationKey pose_init_key(&object->id, NodeType::EVAL_POSE, OperationCode::POSE_INIT);
+  OperationKey pose_batch_key(&object->id, NodeType::EVAL_POSE, OperationCode::POSE_BATCH);
+  OperationKey pose_cleanup_key(&object->id, NodeType::EVAL_POSE, OperationCode::POSE_CLEANUP);
+  OperationKey pose_done_key(&object->id, NodeType::EVAL_POSE, OperationCode::POSE_DONE);
+  add_relation(pose_init_key, pose_batch_key, "Pose Init -> Pose Batch");
+  add_relation(pose_batch_key, pose_done_key, "Pose Batch -> Pose Done");
+  add_relation(pose_batch_key, pose_cleanup_key, "Pose Batch -> Pose Cleanup");
+  LISTBASE_FOREACH (bPoseChannel *, pchan, &object->pose->chanbase) {
+    build_idproperties(pchan->prop);
+    OperationKey bone_local_key(
+        &object->id, NodeType::BONE, pchan->name, OperationCode::BONE_LOCAL);
+    OperationKey bone_ready_key(
+        &object->id, NodeType::BONE, pchan->name, OperationCode::BONE_READY);
+    OperationKey bone_done_key(&object->id, NodeType::BONE, pchan->name, OperationCode::BONE_DONE);
+    pchan->flag &= ~POSE_DONE;
+    add_relation(pose_init_key, bone_local_key, "Pose Init - Bone Local", RELATION_FLAG_GODMODE);
+    /* Drivers of bone properties are evaluated before the batch. */
+    add_relation(bone_local_key, pose_batch_key, "Bone Local -> Pose Batch");
+    add_relation(pose_batch_key, bone_ready_key, "Pose Batch -> Ready");
+    add_relation(bone_ready_key, bone_done_key, "Ready -> Done");
+    if (check_pchan_has_bbone(object, pchan)) {
+      OperationKey bone_segments_key(
+          &object->id, NodeType::BONE, pchan->name, OperationCode::BONE_SEGMENTS);
+      add_relation(bone_done_key, bone_segments_key, "Done -> B-Bone Segments");
+    }
+    if (pchan->custom != nullptr) {
+      build_object(pchan->custom);
+    }
+  }
+}
+
 void DepsgraphRelationBuilder::build_proxy_rig(Object *object)
 {
   bArmature *armature = (bArmature *)object->data;
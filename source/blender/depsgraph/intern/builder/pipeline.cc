@@ -111,6 +111,13 @@ void AbstractBuilderPipeline::build_step_finalize()
 #endif
   /* Relations are up to date. */
   deg_graph_->need_update = false;
+  deg_graph_->need_update_ids.clear();
+  deg_graph_->need_full_update = !supports_incremental_update();
+}
+
+bool AbstractBuilderPipeline::supports_incremental_update() const
+{
+  return false;
 }
 
 unique_ptr<DepsgraphNodeBuilder> AbstractBuilderPipeline::construct_node_builder()
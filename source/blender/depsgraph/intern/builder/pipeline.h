@@ -52,7 +52,7 @@ class AbstractBuilderPipeline {
   AbstractBuilderPipeline(::Depsgraph *graph);
   virtual ~AbstractBuilderPipeline();
 
-  void build();
+  virtual void build();
 
  protected:
   Depsgraph *deg_graph_;
@@ -64,6 +64,9 @@ class AbstractBuilderPipeline {
   virtual unique_ptr<DepsgraphNodeBuilder> construct_node_builder();
   virtual unique_ptr<DepsgraphRelationBuilder> construct_relation_builder();
 
+  /* Whether relations of the built graph can be updated by #IncrementalBuilderPipeline. */
+  virtual bool supports_incremental_update() const;
+
   virtual void build_step_sanity_check();
   void build_step_nodes();
   void build_step_relations();
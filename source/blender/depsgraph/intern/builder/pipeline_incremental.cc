@@ -0,0 +1,439 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#include "pipeline_incremental.h"
+
+#include "PIL_time.h"
+
+#include "BKE_global.h"
+
+#include "DNA_object_types.h"
+
+#include "DEG_depsgraph_build.h"
+#include "DEG_depsgraph_debug.h"
+
+#include "intern/builder/deg_builder_nodes.h"
+#include "intern/builder/deg_builder_relations.h"
+#include "intern/depsgraph.h"
+#include "intern/depsgraph_relation.h"
+#include "intern/node/deg_node_component.h"
+#include "intern/node/deg_node_id.h"
+#include "intern/node/deg_node_operation.h"
+
+namespace blender::deg {
+
+namespace {
+
+/* Identifies an operation across rebuilds of the node of its ID. */
+struct SavedOperationKey {
+  ID *id_orig;
+  NodeType component_type;
+  string component_name;
+  OperationCode opcode;
+  string name;
+  int name_tag;
+
+  SavedOperationKey(const OperationNode *op_node)
+      : id_orig(op_node->owner->owner->id_orig),
+        component_type(op_node->owner->type),
+        component_name(op_node->owner->name),
+        opcode(op_node->opcode),
+        name(op_node->name),
+        name_tag(op_node->name_tag)
+  {
+  }
+
+  OperationNode *find(const Depsgraph *graph) const
+  {
+    IDNode *id_node = graph->find_id_node(id_orig);
+    if (id_node == nullptr) {
+      return nullptr;
+    }
+    ComponentNode *comp_node = id_node->find_component(component_type, component_name.c_str());
+    if (comp_node == nullptr) {
+      return nullptr;
+    }
+    return comp_node->find_operation(opcode, name.c_str(), name_tag);
+  }
+};
+
+/* Relation between a rebuilt neighbor and another ID, which is possibly added by the builder of
+ * the other ID and has to be restored. */
+struct SavedRelation {
+  SavedOperationKey from;
+  SavedOperationKey to;
+  const char *name;
+  int flag;
+};
+
+/* State of an ID node which builders of other IDs contribute to. */
+struct SavedIDState {
+  ID *id_orig;
+  eDepsNode_LinkedState_Type linked_state;
+  bool is_directly_visible;
+  bool has_base;
+  uint32_t eval_flags;
+  DEGCustomDataMeshMasks customdata_masks;
+  /* Neighbor which is possibly only in the graph because of the tagged IDs. */
+  bool is_used_by_tagged_ids_only;
+};
+
+/* Scenes and collections are connected to most of the graph, their nodes are never rebuilt and
+ * their relations to the tagged IDs are re-created by the builders of the tagged IDs. */
+bool is_kept_id_type(const ID_Type id_type)
+{
+  return ELEM(id_type, ID_SCE, ID_GR);
+}
+
+/* Whether nodes and relations of the ID can be built on their own by the builders. */
+bool is_rebuild_supported(const IDNode *id_node)
+{
+  if (id_node->linked_state == DEG_ID_LINKED_VIA_SET) {
+    return false;
+  }
+  switch (id_node->id_type) {
+    case ID_OB: {
+      /* Relations of rigid bodies are added by the scene. */
+      const Object *object = reinterpret_cast<const Object *>(id_node->id_orig);
+      return object->rigidbody_object == nullptr && object->rigidbody_constraint == nullptr;
+    }
+    case ID_AC:
+    case ID_AR:
+    case ID_CA:
+    case ID_KE:
+    case ID_LA:
+    case ID_LP:
+    case ID_NT:
+    case ID_MA:
+    case ID_TE:
+    case ID_IM:
+    case ID_WO:
+    case ID_MSK:
+    case ID_LS:
+    case ID_MC:
+    case ID_ME:
+    case ID_CU:
+    case ID_MB:
+    case ID_LT:
+    case ID_HA:
+    case ID_PT:
+    case ID_VO:
+    case ID_SPK:
+    case ID_SO:
+    case ID_CF:
+    case ID_SIM:
+      return true;
+    default:
+      return false;
+  }
+}
+
+IDNode *operation_id_node(const Node *node)
+{
+  if (node->type != NodeType::OPERATION) {
+    return nullptr;
+  }
+  return static_cast<const OperationNode *>(node)->owner->owner;
+}
+
+bool has_relation_to_ids(const OperationNode *op_node, const Set<ID *> &ids)
+{
+  for (const Relation *rel : op_node->inlinks) {
+    const IDNode *from_id_node = operation_id_node(rel->from);
+    if (from_id_node != nullptr && ids.contains(from_id_node->id_orig)) {
+      return true;
+    }
+  }
+  for (const Relation *rel : op_node->outlinks) {
+    const IDNode *to_id_node = operation_id_node(rel->to);
+    if (to_id_node != nullptr && ids.contains(to_id_node->id_orig)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+IncrementalBuilderPipeline::IncrementalBuilderPipeline(::Depsgraph *graph)
+    : ViewLayerBuilderPipeline(graph)
+{
+}
+
+void IncrementalBuilderPipeline::build()
+{
+  if (build_incremental()) {
+    if (G.debug & G_DEBUG_DEPSGRAPH_VALIDATE_INCREMENTAL) {
+      validate_incremental_build();
+    }
+    return;
+  }
+  ViewLayerBuilderPipeline::build();
+}
+
+bool IncrementalBuilderPipeline::build_incremental()
+{
+  if (deg_graph_->need_full_update || deg_graph_->need_update_ids.is_empty()) {
+    return false;
+  }
+  /* Relations removed by the transitive reduction can not be restored. */
+  if (deg_graph_->is_render_pipeline_depsgraph || G.debug_value == 799) {
+    return false;
+  }
+  /* Physics relations are cached per collection, without tracking which IDs they come from. */
+  for (int i = 0; i < DEG_PHYSICS_RELATIONS_NUM; i++) {
+    if (deg_graph_->physics_relations[i] != nullptr) {
+      return false;
+    }
+  }
+
+  double start_time = 0.0;
+  if (G.debug & (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_TIME)) {
+    start_time = PIL_check_seconds_timer();
+  }
+
+  build_step_sanity_check();
+
+  /* Tagged IDs and their direct neighbors are rebuilt. */
+  Set<IDNode *> tagged_id_nodes;
+  for (ID *id : deg_graph_->need_update_ids) {
+    IDNode *id_node = deg_graph_->find_id_node(id);
+    if (id_node == nullptr || !is_rebuild_supported(id_node)) {
+      return false;
+    }
+    tagged_id_nodes.add(id_node);
+  }
+  Vector<IDNode *> rebuild_id_nodes;
+  Set<IDNode *> rebuild_id_nodes_set;
+  for (IDNode *id_node : tagged_id_nodes) {
+    if (rebuild_id_nodes_set.add(id_node)) {
+      rebuild_id_nodes.append(id_node);
+    }
+  }
+  for (IDNode *id_node : tagged_id_nodes) {
+    for (ComponentNode *comp_node : id_node->components.values()) {
+      for (OperationNode *op_node : comp_node->operations) {
+        for (Relation *rel : op_node->inlinks) {
+          IDNode *neighbor = operation_id_node(rel->from);
+          if (neighbor == nullptr || is_kept_id_type(neighbor->id_type)) {
+            continue;
+          }
+          if (!is_rebuild_supported(neighbor)) {
+            return false;
+          }
+          if (rebuild_id_nodes_set.add(neighbor)) {
+            rebuild_id_nodes.append(neighbor);
+          }
+        }
+        for (Relation *rel : op_node->outlinks) {
+          IDNode *neighbor = operation_id_node(rel->to);
+          if (neighbor == nullptr || is_kept_id_type(neighbor->id_type)) {
+            continue;
+          }
+          if (!is_rebuild_supported(neighbor)) {
+            return false;
+          }
+          if (rebuild_id_nodes_set.add(neighbor)) {
+            rebuild_id_nodes.append(neighbor);
+          }
+        }
+      }
+    }
+  }
+
+  /* Relations between the neighbors and the rest of the graph. Relations of the tagged IDs are
+   * all re-created by their builders. */
+  Vector<SavedRelation> saved_relations;
+  for (IDNode *id_node : rebuild_id_nodes) {
+    if (tagged_id_nodes.contains(id_node)) {
+      continue;
+    }
+    for (ComponentNode *comp_node : id_node->components.values()) {
+      for (OperationNode *op_node : comp_node->operations) {
+        for (Relation *rel : op_node->outlinks) {
+          IDNode *to_id_node = operation_id_node(rel->to);
+          if (to_id_node == nullptr || tagged_id_nodes.contains(to_id_node)) {
+            continue;
+          }
+          saved_relations.append({SavedOperationKey(op_node),
+                                  SavedOperationKey(static_cast<OperationNode *>(rel->to)),
+                                  rel->name,
+                                  rel->flag & ~RELATION_FLAG_CYCLIC});
+        }
+        for (Relation *rel : op_node->inlinks) {
+          IDNode *from_id_node = operation_id_node(rel->from);
+          if (from_id_node == nullptr || rebuild_id_nodes_set.contains(from_id_node)) {
+            continue;
+          }
+          saved_relations.append({SavedOperationKey(static_cast<OperationNode *>(rel->from)),
+                                  SavedOperationKey(op_node),
+                                  rel->name,
+                                  rel->flag & ~RELATION_FLAG_CYCLIC});
+        }
+      }
+    }
+  }
+
+  Vector<SavedIDState> saved_id_states;
+  Vector<ID *> rebuild_ids;
+  for (IDNode *id_node : rebuild_id_nodes) {
+    SavedIDState state;
+    state.id_orig = id_node->id_orig;
+    state.linked_state = id_node->linked_state;
+    state.is_directly_visible = id_node->is_directly_visible;
+    state.has_base = id_node->has_base;
+    state.eval_flags = id_node->eval_flags;
+    state.customdata_masks = id_node->customdata_masks;
+    state.is_used_by_tagged_ids_only = !tagged_id_nodes.contains(id_node) &&
+                                       id_node->linked_state == DEG_ID_LINKED_INDIRECTLY &&
+                                       !id_node->has_base;
+    saved_id_states.append(state);
+    rebuild_ids.append(id_node->id_orig);
+  }
+
+  /* Evaluation flags and masks requested by the rebuilt IDs from the kept ones are detected as
+   * changes by #deg_graph_build_finalize(). */
+  for (IDNode *id_node : deg_graph_->id_nodes) {
+    id_node->previous_eval_flags = id_node->eval_flags;
+    id_node->previous_customdata_masks = id_node->customdata_masks;
+  }
+
+  /* Nodes. */
+  int64_t kept_id_nodes_num, kept_operations_num;
+  {
+    unique_ptr<DepsgraphNodeBuilder> node_builder = construct_node_builder();
+    node_builder->begin_build_incremental(rebuild_id_nodes);
+    kept_id_nodes_num = deg_graph_->id_nodes.size();
+    kept_operations_num = deg_graph_->operations.size();
+    node_builder->build_view_layer_ids(scene_, view_layer_, rebuild_ids);
+    node_builder->end_build();
+  }
+  for (const SavedIDState &state : saved_id_states) {
+    IDNode *id_node = deg_graph_->find_id_node(state.id_orig);
+    id_node->linked_state = max(id_node->linked_state, state.linked_state);
+    id_node->is_directly_visible |= state.is_directly_visible;
+    id_node->has_base |= state.has_base;
+  }
+  /* Operations added to the kept IDs would need their relations to be built as well. */
+  Set<const IDNode *> new_id_nodes;
+  for (const IDNode *id_node : deg_graph_->id_nodes.as_span().drop_front(kept_id_nodes_num)) {
+    new_id_nodes.add(id_node);
+  }
+  for (const OperationNode *op_node :
+       deg_graph_->operations.as_span().drop_front(kept_operations_num)) {
+    if (!new_id_nodes.contains(op_node->owner->owner)) {
+      return false;
+    }
+  }
+
+  /* Relations. */
+  {
+    unique_ptr<DepsgraphRelationBuilder> relation_builder = construct_relation_builder();
+    relation_builder->begin_build_incremental(
+        deg_graph_->id_nodes.as_span().take_front(kept_id_nodes_num));
+    relation_builder->build_view_layer_ids(scene_, rebuild_ids);
+    for (const SavedRelation &saved_relation : saved_relations) {
+      OperationNode *op_from = saved_relation.from.find(deg_graph_);
+      OperationNode *op_to = saved_relation.to.find(deg_graph_);
+      if (op_from == nullptr || op_to == nullptr) {
+        continue;
+      }
+      deg_graph_->add_new_relation(
+          op_from, op_to, saved_relation.name, saved_relation.flag | RELATION_CHECK_BEFORE_ADD);
+    }
+    for (IDNode *id_node : deg_graph_->id_nodes.as_span().drop_front(kept_id_nodes_num)) {
+      relation_builder->build_copy_on_write_relations(id_node);
+    }
+    for (IDNode *id_node : deg_graph_->id_nodes.as_span().drop_front(kept_id_nodes_num)) {
+      relation_builder->build_driver_relations(id_node);
+    }
+  }
+
+  /* A neighbor which is not related to the tagged IDs anymore might not be used at all, which is
+   * only known by building the whole graph. Operations of the rebuilt IDs are not moved to their
+   * components yet, they are all after the kept ones. */
+  Set<ID *> unrelated_ids;
+  for (const SavedIDState &state : saved_id_states) {
+    if (state.is_used_by_tagged_ids_only) {
+      unrelated_ids.add(state.id_orig);
+    }
+  }
+  for (const OperationNode *op_node :
+       deg_graph_->operations.as_span().drop_front(kept_operations_num)) {
+    if (unrelated_ids.is_empty()) {
+      break;
+    }
+    ID *id_orig = op_node->owner->owner->id_orig;
+    if (unrelated_ids.contains(id_orig) &&
+        has_relation_to_ids(op_node, deg_graph_->need_update_ids)) {
+      unrelated_ids.remove(id_orig);
+    }
+  }
+  if (!unrelated_ids.is_empty()) {
+    return false;
+  }
+  /* Relations to NO-OP nodes which were not used before have been removed, see
+   * #deg_graph_remove_unused_noops(). */
+  for (const OperationNode *op_node :
+       deg_graph_->operations.as_span().take_front(kept_operations_num)) {
+    if ((op_node->flag & DEPSOP_FLAG_UNUSED_NOOP) && !op_node->outlinks.is_empty()) {
+      return false;
+    }
+  }
+
+  /* Requests from builders of the kept IDs. */
+  for (const SavedIDState &state : saved_id_states) {
+    IDNode *id_node = deg_graph_->find_id_node(state.id_orig);
+    id_node->eval_flags |= state.eval_flags;
+    id_node->customdata_masks |= state.customdata_masks;
+  }
+
+  /* Cycles are detected again for the whole graph. */
+  for (OperationNode *op_node : deg_graph_->operations) {
+    for (Relation *rel : op_node->outlinks) {
+      rel->flag &= ~RELATION_FLAG_CYCLIC;
+    }
+  }
+  build_step_finalize();
+
+  if (G.debug & (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_TIME)) {
+    printf("Depsgraph updated %d of %d IDs in %f seconds.\n",
+           (int)rebuild_ids.size(),
+           (int)deg_graph_->id_nodes.size(),
+           PIL_check_seconds_timer() - start_time);
+  }
+  return true;
+}
+
+void IncrementalBuilderPipeline::validate_incremental_build()
+{
+  ::Depsgraph *full_graph = DEG_graph_new(bmain_, scene_, view_layer_, deg_graph_->mode);
+  DEG_graph_build_from_view_layer(full_graph);
+  /* Differences are printed with the full build as graph 1. */
+  if (!DEG_debug_compare(full_graph, reinterpret_cast<::Depsgraph *>(deg_graph_))) {
+    fprintf(stderr, "Depsgraph: incremental relations update differs from a full build.\n");
+  }
+  DEG_graph_free(full_graph);
+}
+
+}  // namespace blender::deg
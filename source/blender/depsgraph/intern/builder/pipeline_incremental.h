@@ -0,0 +1,51 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#pragma once
+
+#include "pipeline_view_layer.h"
+
+namespace blender {
+namespace deg {
+
+/* Update relations of a graph built from a view layer by only rebuilding nodes and relations of
+ * the IDs tagged with #DEG_graph_id_tag_relations_update() and of their direct neighbors. All
+ * other nodes and relations of the graph are kept.
+ *
+ * Falls back to a full build of the view layer when the graph was tagged for a full update, or
+ * when the change can not be handled locally. */
+class IncrementalBuilderPipeline : public ViewLayerBuilderPipeline {
+ public:
+  IncrementalBuilderPipeline(::Depsgraph *graph);
+
+  virtual void build() override;
+
+ protected:
+  /* Returns false when the graph is to be fully built instead. */
+  bool build_incremental();
+  /* Compare the graph with a fully built one, reporting differences. */
+  void validate_incremental_build();
+};
+
+}  // namespace deg
+}  // namespace blender
@@ -0,0 +1,143 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "tests/depsgraph_base_test.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_collection.h"
+#include "BKE_constraint.h"
+#include "BKE_layer.h"
+#include "BKE_main.h"
+#include "BKE_modifier.h"
+#include "BKE_object.h"
+#include "BKE_scene.h"
+
+#include "BLI_listbase.h"
+
+#include "DNA_constraint_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+#include "DEG_depsgraph_debug.h"
+
+#include "intern/builder/pipeline_incremental.h"
+#include "intern/depsgraph.h"
+
+namespace blender::deg::tests {
+
+class TestableIncrementalBuilderPipeline : public IncrementalBuilderPipeline {
+ public:
+  TestableIncrementalBuilderPipeline(::Depsgraph *graph) : IncrementalBuilderPipeline(graph)
+  {
+  }
+
+  bool build_incremental()
+  {
+    return IncrementalBuilderPipeline::build_incremental();
+  }
+};
+
+class IncrementalBuilderPipelineTest : public DepsgraphBaseTest {
+ public:
+  Object *object_add(const int type, const char *name)
+  {
+    Object *object = BKE_object_add_only_object(bmain, type, name);
+    object->data = BKE_object_obdata_add_from_type(bmain, type, name);
+    BKE_collection_object_add(bmain, scene->master_collection, object);
+    BKE_main_collection_sync(bmain);
+    return object;
+  }
+
+  /* Evaluation expands copy-on-write datablocks, which are then re-used by the rebuilt nodes. */
+  void graph_evaluate()
+  {
+    DEG_evaluate_on_refresh(graph);
+    DEG_ids_clear_recalc(bmain, graph);
+  }
+
+  void graph_build()
+  {
+    DEG_graph_build_from_view_layer(graph);
+    graph_evaluate();
+  }
+
+  /* Update relations of the given ID incrementally, returns false if a full build is needed. */
+  bool relations_update(ID *id)
+  {
+    DEG_graph_id_tag_relations_update(graph, id);
+    TestableIncrementalBuilderPipeline builder(graph);
+    if (!builder.build_incremental()) {
+      return false;
+    }
+    graph_evaluate();
+    return true;
+  }
+
+  /* Compare the graph with a fully built one. */
+  bool is_equal_to_full_build()
+  {
+    ::Depsgraph *full_graph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_VIEWPORT);
+    DEG_graph_build_from_view_layer(full_graph);
+    const bool is_equal = DEG_debug_compare(full_graph, graph);
+    DEG_graph_free(full_graph);
+    return is_equal;
+  }
+};
+
+TEST_F(IncrementalBuilderPipelineTest, modifier_and_constraint)
+{
+  Object *ob_mesh = object_add(OB_MESH, "Mesh");
+  Object *ob_hook = object_add(OB_EMPTY, "Hook");
+  Object *ob_target = object_add(OB_EMPTY, "Target");
+  graph_build();
+
+  HookModifierData *hmd = (HookModifierData *)BKE_modifier_new(eModifierType_Hook);
+  hmd->object = ob_hook;
+  BLI_addtail(&ob_mesh->modifiers, hmd);
+  EXPECT_TRUE(relations_update(&ob_mesh->id));
+  EXPECT_TRUE(is_equal_to_full_build());
+
+  bConstraint *con = BKE_constraint_add_for_object(
+      ob_hook, "Copy Location", CONSTRAINT_TYPE_LOCLIKE);
+  ((bLocateLikeConstraint *)con->data)->tar = ob_target;
+  EXPECT_TRUE(relations_update(&ob_hook->id));
+  EXPECT_TRUE(is_equal_to_full_build());
+
+  BLI_remlink(&ob_mesh->modifiers, hmd);
+  BKE_modifier_free(&hmd->modifier);
+  EXPECT_TRUE(relations_update(&ob_mesh->id));
+  EXPECT_TRUE(is_equal_to_full_build());
+}
+
+TEST_F(IncrementalBuilderPipelineTest, full_update_fallback)
+{
+  Object *ob_mesh = object_add(OB_MESH, "Mesh");
+  graph_build();
+
+  DEG_graph_tag_relations_update(graph);
+  EXPECT_FALSE(relations_update(&ob_mesh->id));
+
+  /* Scenes are connected to most of the graph and are not rebuilt on their own. */
+  graph_build();
+  EXPECT_FALSE(relations_update(&scene->id));
+}
+
+}  // namespace blender::deg::tests
@@ -0,0 +1,334 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#include "intern/debug/deg_debug_trace.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+#if defined(_WIN32)
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#elif defined(__linux__)
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#else
+#  include <pthread.h>
+#endif
+
+#include "PIL_time.h"
+
+#include "BLI_fileops.h"
+#include "BLI_threads.h"
+#include "BLI_vector.hh"
+
+#include "DNA_scene_types.h"
+
+#include "DEG_depsgraph_debug.h"
+
+#include "intern/depsgraph.h"
+#include "intern/node/deg_node.h"
+#include "intern/node/deg_node_component.h"
+#include "intern/node/deg_node_id.h"
+#include "intern/node/deg_node_operation.h"
+
+namespace deg = blender::deg;
+
+namespace blender::deg {
+namespace {
+
+struct TraceEvent {
+  /* Offsets of null terminated strings in #TraceThread.strings. For operations the name is the
+   * operation name, the event name is the operation identifier. */
+  int64_t name_offset;
+  int64_t id_name_offset;
+  /* Static string, type of the component or "Depsgraph" for graph evaluations. */
+  const char *category;
+  /* Only for operations. */
+  OperationCode opcode;
+  double start_time;
+  double end_time;
+  bool is_graph_evaluation;
+  /* Only for graph evaluations. */
+  float frame;
+};
+
+/* Events are gathered per thread, so that evaluation threads don't wait on each other. */
+struct TraceThread {
+  /* Identifier of the thread in the operating system, as shown by debuggers and profilers. */
+  uint64_t thread_id;
+  bool is_main_thread;
+  Vector<TraceEvent> events;
+  /* Names of all events, so recording an event doesn't allocate. */
+  Vector<char> strings;
+
+  int64_t string_add(const char *str)
+  {
+    const int64_t offset = strings.size();
+    strings.extend(str, (int64_t)strlen(str) + 1);
+    return offset;
+  }
+};
+
+struct TraceState {
+  string filepath;
+  double start_time;
+  /* Used to detect #thread_trace pointers of a previous trace. */
+  int generation;
+  /* Cleared once #frames_num frames have been evaluated, the trace is written on
+   * #DEG_debug_trace_end. */
+  std::atomic<bool> is_recording;
+
+  std::mutex threads_mutex;
+  Vector<std::unique_ptr<TraceThread>> threads;
+
+  /* Stop recording after this many frames, zero to record until #DEG_debug_trace_end. */
+  int frames_num;
+  std::mutex frames_mutex;
+  int frames_recorded;
+  float frame_last;
+};
+
+TraceState *trace_state = nullptr;
+int trace_generation = 0;
+
+thread_local TraceThread *thread_trace = nullptr;
+thread_local int thread_trace_generation = -1;
+
+uint64_t trace_thread_id_get()
+{
+#if defined(_WIN32)
+  return (uint64_t)GetCurrentThreadId();
+#elif defined(__APPLE__)
+  uint64_t thread_id;
+  pthread_threadid_np(nullptr, &thread_id);
+  return thread_id;
+#elif defined(__linux__)
+  return (uint64_t)syscall(SYS_gettid);
+#else
+  return (uint64_t)pthread_self();
+#endif
+}
+
+TraceThread *trace_thread_get()
+{
+  if (thread_trace_generation != trace_state->generation) {
+    std::unique_ptr<TraceThread> thread = std::make_unique<TraceThread>();
+    thread->thread_id = trace_thread_id_get();
+    thread->is_main_thread = BLI_thread_is_main();
+    thread_trace = thread.get();
+    thread_trace_generation = trace_state->generation;
+    std::lock_guard<std::mutex> lock(trace_state->threads_mutex);
+    trace_state->threads.append(std::move(thread));
+  }
+  return thread_trace;
+}
+
+/* Write a JSON string without the quotes. */
+void trace_write_string_escaped(FILE *file, const char *str)
+{
+  for (const char *c = str; *c; c++) {
+    if (*c == '"' || *c == '\\') {
+      fputc('\\', file);
+      fputc(*c, file);
+    }
+    else if ((unsigned char)*c < 0x20) {
+      fprintf(file, "\\u%04x", (unsigned int)*c);
+    }
+    else {
+      fputc(*c, file);
+    }
+  }
+}
+
+void trace_write_string(FILE *file, const char *str)
+{
+  fputc('"', file);
+  trace_write_string_escaped(file, str);
+  fputc('"', file);
+}
+
+void trace_write_event(FILE *file, const TraceThread &thread, const TraceEvent &event)
+{
+  const double start_us = (event.start_time - trace_state->start_time) * 1e6;
+  const double duration_us = (event.end_time - event.start_time) * 1e6;
+  const char *name = &thread.strings[event.name_offset];
+  fprintf(file, "{\"name\":");
+  if (event.is_graph_evaluation) {
+    trace_write_string(file, name);
+  }
+  else {
+    /* Same as #OperationNode::identifier. */
+    fprintf(file, "\"%s(", operationCodeAsString(event.opcode));
+    trace_write_string_escaped(file, name);
+    fprintf(file, ")\"");
+  }
+  fprintf(file,
+          ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%llu,\"ts\":%.3f,\"dur\":%.3f,"
+          "\"args\":{",
+          event.category,
+          (unsigned long long)thread.thread_id,
+          start_us,
+          duration_us);
+  fprintf(file, "\"id\":");
+  trace_write_string(file, &thread.strings[event.id_name_offset]);
+  if (event.is_graph_evaluation) {
+    fprintf(file, ",\"frame\":%g", event.frame);
+  }
+  fprintf(file, "}}");
+}
+
+bool trace_write(FILE *file)
+{
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  bool is_first = true;
+  for (const int i : trace_state->threads.index_range()) {
+    const TraceThread &thread = *trace_state->threads[i];
+    fprintf(file,
+            "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%llu,"
+            "\"args\":{\"name\":\"%s %d\"}}",
+            is_first ? "" : ",\n",
+            (unsigned long long)thread.thread_id,
+            thread.is_main_thread ? "Main Thread" : "Thread",
+            i);
+    is_first = false;
+    for (const TraceEvent &event : thread.events) {
+      fprintf(file, ",\n");
+      trace_write_event(file, thread, event);
+    }
+  }
+  fprintf(file, "\n]}\n");
+  return ferror(file) == 0;
+}
+
+}  // namespace
+
+bool deg_debug_trace_is_active()
+{
+  return trace_state != nullptr && trace_state->is_recording;
+}
+
+void deg_debug_trace_operation(const OperationNode *operation_node,
+                               double start_time,
+                               double end_time)
+{
+  const ComponentNode *comp_node = operation_node->owner;
+  const IDNode *id_node = comp_node->owner;
+  TraceThread *thread = trace_thread_get();
+
+  TraceEvent event;
+  event.name_offset = thread->string_add(operation_node->name.c_str());
+  event.id_name_offset = thread->string_add(id_node->name.c_str());
+  event.category = nodeTypeAsString(comp_node->type);
+  event.opcode = operation_node->opcode;
+  event.start_time = start_time;
+  event.end_time = end_time;
+  event.is_graph_evaluation = false;
+  event.frame = 0.0f;
+  thread->events.append(event);
+}
+
+void deg_debug_trace_graph_evaluation(const Depsgraph *graph, double start_time, double end_time)
+{
+  TraceThread *thread = trace_thread_get();
+
+  TraceEvent event;
+  const string name = graph->debug.name.empty() ? "Depsgraph" : "Depsgraph " + graph->debug.name;
+  event.name_offset = thread->string_add(name.c_str());
+  event.id_name_offset = thread->string_add(graph->scene ? graph->scene->id.name : "");
+  event.category = "Depsgraph";
+  event.opcode = OperationCode::OPERATION;
+  event.start_time = start_time;
+  event.end_time = end_time;
+  event.is_graph_evaluation = true;
+  event.frame = graph->ctime;
+  thread->events.append(event);
+
+  if (trace_state->frames_num == 0) {
+    return;
+  }
+  /* Evaluations of multiple graphs or re-evaluations after edits count as a single frame. */
+  std::lock_guard<std::mutex> lock(trace_state->frames_mutex);
+  if (trace_state->frames_recorded != 0 && trace_state->frame_last == graph->ctime) {
+    return;
+  }
+  trace_state->frame_last = graph->ctime;
+  trace_state->frames_recorded++;
+  if (trace_state->frames_recorded == trace_state->frames_num) {
+    trace_state->is_recording = false;
+    printf("Depsgraph trace: recorded %d frames\n", trace_state->frames_num);
+  }
+}
+
+}  // namespace blender::deg
+
+/* Not thread safe, must be called while no dependency graph is evaluated. */
+void DEG_debug_trace_begin(const char *filepath, int frames_num)
+{
+  if (deg::trace_state != nullptr) {
+    DEG_debug_trace_end();
+  }
+  deg::trace_state = new deg::TraceState();
+  deg::trace_state->filepath = filepath;
+  deg::trace_state->start_time = PIL_check_seconds_timer();
+  deg::trace_state->generation = deg::trace_generation++;
+  deg::trace_state->is_recording = true;
+  deg::trace_state->frames_num = frames_num;
+  deg::trace_state->frames_recorded = 0;
+  deg::trace_state->frame_last = 0.0f;
+}
+
+bool DEG_debug_trace_end(void)
+{
+  if (deg::trace_state == nullptr) {
+    return false;
+  }
+
+  bool ok = false;
+  FILE *file = BLI_fopen(deg::trace_state->filepath.c_str(), "w");
+  if (file == nullptr) {
+    fprintf(stderr,
+            "Depsgraph trace: unable to open '%s' for writing\n",
+            deg::trace_state->filepath.c_str());
+  }
+  else {
+    ok = deg::trace_write(file);
+    ok &= (fclose(file) == 0);
+    int64_t events_num = 0;
+    for (const std::unique_ptr<deg::TraceThread> &thread : deg::trace_state->threads) {
+      events_num += thread->events.size();
+    }
+    printf("Depsgraph trace: %lld events written to '%s'\n",
+           (long long)events_num,
+           deg::trace_state->filepath.c_str());
+  }
+
+  delete deg::trace_state;
+  deg::trace_state = nullptr;
+  return ok;
+}
@@ -0,0 +1,48 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ *
+ * Recording of evaluated operations in the Chrome trace event format, see
+ * #DEG_debug_trace_begin.
+ */
+
+#pragma once
+
+namespace blender {
+namespace deg {
+
+struct Depsgraph;
+struct OperationNode;
+
+/* True when a trace is being recorded. */
+bool deg_debug_trace_is_active();
+
+/* Record evaluation of an operation, times are from #PIL_check_seconds_timer().
+ * Can be called from any thread. */
+void deg_debug_trace_operation(const OperationNode *operation_node,
+                               double start_time,
+                               double end_time);
+
+/* Record evaluation of the whole graph. */
+void deg_debug_trace_graph_evaluation(const Depsgraph *graph, double start_time, double end_time);
+
+}  // namespace deg
+}  // namespace blender
@@ -62,11 +62,13 @@ namespace blender::deg {
 Depsgraph::Depsgraph(Main *bmain, Scene *scene, ViewLayer *view_layer, eEvaluationMode mode)
     : time_source(nullptr),
       need_update(true),
+      need_full_update(true),
       bmain(bmain),
       scene(scene),
       view_layer(view_layer),
       mode(mode),
       ctime(BKE_scene_frame_get(scene)),
+      copy_on_write_counter(0),
       scene_cow(nullptr),
       is_active(false),
       is_evaluating(false),
@@ -292,6 +294,8 @@ void DEG_graph_replace_owners(struct Depsgraph *depsgraph,
   deg_graph->bmain = bmain;
   deg_graph->scene = scene;
   deg_graph->view_layer = view_layer;
+  /* Original IDs referenced by the graph are to be re-mapped, never update it partially. */
+  deg_graph->need_full_update = true;
 
   if (do_update_register) {
     deg::register_graph(deg_graph);
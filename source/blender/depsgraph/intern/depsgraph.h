@@ -111,6 +111,15 @@ struct Depsgraph {
   /* Indicates whether relations needs to be updated. */
   bool need_update;
 
+  /* Original IDs which got their relations tagged for update with
+   * #DEG_graph_id_tag_relations_update(). Unless `need_full_update` is set, only nodes and
+   * relations of those IDs and their direct neighbors are rebuilt. */
+  Set<ID *> need_update_ids;
+
+  /* Relations update is to rebuild the whole graph: relations were tagged for update without
+   * knowing which IDs are affected, or the graph was not built from a view layer. */
+  bool need_full_update;
+
   /* Indicates which ID types were updated. */
   char id_type_updated[MAX_LIBARRAY];
 
@@ -141,6 +150,9 @@ struct Depsgraph {
   /* Time at which dependency graph is being or was last evaluated. */
   float ctime;
 
+  /* Source of unique values for #IDNode::copy_on_write_generation. */
+  uint64_t copy_on_write_counter;
+
   /* Evaluated version of datablocks we access a lot.
    * Stored here to save us form doing hash lookup. */
   Scene *scene_cow;
@@ -47,6 +47,7 @@
 #include "builder/pipeline_all_objects.h"
 #include "builder/pipeline_compositor.h"
 #include "builder/pipeline_from_ids.h"
+#include "builder/pipeline_incremental.h"
 #include "builder/pipeline_render.h"
 #include "builder/pipeline_view_layer.h"
 
@@ -246,6 +247,7 @@ void DEG_graph_tag_relations_update(Depsgraph *graph)
   DEG_DEBUG_PRINTF(graph, TAG, "%s: Tagging relations for update.\n", __func__);
   deg::Depsgraph *deg_graph = reinterpret_cast<deg::Depsgraph *>(graph);
   deg_graph->need_update = true;
+  deg_graph->need_full_update = true;
   /* NOTE: When relations are updated, it's quite possible that
    * we've got new bases in the scene. This means, we need to
    * re-create flat array of bases in view layer.
@@ -258,6 +260,21 @@ void DEG_graph_tag_relations_update(Depsgraph *graph)
   }
 }
 
+/* Tag relations of the given ID for update. */
+void DEG_graph_id_tag_relations_update(Depsgraph *graph, ID *id)
+{
+  deg::Depsgraph *deg_graph = reinterpret_cast<deg::Depsgraph *>(graph);
+  deg::IDNode *id_node = deg_graph->find_id_node(id);
+  if (id_node == nullptr) {
+    /* ID is not in the graph, its relations are not used. */
+    return;
+  }
+  DEG_DEBUG_PRINTF(graph, TAG, "%s: Tagging relations of %s for update.\n", __func__, id->name);
+  deg_graph->need_update = true;
+  deg_graph->need_update_ids.add(id);
+  id_node->tag_update(deg_graph, deg::DEG_UPDATE_SOURCE_RELATIONS);
+}
+
 /* Create or update relations in the specified graph. */
 void DEG_graph_relations_update(Depsgraph *graph)
 {
@@ -266,7 +283,8 @@ void DEG_graph_relations_update(Depsgraph *graph)
     /* Graph is up to date, nothing to do. */
     return;
   }
-  DEG_graph_build_from_view_layer(graph);
+  deg::IncrementalBuilderPipeline builder(graph);
+  builder.build();
 }
 
 /* Tag all relations for update. */
@@ -277,3 +295,12 @@ void DEG_relations_tag_update(Main *bmain)
     DEG_graph_tag_relations_update(reinterpret_cast<Depsgraph *>(depsgraph));
   }
 }
+
+/* Tag relations of the given ID for update in all graphs. */
+void DEG_id_tag_relations_update(Main *bmain, ID *id)
+{
+  DEG_GLOBAL_DEBUG_PRINTF(TAG, "%s: Tagging relations of %s for update.\n", __func__, id->name);
+  for (deg::Depsgraph *depsgraph : deg::get_all_registered_graphs(bmain)) {
+    DEG_graph_id_tag_relations_update(reinterpret_cast<Depsgraph *>(depsgraph), id);
+  }
+}
@@ -25,6 +25,8 @@
 
 #include "BLI_utildefines.h"
 
+#include "BKE_global.h"
+
 #include "DNA_scene_types.h"
 
 #include "DNA_object_types.h"
@@ -40,6 +42,7 @@
 #include "intern/depsgraph_type.h"
 #include "intern/node/deg_node_component.h"
 #include "intern/node/deg_node_id.h"
+#include "intern/node/deg_node_operation.h"
 #include "intern/node/deg_node_time.h"
 
 namespace deg = blender::deg;
@@ -68,22 +71,86 @@ const char *DEG_debug_name_get(struct Depsgraph *depsgraph)
   return deg_graph->debug.name.c_str();
 }
 
+namespace blender::deg {
+namespace {
+
+string debug_compare_node_key(const Node *node)
+{
+  if (node->type != NodeType::OPERATION) {
+    return node->identifier();
+  }
+  const OperationNode *op_node = static_cast<const OperationNode *>(node);
+  const ComponentNode *comp_node = op_node->owner;
+  return comp_node->owner->name + " " + nodeTypeAsString(comp_node->type) + "[" +
+         comp_node->name + "] " + op_node->identifier() + "#" + to_string(op_node->name_tag);
+}
+
+void debug_compare_graph_keys(const Depsgraph *graph,
+                              Set<string> &r_id_keys,
+                              Set<string> &r_operation_keys,
+                              Set<string> &r_relation_keys)
+{
+  for (const IDNode *id_node : graph->id_nodes) {
+    r_id_keys.add(id_node->name);
+  }
+  for (const OperationNode *op_node : graph->operations) {
+    r_operation_keys.add(debug_compare_node_key(op_node));
+    for (const Relation *rel : op_node->inlinks) {
+      r_relation_keys.add(debug_compare_node_key(rel->from) + " -> " +
+                          debug_compare_node_key(op_node) + " (" + rel->name + ")");
+    }
+  }
+}
+
+/* Returns true when the sets are equal. Keys which are only in one of the sets are printed with
+ * depsgraph build debugging or validation of incremental updates enabled. */
+bool debug_compare_keys(const char *what, const Set<string> &keys1, const Set<string> &keys2)
+{
+  const bool do_print = (G.debug &
+                         (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_VALIDATE_INCREMENTAL)) != 0;
+  const int max_printed = 10;
+  bool is_equal = true;
+  for (const int side : {1, 2}) {
+    const Set<string> &keys = (side == 1) ? keys1 : keys2;
+    const Set<string> &other_keys = (side == 1) ? keys2 : keys1;
+    int num_missing = 0;
+    for (const string &key : keys) {
+      if (other_keys.contains(key)) {
+        continue;
+      }
+      if (do_print && num_missing < max_printed) {
+        printf("  %s only in graph %d: %s\n", what, side, key.c_str());
+      }
+      num_missing++;
+    }
+    if (do_print && num_missing > max_printed) {
+      printf("  ... %d more %ss only in graph %d\n", num_missing - max_printed, what, side);
+    }
+    is_equal &= (num_missing == 0);
+  }
+  return is_equal;
+}
+
+}  // namespace
+}  // namespace blender::deg
+
 bool DEG_debug_compare(const struct Depsgraph *graph1, const struct Depsgraph *graph2)
 {
   BLI_assert(graph1 != nullptr);
   BLI_assert(graph2 != nullptr);
   const deg::Depsgraph *deg_graph1 = reinterpret_cast<const deg::Depsgraph *>(graph1);
   const deg::Depsgraph *deg_graph2 = reinterpret_cast<const deg::Depsgraph *>(graph2);
-  if (deg_graph1->operations.size() != deg_graph2->operations.size()) {
-    return false;
-  }
-  /* TODO(sergey): Currently we only do real stupid check,
-   * which is fast but which isn't 100% reliable.
-   *
-   * Would be cool to make it more robust, but it's good enough
-   * for now. Also, proper graph check is actually NP-complex
-   * problem. */
-  return true;
+  /* NOTE: Nodes are matched by the names of their IDs, components and operations, which is
+   * enough to compare two graphs built from the same view layer. */
+  blender::Set<std::string> id_keys1, operation_keys1, relation_keys1;
+  blender::Set<std::string> id_keys2, operation_keys2, relation_keys2;
+  deg::debug_compare_graph_keys(deg_graph1, id_keys1, operation_keys1, relation_keys1);
+  deg::debug_compare_graph_keys(deg_graph2, id_keys2, operation_keys2, relation_keys2);
+  bool is_equal = true;
+  is_equal &= deg::debug_compare_keys("ID", id_keys1, id_keys2);
+  is_equal &= deg::debug_compare_keys("operation", operation_keys1, operation_keys2);
+  is_equal &= deg::debug_compare_keys("relation", relation_keys1, relation_keys2);
+  return is_equal;
 }
 
 bool DEG_debug_graph_relations_validate(Depsgraph *graph,
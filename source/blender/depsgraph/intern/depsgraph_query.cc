@@ -79,6 +79,16 @@ float DEG_get_ctime(const Depsgraph *graph)
   return deg_graph->ctime;
 }
 
+uint64_t DEG_get_copy_on_write_generation(const Depsgraph *graph, ID *id)
+{
+  const deg::Depsgraph *deg_graph = reinterpret_cast<const deg::Depsgraph *>(graph);
+  const deg::IDNode *id_node = deg_graph->find_id_node(DEG_get_original_id(id));
+  if (id_node == nullptr) {
+    return 0;
+  }
+  return id_node->copy_on_write_generation;
+}
+
 bool DEG_id_type_updated(const Depsgraph *graph, short id_type)
 {
   const deg::Depsgraph *deg_graph = reinterpret_cast<const deg::Depsgraph *>(graph);
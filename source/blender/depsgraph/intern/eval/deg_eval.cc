@@ -25,12 +25,17 @@
 
 #include "intern/eval/deg_eval.h"
 
+#include <algorithm>
+
 #include "PIL_time.h"
 
 #include "BLI_compiler_attrs.h"
 #include "BLI_gsqueue.h"
+#include "BLI_heap.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "BKE_global.h"
 
@@ -43,6 +48,7 @@
 
 #include "atomic_ops.h"
 
+#include "intern/debug/deg_debug_trace.h"
 #include "intern/depsgraph.h"
 #include "intern/depsgraph_relation.h"
 #include "intern/eval/deg_eval_copy_on_write.h"
@@ -61,6 +67,7 @@ namespace {
 struct DepsgraphEvalState;
 
 void deg_task_run_func(TaskPool *pool, void *taskdata);
+void deg_task_run_priority_func(TaskPool *pool, void *taskdata);
 
 template<typename ScheduleFunction, typename... ScheduleFunctionArgs>
 void schedule_children(DepsgraphEvalState *state,
@@ -73,6 +80,10 @@ void schedule_node_to_pool(OperationNode *node, const int UNUSED(thread_id), Tas
   BLI_task_pool_push(pool, deg_task_run_func, node, false, nullptr);
 }
 
+void schedule_node_to_priority_queue(OperationNode *node,
+                                     const int UNUSED(thread_id),
+                                     TaskPool *pool);
+
 /* Denotes which part of dependency graph is being evaluated. */
 enum class EvaluationStage {
   /* Stage 1: Only  Copy-on-Write operations are to be evaluated, prior to anything else.
@@ -93,8 +104,20 @@ enum class EvaluationStage {
 struct DepsgraphEvalState {
   Depsgraph *graph;
   bool do_stats;
+  /* Record every evaluated operation, see #DEG_debug_trace_begin. */
+  bool do_trace;
+  /* Measure time of every operation, for statistics, tracing or priority scheduling. */
+  bool do_timing;
   EvaluationStage stage;
   bool need_single_thread_pass;
+
+  /* Dispatch ready operations in the order of their critical path time, so that long chains of
+   * operations start as early as possible. See #G_DEBUG_DEPSGRAPH_PRIORITY. */
+  bool use_priority_scheduling;
+  /* Operations which are ready to be evaluated, with the negated critical path time as value.
+   * Every operation pushed to the queue has a matching task in the pool. */
+  Heap *ready_queue;
+  SpinLock ready_queue_lock;
 };
 
 void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_node)
@@ -104,10 +127,14 @@ void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_nod
   /* Sanity checks. */
   BLI_assert(!operation_node->is_noop() && "NOOP nodes should not actually be scheduled");
   /* Perform operation. */
-  if (state->do_stats) {
+  if (state->do_timing) {
     const double start_time = PIL_check_seconds_timer();
     operation_node->evaluate(depsgraph);
-    operation_node->stats.current_time += PIL_check_seconds_timer() - start_time;
+    const double end_time = PIL_check_seconds_timer();
+    operation_node->stats.add_time(end_time - start_time);
+    if (state->do_trace) {
+      deg_debug_trace_operation(operation_node, start_time, end_time);
+    }
   }
   else {
     operation_node->evaluate(depsgraph);
@@ -127,7 +154,32 @@ void deg_task_run_func(TaskPool *pool, void *taskdata)
   schedule_children(state, operation_node, schedule_node_to_pool, pool);
 }
 
-bool check_operation_node_visible(OperationNode *op_node)
+void schedule_node_to_priority_queue(OperationNode *node,
+                                     const int UNUSED(thread_id),
+                                     TaskPool *pool)
+{
+  DepsgraphEvalState *state = (DepsgraphEvalState *)BLI_task_pool_user_data(pool);
+  BLI_spin_lock(&state->ready_queue_lock);
+  BLI_heap_insert(state->ready_queue, -node->critical_path_time, node);
+  BLI_spin_unlock(&state->ready_queue_lock);
+  /* The task doesn't evaluate this node, but the most important one which is ready by the time
+   * the task is executed. */
+  BLI_task_pool_push(pool, deg_task_run_priority_func, nullptr, false, nullptr);
+}
+
+void deg_task_run_priority_func(TaskPool *pool, void *UNUSED(taskdata))
+{
+  DepsgraphEvalState *state = (DepsgraphEvalState *)BLI_task_pool_user_data(pool);
+
+  BLI_spin_lock(&state->ready_queue_lock);
+  OperationNode *operation_node = (OperationNode *)BLI_heap_pop_min(state->ready_queue);
+  BLI_spin_unlock(&state->ready_queue_lock);
+
+  evaluate_node(state, operation_node);
+  schedule_children(state, operation_node, schedule_node_to_priority_queue, pool);
+}
+
+bool check_operation_node_visible(const OperationNode *op_node)
 {
   const ComponentNode *comp_node = op_node->owner;
   /* Special exception, copy on write component is to be always evaluated,
@@ -177,16 +229,88 @@ void calculate_pending_parents(Depsgraph *graph)
   }
 }
 
+bool need_evaluate_operation(const OperationNode *node)
+{
+  return (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) && check_operation_node_visible(node);
+}
+
+/* Relations along which the critical path is calculated: same as the ones counted in
+ * #calculate_pending_parents_for_node. */
+bool is_critical_path_relation(const Relation *rel)
+{
+  if (rel->flag & RELATION_FLAG_CYCLIC) {
+    return false;
+  }
+  if (rel->from->type != NodeType::OPERATION || rel->to->type != NodeType::OPERATION) {
+    return false;
+  }
+  return need_evaluate_operation((const OperationNode *)rel->from) &&
+         need_evaluate_operation((const OperationNode *)rel->to);
+}
+
+float operation_estimated_time(const OperationNode *node)
+{
+  if (node->is_noop()) {
+    return 0.0f;
+  }
+  /* Operations which were never timed still count, so that without any timing information the
+   * longest chain of operations goes first. */
+  return std::max((float)node->stats.average_time, 1e-6f);
+}
+
+/* Calculate the longest remaining path for every operation to be evaluated, going from the
+ * operations without children to their parents. The custom flags of the operations are used to
+ * count the children which are not handled yet. */
+void calculate_critical_path_times(Depsgraph *graph)
+{
+  Vector<OperationNode *> ready_nodes;
+  for (OperationNode *node : graph->operations) {
+    node->custom_flags = 0;
+    node->critical_path_time = 0.0f;
+    if (!need_evaluate_operation(node)) {
+      continue;
+    }
+    node->critical_path_time = operation_estimated_time(node);
+    for (Relation *rel : node->outlinks) {
+      if (is_critical_path_relation(rel)) {
+        node->custom_flags++;
+      }
+    }
+    if (node->custom_flags == 0) {
+      ready_nodes.append(node);
+    }
+  }
+
+  while (!ready_nodes.is_empty()) {
+    OperationNode *node = ready_nodes.pop_last();
+    for (Relation *rel : node->inlinks) {
+      if (!is_critical_path_relation(rel)) {
+        continue;
+      }
+      OperationNode *from = (OperationNode *)rel->from;
+      from->critical_path_time = std::max(from->critical_path_time,
+                                          operation_estimated_time(from) +
+                                              node->critical_path_time);
+      if (--from->custom_flags == 0) {
+        ready_nodes.append(from);
+      }
+    }
+  }
+}
+
 void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
 {
-  const bool do_stats = state->do_stats;
+  const bool do_timing = state->do_timing;
   calculate_pending_parents(graph);
   /* Clear tags and other things which needs to be clear. */
   for (OperationNode *node : graph->operations) {
-    if (do_stats) {
+    if (do_timing) {
       node->stats.reset_current();
     }
   }
+  if (state->use_priority_scheduling) {
+    calculate_critical_path_times(graph);
+  }
 }
 
 bool is_metaball_object_operation(const OperationNode *operation_node)
@@ -356,6 +480,19 @@ static TaskPool *deg_evaluate_task_pool_create(DepsgraphEvalState *state)
   return BLI_task_pool_create_suspended(state, TASK_PRIORITY_HIGH);
 }
 
+static void deg_evaluate_task_pool_run(DepsgraphEvalState *state)
+{
+  TaskPool *task_pool = deg_evaluate_task_pool_create(state);
+  if (state->use_priority_scheduling) {
+    schedule_graph(state, schedule_node_to_priority_queue, task_pool);
+  }
+  else {
+    schedule_graph(state, schedule_node_to_pool, task_pool);
+  }
+  BLI_task_pool_work_and_wait(task_pool);
+  BLI_task_pool_free(task_pool);
+}
+
 /**
  * Evaluate all nodes tagged for updating,
  * \warning This is usually done as part of main loop, but may also be
@@ -371,6 +508,7 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   }
 
   graph->debug.begin_graph_evaluation();
+  const double trace_start_time = deg_debug_trace_is_active() ? PIL_check_seconds_timer() : 0.0;
 
   graph->is_evaluating = true;
   depsgraph_ensure_view_layer(graph);
@@ -378,24 +516,33 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   DepsgraphEvalState state;
   state.graph = graph;
   state.do_stats = graph->debug.do_time_debug();
+  state.use_priority_scheduling = (G.debug & G_DEBUG_DEPSGRAPH_PRIORITY) &&
+                                  !(G.debug & G_DEBUG_DEPSGRAPH_NO_THREADS);
+  state.do_trace = deg_debug_trace_is_active();
+  state.do_timing = state.do_stats || state.do_trace || state.use_priority_scheduling;
   state.need_single_thread_pass = false;
+  state.ready_queue = nullptr;
+  if (state.use_priority_scheduling) {
+    state.ready_queue = BLI_heap_new();
+    BLI_spin_init(&state.ready_queue_lock);
+  }
   /* Prepare all nodes for evaluation. */
   initialize_execution(&state, graph);
 
   /* Do actual evaluation now. */
   /* First, process all Copy-On-Write nodes. */
   state.stage = EvaluationStage::COPY_ON_WRITE;
-  TaskPool *task_pool = deg_evaluate_task_pool_create(&state);
-  schedule_graph(&state, schedule_node_to_pool, task_pool);
-  BLI_task_pool_work_and_wait(task_pool);
-  BLI_task_pool_free(task_pool);
+  deg_evaluate_task_pool_run(&state);
 
   /* After that, process all other nodes. */
   state.stage = EvaluationStage::THREADED_EVALUATION;
-  task_pool = deg_evaluate_task_pool_create(&state);
-  schedule_graph(&state, schedule_node_to_pool, task_pool);
-  BLI_task_pool_work_and_wait(task_pool);
-  BLI_task_pool_free(task_pool);
+  deg_evaluate_task_pool_run(&state);
+
+  if (state.ready_queue != nullptr) {
+    BLI_assert(BLI_heap_is_empty(state.ready_queue));
+    BLI_heap_free(state.ready_queue, nullptr);
+    BLI_spin_end(&state.ready_queue_lock);
+  }
 
   if (state.need_single_thread_pass) {
     state.stage = EvaluationStage::SINGLE_THREADED_WORKAROUND;
@@ -412,6 +559,9 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   deg_graph_clear_tags(graph);
   graph->is_evaluating = false;
 
+  if (state.do_trace) {
+    deg_debug_trace_graph_evaluation(graph, trace_start_time, PIL_check_seconds_timer());
+  }
   graph->debug.end_graph_evaluation();
 }
 
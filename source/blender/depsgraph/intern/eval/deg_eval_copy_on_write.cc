@@ -41,11 +41,13 @@
 #include "BLI_utildefines.h"
 
 #include "BKE_curve.h"
+#include "BKE_customdata.h"
 #include "BKE_global.h"
 #include "BKE_gpencil.h"
 #include "BKE_idprop.h"
 #include "BKE_layer.h"
 #include "BKE_lib_id.h"
+#include "BKE_mesh.h"
 #include "BKE_scene.h"
 
 #include "DEG_depsgraph.h"
@@ -53,10 +55,13 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "DNA_ID.h"
 #include "DNA_anim_types.h"
 #include "DNA_armature_types.h"
 #include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
 #include "DNA_modifier_types.h"
 #include "DNA_object_types.h"
 #include "DNA_particle_types.h"
@@ -282,6 +287,72 @@ struct ValidateData {
   bool is_valid;
 };
 
+/* Whether the copy-on-write version of the ID can reference custom data arrays of the original
+ * instead of duplicating them.
+ *
+ * Evaluation never writes to the arrays of a copied mesh: modifiers duplicate referenced layers
+ * before modifying them, since the same copy is evaluated again on every update. The exception is
+ * animation, which writes to the arrays through RNA. Meshes in edit mode are copied fully, their
+ * original arrays are replaced when leaving edit mode. Which layers are shared is decided by
+ * #id_copy_custom_data_type_is_shared. */
+bool id_copy_can_reference_custom_data(const ID *id)
+{
+  if (GS(id->name) != ID_ME) {
+    return false;
+  }
+  const Mesh *mesh = reinterpret_cast<const Mesh *>(id);
+  return mesh->edit_mesh == nullptr && mesh->adt == nullptr;
+}
+
+/* The original mesh can be modified while another dependency graph (of a render job for example)
+ * evaluates its copy, so only layers which are not written to in place outside of edit mode are
+ * shared. Other layers are duplicated:
+ * - Vertices: normals are calculated in place by evaluation, sculpt mode moves vertices.
+ * - Edges and faces: paint modes write selection and hide flags.
+ * - Deform weights: weight paint reallocates the weights of vertices. Layers which own
+ *   allocations per element are never shared for the same reason.
+ * - Colors, masks and face sets: written by paint and sculpt modes. */
+bool id_copy_custom_data_type_is_shared(const int type)
+{
+  switch (type) {
+    case CD_MLOOP:
+    case CD_MLOOPUV:
+    case CD_CUSTOMLOOPNORMAL:
+    case CD_FREESTYLE_EDGE:
+    case CD_FREESTYLE_FACE:
+    case CD_PROP_FLOAT:
+    case CD_PROP_FLOAT2:
+    case CD_PROP_FLOAT3:
+    case CD_PROP_INT32:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void custom_data_ensure_mutable_layers(CustomData *data, const int totelem)
+{
+  for (int i = 0; i < data->totlayer; i++) {
+    const int type = data->layers[i].type;
+    if (!id_copy_custom_data_type_is_shared(type)) {
+      const int n = i - CustomData_get_layer_index(data, type);
+      CustomData_duplicate_referenced_layer_n(data, type, n, totelem);
+    }
+  }
+}
+
+/* Duplicate referenced layers which are not shared with the original. */
+void id_copy_ensure_mutable_custom_data(ID *id_cow)
+{
+  Mesh *mesh_cow = reinterpret_cast<Mesh *>(id_cow);
+  custom_data_ensure_mutable_layers(&mesh_cow->vdata, mesh_cow->totvert);
+  custom_data_ensure_mutable_layers(&mesh_cow->edata, mesh_cow->totedge);
+  custom_data_ensure_mutable_layers(&mesh_cow->fdata, mesh_cow->totface);
+  custom_data_ensure_mutable_layers(&mesh_cow->ldata, mesh_cow->totloop);
+  custom_data_ensure_mutable_layers(&mesh_cow->pdata, mesh_cow->totpoly);
+  BKE_mesh_update_customdata_pointers(mesh_cow, false);
+}
+
 /* Similar to generic BKE_id_copy() but does not require main and assumes pointer
  * is already allocated. */
 bool id_copy_inplace_no_main(const ID *id, ID *newid)
@@ -301,10 +372,13 @@ bool id_copy_inplace_no_main(const ID *id, ID *newid)
   id_for_copy = nested_id_hack_get_discarded_pointers(&id_hack_storage, id);
 #endif
 
-  bool result = (BKE_id_copy_ex(nullptr,
-                                (ID *)id_for_copy,
-                                &newid,
-                                LIB_ID_COPY_LOCALIZE | LIB_ID_CREATE_NO_ALLOCATE) != nullptr);
+  int flag = LIB_ID_COPY_LOCALIZE | LIB_ID_CREATE_NO_ALLOCATE;
+  const bool reference_custom_data = id_copy_can_reference_custom_data(id);
+  if (reference_custom_data) {
+    flag |= LIB_ID_COPY_CD_REFERENCE;
+  }
+
+  bool result = (BKE_id_copy_ex(nullptr, (ID *)id_for_copy, &newid, flag) != nullptr);
 
 #ifdef NESTED_ID_NASTY_WORKAROUND
   if (result) {
@@ -312,6 +386,10 @@ bool id_copy_inplace_no_main(const ID *id, ID *newid)
   }
 #endif
 
+  if (result && reference_custom_data) {
+    id_copy_ensure_mutable_custom_data(newid);
+  }
+
   return result;
 }
 
@@ -1076,9 +1154,9 @@ void deg_free_copy_on_write_datablock(ID *id_cow)
   id_cow->name[0] = '\0';
 }
 
-void deg_evaluate_copy_on_write(struct ::Depsgraph *graph, const IDNode *id_node)
+void deg_evaluate_copy_on_write(struct ::Depsgraph *graph, IDNode *id_node)
 {
-  const Depsgraph *depsgraph = reinterpret_cast<const Depsgraph *>(graph);
+  Depsgraph *depsgraph = reinterpret_cast<Depsgraph *>(graph);
   DEG_debug_print_eval(graph, __func__, id_node->id_orig->name, id_node->id_cow);
   if (id_node->id_orig == &depsgraph->scene->id) {
     /* NOTE: This is handled by eval_ctx setup routines, which
@@ -1086,6 +1164,8 @@ void deg_evaluate_copy_on_write(struct ::Depsgraph *graph, const IDNode *id_node
     return;
   }
   deg_update_copy_on_write_datablock(depsgraph, id_node);
+  id_node->copy_on_write_generation = atomic_add_and_fetch_uint64(
+      &depsgraph->copy_on_write_counter, 1);
 }
 
 bool deg_validate_copy_on_write_datablock(ID *id_cow)
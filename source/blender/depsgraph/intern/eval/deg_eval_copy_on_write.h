@@ -74,7 +74,7 @@ void deg_free_copy_on_write_datablock(struct ID *id_cow);
 /* Callback function for depsgraph operation node which ensures copy-on-write
  * datablock is ready for use by further evaluation routines.
  */
-void deg_evaluate_copy_on_write(struct ::Depsgraph *depsgraph, const struct IDNode *id_node);
+void deg_evaluate_copy_on_write(struct ::Depsgraph *depsgraph, struct IDNode *id_node);
 
 /* Check that given ID is properly expanded and does not have any shallow
  * copies inside. */
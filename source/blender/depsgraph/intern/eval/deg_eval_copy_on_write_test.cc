@@ -0,0 +1,176 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "tests/depsgraph_base_test.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_anim_data.h"
+#include "BKE_collection.h"
+#include "BKE_customdata.h"
+#include "BKE_deform.h"
+#include "BKE_layer.h"
+#include "BKE_lib_id.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BKE_object.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+#include "DEG_depsgraph_query.h"
+
+namespace blender::deg::tests {
+
+class CopyOnWriteTest : public DepsgraphBaseTest {
+ public:
+  /* Object with a grid of `size` by `size` vertices. */
+  Mesh *mesh_object_add(const char *name, const int size = 2)
+  {
+    Object *object = BKE_object_add_only_object(bmain, OB_MESH, name);
+    Mesh *mesh = (Mesh *)BKE_object_obdata_add_from_type(bmain, OB_MESH, name);
+    object->data = mesh;
+    mesh->totvert = size * size;
+    mesh->totedge = 2 * size * (size - 1);
+    mesh->totpoly = (size - 1) * (size - 1);
+    mesh->totloop = mesh->totpoly * 4;
+    CustomData_add_layer(&mesh->vdata, CD_MVERT, CD_CALLOC, nullptr, mesh->totvert);
+    CustomData_add_layer(&mesh->edata, CD_MEDGE, CD_CALLOC, nullptr, mesh->totedge);
+    CustomData_add_layer(&mesh->ldata, CD_MLOOP, CD_CALLOC, nullptr, mesh->totloop);
+    CustomData_add_layer(&mesh->pdata, CD_MPOLY, CD_CALLOC, nullptr, mesh->totpoly);
+    BKE_mesh_update_customdata_pointers(mesh, false);
+
+    const auto vert_index = [size](const int x, const int y) { return y * size + x; };
+    for (int y = 0; y < size; y++) {
+      for (int x = 0; x < size; x++) {
+        MVert *mv = &mesh->mvert[vert_index(x, y)];
+        mv->co[0] = (float)x;
+        mv->co[1] = (float)y;
+      }
+    }
+    /* Horizontal edges, then vertical edges. */
+    const int edges_x_num = (size - 1) * size;
+    const auto edge_x_index = [size](const int x, const int y) { return y * (size - 1) + x; };
+    const auto edge_y_index = [size, edges_x_num](const int x, const int y) {
+      return edges_x_num + x * (size - 1) + y;
+    };
+    for (int y = 0; y < size; y++) {
+      for (int x = 0; x < size - 1; x++) {
+        mesh->medge[edge_x_index(x, y)].v1 = vert_index(x, y);
+        mesh->medge[edge_x_index(x, y)].v2 = vert_index(x + 1, y);
+        mesh->medge[edge_y_index(y, x)].v1 = vert_index(y, x);
+        mesh->medge[edge_y_index(y, x)].v2 = vert_index(y, x + 1);
+      }
+    }
+    for (int y = 0; y < size - 1; y++) {
+      for (int x = 0; x < size - 1; x++) {
+        const int poly_index = y * (size - 1) + x;
+        MPoly *mp = &mesh->mpoly[poly_index];
+        mp->loopstart = poly_index * 4;
+        mp->totloop = 4;
+        MLoop *ml = &mesh->mloop[mp->loopstart];
+        ml[0].v = vert_index(x, y);
+        ml[0].e = edge_x_index(x, y);
+        ml[1].v = vert_index(x + 1, y);
+        ml[1].e = edge_y_index(x + 1, y);
+        ml[2].v = vert_index(x + 1, y + 1);
+        ml[2].e = edge_x_index(x, y + 1);
+        ml[3].v = vert_index(x, y + 1);
+        ml[3].e = edge_y_index(x, y);
+      }
+    }
+
+    BKE_collection_object_add(bmain, scene->master_collection, object);
+    BKE_main_collection_sync(bmain);
+    return mesh;
+  }
+
+  void graph_build_and_evaluate()
+  {
+    DEG_graph_build_from_view_layer(graph);
+    DEG_evaluate_on_refresh(graph);
+    DEG_ids_clear_recalc(bmain, graph);
+  }
+};
+
+TEST_F(CopyOnWriteTest, mesh_references_original_arrays)
+{
+  Mesh *mesh = mesh_object_add("Mesh");
+  CustomData_add_layer(&mesh->ldata, CD_MLOOPUV, CD_CALLOC, nullptr, mesh->totloop);
+  CustomData_add_layer(&mesh->ldata, CD_MLOOPCOL, CD_CALLOC, nullptr, mesh->totloop);
+  CustomData_add_layer(&mesh->vdata, CD_MDEFORMVERT, CD_CALLOC, nullptr, mesh->totvert);
+  BKE_mesh_update_customdata_pointers(mesh, false);
+  BKE_defvert_add_index_notest(&mesh->dvert[0], 0, 1.0f);
+  graph_build_and_evaluate();
+
+  const Mesh *mesh_cow = (const Mesh *)DEG_get_evaluated_id(graph, &mesh->id);
+  ASSERT_NE(mesh_cow, mesh);
+  EXPECT_EQ(mesh_cow->mloop, mesh->mloop);
+  EXPECT_EQ(mesh_cow->mloopuv, mesh->mloopuv);
+  /* Vertex normals are written by evaluation, flags and colors by paint modes. */
+  EXPECT_NE(mesh_cow->mvert, mesh->mvert);
+  EXPECT_EQ(memcmp(mesh_cow->mvert, mesh->mvert, sizeof(MVert) * mesh->totvert), 0);
+  EXPECT_NE(mesh_cow->medge, mesh->medge);
+  EXPECT_NE(mesh_cow->mpoly, mesh->mpoly);
+  EXPECT_NE(mesh_cow->mloopcol, mesh->mloopcol);
+  /* Weight paint reallocates the weights of vertices. */
+  ASSERT_NE(mesh_cow->dvert, nullptr);
+  EXPECT_NE(mesh_cow->dvert, mesh->dvert);
+  EXPECT_NE(mesh_cow->dvert[0].dw, mesh->dvert[0].dw);
+}
+
+TEST_F(CopyOnWriteTest, animated_mesh_is_copied)
+{
+  Mesh *mesh = mesh_object_add("Mesh");
+  BKE_animdata_add_id(&mesh->id);
+  graph_build_and_evaluate();
+
+  const Mesh *mesh_cow = (const Mesh *)DEG_get_evaluated_id(graph, &mesh->id);
+  EXPECT_NE(mesh_cow->medge, mesh->medge);
+  EXPECT_NE(mesh_cow->mloop, mesh->mloop);
+  EXPECT_NE(mesh_cow->mpoly, mesh->mpoly);
+  EXPECT_NE(mesh_cow->mvert, mesh->mvert);
+}
+
+/* Memory used by building and evaluating the graph of a mesh with UVs, compared to a copy of the
+ * mesh. */
+TEST_F(CopyOnWriteTest, performance_memory_500)
+{
+  Mesh *mesh = mesh_object_add("Mesh", 500);
+  CustomData_add_layer(&mesh->ldata, CD_MLOOPUV, CD_CALLOC, nullptr, mesh->totloop);
+  BKE_mesh_update_customdata_pointers(mesh, false);
+
+  size_t mem_start = MEM_get_memory_in_use();
+  ID *mesh_copy = BKE_id_copy_ex(nullptr, &mesh->id, nullptr, LIB_ID_COPY_LOCALIZE);
+  const size_t mem_copy = MEM_get_memory_in_use() - mem_start;
+  BKE_id_free(nullptr, mesh_copy);
+
+  mem_start = MEM_get_memory_in_use();
+  graph_build_and_evaluate();
+  const size_t mem_graph = MEM_get_memory_in_use() - mem_start;
+
+  printf("Mesh copy: %.2f MB, dependency graph with copy-on-write mesh: %.2f MB\n",
+         (double)mem_copy / (1024.0 * 1024.0),
+         (double)mem_graph / (1024.0 * 1024.0));
+  EXPECT_LT(mem_graph, mem_copy);
+}
+
+}  // namespace blender::deg::tests
@@ -278,6 +278,7 @@ Node::Stats::Stats()
 void Node::Stats::reset()
 {
   current_time = 0.0;
+  average_time = 0.0;
 }
 
 void Node::Stats::reset_current()
@@ -285,6 +286,18 @@ void Node::Stats::reset_current()
   current_time = 0.0;
 }
 
+void Node::Stats::add_time(double time)
+{
+  current_time += time;
+  /* Exponential moving average, adapts to changes in the scene within a few frames. */
+  if (average_time == 0.0) {
+    average_time = time;
+  }
+  else {
+    average_time += (time - average_time) * 0.25;
+  }
+}
+
 /*******************************************************************************
  * Node itself.
  */
@@ -305,6 +318,20 @@ Node::~Node()
   }
 }
 
+void Node::unlink_relations()
+{
+  while (!inlinks.is_empty()) {
+    Relation *rel = inlinks[0];
+    rel->unlink();
+    delete rel;
+  }
+  while (!outlinks.is_empty()) {
+    Relation *rel = outlinks[0];
+    rel->unlink();
+    delete rel;
+  }
+}
+
 /* Generic identifier for Depsgraph Nodes. */
 string Node::identifier() const
 {
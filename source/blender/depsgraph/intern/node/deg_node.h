@@ -161,8 +161,12 @@ struct Node {
     /* Reset counters needed for the current graph evaluation, does not
      * touch averaging accumulators. */
     void reset_current();
+    /* Add time spent on evaluating the node, to the current time and the average. */
+    void add_time(double time);
     /* Time spend on this node during current graph evaluation. */
     double current_time;
+    /* Running average of the evaluation time over the previous evaluations. */
+    double average_time;
   };
   /* Relationships between nodes
    * The reason why all depsgraph nodes are descended from this type (apart
@@ -188,6 +192,9 @@ struct Node {
 
   virtual string identifier() const;
 
+  /* Remove all relations of this node from both of their sides, and free them. */
+  void unlink_relations();
+
   virtual void init(const ID * /*id*/, const char * /*subdata*/)
   {
   }
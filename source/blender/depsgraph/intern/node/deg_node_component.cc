@@ -177,6 +177,18 @@ OperationNode *ComponentNode::add_operation(const DepsEvalOperationCb &op,
     DepsNodeFactory *factory = type_get_factory(NodeType::OPERATION);
     op_node = (OperationNode *)factory->create_node(this->owner->id_orig, "", name);
 
+    if (operations_map == nullptr) {
+      /* Component was finalized by a previous build, which happens when relations are updated
+       * incrementally. Go back to the construction state. */
+      operations_map = new Map<ComponentNode::OperationIDKey, OperationNode *>();
+      for (OperationNode *op_existing : operations) {
+        OperationIDKey key_existing(
+            op_existing->opcode, op_existing->name.c_str(), op_existing->name_tag);
+        operations_map->add_new(key_existing, op_existing);
+      }
+      operations.clear();
+    }
+
     /* register opnode in this component's operation set */
     OperationIDKey key(opcode, name, name_tag);
     operations_map->add(key, op_node);
@@ -289,6 +301,10 @@ OperationNode *ComponentNode::get_exit_operation()
 
 void ComponentNode::finalize_build(Depsgraph * /*graph*/)
 {
+  if (operations_map == nullptr) {
+    /* Kept from a previous build by an incremental relations update. */
+    return;
+  }
   operations.reserve(operations_map->size());
   for (OperationNode *op_node : operations_map->values()) {
     operations.append(op_node);
@@ -89,6 +89,7 @@ void IDNode::init(const ID *id, const char *UNUSED(subdata))
   is_collection_fully_expanded = false;
   has_base = false;
   is_user_modified = false;
+  copy_on_write_generation = 0;
 
   visible_components_mask = 0;
   previously_visible_components_mask = 0;
@@ -110,6 +110,10 @@ struct IDNode : public Node {
   /* Accumulated flag from operation. Is initialized and used during updates flush. */
   bool is_user_modified;
 
+  /* Unique value assigned whenever the copy-on-write datablock is updated from the original,
+   * see #DEG_get_copy_on_write_generation(). Zero until the first update of this node. */
+  uint64_t copy_on_write_generation;
+
   IDComponentsMask visible_components_mask;
   IDComponentsMask previously_visible_components_mask;
 
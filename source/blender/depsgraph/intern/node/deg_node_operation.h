@@ -126,6 +126,8 @@ enum class OperationCode {
   /* IK/Spline Solvers */
   POSE_IK_SOLVER,
   POSE_SPLINE_IK_SOLVER,
+  /* All bones of a pose without external dependencies, in one operation. */
+  POSE_BATCH,
 
   /* Bone. ---------------------------------------------------------------- */
   /* Bone local transforms - entry point */
@@ -223,6 +225,9 @@ enum OperationFlag {
    * outgoing relations. This is for NO-OP nodes that are purely used to indicate a
    * relation between components/IDs, and not for connecting to an operation. */
   DEPSOP_FLAG_PINNED = (1 << 3),
+  /* Incoming relations of this NO-OP node were removed since nothing depended on it, see
+   * #deg_graph_remove_unused_noops(). */
+  DEPSOP_FLAG_UNUSED_NOOP = (1 << 4),
 
   /* Set of flags which gets flushed along the relations. */
   DEPSOP_FLAG_FLUSH = (DEPSOP_FLAG_USER_MODIFIED),
@@ -266,6 +271,11 @@ struct OperationNode : public Node {
   uint32_t num_links_pending;
   bool scheduled;
 
+  /* Estimated time of the longest chain of operations which is to be evaluated after this one,
+   * including this operation itself. Only calculated for priority scheduling, where the ready
+   * operation with the longest chain is evaluated first. */
+  float critical_path_time;
+
   /* Identifier for the operation being performed. */
   OperationCode opcode;
   int name_tag;
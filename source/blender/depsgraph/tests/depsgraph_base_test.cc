@@ -0,0 +1,78 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "depsgraph_base_test.h"
+
+#include "BKE_appdir.h"
+#include "BKE_idtype.h"
+#include "BKE_layer.h"
+#include "BKE_main.h"
+#include "BKE_modifier.h"
+#include "BKE_scene.h"
+
+#include "BLI_threads.h"
+
+#include "DEG_depsgraph.h"
+
+#include "IMB_imbuf.h"
+
+#include "RNA_define.h"
+
+#include "CLG_log.h"
+
+namespace blender::deg::tests {
+
+void DepsgraphBaseTest::SetUpTestCase()
+{
+  /* Color management is used by new scenes. */
+  CLG_init();
+  BLI_threadapi_init();
+  BKE_idtype_init();
+  BKE_appdir_init();
+  IMB_init();
+  RNA_init();
+  BKE_modifier_init();
+  DEG_register_node_types();
+}
+
+void DepsgraphBaseTest::TearDownTestCase()
+{
+  DEG_free_node_types();
+  RNA_exit();
+  IMB_exit();
+  BLI_threadapi_exit();
+  CLG_exit();
+}
+
+void DepsgraphBaseTest::SetUp()
+{
+  bmain = BKE_main_new();
+  scene = BKE_scene_add(bmain, "Scene");
+  view_layer = BKE_view_layer_default_view(scene);
+  graph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_VIEWPORT);
+}
+
+void DepsgraphBaseTest::TearDown()
+{
+  if (graph != nullptr) {
+    DEG_graph_free(graph);
+    graph = nullptr;
+  }
+  BKE_main_free(bmain);
+}
+
+}  // namespace blender::deg::tests
@@ -0,0 +1,49 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#pragma once
+
+#include "testing/testing.h"
+
+struct Depsgraph;
+struct Main;
+struct Scene;
+struct ViewLayer;
+
+namespace blender::deg::tests {
+
+/* Main database with an empty scene and a viewport dependency graph of its view layer.
+ * Tests add data-blocks to the scene, then build and evaluate the graph themselves. */
+class DepsgraphBaseTest : public testing::Test {
+ public:
+  Main *bmain = nullptr;
+  Scene *scene = nullptr;
+  ViewLayer *view_layer = nullptr;
+  ::Depsgraph *graph = nullptr;
+
+  /* Sets up Blender just enough to build and evaluate dependency graphs, including animation
+   * through RNA and modifiers. */
+  static void SetUpTestCase();
+  static void TearDownTestCase();
+
+ protected:
+  void SetUp() override;
+  /* Frees the dependency graph (when not null) and the main database. */
+  void TearDown() override;
+};
+
+}  // namespace blender::deg::tests
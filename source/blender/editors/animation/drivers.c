@@ -1016,7 +1016,7 @@ static int add_driver_button_none(bContext *C, wmOperator *op, short mapping_typ
   if (success) {
     /* send updates */
     UI_context_update_anim_flag(C);
-    DEG_relations_tag_update(CTX_data_main(C));
+    DEG_id_tag_relations_update(CTX_data_main(C), ptr.owner_id);
     WM_event_add_notifier(C, NC_ANIMATION | ND_FCURVES_ORDER, NULL); /* XXX */
 
     return OPERATOR_FINISHED;
@@ -1169,7 +1169,7 @@ static int remove_driver_button_exec(bContext *C, wmOperator *op)
   if (changed) {
     /* send updates */
     UI_context_update_anim_flag(C);
-    DEG_relations_tag_update(CTX_data_main(C));
+    DEG_id_tag_relations_update(CTX_data_main(C), ptr.owner_id);
     WM_event_add_notifier(C, NC_ANIMATION | ND_FCURVES_ORDER, NULL); /* XXX */
   }
 
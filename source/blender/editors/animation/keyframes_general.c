@@ -632,9 +632,10 @@ void sample_fcurve(FCurve *fcu)
           value_cache = MEM_callocN(sizeof(TempFrameValCache) * range, "IcuFrameValCache");
 
           /* sample values */
+          FCurveSegmentCursor cursor = FCURVE_SEGMENT_CURSOR_INIT;
           for (n = 1, fp = value_cache; n < range && fp; n++, fp++) {
             fp->frame = (float)(sfra + n);
-            fp->val = evaluate_fcurve(fcu, fp->frame);
+            fp->val = evaluate_fcurve_cursor(fcu, fp->frame, &cursor);
           }
 
           /* add keyframes with these, tagging as 'breakdowns' */
@@ -87,6 +87,10 @@ void ED_undosys_type_free(void);
 
 /* memfile_undo.c */
 struct MemFile *ED_undosys_stack_memfile_get_active(struct UndoStack *ustack);
+void ED_undosys_stack_memfile_stats_get(struct UndoStack *ustack,
+                                        size_t *r_size,
+                                        size_t *r_size_total,
+                                        size_t *r_size_shared_by_content);
 
 #ifdef __cplusplus
 }
@@ -235,7 +235,7 @@ ModifierData *ED_object_modifier_add(
   }
 
   DEG_id_tag_update(&ob->id, ID_RECALC_GEOMETRY);
-  DEG_relations_tag_update(bmain);
+  DEG_id_tag_relations_update(bmain, &ob->id);
 
   return new_md;
 }
@@ -399,7 +399,7 @@ bool ED_object_modifier_remove(
   }
 
   DEG_id_tag_update(&ob->id, ID_RECALC_GEOMETRY);
-  DEG_relations_tag_update(bmain);
+  DEG_id_tag_relations_update(bmain, &ob->id);
 
   return true;
 }
@@ -422,7 +422,7 @@ void ED_object_modifier_clear(Main *bmain, Scene *scene, Object *ob)
   }
 
   DEG_id_tag_update(&ob->id, ID_RECALC_GEOMETRY);
-  DEG_relations_tag_update(bmain);
+  DEG_id_tag_relations_update(bmain, &ob->id);
 }
 
 bool ED_object_modifier_move_up(ReportList *reports, Object *ob, ModifierData *md)
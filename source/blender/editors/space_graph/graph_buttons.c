@@ -985,6 +985,19 @@ static void graph_draw_driver_settings_panel(uiLayout *layout,
       else {
         uiItemL(col, TIP_("Slow Python expression"), ICON_INFO);
       }
+
+      /* Show what keeps the expression from being evaluated without Python. */
+      int error_offset;
+      const char *error = BKE_driver_simple_expression_error(driver, &error_offset);
+      if (error) {
+        char error_buf[128];
+        BLI_snprintf(error_buf,
+                     sizeof(error_buf),
+                     TIP_("Not a simple expression, %s at: %s"),
+                     TIP_(error),
+                     driver->expression + error_offset);
+        uiItemL(col, error_buf, ICON_NONE);
+      }
     }
 
     /* Explicit bpy-references are evil. Warn about these to prevent errors */
@@ -646,9 +646,12 @@ static void draw_fcurve_curve(bAnimContext *ac, ID *id, FCurve *fcu_, View2D *v2
   if (n > 0) {
     immBegin(GPU_PRIM_LINE_STRIP, (n + 1));
 
+    /* Consecutive samples mostly fall into the same keyframe segment. */
+    FCurveSegmentCursor cursor = FCURVE_SEGMENT_CURSOR_INIT;
     for (int i = 0; i <= n; i++) {
       float ctime = stime + i * samplefreq;
-      immVertex2f(pos, ctime, (evaluate_fcurve(&fcurve_for_draw, ctime) + offset) * unitFac);
+      const float value = evaluate_fcurve_cursor(&fcurve_for_draw, ctime, &cursor);
+      immVertex2f(pos, ctime, (value + offset) * unitFac);
     }
 
     immEnd();
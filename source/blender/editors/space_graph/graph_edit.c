@@ -447,11 +447,12 @@ static void create_ghost_curves(bAnimContext *ac, int start, int end)
     gcu->totvert = end - start + 1;
 
     /* Use the sampling callback at 1-frame intervals from start to end frames. */
+    FCurveSegmentCursor cursor = FCURVE_SEGMENT_CURSOR_INIT;
     for (cfra = start; cfra <= end; cfra++, fpt++) {
       float cfrae = BKE_nla_tweakedit_remap(adt, cfra, NLATIME_CONVERT_UNMAP);
 
       fpt->vec[0] = cfrae;
-      fpt->vec[1] = (fcurve_samplingcb_evalcurve(fcu, NULL, cfrae) + offset) * unitFac;
+      fpt->vec[1] = (fcurve_samplingcb_evalcurve(fcu, &cursor, cfrae) + offset) * unitFac;
     }
 
     /* Set color of ghost curve
@@ -1804,7 +1805,8 @@ static void bake_graph_curves(bAnimContext *ac, int start, int end)
     fcu->driver = NULL;
 
     /* Create samples. */
-    fcurve_store_samples(fcu, NULL, start, end, fcurve_samplingcb_evalcurve);
+    FCurveSegmentCursor cursor = FCURVE_SEGMENT_CURSOR_INIT;
+    fcurve_store_samples(fcu, &cursor, start, end, fcurve_samplingcb_evalcurve);
 
     /* Restore driver. */
     fcu->driver = driver;
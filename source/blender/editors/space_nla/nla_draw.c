@@ -335,8 +335,10 @@ static void nla_draw_strip_curves(NlaStrip *strip, float yminc, float ymaxc, uin
       /* sample at 1 frame intervals, and draw
        * - min y-val is yminc, max is y-maxc, so clamp in those regions
        */
+      FCurveSegmentCursor cursor = FCURVE_SEGMENT_CURSOR_INIT;
       for (cfra = strip->start; cfra <= strip->end; cfra += 1.0f) {
-        float y = evaluate_fcurve(fcu, cfra); /* assume this to be in 0-1 range */
+        /* assume this to be in 0-1 range */
+        float y = evaluate_fcurve_cursor(fcu, cfra, &cursor);
         CLAMP(y, 0.0f, 1.0f);
         immVertex2f(pos, cfra, ((y * yheight) + yminc));
       }
@@ -31,6 +31,7 @@
 #include "DNA_scene_types.h"
 
 #include "BLI_listbase.h"
+#include "BLI_string.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
@@ -751,6 +752,26 @@ static int undo_history_invoke(bContext *C, wmOperator *op, const wmEvent *UNUSE
 
       MEM_freeN((void *)item);
 
+      /* Global undo memory usage, steps share unchanged data. */
+      size_t size, size_total, size_shared_by_content;
+      ED_undosys_stack_memfile_stats_get(
+          CTX_wm_manager(C)->undo_stack, &size, &size_total, &size_shared_by_content);
+      if (size_total != 0) {
+        char size_str[15], size_total_str[15], size_shared_str[15];
+        char info[256];
+        BLI_str_format_byte_unit(size_str, (long long int)size, false);
+        BLI_str_format_byte_unit(size_total_str, (long long int)size_total, false);
+        BLI_str_format_byte_unit(size_shared_str, (long long int)size_shared_by_content, false);
+        BLI_snprintf(info,
+                     sizeof(info),
+                     TIP_("Global undo memory: %s for %s of data (%s shared by content)"),
+                     size_str,
+                     size_total_str,
+                     size_shared_str);
+        uiItemS(layout);
+        uiItemL(layout, info, ICON_NONE);
+      }
+
       UI_popup_menu_end(C, pup);
     }
   }
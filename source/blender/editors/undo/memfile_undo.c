@@ -24,6 +24,7 @@
 #include "BLI_utildefines.h"
 
 #include "BLI_ghash.h"
+#include "BLI_listbase.h"
 
 #include "DNA_node_types.h"
 #include "DNA_object_enums.h"
@@ -262,6 +263,9 @@ static void memfile_undosys_step_free(UndoStep *us_p)
     if (us_next_p != NULL) {
       MemFileUndoStep *us_next = (MemFileUndoStep *)us_next_p;
       BLO_memfile_merge(&us->data->memfile, &us_next->data->memfile);
+      /* The next step may have taken ownership of some memory. */
+      us_next->data->undo_size = us_next->data->memfile.size;
+      us_next->step.data_size = us_next->data->undo_size;
     }
   }
 
@@ -307,4 +311,29 @@ struct MemFile *ED_undosys_stack_memfile_get_active(UndoStack *ustack)
   return NULL;
 }
 
+/**
+ * Memory statistics of all global undo steps of the stack.
+ *
+ * \param r_size: Memory actually used.
+ * \param r_size_total: Size of the data stored, as if nothing was shared between steps.
+ * \param r_size_shared_by_content: Part of the shared data that was found by content.
+ */
+void ED_undosys_stack_memfile_stats_get(UndoStack *ustack,
+                                        size_t *r_size,
+                                        size_t *r_size_total,
+                                        size_t *r_size_shared_by_content)
+{
+  *r_size = 0;
+  *r_size_total = 0;
+  *r_size_shared_by_content = 0;
+  LISTBASE_FOREACH (UndoStep *, us, &ustack->steps) {
+    if (us->type == BKE_UNDOSYS_TYPE_MEMFILE) {
+      const struct MemFile *memfile = ed_undosys_step_get_memfile(us);
+      *r_size += memfile->size;
+      *r_size_total += memfile->size_total;
+      *r_size_shared_by_content += memfile->size_shared_by_content;
+    }
+  }
+}
+
 /** \} */
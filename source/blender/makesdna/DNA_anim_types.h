@@ -1093,6 +1093,8 @@ typedef struct AnimData {
 
   /** Runtime data, for depsgraph evaluation. */
   FCurve **driver_array;
+  /** Runtime data, resolved RNA paths of the active action for depsgraph evaluation. */
+  struct AnimBindingCache *binding_cache;
 
   /* settings for animation evaluation */
   /** User-defined settings. */
@@ -165,6 +165,8 @@ typedef enum eArmature_Flag {
   ARM_DS_EXPAND = (1 << 13),
   /** other objects are used for visualizing various states (hack for efficient updates) */
   ARM_HAS_VIZ_DEPS = (1 << 14),
+  /** evaluate all bones of the pose in a single dependency graph operation */
+  ARM_POSE_BATCH = (1 << 15),
 } eArmature_Flag;
 
 /* armature->drawtype */
@@ -53,6 +53,11 @@ typedef struct CustomDataLayer {
   char name[64];
   /** Layer data. */
   void *data;
+  /**
+   * Run-time only, user count of data shared with layers copied with #CD_REFERENCE.
+   * NULL when the data has not been shared.
+   */
+  struct CustomDataLayerSharing *sharing;
 } CustomDataLayer;
 
 #define MAX_CUSTOMDATA_LAYER_NAME 64
@@ -88,7 +88,11 @@ typedef struct Mesh_Runtime {
   void *batch_cache;
 
   struct SubdivCCG *subdiv_ccg;
-  void *_pad1;
+  /**
+   * Trees of the previous evaluated mesh which was used as `mesh_eval`,
+   * handed over to the next one, see #bvhcache_release_for_reuse.
+   */
+  struct BVHCache *bvh_cache_reuse;
   int subdiv_ccg_tot_level;
   char _pad2[4];
 
@@ -2002,6 +2002,7 @@ typedef struct WeldModifierData {
 /* WeldModifierData->flag */
 enum {
   MOD_WELD_INVERT_VGROUP = (1 << 0),
+  MOD_WELD_MERGE_CHAINS = (1 << 1),
 };
 
 typedef struct DataTransferModifierData {
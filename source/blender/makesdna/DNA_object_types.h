@@ -38,6 +38,7 @@ extern "C" {
 
 struct AnimData;
 struct BoundBox;
+struct BVHCache;
 struct DerivedMesh;
 struct FluidsimSettings;
 struct GpencilBatchCache;
@@ -177,6 +178,18 @@ typedef struct Object_Runtime {
   /** Runtime evaluated curve-specific data, not stored in the file. */
   struct CurveCache *curve_cache;
 
+  /**
+   * Trees of the previous evaluated mesh, kept when the evaluated data is freed to refit them
+   * for the next one, see #bvhcache_release_for_reuse.
+   */
+  struct BVHCache *bvh_cache_reuse;
+
+  /**
+   * Smooth fans of the split normals of the evaluated mesh, reused as long as topology and
+   * sharp edges stay the same, see #BKE_mesh_calc_normals_split_cached.
+   */
+  struct MeshLoopSplitCache *loop_split_cache;
+
   unsigned short local_collections_bits;
   short _pad2[3];
 } Object_Runtime;
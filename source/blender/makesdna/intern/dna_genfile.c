@@ -1133,6 +1133,9 @@ typedef struct DNA_ReconstructInfo {
 
   int *step_counts;
   ReconstructStep **steps;
+  /** True for structs whose steps are all #RECONSTRUCT_STEP_MEMCPY (e.g. when members were only
+   * added or removed), which are reconstructed without going through #reconstruct_struct. */
+  bool *steps_memcpy_only;
 } DNA_ReconstructInfo;
 
 static void reconstruct_structs(const DNA_ReconstructInfo *reconstruct_info,
@@ -1200,6 +1203,42 @@ static void reconstruct_struct(const DNA_ReconstructInfo *reconstruct_info,
   }
 }
 
+/**
+ * Fast path for structs that only need parts of the old struct to be copied, with gaps in between
+ * (the gaps are already zeroed). Avoids the per member dispatch of #reconstruct_struct, the common
+ * single step case is a plain strided copy.
+ */
+static void reconstruct_structs_memcpy(const ReconstructStep *steps,
+                                       const int step_count,
+                                       const int blocks,
+                                       const int old_block_size,
+                                       const int new_block_size,
+                                       const char *old_blocks,
+                                       char *new_blocks)
+{
+  if (step_count == 1) {
+    const char *old_data = old_blocks + steps[0].data.memcpy.old_offset;
+    char *new_data = new_blocks + steps[0].data.memcpy.new_offset;
+    const size_t size = (size_t)steps[0].data.memcpy.size;
+    for (int a = 0; a < blocks; a++) {
+      memcpy(new_data, old_data, size);
+      old_data += old_block_size;
+      new_data += new_block_size;
+    }
+    return;
+  }
+
+  for (int a = 0; a < blocks; a++) {
+    const char *old_block = old_blocks + (size_t)a * old_block_size;
+    char *new_block = new_blocks + (size_t)a * new_block_size;
+    for (int b = 0; b < step_count; b++) {
+      memcpy(new_block + steps[b].data.memcpy.new_offset,
+             old_block + steps[b].data.memcpy.old_offset,
+             (size_t)steps[b].data.memcpy.size);
+    }
+  }
+}
+
 /** Reconstructs an array of structs. */
 static void reconstruct_structs(const DNA_ReconstructInfo *reconstruct_info,
                                 const int blocks,
@@ -1214,9 +1253,20 @@ static void reconstruct_structs(const DNA_ReconstructInfo *reconstruct_info,
   const int old_block_size = reconstruct_info->oldsdna->types_size[old_struct->type];
   const int new_block_size = reconstruct_info->newsdna->types_size[new_struct->type];
 
+  if (reconstruct_info->steps_memcpy_only[new_struct_nr]) {
+    reconstruct_structs_memcpy(reconstruct_info->steps[new_struct_nr],
+                               reconstruct_info->step_counts[new_struct_nr],
+                               blocks,
+                               old_block_size,
+                               new_block_size,
+                               old_blocks,
+                               new_blocks);
+    return;
+  }
+
   for (int a = 0; a < blocks; a++) {
-    const char *old_block = old_blocks + a * old_block_size;
-    char *new_block = new_blocks + a * new_block_size;
+    const char *old_block = old_blocks + (size_t)a * old_block_size;
+    char *new_block = new_blocks + (size_t)a * new_block_size;
     reconstruct_struct(reconstruct_info, new_struct_nr, old_block, new_block);
   }
 }
@@ -1233,24 +1283,74 @@ void *DNA_struct_reconstruct(const DNA_ReconstructInfo *reconstruct_info,
                              int blocks,
                              const void *old_blocks)
 {
-  const SDNA *oldsdna = reconstruct_info->oldsdna;
-  const SDNA *newsdna = reconstruct_info->newsdna;
+  const int new_block_size = DNA_struct_reconstruct_size(reconstruct_info, old_struct_nr);
+
+  if (new_block_size == 0) {
+    return NULL;
+  }
+
+  char *new_blocks = MEM_callocN((size_t)blocks * (size_t)new_block_size, "reconstruct");
+  DNA_struct_reconstruct_range(reconstruct_info, old_struct_nr, 0, blocks, old_blocks, new_blocks);
+  return new_blocks;
+}
 
+/** Index of the struct in newsdna matching the given struct of oldsdna, -1 if there is none. */
+static int reconstruct_new_struct_nr(const DNA_ReconstructInfo *reconstruct_info,
+                                     const int old_struct_nr)
+{
+  const SDNA *oldsdna = reconstruct_info->oldsdna;
   const SDNA_Struct *old_struct = oldsdna->structs[old_struct_nr];
   const char *type_name = oldsdna->types[old_struct->type];
-  const int new_struct_nr = DNA_struct_find_nr(newsdna, type_name);
+  return DNA_struct_find_nr(reconstruct_info->newsdna, type_name);
+}
 
+/**
+ * \return The size of a single reconstructed struct,
+ * zero when the struct does not exist anymore in newsdna.
+ */
+int DNA_struct_reconstruct_size(const DNA_ReconstructInfo *reconstruct_info, int old_struct_nr)
+{
+  const int new_struct_nr = reconstruct_new_struct_nr(reconstruct_info, old_struct_nr);
   if (new_struct_nr == -1) {
-    return NULL;
+    return 0;
   }
+  const SDNA *newsdna = reconstruct_info->newsdna;
+  return newsdna->types_size[newsdna->structs[new_struct_nr]->type];
+}
 
-  const SDNA_Struct *new_struct = newsdna->structs[new_struct_nr];
-  const int new_block_size = newsdna->types_size[new_struct->type];
+/**
+ * Reconstructs part of an array of structs into memory allocated by the caller, so that large
+ * arrays can be split over multiple threads (the reconstruct info is not modified).
+ *
+ * \param blocks_start: The index of the first array element to reconstruct.
+ * \param blocks: The number of array elements to reconstruct.
+ * \param old_blocks: The whole array of old struct data.
+ * \param new_blocks: The whole array of new struct data, zero initialized,
+ * of #DNA_struct_reconstruct_size bytes per element.
+ */
+void DNA_struct_reconstruct_range(const DNA_ReconstructInfo *reconstruct_info,
+                                  int old_struct_nr,
+                                  int blocks_start,
+                                  int blocks,
+                                  const void *old_blocks,
+                                  void *new_blocks)
+{
+  const int new_struct_nr = reconstruct_new_struct_nr(reconstruct_info, old_struct_nr);
+  if (new_struct_nr == -1) {
+    return;
+  }
 
-  char *new_blocks = MEM_callocN(blocks * new_block_size, "reconstruct");
-  reconstruct_structs(
-      reconstruct_info, blocks, old_struct_nr, new_struct_nr, old_blocks, new_blocks);
-  return new_blocks;
+  const SDNA *oldsdna = reconstruct_info->oldsdna;
+  const SDNA *newsdna = reconstruct_info->newsdna;
+  const size_t old_block_size = (size_t)oldsdna->types_size[oldsdna->structs[old_struct_nr]->type];
+  const size_t new_block_size = (size_t)newsdna->types_size[newsdna->structs[new_struct_nr]->type];
+
+  reconstruct_structs(reconstruct_info,
+                      blocks,
+                      old_struct_nr,
+                      new_struct_nr,
+                      (const char *)old_blocks + (size_t)blocks_start * old_block_size,
+                      (char *)new_blocks + (size_t)blocks_start * new_block_size);
 }
 
 /** Finds a member in the given struct with the given name. */
@@ -1540,6 +1640,8 @@ DNA_ReconstructInfo *DNA_reconstruct_info_create(const SDNA *oldsdna,
   reconstruct_info->step_counts = MEM_malloc_arrayN(sizeof(int), newsdna->structs_len, __func__);
   reconstruct_info->steps = MEM_malloc_arrayN(
       sizeof(ReconstructStep *), newsdna->structs_len, __func__);
+  reconstruct_info->steps_memcpy_only = MEM_calloc_arrayN(
+      sizeof(bool), newsdna->structs_len, __func__);
 
   /* Generate reconstruct steps for all structs. */
   for (int new_struct_nr = 0; new_struct_nr < newsdna->structs_len; new_struct_nr++) {
@@ -1562,6 +1664,15 @@ DNA_ReconstructInfo *DNA_reconstruct_info_create(const SDNA *oldsdna,
     reconstruct_info->steps[new_struct_nr] = steps;
     reconstruct_info->step_counts[new_struct_nr] = steps_len;
 
+    bool steps_memcpy_only = true;
+    for (int a = 0; a < steps_len; a++) {
+      if (steps[a].type != RECONSTRUCT_STEP_MEMCPY) {
+        steps_memcpy_only = false;
+        break;
+      }
+    }
+    reconstruct_info->steps_memcpy_only[new_struct_nr] = steps_memcpy_only;
+
 /* This is useful when debugging the reconstruct steps. */
 #if 0
     printf("%s: \n", new_struct_name);
@@ -1586,6 +1697,7 @@ void DNA_reconstruct_info_free(DNA_ReconstructInfo *reconstruct_info)
   }
   MEM_freeN(reconstruct_info->steps);
   MEM_freeN(reconstruct_info->step_counts);
+  MEM_freeN(reconstruct_info->steps_memcpy_only);
   MEM_freeN(reconstruct_info);
 }
 
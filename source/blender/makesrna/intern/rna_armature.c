@@ -1502,6 +1502,12 @@ static void rna_def_armature(BlenderRNA *brna)
   RNA_def_property_update(prop, 0, "rna_Armature_update_data");
   RNA_def_property_flag(prop, PROP_LIB_EXCEPTION);
 
+  prop = RNA_def_property(srna, "use_pose_batch", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", ARM_POSE_BATCH);
+  RNA_def_property_ui_text(
+      prop, "Batch Evaluation", "Evaluate all bones at once, faster for many simple rigs");
+  RNA_def_property_update(prop, 0, "rna_Armature_dependency_update");
+
   prop = RNA_def_property(srna, "display_type", PROP_ENUM, PROP_NONE);
   RNA_def_property_enum_sdna(prop, NULL, "drawtype");
   RNA_def_property_enum_items(prop, prop_drawtype_items);
@@ -59,7 +59,8 @@ static void rna_FCurve_convert_to_samples(FCurve *fcu, ReportList *reports, int
     BKE_report(reports, RPT_WARNING, "FCurve has no keyframes");
   }
   else {
-    fcurve_store_samples(fcu, NULL, start, end, fcurve_samplingcb_evalcurve);
+    FCurveSegmentCursor cursor = FCURVE_SEGMENT_CURSOR_INIT;
+    fcurve_store_samples(fcu, &cursor, start, end, fcurve_samplingcb_evalcurve);
     WM_main_add_notifier(NC_ANIMATION | ND_ANIMCHAN | NA_EDITED, NULL);
   }
 }
@@ -82,6 +82,17 @@ static void copyData(const ModifierData *md, ModifierData *target, const int fla
   tamd->vert_coords_prev = NULL;
 }
 
+static void freeRuntimeData(void *runtime_data)
+{
+  BKE_armature_deform_cache_free(runtime_data);
+}
+
+static void freeData(ModifierData *md)
+{
+  freeRuntimeData(md->runtime);
+  md->runtime = NULL;
+}
+
 static void requiredDataMask(Object *UNUSED(ob),
                              ModifierData *UNUSED(md),
                              CustomData_MeshMasks *r_cddata_masks)
@@ -159,7 +170,9 @@ static void deformVerts(ModifierData *md,
                                        amd->deformflag,
                                        amd->vert_coords_prev,
                                        amd->defgrp_name,
-                                       mesh);
+                                       mesh,
+                                       ctx->depsgraph,
+                                       (struct ArmatureDeformCache **)&md->runtime);
 
   /* free cache */
   MEM_SAFE_FREE(amd->vert_coords_prev);
@@ -234,7 +247,9 @@ static void deformMatrices(ModifierData *md,
                                        amd->deformflag,
                                        NULL,
                                        amd->defgrp_name,
-                                       mesh_src);
+                                       mesh_src,
+                                       NULL,
+                                       NULL);
 
   if (!ELEM(mesh_src, NULL, mesh)) {
     BKE_id_free(NULL, mesh_src);
@@ -300,14 +315,14 @@ ModifierTypeInfo modifierType_Armature = {
 
     /* initData */ initData,
     /* requiredDataMask */ requiredDataMask,
-    /* freeData */ NULL,
+    /* freeData */ freeData,
     /* isDisabled */ isDisabled,
     /* updateDepsgraph */ updateDepsgraph,
     /* dependsOnTime */ NULL,
     /* dependsOnNormals */ NULL,
     /* foreachIDLink */ foreachIDLink,
     /* foreachTexLink */ NULL,
-    /* freeRuntimeData */ NULL,
+    /* freeRuntimeData */ freeRuntimeData,
     /* panelRegister */ panelRegister,
     /* blendWrite */ NULL,
     /* blendRead */ blendRead,
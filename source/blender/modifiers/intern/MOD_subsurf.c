@@ -37,6 +37,8 @@
 #include "DNA_screen_types.h"
 
 #include "BKE_context.h"
+#include "BKE_customdata.h"
+#include "BKE_lib_id.h"
 #include "BKE_mesh.h"
 #include "BKE_scene.h"
 #include "BKE_screen.h"
@@ -66,6 +68,18 @@
 typedef struct SubsurfRuntimeData {
   /* Cached subdivision surface descriptor, with topology and settings. */
   struct Subdiv *subdiv;
+
+  /* Subdivided mesh of the previous evaluation, together with a copy of its input mesh and the
+   * settings used. When only coarse vertex positions change the subdivided mesh is updated in
+   * place, without comparing topology of the subdivision surface again.
+   *
+   * NOTE: This keeps the subdivided mesh and a full copy of the coarse mesh alive per modifier,
+   * in addition to the meshes owned by the evaluated object. Only viewport evaluations are
+   * cached, the cache is freed when evaluating for render or applying the modifier. */
+  struct Mesh *mesh_cache;
+  struct Mesh *coarse_mesh_cache;
+  SubdivSettings subdiv_settings_cache;
+  SubdivToMeshSettings mesh_settings_cache;
 } SubsurfRuntimeData;
 
 static void initData(ModifierData *md)
@@ -109,6 +123,18 @@ static void copyData(const ModifierData *md, ModifierData *target, const int fla
   tsmd->emCache = tsmd->mCache = NULL;
 }
 
+static void subdiv_mesh_cache_free(SubsurfRuntimeData *runtime_data)
+{
+  if (runtime_data->mesh_cache != NULL) {
+    BKE_id_free(NULL, runtime_data->mesh_cache);
+    runtime_data->mesh_cache = NULL;
+  }
+  if (runtime_data->coarse_mesh_cache != NULL) {
+    BKE_id_free(NULL, runtime_data->coarse_mesh_cache);
+    runtime_data->coarse_mesh_cache = NULL;
+  }
+}
+
 static void freeRuntimeData(void *runtime_data_v)
 {
   if (runtime_data_v == NULL) {
@@ -118,6 +144,7 @@ static void freeRuntimeData(void *runtime_data_v)
   if (runtime_data->subdiv != NULL) {
     BKE_subdiv_free(runtime_data->subdiv);
   }
+  subdiv_mesh_cache_free(runtime_data);
   MEM_freeN(runtime_data);
 }
 
@@ -211,6 +238,68 @@ static Mesh *subdiv_as_mesh(SubsurfModifierData *smd,
   return result;
 }
 
+/* Subdivide into fully qualified mesh, re-using the mesh of the previous evaluation. */
+
+static bool subdiv_mesh_settings_equal(const SubdivToMeshSettings *settings_a,
+                                       const SubdivToMeshSettings *settings_b)
+{
+  return (settings_a->resolution == settings_b->resolution &&
+          settings_a->use_optimal_display == settings_b->use_optimal_display);
+}
+
+static bool subdiv_mesh_cache_is_valid(const SubsurfRuntimeData *runtime_data,
+                                       const SubdivSettings *subdiv_settings,
+                                       const SubdivToMeshSettings *mesh_settings,
+                                       const Mesh *mesh)
+{
+  return runtime_data->mesh_cache != NULL && runtime_data->subdiv != NULL &&
+         BKE_subdiv_settings_equal(&runtime_data->subdiv_settings_cache, subdiv_settings) &&
+         subdiv_mesh_settings_equal(&runtime_data->mesh_settings_cache, mesh_settings) &&
+         BKE_subdiv_mesh_coarse_positions_only_differ(mesh, runtime_data->coarse_mesh_cache);
+}
+
+/* Copy of the cached mesh, which shares all arrays with it except vertices. */
+static Mesh *subdiv_mesh_cache_copy(SubsurfRuntimeData *runtime_data)
+{
+  Mesh *result = BKE_mesh_copy_for_eval(runtime_data->mesh_cache, true);
+  result->mvert = CustomData_duplicate_referenced_layer(
+      &result->vdata, CD_MVERT, result->totvert);
+  return result;
+}
+
+static Mesh *subdiv_as_mesh_cached(SubsurfModifierData *smd,
+                                   const ModifierEvalContext *ctx,
+                                   Mesh *mesh,
+                                   const SubdivSettings *subdiv_settings)
+{
+  SubsurfRuntimeData *runtime_data = (SubsurfRuntimeData *)smd->modifier.runtime;
+  SubdivToMeshSettings mesh_settings;
+  subdiv_mesh_settings_init(&mesh_settings, smd, ctx);
+  if (mesh_settings.resolution < 3) {
+    return mesh;
+  }
+  if (subdiv_mesh_cache_is_valid(runtime_data, subdiv_settings, &mesh_settings, mesh) &&
+      BKE_subdiv_mesh_update_positions(
+          runtime_data->subdiv, &mesh_settings, mesh, runtime_data->mesh_cache)) {
+    return subdiv_mesh_cache_copy(runtime_data);
+  }
+  subdiv_mesh_cache_free(runtime_data);
+  Subdiv *subdiv = subdiv_descriptor_ensure(smd, subdiv_settings, mesh);
+  if (subdiv == NULL) {
+    /* Happens on bad topology, but also on empty input mesh. */
+    return mesh;
+  }
+  Mesh *result = BKE_subdiv_to_mesh(subdiv, &mesh_settings, mesh);
+  if (result == NULL) {
+    return NULL;
+  }
+  runtime_data->mesh_cache = result;
+  runtime_data->coarse_mesh_cache = BKE_mesh_copy_for_eval(mesh, false);
+  runtime_data->subdiv_settings_cache = *subdiv_settings;
+  runtime_data->mesh_settings_cache = mesh_settings;
+  return subdiv_mesh_cache_copy(runtime_data);
+}
+
 /* Subdivide into CCG. */
 
 static void subdiv_ccg_settings_init(SubdivToCCGSettings *settings,
@@ -264,14 +353,20 @@ static Mesh *modifyMesh(ModifierData *md, const ModifierEvalContext *ctx, Mesh *
     return result;
   }
   SubsurfRuntimeData *runtime_data = subsurf_ensure_runtime(smd);
+  const bool use_clnors = (smd->flags & eSubsurfModifierFlag_UseCustomNormals) &&
+                          (mesh->flag & ME_AUTOSMOOTH) &&
+                          CustomData_has_layer(&mesh->ldata, CD_CUSTOMLOOPNORMAL);
+  /* Keep the subdivided mesh for viewport playback of deformed meshes. Custom normals are
+   * calculated from positions and interpolated, so they can not be re-used. */
+  if (!use_clnors && !(ctx->flag & (MOD_APPLY_RENDER | MOD_APPLY_TO_BASE_MESH))) {
+    return subdiv_as_mesh_cached(smd, ctx, mesh, &subdiv_settings);
+  }
+  subdiv_mesh_cache_free(runtime_data);
   Subdiv *subdiv = subdiv_descriptor_ensure(smd, &subdiv_settings, mesh);
   if (subdiv == NULL) {
     /* Happens on bad topology, but also on empty input mesh. */
     return result;
   }
-  const bool use_clnors = (smd->flags & eSubsurfModifierFlag_UseCustomNormals) &&
-                          (mesh->flag & ME_AUTOSMOOTH) &&
-                          CustomData_has_layer(&mesh->ldata, CD_CUSTOMLOOPNORMAL);
   if (use_clnors) {
     /* If custom normals are present and the option is turned on calculate the split
      * normals and clear flag so the normals get interpolated to the result mesh. */
@@ -323,6 +418,8 @@ static void deformMatrices(ModifierData *md,
     return;
   }
   SubsurfRuntimeData *runtime_data = subsurf_ensure_runtime(smd);
+  /* The descriptor might be re-created for a different topology. */
+  subdiv_mesh_cache_free(runtime_data);
   Subdiv *subdiv = subdiv_descriptor_ensure(smd, &subdiv_settings, mesh);
   if (subdiv == NULL) {
     /* Happens on bad topology, but also on empty input mesh. */
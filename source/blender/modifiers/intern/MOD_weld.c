@@ -39,6 +39,8 @@
 #include "BLI_bitmap.h"
 #include "BLI_kdtree.h"
 #include "BLI_math.h"
+#include "BLI_spatial_hash.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -366,33 +368,120 @@ static void weld_assert_poly_len(const WeldPoly *wp, const WeldLoop *wloop)
 #endif
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Weld Context Blocks
+ *
+ * The contexts are arrays of the elements affected by the weld, in the order of the mesh.
+ * They are filled in parallel, in blocks of elements: the context elements of each block are
+ * counted first, which gives each block the offset to fill its elements from.
+ * \{ */
+
+#define WELD_CTX_BLOCK_SIZE 4096
+
+static uint weld_ctx_blocks_len(const uint elem_len)
+{
+  return (elem_len + WELD_CTX_BLOCK_SIZE - 1) / WELD_CTX_BLOCK_SIZE;
+}
+
+static void weld_ctx_block_range(const uint elem_len,
+                                 const int block,
+                                 uint *r_start,
+                                 uint *r_end)
+{
+  *r_start = (uint)block * WELD_CTX_BLOCK_SIZE;
+  *r_end = MIN2(*r_start + WELD_CTX_BLOCK_SIZE, elem_len);
+}
+
+/* Turn the number of elements of each block into offsets, returns the total. */
+static uint weld_ctx_blocks_accumulate(uint *blocks_ofs, const uint blocks_len)
+{
+  uint ofs = 0;
+  for (uint i = 0; i < blocks_len; i++) {
+    const uint len = blocks_ofs[i];
+    blocks_ofs[i] = ofs;
+    ofs += len;
+  }
+  return ofs;
+}
+
+static void weld_ctx_blocks_parallel(const uint blocks_len,
+                                     void *userdata,
+                                     TaskParallelRangeFunc func)
+{
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (blocks_len > 1);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, (int)blocks_len, userdata, func, &settings);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Weld Vert API
  * \{ */
 
+typedef struct WeldVertCtxData {
+  uint mvert_len;
+  const uint *vert_dest_map;
+  uint *blocks_ofs;
+  WeldVert *wvert;
+} WeldVertCtxData;
+
+static void weld_vert_ctx_count_cb(void *__restrict userdata,
+                                   const int block,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  WeldVertCtxData *data = userdata;
+  uint start, end, len = 0;
+  weld_ctx_block_range(data->mvert_len, block, &start, &end);
+  for (uint i = start; i < end; i++) {
+    if (data->vert_dest_map[i] != OUT_OF_CONTEXT) {
+      len++;
+    }
+  }
+  data->blocks_ofs[block] = len;
+}
+
+static void weld_vert_ctx_fill_cb(void *__restrict userdata,
+                                  const int block,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  WeldVertCtxData *data = userdata;
+  uint start, end;
+  weld_ctx_block_range(data->mvert_len, block, &start, &end);
+  WeldVert *wv = &data->wvert[data->blocks_ofs[block]];
+  for (uint i = start; i < end; i++) {
+    const uint v_dest = data->vert_dest_map[i];
+    if (v_dest != OUT_OF_CONTEXT) {
+      wv->vert_dest = v_dest;
+      wv->vert_orig = i;
+      wv++;
+    }
+  }
+}
+
 static void weld_vert_ctx_alloc_and_setup(const uint mvert_len,
                                           uint *r_vert_dest_map,
                                           WeldVert **r_wvert,
                                           uint *r_wvert_len)
 {
   /* Vert Context. */
-  uint wvert_len = 0;
+  const uint blocks_len = weld_ctx_blocks_len(mvert_len);
+  WeldVertCtxData data = {
+      .mvert_len = mvert_len,
+      .vert_dest_map = r_vert_dest_map,
+      .blocks_ofs = MEM_malloc_arrayN(blocks_len, sizeof(uint), __func__),
+  };
 
-  WeldVert *wvert, *wv;
-  wvert = MEM_mallocN(sizeof(*wvert) * mvert_len, __func__);
-  wv = &wvert[0];
+  weld_ctx_blocks_parallel(blocks_len, &data, weld_vert_ctx_count_cb);
+  const uint wvert_len = weld_ctx_blocks_accumulate(data.blocks_ofs, blocks_len);
 
-  uint *v_dest_iter = &r_vert_dest_map[0];
-  for (uint i = 0; i < mvert_len; i++, v_dest_iter++) {
-    if (*v_dest_iter != OUT_OF_CONTEXT) {
-      wv->vert_dest = *v_dest_iter;
-      wv->vert_orig = i;
-      wv++;
-      wvert_len++;
-    }
-  }
+  data.wvert = MEM_malloc_arrayN(wvert_len, sizeof(*data.wvert), __func__);
+  weld_ctx_blocks_parallel(blocks_len, &data, weld_vert_ctx_fill_cb);
+  MEM_freeN(data.blocks_ofs);
 
-  *r_wvert = MEM_reallocN(wvert, sizeof(*wvert) * wvert_len);
+  *r_wvert = data.wvert;
   *r_wvert_len = wvert_len;
 }
 
@@ -587,48 +676,96 @@ static void weld_edge_ctx_setup(const uint mvert_len,
   *r_edge_kiil_len = edge_kill_len;
 }
 
-static void weld_edge_ctx_alloc(const MEdge *medge,
-                                const uint medge_len,
-                                const uint *vert_dest_map,
-                                uint *r_edge_dest_map,
-                                uint **r_edge_ctx_map,
-                                WeldEdge **r_wedge,
-                                uint *r_wedge_len)
+typedef struct WeldEdgeCtxData {
+  const MEdge *medge;
+  uint medge_len;
+  const uint *vert_dest_map;
+  uint *blocks_ofs;
+  uint *edge_dest_map;
+  uint *edge_map;
+  WeldEdge *wedge;
+} WeldEdgeCtxData;
+
+BLI_INLINE bool weld_edge_is_ctx(const MEdge *me, const uint *vert_dest_map)
 {
-  /* Edge Context. */
-  uint *edge_map = MEM_mallocN(sizeof(*edge_map) * medge_len, __func__);
-  uint wedge_len = 0;
+  return (vert_dest_map[me->v1] != OUT_OF_CONTEXT) || (vert_dest_map[me->v2] != OUT_OF_CONTEXT);
+}
 
-  WeldEdge *wedge, *we;
-  wedge = MEM_mallocN(sizeof(*wedge) * medge_len, __func__);
-  we = &wedge[0];
+static void weld_edge_ctx_count_cb(void *__restrict userdata,
+                                   const int block,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  WeldEdgeCtxData *data = userdata;
+  uint start, end, len = 0;
+  weld_ctx_block_range(data->medge_len, block, &start, &end);
+  for (uint i = start; i < end; i++) {
+    if (weld_edge_is_ctx(&data->medge[i], data->vert_dest_map)) {
+      len++;
+    }
+  }
+  data->blocks_ofs[block] = len;
+}
 
-  const MEdge *me = &medge[0];
-  uint *e_dest_iter = &r_edge_dest_map[0];
-  uint *iter = &edge_map[0];
-  for (uint i = 0; i < medge_len; i++, me++, iter++, e_dest_iter++) {
+static void weld_edge_ctx_fill_cb(void *__restrict userdata,
+                                  const int block,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  WeldEdgeCtxData *data = userdata;
+  const uint *vert_dest_map = data->vert_dest_map;
+  uint start, end;
+  weld_ctx_block_range(data->medge_len, block, &start, &end);
+  uint wedge_index = data->blocks_ofs[block];
+  for (uint i = start; i < end; i++) {
+    const MEdge *me = &data->medge[i];
     uint v1 = me->v1;
     uint v2 = me->v2;
     uint v_dest_1 = vert_dest_map[v1];
     uint v_dest_2 = vert_dest_map[v2];
     if ((v_dest_1 != OUT_OF_CONTEXT) || (v_dest_2 != OUT_OF_CONTEXT)) {
+      WeldEdge *we = &data->wedge[wedge_index];
       we->vert_a = (v_dest_1 != OUT_OF_CONTEXT) ? v_dest_1 : v1;
       we->vert_b = (v_dest_2 != OUT_OF_CONTEXT) ? v_dest_2 : v2;
       we->edge_dest = OUT_OF_CONTEXT;
       we->edge_orig = i;
-      we++;
-      *e_dest_iter = i;
-      *iter = wedge_len++;
+      data->edge_dest_map[i] = i;
+      data->edge_map[i] = wedge_index++;
     }
     else {
-      *e_dest_iter = OUT_OF_CONTEXT;
-      *iter = OUT_OF_CONTEXT;
+      data->edge_dest_map[i] = OUT_OF_CONTEXT;
+      data->edge_map[i] = OUT_OF_CONTEXT;
     }
   }
+}
 
-  *r_wedge = MEM_reallocN(wedge, sizeof(*wedge) * wedge_len);
+static void weld_edge_ctx_alloc(const MEdge *medge,
+                                const uint medge_len,
+                                const uint *vert_dest_map,
+                                uint *r_edge_dest_map,
+                                uint **r_edge_ctx_map,
+                                WeldEdge **r_wedge,
+                                uint *r_wedge_len)
+{
+  /* Edge Context. */
+  const uint blocks_len = weld_ctx_blocks_len(medge_len);
+  WeldEdgeCtxData data = {
+      .medge = medge,
+      .medge_len = medge_len,
+      .vert_dest_map = vert_dest_map,
+      .blocks_ofs = MEM_malloc_arrayN(blocks_len, sizeof(uint), __func__),
+      .edge_dest_map = r_edge_dest_map,
+      .edge_map = MEM_malloc_arrayN(medge_len, sizeof(uint), __func__),
+  };
+
+  weld_ctx_blocks_parallel(blocks_len, &data, weld_edge_ctx_count_cb);
+  const uint wedge_len = weld_ctx_blocks_accumulate(data.blocks_ofs, blocks_len);
+
+  data.wedge = MEM_malloc_arrayN(wedge_len, sizeof(*data.wedge), __func__);
+  weld_ctx_blocks_parallel(blocks_len, &data, weld_edge_ctx_fill_cb);
+  MEM_freeN(data.blocks_ofs);
+
+  *r_wedge = data.wedge;
   *r_wedge_len = wedge_len;
-  *r_edge_ctx_map = edge_map;
+  *r_edge_ctx_map = data.edge_map;
 }
 
 static void weld_edge_groups_setup(const uint medge_len,
@@ -823,53 +960,106 @@ static bool weld_iter_loop_of_poly_next(WeldLoopOfPolyIter *iter)
   return false;
 }
 
-static void weld_poly_loop_ctx_alloc(const MPoly *mpoly,
-                                     const uint mpoly_len,
-                                     const MLoop *mloop,
-                                     const uint mloop_len,
-                                     const uint *vert_dest_map,
-                                     const uint *edge_dest_map,
-                                     WeldMesh *r_weld_mesh)
+typedef struct WeldPolyCtxBlock {
+  /* Number of context loops and polygons in the block, then their offsets. */
+  uint wloop_ofs;
+  uint wpoly_ofs;
+  uint maybe_new_poly;
+  uint max_ctx_poly_len;
+} WeldPolyCtxBlock;
+
+typedef struct WeldPolyCtxData {
+  const MPoly *mpoly;
+  uint mpoly_len;
+  const MLoop *mloop;
+  const uint *vert_dest_map;
+  const uint *edge_dest_map;
+  WeldPolyCtxBlock *blocks;
+  uint *loop_map;
+  uint *poly_map;
+  WeldLoop *wloop;
+  WeldPoly *wpoly;
+} WeldPolyCtxData;
+
+static void weld_poly_loop_ctx_count_cb(void *__restrict userdata,
+                                        const int block,
+                                        const TaskParallelTLS *__restrict UNUSED(tls))
 {
-  /* Loop/Poly Context. */
-  uint *loop_map = MEM_mallocN(sizeof(*loop_map) * mloop_len, __func__);
-  uint *poly_map = MEM_mallocN(sizeof(*poly_map) * mpoly_len, __func__);
+  WeldPolyCtxData *data = userdata;
+  WeldPolyCtxBlock *ctx_block = &data->blocks[block];
+  uint start, end;
+  weld_ctx_block_range(data->mpoly_len, block, &start, &end);
+
   uint wloop_len = 0;
   uint wpoly_len = 0;
+  uint maybe_new_poly = 0;
   uint max_ctx_poly_len = 4;
 
-  WeldLoop *wloop, *wl;
-  wloop = MEM_mallocN(sizeof(*wloop) * mloop_len, __func__);
-  wl = &wloop[0];
+  for (uint i = start; i < end; i++) {
+    const MPoly *mp = &data->mpoly[i];
+    const uint totloop = mp->totloop;
+    uint vert_ctx_len = 0;
+    uint loop_ctx_len = 0;
 
-  WeldPoly *wpoly, *wp;
-  wpoly = MEM_mallocN(sizeof(*wpoly) * mpoly_len, __func__);
-  wp = &wpoly[0];
+    const MLoop *ml = &data->mloop[mp->loopstart];
+    for (uint j = totloop; j--; ml++) {
+      bool is_vert_ctx = data->vert_dest_map[ml->v] != OUT_OF_CONTEXT;
+      bool is_edge_ctx = data->edge_dest_map[ml->e] != OUT_OF_CONTEXT;
+      if (is_vert_ctx) {
+        vert_ctx_len++;
+      }
+      if (is_vert_ctx || is_edge_ctx) {
+        loop_ctx_len++;
+      }
+    }
+    if (loop_ctx_len) {
+      wloop_len += loop_ctx_len;
+      wpoly_len++;
+      if (totloop > 5 && vert_ctx_len > 1) {
+        uint max_new = (totloop / 3) - 1;
+        vert_ctx_len /= 2;
+        maybe_new_poly += MIN2(max_new, vert_ctx_len);
+        CLAMP_MIN(max_ctx_poly_len, totloop);
+      }
+    }
+  }
 
-  uint maybe_new_poly = 0;
+  ctx_block->wloop_ofs = wloop_len;
+  ctx_block->wpoly_ofs = wpoly_len;
+  ctx_block->maybe_new_poly = maybe_new_poly;
+  ctx_block->max_ctx_poly_len = max_ctx_poly_len;
+}
 
-  const MPoly *mp = &mpoly[0];
-  uint *iter = &poly_map[0];
-  uint *loop_map_iter = &loop_map[0];
-  for (uint i = 0; i < mpoly_len; i++, mp++, iter++) {
+static void weld_poly_loop_ctx_fill_cb(void *__restrict userdata,
+                                       const int block,
+                                       const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  WeldPolyCtxData *data = userdata;
+  const WeldPolyCtxBlock *ctx_block = &data->blocks[block];
+  uint start, end;
+  weld_ctx_block_range(data->mpoly_len, block, &start, &end);
+
+  uint wloop_len = ctx_block->wloop_ofs;
+  uint wpoly_len = ctx_block->wpoly_ofs;
+  WeldLoop *wl = &data->wloop[wloop_len];
+  WeldPoly *wp = &data->wpoly[wpoly_len];
+
+  for (uint i = start; i < end; i++) {
+    const MPoly *mp = &data->mpoly[i];
     const uint loopstart = mp->loopstart;
     const uint totloop = mp->totloop;
 
-    uint vert_ctx_len = 0;
-
     uint l = loopstart;
     uint prev_wloop_len = wloop_len;
-    const MLoop *ml = &mloop[l];
+    const MLoop *ml = &data->mloop[l];
+    uint *loop_map_iter = &data->loop_map[l];
     for (uint j = totloop; j--; l++, ml++, loop_map_iter++) {
       uint v = ml->v;
       uint e = ml->e;
-      uint v_dest = vert_dest_map[v];
-      uint e_dest = edge_dest_map[e];
+      uint v_dest = data->vert_dest_map[v];
+      uint e_dest = data->edge_dest_map[e];
       bool is_vert_ctx = v_dest != OUT_OF_CONTEXT;
       bool is_edge_ctx = e_dest != OUT_OF_CONTEXT;
-      if (is_vert_ctx) {
-        vert_ctx_len++;
-      }
       if (is_vert_ctx || is_edge_ctx) {
         wl->vert = is_vert_ctx ? v_dest : v;
         wl->edge = is_edge_ctx ? e_dest : e;
@@ -895,29 +1085,68 @@ static void weld_poly_loop_ctx_alloc(const MPoly *mpoly,
       wp->len = totloop;
       wp++;
 
-      *iter = wpoly_len++;
-      if (totloop > 5 && vert_ctx_len > 1) {
-        uint max_new = (totloop / 3) - 1;
-        vert_ctx_len /= 2;
-        maybe_new_poly += MIN2(max_new, vert_ctx_len);
-        CLAMP_MIN(max_ctx_poly_len, totloop);
-      }
+      data->poly_map[i] = wpoly_len++;
     }
     else {
-      *iter = OUT_OF_CONTEXT;
+      data->poly_map[i] = OUT_OF_CONTEXT;
     }
   }
+}
+
+static void weld_poly_loop_ctx_alloc(const MPoly *mpoly,
+                                     const uint mpoly_len,
+                                     const MLoop *mloop,
+                                     const uint mloop_len,
+                                     const uint *vert_dest_map,
+                                     const uint *edge_dest_map,
+                                     WeldMesh *r_weld_mesh)
+{
+  /* Loop/Poly Context. */
+  const uint blocks_len = weld_ctx_blocks_len(mpoly_len);
+  WeldPolyCtxData data = {
+      .mpoly = mpoly,
+      .mpoly_len = mpoly_len,
+      .mloop = mloop,
+      .vert_dest_map = vert_dest_map,
+      .edge_dest_map = edge_dest_map,
+      .blocks = MEM_malloc_arrayN(blocks_len, sizeof(WeldPolyCtxBlock), __func__),
+      .loop_map = MEM_malloc_arrayN(mloop_len, sizeof(uint), __func__),
+      .poly_map = MEM_malloc_arrayN(mpoly_len, sizeof(uint), __func__),
+  };
 
-  if (mpoly_len < (wpoly_len + maybe_new_poly)) {
-    WeldPoly *wpoly_tmp = wpoly;
-    wpoly = MEM_mallocN(sizeof(*wpoly) * ((size_t)wpoly_len + maybe_new_poly), __func__);
-    memcpy(wpoly, wpoly_tmp, sizeof(*wpoly) * wpoly_len);
-    MEM_freeN(wpoly_tmp);
+  weld_ctx_blocks_parallel(blocks_len, &data, weld_poly_loop_ctx_count_cb);
+
+  uint wloop_len = 0;
+  uint wpoly_len = 0;
+  uint maybe_new_poly = 0;
+  uint max_ctx_poly_len = 4;
+  for (uint i = 0; i < blocks_len; i++) {
+    WeldPolyCtxBlock *ctx_block = &data.blocks[i];
+    const uint block_wloop_len = ctx_block->wloop_ofs;
+    const uint block_wpoly_len = ctx_block->wpoly_ofs;
+    ctx_block->wloop_ofs = wloop_len;
+    ctx_block->wpoly_ofs = wpoly_len;
+    wloop_len += block_wloop_len;
+    wpoly_len += block_wpoly_len;
+    maybe_new_poly += ctx_block->maybe_new_poly;
+    CLAMP_MIN(max_ctx_poly_len, ctx_block->max_ctx_poly_len);
   }
 
+  /* Room for the polygons that may be split off. */
+  data.wloop = MEM_malloc_arrayN(wloop_len, sizeof(*data.wloop), __func__);
+  data.wpoly = MEM_malloc_arrayN(
+      MAX2(mpoly_len, wpoly_len + maybe_new_poly), sizeof(*data.wpoly), __func__);
+  weld_ctx_blocks_parallel(blocks_len, &data, weld_poly_loop_ctx_fill_cb);
+  MEM_freeN(data.blocks);
+
+  WeldLoop *wloop = data.wloop;
+  WeldPoly *wpoly = data.wpoly;
+  uint *loop_map = data.loop_map;
+  uint *poly_map = data.poly_map;
+
   WeldPoly *poly_new = &wpoly[wpoly_len];
 
-  r_weld_mesh->wloop = MEM_reallocN(wloop, sizeof(*wloop) * wloop_len);
+  r_weld_mesh->wloop = wloop;
   r_weld_mesh->wpoly = wpoly;
   r_weld_mesh->wpoly_new = poly_new;
   r_weld_mesh->wloop_len = wloop_len;
@@ -1567,6 +1796,33 @@ static bool bvhtree_weld_overlap_cb(void *userdata, int index_a, int index_b, in
 }
 #endif
 
+typedef struct WeldRemapData {
+  const uint *vert_final;
+  const uint *edge_final;
+  MEdge *medge;
+  MLoop *mloop;
+} WeldRemapData;
+
+static void weld_remap_edges_cb(void *__restrict userdata,
+                                const int i,
+                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const WeldRemapData *data = userdata;
+  MEdge *me = &data->medge[i];
+  me->v1 = data->vert_final[me->v1];
+  me->v2 = data->vert_final[me->v2];
+}
+
+static void weld_remap_loops_cb(void *__restrict userdata,
+                                const int i,
+                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const WeldRemapData *data = userdata;
+  MLoop *ml = &data->mloop[i];
+  ml->v = data->vert_final[ml->v];
+  ml->e = data->edge_final[ml->e];
+}
+
 static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContext *ctx, Mesh *mesh)
 {
   Mesh *result = mesh;
@@ -1575,12 +1831,10 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
   BLI_bitmap *v_mask = NULL;
   int v_mask_act = 0;
 
-  const MVert *mvert;
   const MLoop *mloop;
   const MPoly *mpoly, *mp;
   uint totvert, totedge, totloop, totpoly;
 
-  mvert = mesh->mvert;
   totvert = mesh->totvert;
 
   /* Vertex Group. */
@@ -1608,6 +1862,7 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
   uint vert_kill_len = 0;
 #ifdef USE_BVHTREEKDOP
   {
+    const MVert *mvert = mesh->mvert;
     /* Get overlap map. */
     struct BVHTreeFromMesh treedata;
     BVHTree *bvhtree = bvhtree_from_mesh_verts_ex(&treedata,
@@ -1686,7 +1941,15 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
     }
   }
 #else
-  {
+  if (wmd->flag & MOD_WELD_MERGE_CHAINS) {
+    /* Unmerged vertices are set to -1, which is #OUT_OF_CONTEXT. */
+    float(*vert_coords)[3] = BKE_mesh_vert_coords_alloc(mesh, NULL);
+    vert_kill_len = BLI_spatial_hash_3d_calc_duplicates(
+        vert_coords, totvert, v_mask, wmd->merge_dist, (int *)vert_dest_map);
+    MEM_freeN(vert_coords);
+  }
+  else {
+    const MVert *mvert = mesh->mvert;
     KDTree_3d *tree = BLI_kdtree_3d_new(v_mask ? v_mask_act : totvert);
     for (uint i = 0; i < totvert; i++) {
       if (!v_mask || BLI_BITMAP_TEST(v_mask, i)) {
@@ -1776,12 +2039,7 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
       }
       if (count) {
         CustomData_copy_data(&mesh->edata, &result->edata, source_index, dest_index, count);
-        MEdge *me = &result->medge[dest_index];
         dest_index += count;
-        for (; count--; me++) {
-          me->v1 = vert_final[me->v1];
-          me->v2 = vert_final[me->v2];
-        }
       }
       if (i == totedge) {
         break;
@@ -1794,8 +2052,8 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
                         wegrp->group.len,
                         dest_index);
         MEdge *me = &result->medge[dest_index];
-        me->v1 = vert_final[wegrp->v1];
-        me->v2 = vert_final[wegrp->v2];
+        me->v1 = wegrp->v1;
+        me->v2 = wegrp->v2;
         me->flag |= ME_LOOSEEDGE;
 
         *index_iter = dest_index;
@@ -1805,6 +2063,18 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
 
     BLI_assert(dest_index == result_nedges);
 
+    /* Edges still use the original vertex indices, remap them all at once. */
+    WeldRemapData remap_data = {
+        .vert_final = vert_final,
+        .edge_final = edge_final,
+        .medge = result->medge,
+        .mloop = result->mloop,
+    };
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = (result_nedges > 10000);
+    BLI_task_parallel_range(0, result_nedges, &remap_data, weld_remap_edges_cb, &settings);
+
     /* Polys/Loops */
 
     mp = &mpoly[0];
@@ -1820,10 +2090,7 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
         uint mp_loop_len = mp->totloop;
         CustomData_copy_data(&mesh->ldata, &result->ldata, mp->loopstart, loop_cur, mp_loop_len);
         loop_cur += mp_loop_len;
-        for (; mp_loop_len--; r_ml++) {
-          r_ml->v = vert_final[r_ml->v];
-          r_ml->e = edge_final[r_ml->e];
-        }
+        r_ml += mp_loop_len;
       }
       else {
         WeldPoly *wp = &weld_mesh.wpoly[poly_ctx];
@@ -1838,10 +2105,9 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
         }
         while (weld_iter_loop_of_poly_next(&iter)) {
           customdata_weld(&mesh->ldata, &result->ldata, group_buffer, iter.group_len, loop_cur);
-          uint v = vert_final[iter.v];
           uint e = edge_final[iter.e];
-          r_ml->v = v;
-          r_ml->e = e;
+          r_ml->v = iter.v;
+          r_ml->e = iter.e;
           r_ml++;
           loop_cur++;
           if (iter.type) {
@@ -1872,10 +2138,9 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
       }
       while (weld_iter_loop_of_poly_next(&iter)) {
         customdata_weld(&mesh->ldata, &result->ldata, group_buffer, iter.group_len, loop_cur);
-        uint v = vert_final[iter.v];
         uint e = edge_final[iter.e];
-        r_ml->v = v;
-        r_ml->e = e;
+        r_ml->v = iter.v;
+        r_ml->e = iter.e;
         r_ml++;
         loop_cur++;
         if (iter.type) {
@@ -1893,6 +2158,10 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
     BLI_assert((int)r_i == result_npolys);
     BLI_assert(loop_cur == result_nloops);
 
+    /* Loops still use the original vertex and edge indices, remap them all at once. */
+    settings.use_threading = (result_nloops > 10000);
+    BLI_task_parallel_range(0, result_nloops, &remap_data, weld_remap_loops_cb, &settings);
+
     /* is this needed? */
     /* recalculate normals */
     result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
@@ -1941,6 +2210,7 @@ static void panel_draw(const bContext *UNUSED(C), Panel *panel)
   uiLayoutSetPropSep(layout, true);
 
   uiItemR(layout, ptr, "merge_threshold", 0, IFACE_("Distance"), ICON_NONE);
+  uiItemR(layout, ptr, "use_merge_chains", 0, NULL, ICON_NONE);
   modifier_vgroup_ui(layout, ptr, &ob_ptr, "vertex_group", "invert_vertex_group", NULL);
 
   modifier_panel_end(layout, ptr);
@@ -0,0 +1,200 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_modifier.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+
+#include "BLI_array.hh"
+#include "BLI_float3.hh"
+#include "BLI_math.h"
+
+#include "MOD_modifiertypes.h"
+
+namespace blender::modifiers::tests {
+
+class WeldTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BKE_idtype_init();
+  }
+};
+
+/**
+ * A grid of quads, larger than one block of the threaded weld context setup. Vertices are moved
+ * so that some edges collapse, turning quads into triangles, and some quads collapse entirely.
+ * The merged vertices are far from any other, so clustering the vertices greedily or through
+ * chains gives the same groups.
+ */
+static Mesh *weld_test_grid_new(const int size)
+{
+  const int row = size + 1;
+  Mesh *mesh = BKE_mesh_new_nomain(row * row, 0, 0, size * size * 4, size * size);
+  for (int y = 0; y <= size; y++) {
+    for (int x = 0; x <= size; x++) {
+      copy_v3_fl3(mesh->mvert[y * row + x].co, (float)x, (float)y, 0.0f);
+    }
+  }
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      const int poly = y * size + x;
+      const int v = y * row + x;
+      MLoop *ml = &mesh->mloop[poly * 4];
+      ml[0].v = (uint)v;
+      ml[1].v = (uint)(v + 1);
+      ml[2].v = (uint)(v + row + 1);
+      ml[3].v = (uint)(v + row);
+      mesh->mpoly[poly].loopstart = poly * 4;
+      mesh->mpoly[poly].totloop = 4;
+
+      if (x % 7 == 1 && y % 7 == 1) {
+        /* Edge collapse. */
+        copy_v3_fl3(mesh->mvert[v + 1].co, (float)x + 0.002f, (float)y, 0.0f);
+      }
+      else if (x % 7 == 4 && y % 7 == 4) {
+        /* Face collapse. */
+        for (int i = 0; i < 4; i++) {
+          copy_v3_fl3(mesh->mvert[ml[i].v].co,
+                      (float)x + 0.5f + (float)i * 0.001f,
+                      (float)y + 0.5f,
+                      (float)i * 0.002f);
+        }
+      }
+    }
+  }
+  BKE_mesh_calc_edges(mesh, false, false);
+  BKE_mesh_calc_normals(mesh);
+  return mesh;
+}
+
+static Mesh *weld_test_apply(Mesh *mesh, const float merge_dist, const bool use_merge_chains)
+{
+  WeldModifierData wmd = {{nullptr}};
+  wmd.modifier.type = eModifierType_Weld;
+  wmd.merge_dist = merge_dist;
+  wmd.flag = use_merge_chains ? MOD_WELD_MERGE_CHAINS : 0;
+
+  Object ob = {{nullptr}};
+  ModifierEvalContext ctx = {nullptr, &ob, (ModifierApplyFlag)0};
+  return modifierType_Weld.modifyMesh(&wmd.modifier, &ctx, mesh);
+}
+
+/**
+ * The greedy and chain clustering can pick a different vertex of a group to keep, which only
+ * changes the order of the elements. Compare the meshes with their vertices sorted by position.
+ */
+static void weld_test_compare(const Mesh *a, const Mesh *b)
+{
+  ASSERT_EQ(a->totvert, b->totvert);
+  ASSERT_EQ(a->totedge, b->totedge);
+  ASSERT_EQ(a->totloop, b->totloop);
+  ASSERT_EQ(a->totpoly, b->totpoly);
+
+  /* Index of every vertex in the sorted order. */
+  auto vert_order = [](const Mesh *mesh) {
+    Array<int> order(mesh->totvert), order_inv(mesh->totvert);
+    for (int i = 0; i < mesh->totvert; i++) {
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](const int i1, const int i2) {
+      const float *co1 = mesh->mvert[i1].co, *co2 = mesh->mvert[i2].co;
+      return std::lexicographical_compare(co1, co1 + 3, co2, co2 + 3);
+    });
+    for (int i = 0; i < mesh->totvert; i++) {
+      order_inv[order[i]] = i;
+    }
+    return order_inv;
+  };
+  const Array<int> verts_a = vert_order(a), verts_b = vert_order(b);
+
+  Array<float3> cos_a(a->totvert), cos_b(b->totvert);
+  for (int i = 0; i < a->totvert; i++) {
+    cos_a[verts_a[i]] = a->mvert[i].co;
+    cos_b[verts_b[i]] = b->mvert[i].co;
+  }
+  for (int i = 0; i < a->totvert; i++) {
+    EXPECT_EQ_ARRAY((const float *)cos_a[i], (const float *)cos_b[i], 3);
+  }
+
+  auto sorted_edges = [](const Mesh *mesh, const Array<int> &verts) {
+    std::vector<std::pair<int, int>> edges;
+    for (int i = 0; i < mesh->totedge; i++) {
+      const int v1 = verts[mesh->medge[i].v1], v2 = verts[mesh->medge[i].v2];
+      edges.push_back({std::min(v1, v2), std::max(v1, v2)});
+    }
+    std::sort(edges.begin(), edges.end());
+    return edges;
+  };
+  EXPECT_EQ(sorted_edges(a, verts_a), sorted_edges(b, verts_b));
+
+  /* Polygons as their vertices, starting from the lowest one. */
+  auto sorted_polys = [](const Mesh *mesh, const Array<int> &verts) {
+    std::vector<std::vector<int>> polys;
+    for (int i = 0; i < mesh->totpoly; i++) {
+      const MPoly *mp = &mesh->mpoly[i];
+      std::vector<int> poly;
+      for (int j = 0; j < mp->totloop; j++) {
+        poly.push_back(verts[mesh->mloop[mp->loopstart + j].v]);
+      }
+      std::rotate(poly.begin(), std::min_element(poly.begin(), poly.end()), poly.end());
+      polys.push_back(poly);
+    }
+    std::sort(polys.begin(), polys.end());
+    return polys;
+  };
+  EXPECT_EQ(sorted_polys(a, verts_a), sorted_polys(b, verts_b));
+}
+
+TEST_F(WeldTest, MergeChainsMatchesGreedy)
+{
+  Mesh *mesh = weld_test_grid_new(70);
+  Mesh *result_greedy = weld_test_apply(mesh, 0.01f, false);
+  Mesh *result_chains = weld_test_apply(mesh, 0.01f, true);
+
+  /* 100 edge collapses of one vertex, 100 face collapses of three vertices, one quad and the
+   * edges of its four neighbors each. */
+  EXPECT_EQ(result_greedy->totvert, mesh->totvert - 100 - 100 * 3);
+  EXPECT_EQ(result_greedy->totpoly, mesh->totpoly - 100);
+  int tris_num = 0;
+  for (int i = 0; i < result_greedy->totpoly; i++) {
+    tris_num += (result_greedy->mpoly[i].totloop == 3);
+  }
+  EXPECT_EQ(tris_num, 100 * 2 + 100 * 4);
+
+  weld_test_compare(result_greedy, result_chains);
+  /* Merged vertices are left without normals. */
+  BKE_mesh_calc_normals(result_chains);
+  EXPECT_FALSE(BKE_mesh_validate(result_chains, false, false));
+
+  BKE_id_free(nullptr, result_greedy);
+  BKE_id_free(nullptr, result_chains);
+  BKE_id_free(nullptr, mesh);
+}
+
+}  // namespace blender::modifiers::tests
@@ -45,6 +45,7 @@
 
 #  include "BLO_readfile.h" /* only for BLO_has_bfile_extension */
 
+#  include "BKE_blender.h"
 #  include "BKE_blender_version.h"
 #  include "BKE_context.h"
 
@@ -65,6 +66,8 @@
 #    include "BPY_extern_run.h"
 #  endif
 
+#  include "DEG_depsgraph_debug.h"
+
 #  include "RE_engine.h"
 #  include "RE_pipeline.h"
 
@@ -584,8 +587,11 @@ static int arg_handle_print_help(int UNUSED(argc), const char **UNUSED(argv), vo
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-build");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-tag");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-no-threads");
+  BLI_args_print_arg_doc(ba, "--debug-depsgraph-priority");
+  BLI_args_print_arg_doc(ba, "--debug-depsgraph-validate-incremental");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-time");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-pretty");
+  BLI_args_print_arg_doc(ba, "--debug-depsgraph-trace");
   BLI_args_print_arg_doc(ba, "--debug-gpu");
   BLI_args_print_arg_doc(ba, "--debug-gpumem");
   BLI_args_print_arg_doc(ba, "--debug-gpu-shaders");
@@ -977,6 +983,14 @@ static const char arg_handle_debug_mode_generic_set_doc_depsgraph_eval[] =
 static const char arg_handle_debug_mode_generic_set_doc_depsgraph_no_threads[] =
     "\n\t"
     "Switch dependency graph to a single threaded evaluation.";
+static const char arg_handle_debug_mode_generic_set_doc_depsgraph_priority[] =
+    "\n\t"
+    "Evaluate dependency graph operations on the longest chain first, based on timing of previous "
+    "evaluations.";
+static const char arg_handle_debug_mode_generic_set_doc_depsgraph_validate_incremental[] =
+    "\n\t"
+    "Compare incremental updates of dependency graph relations against a full build, printing "
+    "differences.";
 static const char arg_handle_debug_mode_generic_set_doc_depsgraph_pretty[] =
     "\n\t"
     "Enable colors for dependency graph debug messages.";
@@ -1080,6 +1094,32 @@ static int arg_handle_debug_value_set(int argc, const char **argv, void *UNUSED(
   return 0;
 }
 
+static const char arg_handle_debug_depsgraph_trace_set_doc[] =
+    "<filepath> [<frames>]\n"
+    "\tRecord timing of every dependency graph operation, written to <filepath> on exit\n"
+    "\tin the Chrome trace event format (viewable in 'chrome://tracing' or Perfetto).\n"
+    "\tWhen <frames> is given, recording stops after evaluating that many frames.";
+static void callback_debug_depsgraph_trace_atexit(void *UNUSED(user_data))
+{
+  DEG_debug_trace_end();
+}
+static int arg_handle_debug_depsgraph_trace_set(int argc, const char **argv, void *UNUSED(data))
+{
+  if (argc > 1) {
+    /* The frame count is optional, only use the next argument when it's a number. */
+    int frames_num = 0;
+    const char *err_msg = NULL;
+    const bool has_frames_num = (argc > 2) && parse_int_strict_range(
+                                                  argv[2], NULL, 1, INT_MAX, &frames_num, &err_msg);
+    DEG_debug_trace_begin(argv[1], has_frames_num ? frames_num : 0);
+    BKE_blender_atexit_unregister(callback_debug_depsgraph_trace_atexit, NULL);
+    BKE_blender_atexit_register(callback_debug_depsgraph_trace_atexit, NULL);
+    return has_frames_num ? 2 : 1;
+  }
+  printf("\nError: you must specify a file path to write the trace to.\n");
+  return 0;
+}
+
 static const char arg_handle_debug_fpe_set_doc[] =
     "\n\t"
     "Enable floating point exceptions.";
@@ -2150,6 +2190,16 @@ void main_args_setup(bContext *C, bArgs *ba)
                "--debug-depsgraph-no-threads",
                CB_EX(arg_handle_debug_mode_generic_set, depsgraph_no_threads),
                (void *)G_DEBUG_DEPSGRAPH_NO_THREADS);
+  BLI_args_add(ba,
+               NULL,
+               "--debug-depsgraph-priority",
+               CB_EX(arg_handle_debug_mode_generic_set, depsgraph_priority),
+               (void *)G_DEBUG_DEPSGRAPH_PRIORITY);
+  BLI_args_add(ba,
+               NULL,
+               "--debug-depsgraph-validate-incremental",
+               CB_EX(arg_handle_debug_mode_generic_set, depsgraph_validate_incremental),
+               (void *)G_DEBUG_DEPSGRAPH_VALIDATE_INCREMENTAL);
   BLI_args_add(ba,
                NULL,
                "--debug-depsgraph-pretty",
@@ -2160,6 +2210,8 @@ void main_args_setup(bContext *C, bArgs *ba)
                "--debug-depsgraph-uuid",
                CB_EX(arg_handle_debug_mode_generic_set, depsgraph_build),
                (void *)G_DEBUG_DEPSGRAPH_UUID);
+  BLI_args_add(
+      ba, NULL, "--debug-depsgraph-trace", CB(arg_handle_debug_depsgraph_trace_set), NULL);
   BLI_args_add(ba,
                NULL,
                "--debug-gpumem",
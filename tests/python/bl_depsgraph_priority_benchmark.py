@@ -0,0 +1,133 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+# Compare playback FPS of the default dependency graph scheduling with the priority scheduling
+# (`--debug-depsgraph-priority`), on a scene with one long chain of operations (animated bone
+# chain -> heavy armature deform -> subdivision) next to many small independent objects.
+#
+# ./blender.bin --background --factory-startup \
+#     --python tests/python/bl_depsgraph_priority_benchmark.py -- --frames 100
+
+import bpy
+
+import sys
+import time
+
+
+def scene_create(args):
+    bpy.ops.wm.read_factory_settings(use_empty=True)
+    scene = bpy.context.scene
+
+    # Bone chain, each bone rotating.
+    bpy.ops.object.armature_add(enter_editmode=True, location=(0.0, 0.0, 0.0))
+    ob_arm = bpy.context.object
+    edit_bones = ob_arm.data.edit_bones
+    bone_prev = edit_bones[0]
+    bone_prev.tail = (0.0, 0.0, 0.1)
+    for i in range(1, args.bones):
+        bone = edit_bones.new("Bone.%03d" % i)
+        bone.head = bone_prev.tail
+        bone.tail = (0.0, 0.0, 0.1 * (i + 1))
+        bone.parent = bone_prev
+        bone.use_connect = True
+        bone_prev = bone
+    bpy.ops.object.mode_set(mode='OBJECT')
+    for pchan in ob_arm.pose.bones:
+        pchan.rotation_mode = 'XYZ'
+        for frame, angle in ((1, -0.2), (50, 0.2), (100, -0.2)):
+            pchan.rotation_euler[0] = angle
+            pchan.keyframe_insert("rotation_euler", index=0, frame=frame)
+
+    # Heavy mesh deformed by the chain.
+    bpy.ops.mesh.primitive_grid_add(
+        x_subdivisions=args.grid, y_subdivisions=args.grid, size=1.0, rotation=(1.5708, 0.0, 0.0))
+    ob_mesh = bpy.context.object
+    ob_mesh.scale = (0.5, 1.0, args.bones * 0.05)
+    ob_mesh.location = (0.0, 0.0, args.bones * 0.05)
+    modifier = ob_mesh.modifiers.new("Armature", 'ARMATURE')
+    modifier.object = ob_arm
+    modifier.use_vertex_groups = False
+    modifier.use_bone_envelopes = True
+    modifier = ob_mesh.modifiers.new("Subdivision", 'SUBSURF')
+    modifier.levels = 1
+
+    # Many small independent objects, which keep the threads busy when scheduled first.
+    for i in range(args.objects):
+        location = (1.0 + (i % 20) * 0.2, (i // 20) * 0.2, 0.0)
+        bpy.ops.mesh.primitive_cube_add(size=0.1, location=location)
+        ob = bpy.context.object
+        modifier = ob.modifiers.new("Subdivision", 'SUBSURF')
+        modifier.levels = 3
+        for frame, z in ((1, 0.0), (100, 1.0)):
+            ob.location[2] = z
+            ob.keyframe_insert("location", index=2, frame=frame)
+
+    scene.frame_start = 1
+    scene.frame_end = 100
+    return scene
+
+
+def playback_fps(scene, frames):
+    # Warm up, so the priority scheduler has timings of the operations.
+    for frame in range(1, 4):
+        scene.frame_set(frame)
+
+    time_start = time.perf_counter()
+    for i in range(frames):
+        scene.frame_set(1 + i % 100)
+    return frames / (time.perf_counter() - time_start)
+
+
+def argparse_create():
+    import argparse
+
+    description = "Compare playback FPS with and without dependency graph priority scheduling."
+    parser = argparse.ArgumentParser(description=description)
+    parser.add_argument("--frames", dest="frames", type=int, default=100,
+                        help="Number of frames to play back for each scheduler")
+    parser.add_argument("--bones", dest="bones", type=int, default=64,
+                        help="Length of the bone chain")
+    parser.add_argument("--grid", dest="grid", type=int, default=400,
+                        help="Resolution of the deformed grid")
+    parser.add_argument("--objects", dest="objects", type=int, default=400,
+                        help="Number of independent objects")
+    return parser
+
+
+def main():
+    args = argparse_create().parse_args()
+    scene = scene_create(args)
+
+    results = []
+    for use_priority in (False, True, False, True):
+        bpy.app.debug_depsgraph_priority = use_priority
+        results.append((use_priority, playback_fps(scene, args.frames)))
+    bpy.app.debug_depsgraph_priority = False
+
+    for use_priority, fps in results:
+        print("%-10s %8.2f fps" % ("priority" if use_priority else "default", fps))
+    fps_default = max(fps for use_priority, fps in results if not use_priority)
+    fps_priority = max(fps for use_priority, fps in results if use_priority)
+    print("Speedup: %.3fx" % (fps_priority / fps_default))
+
+
+if __name__ == '__main__':
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    main()